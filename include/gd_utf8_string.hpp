@@ -1,11 +1,13 @@
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <iterator>
 #include <string_view>
 #include <initializer_list>
 #include <iostream>
 #include <functional>
+#include <vector>
 		
 #include "gd_utf8.hpp"
 
@@ -64,6 +66,52 @@ namespace gd::utf8 {
 
    struct buffer;
 
+   /**
+    * @brief Memory for string buffers, bind allocator to string to select where text is allocated
+    * Buffers remember allocator they are allocated from, buffer shared by
+    * strings with different allocators is returned to the right allocator.
+    * Allocator need to live longer than strings using it.
+    */
+   struct allocator
+   {
+      virtual ~allocator() {}
+      virtual void* allocate( std::size_t uSize ) = 0;
+      virtual void deallocate( void* p, std::size_t uSize ) = 0;
+   };
+
+   /**
+    * @brief Monotonic allocator, memory is taken from large blocks and all blocks are freed at once
+    * `deallocate` does nothing, memory is freed with `release` or when arena is
+    * destroyed. Use it for strings with same lifetime, like all sections in
+    * one file. Arena is not thread safe.
+    */
+   class arena : public allocator
+   {
+   public:
+      arena() {}
+      explicit arena( std::size_t uBlockSize ): m_uBlockSize( uBlockSize ) {}
+      arena( const arena& ) = delete;
+      arena& operator=( const arena& ) = delete;
+      ~arena() override { release(); }
+
+   public:
+      void* allocate( std::size_t uSize ) override;
+      void deallocate( void*, std::size_t ) override {}                       // freed in release
+      /// free all memory, strings using arena can't be used after this
+      void release();
+      /// bytes taken from arena
+      std::size_t size() const noexcept { return m_uSize; }
+      /// number of blocks allocated
+      std::size_t block_count() const noexcept { return m_vectorBlock.size(); }
+
+   public:
+      std::size_t m_uBlockSize = 64 * 1024;  ///< size for each block, larger requests get their own block
+      std::size_t m_uSize = 0;               ///< bytes taken from arena
+      uint8_t* m_puPosition = nullptr;       ///< next free position in active block
+      uint8_t* m_puEnd = nullptr;            ///< end of active block
+      std::vector<uint8_t*> m_vectorBlock;   ///< allocated blocks
+   };
+
 class string
 {
 public:
@@ -71,14 +119,19 @@ public:
       eBufferStorageReferenceCount   = 0x01,   // normal string, it is reference counted and it owns memory and should free memory when destruct
       eBufferStorageStack            = 0x02,   // string data is on stack, do not delete
       eBufferStorageSingle           = 0x04,   // string data is not reference counted
+      eBufferStorageInline           = 0x08,   // string data is stored in string object (short text), combined with single if string is unique
       eBufferStorageEmptyReference   = 0x0100,
       eBufferStorageEmptySingle      = 0x0200,
+      eBufferStorageEmptyAtomic      = 0x0400,
       eBufferMaskType                = 0x00000000ff,// mask type part in flags member
       eBufferMaskMemory              = 0x000000ff00,// mask memory logic type
+      eBufferStorageAllocator        = 0x0000010000,// buffer is allocated with allocator, pointer to allocator is placed before buffer
+      eBufferStorageAtomic           = 0x0000020000,// reference counter and character count are atomic, combined with reference count (or inline) buffer can be shared between threads
+      eBufferTextAscii               = 0x0000040000,// text is ascii only and each character is one byte, set when text is assigned and kept by edits that only add ascii
    };
 
    // constant to set storage type
-   enum storage { reference_counter, unique };
+   enum storage { reference_counter, unique, atomic_counter };
 
 public:
    typedef string                self;
@@ -302,7 +355,10 @@ public:
    /// construct string with specific storage type
    /// storage::reference_counter = string has reference counter
    /// storage::unique = string owns data, use this in threaded code
-   string(storage _1) { m_pbuffer = _1 == storage::reference_counter ? string::m_pbuffer_empty_reference : string::m_pbuffer_empty_unique; }
+   /// storage::atomic_counter = string has atomic reference counter, copies can be used in other threads (copy on write)
+   string(storage _1) { m_pbuffer = _1 == storage::reference_counter ? string::m_pbuffer_empty_reference : ( _1 == storage::unique ? string::m_pbuffer_empty_unique : string::m_pbuffer_empty_atomic ); }
+   /// construct string where text buffers are allocated with allocator
+   explicit string( gd::utf8::allocator* pallocator ): m_pbuffer(string::m_pbuffer_empty_reference), m_pallocator( pallocator ) {}
    explicit string( gd::utf8::buffer bufferStack );
    explicit string( const char* pbszText ): m_pbuffer(string::m_pbuffer_empty_reference) { assign( pbszText ); }
    string( std::string_view stringText );
@@ -311,13 +367,9 @@ public:
    template<typename CHAR>
    string( std::initializer_list<CHAR> listString ) : m_pbuffer(string::m_pbuffer_empty_reference) { assign( listString ); }
 
-   string(string&& o) noexcept : m_pbuffer( o.m_pbuffer ) {
-      string::add_reference(m_pbuffer);
-      m_pbuffer->set_null_buffer( o.m_pbuffer );
-      DEBUG_ONLY( m_psz = m_pbuffer->c_str() );
-   }
+   string(string&& o) noexcept : m_pbuffer( string::m_pbuffer_empty_reference ), m_pallocator( o.m_pallocator ) { _move( o ); }
 
-   string(const string& o): m_pbuffer(string::m_pbuffer_empty_reference) { copy(o); }
+   string(const string& o): m_pbuffer(string::m_pbuffer_empty_reference), m_pallocator( o.m_pallocator ) { copy(o); }
    //string(const string& o): m_pbuffer( string::m_pbuffer_empty ) { clone(o); }
    ~string() {                                                                assert( m_pbuffer->get_reference() != 0 );
       string::release( m_pbuffer ); 
@@ -327,8 +379,7 @@ public:
    string& operator=(const string& o) { copy(o); return *this; }
    //string& operator=(const string& o) { clone(o); return *this; }
    string& operator=(string&& o) noexcept { 
-      m_pbuffer = o.m_pbuffer; 
-      m_pbuffer->set_null_buffer(o.m_pbuffer);
+      if( this != &o ) { string::release( m_pbuffer ); m_pallocator = o.m_pallocator; _move( o ); }
       return *this;
    }
    string& operator=( const char* pbszText ) { return assign( pbszText ); }
@@ -345,6 +396,10 @@ public:
    [[nodiscard]] uint32_t size() const { return m_pbuffer->size(); }
    [[nodiscard]] uint32_t length() const { return m_pbuffer->size(); }
    [[nodiscard]] uint32_t count() const { return m_pbuffer->count(); }
+   /// Check if number of characters is known, count is calculated first time it is needed after text is modified
+   [[nodiscard]] bool is_counted() const { return m_pbuffer->is_counted(); }
+   /// Check if text is ascii only, count, position and find work on bytes when it is
+   [[nodiscard]] bool is_ascii() const { return m_pbuffer->is_ascii() || m_pbuffer->empty(); }
    [[nodiscard]] uint32_t capacity() const { return m_pbuffer->capacity(); }
    [[nodiscard]] bool empty() const { return m_pbuffer->empty(); }
    //[[nodiscard]] const value_type* c_buffer() const { assert(m_pbuffer != string::m_pbuffer_empty); return m_pbuffer->c_buffer(); }
@@ -353,12 +408,12 @@ public:
 
 public:
    void copy(const string& o);
-   void clone(const string& o) { string::release(m_pbuffer); _clone(o); }
+   void clone(const string& o) { buffer* pbufferEmpty = string::get_empty( m_pbuffer ); string::release(m_pbuffer); m_pbuffer = pbufferEmpty; _clone(o); }
 
    /** @name COMPARE
     *///@{
    bool compare( const value_type* pbszText ) const noexcept { return strcmp( c_str(), decltype(c_str())(pbszText) ) == 0; }
-   bool compare( const string& o ) const noexcept { return count() == o.count() ? memcmp( c_str(), o.c_str(), size() ) == 0 : false; }
+   bool compare( const string& o ) const noexcept { return size() == o.size() ? memcmp( c_str(), o.c_str(), size() ) == 0 : false; }
    //@}
 
 
@@ -367,7 +422,7 @@ public:
    string& assign( const char* pbszText, uint32_t uLength );
    string& assign( const value_type* pbszText, uint32_t uSize, uint32_t uCount );
    //string& assign( const value_type* pbszText, uint32_t uSize ) { return assign( pbszText, uSize, gd::utf8::count( pbszText, pbszText + uSize ).first ); }
-   string& assign( const value_type* pbszText, std::size_t uSize ) { return assign( pbszText, static_cast<uint32_t>( uSize ), gd::utf8::count( pbszText, pbszText + uSize ).first ); }
+   string& assign( const value_type* pbszText, std::size_t uSize ) { return assign( pbszText, static_cast<uint32_t>( uSize ), uSize == 0 ? 0 : buffer::npos ); }// characters are counted when needed
    string& assign( const string& stringFrom );
    template<typename CHAR>
    string& assign( std::initializer_list<CHAR> listString ) { // _Ilist.begin(), _Convert_size<size_type>(_Ilist.size()));
@@ -394,7 +449,7 @@ public:
    string& append( const char* pbszText, uint32_t uLength );
    string& append( const value_type* puText, uint32_t uLength );
    string& append( const value_type* puText, uint32_t uLength, uint32_t uCount );
-   string& append( const string& o ) { return append( o.c_buffer(), o.size(), o.count() ); }
+   string& append( const string& o ) { return append( o.c_buffer(), o.size(), o.m_pbuffer->get_count() ); }
    //@}
 
 
@@ -422,13 +477,12 @@ public:
    //@}
 
 
-   [[nodiscard]] gd::utf8::value32 at( size_type uIndex ) const { 
-      auto it = begin();
-      std::advance( it, uIndex );
-      return value32( it.m_pPosition );
-   }
+   [[nodiscard]] gd::utf8::value32 at( size_type uIndex ) const { return value32( position( uIndex ).m_pPosition ); }
    [[nodiscard]] gd::utf8::value32 at( const_iterator it ) const { return value32( it.m_pPosition ); }
 
+   /// position for character, character index is used for large text. end is returned if index is past last character
+   [[nodiscard]] const_iterator position( size_type uIndex ) const;
+
    [[nodiscard]] const_iterator find( value_type ch ) const;
    [[nodiscard]] const_iterator find( value_type ch, const_iterator itFrom ) const;
 
@@ -462,8 +516,9 @@ public:
    iterator erase( iterator itFirst, iterator itLast, bool bCount );
    void clear() {
       if( m_pbuffer->is_refcount() && m_pbuffer->get_reference() > 1 ) {
+         buffer* pbufferEmpty = string::get_empty( m_pbuffer );
          string::release( m_pbuffer );
-         m_pbuffer = string::m_pbuffer_empty_reference;
+         m_pbuffer = pbufferEmpty;
       }
       else if( m_pbuffer->is_common_empty() == false  ) {
          m_pbuffer->count( 0 ); m_pbuffer->size( 0 ); m_pbuffer->null_terminate();
@@ -489,6 +544,29 @@ public:
    void allocate_exact( uint32_t uSize );
    static void allocate_exact(string& stringObject, uint32_t uSize);
 
+   /// Set size and character count after text is written directly to buffer (see `c_buffer`), buffer needs to be allocated. Count can be `buffer::npos` if not known
+   void set_size( uint32_t uSize, uint32_t uCount ) {                         assert( m_pbuffer->is_common_empty() == false ); assert( uSize <= capacity() );
+      bool bAscii = gd::utf8::is_ascii( c_buffer(), c_buffer() + uSize );     // text is checked once when it is written
+      m_pbuffer->size( uSize ); m_pbuffer->count( bAscii == true ? uSize : uCount ); m_pbuffer->ascii( bAscii ); m_pbuffer->null_terminate();
+   }
+
+   /// Swap buffers with other string, text stored in string object is moved. Allocator follows its buffer
+   void swap( string& o ) noexcept { 
+      if( m_pbuffer->is_inline() == false && o.m_pbuffer->is_inline() == false ) { std::swap( m_pbuffer, o.m_pbuffer ); std::swap( m_pallocator, o.m_pallocator ); DEBUG_ONLY( std::swap( m_psz, o.m_psz ) ); return; }
+      string stringSwap( std::move( o ) );                                     // allocator is moved with text
+      o = std::move( *this );
+      *this = std::move( stringSwap );
+   }
+
+   /// Check if text is stored in string object, short text do not need to be allocated
+   [[nodiscard]] bool is_inline() const { return m_pbuffer->is_inline(); }
+   /// Check if buffer is reference counted, copies share buffer until one of them is changed
+   [[nodiscard]] bool is_refcount() const { return m_pbuffer->is_refcount(); }
+
+   /// allocator used when string needs a new buffer, nullptr = new/delete
+   [[nodiscard]] gd::utf8::allocator* get_allocator() const { return m_pallocator; }
+   void set_allocator( gd::utf8::allocator* pallocator ) { m_pallocator = pallocator; }
+
    /** @name SUPPORT methods ( miscellaneous methods working with utf8 string )
     *///@{
    void create_single_if_referenced() { if( m_pbuffer->is_used_by_many() ) { _clone( *this ); } }
@@ -499,22 +577,49 @@ public:
 
 public:
 
+   /// sparse index from character to byte offset, one checkpoint for each `step` characters
+   struct character_index
+   {
+      static constexpr uint32_t step = 64;         ///< characters between checkpoints
+      static constexpr uint32_t min_size = 1024;   ///< index is not used for text smaller than this (bytes)
+      std::vector<uint32_t> m_vectorOffset;        ///< byte offset for character 0, step, 2*step ...
+   };
+
    struct buffer
    {
       uint32_t m_uSize;             /// string length in bytes
       uint32_t m_uSizeBuffer;       /// string length in bytes
-      uint32_t m_uCount;            /// Number of utf8 characters in text
+      mutable uint32_t m_uCount;    /// Number of utf8 characters in text, npos if not counted
       uint32_t m_uFlags;            /// Internal flags how string logic works ( see: enumBufferStorage )
       int32_t  m_iReferenceCount;   /// reference counter
 
       uint32_t flags() const { return m_uFlags; }
       void flags( uint32_t uFlags ) { m_uFlags = uFlags; }
       uint32_t length() const { return m_uSize; }
-      void length( uint32_t uLength ) { m_uSize = uLength; }
+      void length( uint32_t uLength ) { index_drop(); m_uSize = uLength; }
       uint32_t size() const { return m_uSize; }
-      void size( uint32_t uSize ) { m_uSize = uSize; }
-      uint32_t count() const { return m_uCount; }
-      void count( uint32_t uCount ) { m_uCount = uCount; }
+      void size( uint32_t uSize ) { index_drop(); m_uSize = uSize; }
+      static constexpr uint32_t npos = 0xffffffff;///< value for m_uCount when characters need to be counted
+
+      /// number of characters, characters are counted if text has been modified since last count
+      uint32_t count() const { 
+         uint32_t uCount = get_count();
+         if( uCount == npos )
+         {
+            if( is_ascii() == true ) uCount = m_uSize;                         // one byte for each character
+            else uCount = m_uSize > 0 ? gd::utf8::count( c_buffer(), c_buffer_end() ).first : 0;
+            if( is_type_atomic() == true ) std::atomic_ref<uint32_t>( m_uCount ).store( uCount, std::memory_order_relaxed );// shared buffer may be counted by other threads, all get the same value
+            else                           m_uCount = uCount;
+         }
+         return uCount; 
+      }
+      void count( uint32_t uCount ) { index_drop(); m_uCount = uCount; }
+      /// add to count if characters are counted
+      void add_count( uint32_t uCount ) { index_drop(); if( m_uCount != npos ) m_uCount += uCount; }
+      /// mark count as unknown, text has been modified and characters are counted when needed
+      void count_invalidate() { index_drop(); m_uCount = m_uSize == 0 ? 0 : npos; }
+      bool is_counted() const { return get_count() != npos; }
+      uint32_t get_count() const { return is_type_atomic() == true ? std::atomic_ref<uint32_t>( m_uCount ).load( std::memory_order_relaxed ) : m_uCount; }
       uint32_t capacity() const { return m_uSizeBuffer; }
       void capacity( uint32_t uCapacity ) { m_uSizeBuffer = uCapacity; }
       bool empty() const { return m_uSize == 0; }
@@ -524,15 +629,46 @@ public:
          return true;
       }
 
-      void add_size( uint32_t uSize ) { m_uSize += uSize; }
+      void add_size( uint32_t uSize ) { index_drop(); m_uSize += uSize; }
 
-      bool is_refcount() const { assert(check_flags()); return (m_uFlags & eBufferMaskType) == eBufferStorageReferenceCount ? true : false; }  // string is reference counted (don't use this if string is accessed from multiple threads)
+      bool is_refcount() const { assert(check_flags()); return (m_uFlags & eBufferMaskType) == eBufferStorageReferenceCount ? true : false; }  // string is reference counted (only share between threads if type is atomic)
       bool is_stack() const { return (m_uFlags & eBufferMaskType) == eBufferStorageStack ? true : false; }              // string is allocated on stack
       bool is_single() const { return (m_uFlags & eBufferMaskType) == eBufferStorageSingle ? true : false; }            // string owns it space, used this for threads
       bool is_common_empty() const { return (m_uFlags & eBufferMaskMemory) != 0 ? true : false;  }                      // empty buffer
+      bool is_inline() const { return (m_uFlags & eBufferStorageInline) != 0 ? true : false; }                          // buffer is stored in string object
+      bool is_ascii() const { return (m_uFlags & eBufferTextAscii) != 0 ? true : false; }                               // text is ascii only
+      void ascii( bool bAscii ) {                                                                                       assert( is_common_empty() == false );
+         if( bAscii == true ) m_uFlags |= eBufferTextAscii; else m_uFlags &= ~eBufferTextAscii;
+      }
+      /// allocator buffer was allocated with, nullptr if allocated with new
+      gd::utf8::allocator* get_allocator() const { return (m_uFlags & eBufferStorageAllocator) != 0 ? reinterpret_cast<gd::utf8::allocator* const*>( index_slot() )[-1] : nullptr; }
+      /// buffer is allocated with `new_buffer`, slot for character index is placed before buffer
+      bool is_heap() const { return (m_uFlags & (eBufferStorageInline | eBufferStorageStack | eBufferMaskMemory)) == 0 ? true : false; }
+      character_index** index_slot() const { return reinterpret_cast<character_index**>( const_cast<buffer*>( this ) ) - 1; }
+      /// character index for text, nullptr if not built (or buffer can't have index)
+      const character_index* get_index() const {
+         if( is_heap() == false ) return nullptr;
+         return is_type_atomic() == true ? std::atomic_ref<character_index*>( *index_slot() ).load( std::memory_order_acquire ) : *index_slot();
+      }
+      /// set character index if not set, returns index used by buffer (other thread may set index first for atomic buffers)
+      const character_index* set_index( character_index* pindex ) {                       assert( is_heap() == true );
+         character_index* pindexOld = nullptr;
+         if( is_type_atomic() == true ) { if( std::atomic_ref<character_index*>( *index_slot() ).compare_exchange_strong( pindexOld, pindex, std::memory_order_acq_rel ) == false ) return pindexOld; }
+         else *index_slot() = pindex;
+         return pindex;
+      }
+      /// text is modified, drop character index
+      void index_drop() { if( is_heap() == true && *index_slot() != nullptr ) string::free_index( this ); }
+      /// bytes allocated for buffer, header and text with zero terminator
+      std::size_t size_allocated() const { return sizeof( buffer ) + m_uSizeBuffer + 1; }
       bool is_used_by_many() const { return m_iReferenceCount > 1; }
       bool is_type_reference() const { return (m_uFlags & (eBufferStorageReferenceCount | eBufferStorageEmptyReference)) == 0 ? false : true; }
       bool is_type_single() const {  return (m_uFlags & (eBufferStorageSingle | eBufferStorageEmptySingle)) == 0 ? false : true; }
+      bool is_type_atomic() const {  return (m_uFlags & (eBufferStorageAtomic | eBufferStorageEmptyAtomic)) == 0 ? false : true; }
+      /// storage type for allocated buffer when string grows, unique strings stay unique and atomic strings stay atomic
+      uint32_t get_allocate_storage() const { return is_type_single() || is_stack() ? eBufferStorageSingle : ( is_type_atomic() ? ( eBufferStorageReferenceCount | eBufferStorageAtomic ) : eBufferStorageReferenceCount ); }
+      /// storage type when text is stored in string object
+      uint32_t get_inline_storage() const { return is_type_single() || is_stack() ? ( eBufferStorageInline | eBufferStorageSingle ) : ( is_type_atomic() ? ( eBufferStorageInline | eBufferStorageAtomic ) : eBufferStorageInline ); }
 
 
 
@@ -556,23 +692,30 @@ public:
       string::pointer move_to( buffer* pbuffer, string::const_pointer p ) const { return pbuffer->c_buffer() + (p - c_buffer()); }
 
       void set_reference( int32_t iCount ) { m_iReferenceCount = iCount; }
-      void add_reference() { if( is_single() == false ) m_iReferenceCount++;  }
-      int32_t get_reference() const { return m_iReferenceCount; }
+      void add_reference() { 
+         if( is_single() == true ) return;
+         if( is_type_atomic() == true ) std::atomic_ref<int32_t>( m_iReferenceCount ).fetch_add( 1, std::memory_order_relaxed );
+         else                           m_iReferenceCount++;
+      }
+      int32_t get_reference() const { return is_type_atomic() == true ? std::atomic_ref<int32_t>( const_cast<int32_t&>( m_iReferenceCount ) ).load( std::memory_order_acquire ) : m_iReferenceCount; }
 
       void set_null_buffer(buffer* pbuffer)
       {
-         if(is_type_reference()) pbuffer = string::m_pbuffer_empty_reference;
-         else                    pbuffer = string::m_pbuffer_empty_unique;
+         pbuffer = string::get_empty( this );
       }
 
       void release()
-      {                                                                        assert( m_iReferenceCount > 0 );
+      {                                                                        assert( get_reference() > 0 );
          if( is_stack() == false )
          {
-            m_iReferenceCount--;
-            if( m_iReferenceCount == 0 ) {
-               delete[] reinterpret_cast<buffer*>(this);
+            if( is_type_atomic() == true )
+            {
+               if( std::atomic_ref<int32_t>( m_iReferenceCount ).fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) string::free_buffer( this );
+               return;
             }
+
+            m_iReferenceCount--;
+            if( m_iReferenceCount == 0 ) string::free_buffer( this );
          }
       }
    };
@@ -589,8 +732,33 @@ public:
    //buffer* m_pbuffer = string::m_pbuffer_empty_reference;
    buffer* m_pbuffer;// = string::m_pbuffer_empty_memory;
 
+   /// buffer in string object for short text, header is followed by text like allocated buffers
+   struct buffer_inline
+   {
+      static constexpr uint32_t capacity = 64 - sizeof( buffer* ) - sizeof( gd::utf8::allocator* ) - sizeof( buffer ) - 1;///< max text size, string object is 64 bytes (without debug members)
+      buffer m_buffer;
+      value_type m_puText[capacity + 1];
+   };
+   gd::utf8::allocator* m_pallocator = nullptr;///< allocator for new buffers, nullptr = new/delete
+   buffer_inline m_bufferInline;
+
 private:
    void _clone(const string& o);
+   void _copy_inline( const string& o );
+   void _move( string& o ) noexcept;
+   void _use_inline();
+   /// copy buffer before edit if it is shared with other strings, returns same position in buffer that is safe to modify
+   pointer _safe_to_modify( const_pointer pPosition ) {
+      std::size_t uOffset = pPosition - m_pbuffer->c_buffer();
+      m_pbuffer = string::safe_to_modify( m_pbuffer );                         DEBUG_ONLY( m_psz = reinterpret_cast<const char*>( m_pbuffer->c_buffer() ) );
+      return m_pbuffer->c_buffer() + uOffset;
+   }
+   /// set ascii flag after edit, common empty buffers are not changed
+   void _set_ascii( bool bAscii ) { if( m_pbuffer->is_common_empty() == false ) m_pbuffer->ascii( bAscii ); }
+   static buffer* new_buffer( gd::utf8::allocator* pallocator, std::size_t uSize );
+   static void free_buffer( buffer* pbuffer );
+   static void free_index( buffer* pbuffer );
+   const character_index* get_character_index() const;
 
    static bool is_empty( const buffer* pbuffer ) { return pbuffer->is_common_empty(); }
    static void add_reference(buffer* pbuffer) {
@@ -598,15 +766,22 @@ private:
    }
    static void release( buffer* pbuffer ) {
       if( pbuffer->is_refcount() ) pbuffer->release(); 
+      else if( pbuffer->is_single() ) string::free_buffer( pbuffer );          // allocated buffer owned by string
    }
    static buffer* safe_to_modify(buffer* pbuffer) {
       if(pbuffer->is_refcount() && pbuffer->get_reference() > 1) {
+         buffer* pbufferCopy = pbuffer->clone();                              // copy before release, other owners may release at the same time (atomic)
          pbuffer->release();
-         pbuffer = pbuffer->clone();
-         return pbuffer;
+         return pbufferCopy;
       }
       return pbuffer;
    }
+   /// common empty buffer with same storage type as buffer
+   static buffer* get_empty( const buffer* pbuffer ) {
+      if( pbuffer->is_type_single() ) return string::m_pbuffer_empty_unique;
+      if( pbuffer->is_type_atomic() ) return string::m_pbuffer_empty_atomic;
+      return string::m_pbuffer_empty_reference;
+   }
 
    static buffer* clone( buffer* p ) { 
       if( p->is_common_empty() == false ) {
@@ -631,6 +806,14 @@ private:
       -1,// size ( m_iReferenceCount )
       0  // last character is zero to mimic null terminator 
    };
+   inline static buffer m_pbuffer_empty_atomic[] = {
+      0, // size ( m_uSize )
+      0, // total buffer size ( m_uSizeBuffer )
+      0, // number of utf8 characters ( m_uCount )
+      0x00000400, // flags ( m_uFlags ) 0x0400 is marked as empty atomic reference buffer
+      -1,// size ( m_iReferenceCount )
+      0  // last character is zero to mimic null terminator 
+   };
 };
 
 /**
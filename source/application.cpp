@@ -8,59 +8,67 @@ namespace application {
 
    /**
     * @brief Load file into utf8 string
-    * @param stringFile 
-    * @param stringName 
-    * @return 
+    * File is memory mapped and text is copied from mapped pages into string, 
+    * string is allocated once with the exact size needed.
+    * @param stringFile file to load
+    * @param stringLoadText string getting file text (without BOM, UTF-16 files are converted to UTF-8)
+    * @return true if ok, otherwise false and error information
    */
    std::pair<bool, std::string> FILE_Load( std::string_view stringFile, gd::utf8::string& stringLoadText )
    {
-      std::ifstream ifstreamText;
-      ifstreamText.open( std::string( stringFile ), std::ios::in );
-      if( ifstreamText )
-      {
-         std::vector<uint8_t> vectorBuffer;
-         char uValue;
-         while( ifstreamText.get( uValue ) )
-         {
-            vectorBuffer.push_back( uValue );
-         }
-         ifstreamText.close();
-
-         if( vectorBuffer.empty() == false )
-         {
-            gd::utf8::string stringText;
-            auto _size = vectorBuffer.size();
-            auto pbBOM = vectorBuffer.data();
-            if( pbBOM[ 0 ] == 0xEF && pbBOM[ 1 ] == 0xBB && pbBOM[ 2 ] == 0xBF )
-            {
-               stringText.assign( reinterpret_cast<const uint8_t*>(pbBOM + 3), vectorBuffer.size() - 3 );
-            }
-            else
-            {
-               stringText.assign( vectorBuffer.data(), vectorBuffer.size() );
-            }
-
-            stringLoadText = stringText;
-         }
-      }
-      else
+      file::CFileMap filemapText;
+      auto [bOk, stringError] = filemapText.Open( stringFile );
+      if( bOk == false )
       {
          return { false, std::format("Failed to load file: {} [FILE_Load]", stringFile)};
       }
 
-      return { true, std::string() };
+      return filemapText.Text( stringLoadText );                               // text without BOM, UTF-16 is converted to UTF-8
    }
 
    std::pair<bool, std::string> FILE_Save( std::string_view stringFile, gd::utf8::string& stringSaveText )
    {
-      std::ofstream ofstreamText( stringFile.data(), std::ofstream::binary );
-      if( ofstreamText )
+      std::ofstream ofstreamText( std::string( stringFile ), std::ofstream::binary );
+      if( ofstreamText.is_open() == false ) return { false, std::format("Failed to save file: {} [FILE_Save]", stringFile) };
+
+      ofstreamText.write( stringSaveText.c_str(), stringSaveText.size() );
+      ofstreamText.close();
+
+      return { true, std::string() };
+   }
+
+   /**
+    * @brief Save file sections, sections are written directly from section buffers (or pieces for edited sections)
+    * @param stringFile file to save to
+    * @param fileSave file with sections to save
+    * @param uFlags flags used to write file (see: `file::CFileWrite::enumFlag`)
+    * @return true if ok, otherwise false and error information
+   */
+   std::pair<bool, std::string> FILE_Save( std::string_view stringFile, const file::CFile& fileSave, unsigned uFlags )
+   {
+      file::CFileWrite filewrite;
+      auto result_ = filewrite.Open( stringFile, uFlags );
+      if( result_.first == false ) return { false, std::format("Failed to save file: {} [FILE_Save]", stringFile) };
+
+      for( auto it = fileSave.SECTION_Begin(); it != fileSave.SECTION_End(); it++ )
       {
-         ofstreamText.write( stringSaveText.c_str(), stringSaveText.size() );
-         ofstreamText.close();
+         if( it->EDIT_Active() == true )                                       // edited section, pieces are written without rebuilding code
+         {
+            it->piecetable()->for_each( [&filewrite, &result_]( const uint8_t* pubText, std::size_t uSize ) {
+               if( result_.first == true ) result_ = filewrite.Write( pubText, uSize );
+            } );
+         }
+         else if( it->eraselist().empty() == false )                           // erased spans are skipped, code is not compacted
+         {
+            it->eraselist().for_each( it->view(), [&filewrite, &result_]( const uint8_t* pubText, std::size_t uSize ) {
+               if( result_.first == true ) result_ = filewrite.Write( pubText, uSize );
+            } );
+         }
+         else result_ = filewrite.Write( reinterpret_cast<const uint8_t*>( it->view().data() ), it->view().length() );// views are written from shared buffer
+         if( result_.first == false ) return result_;
       }
 
-      return { true, std::string() };
+      return filewrite.Close();
    }
 
    /**
@@ -88,21 +96,16 @@ namespace application {
     * @brief Save utf8 sections  with specified file name
     * @param stringFile name of file sections are save to
     * @param stringName file name in document
+    * @param uFlags flags used to write file (see: `file::CFileWrite::enumFlag`)
     * @return true if ok, otherwise false and string message with error information
    */
-   std::pair<bool, std::string> CDocument::FILE_Save( std::string_view stringFile, std::string_view stringName )
+   std::pair<bool, std::string> CDocument::FILE_Save( std::string_view stringFile, std::string_view stringName, unsigned uFlags )
    {
       // collect information from attached sections
       const file::CFile* pFile = FILE_Get( stringName );
       if( pFile != nullptr )
       {
-         gd::utf8::string stringCode;
-         for( auto it = pFile->SECTION_Begin(); it != pFile->SECTION_End(); it++ )
-         {
-            stringCode += it->code();
-         }
-
-         return application::FILE_Save( stringFile, stringCode );
+         return application::FILE_Save( stringFile, *pFile, uFlags );
       }
 
       return { true, std::string() };
@@ -11,6 +11,7 @@
 namespace application {
 
    extern std::pair<bool, std::string> FILE_Load( std::string_view stringFile, gd::utf8::string& stringLoadText );
+   extern std::pair<bool, std::string> FILE_Save( std::string_view stringFile, const file::CFile& fileSave, unsigned uFlags = 0 );
 
 /**
  * ## CDocument ===============================================================
@@ -38,7 +39,8 @@ namespace application {
          return nullptr;
       }
       std::pair<bool, std::string> FILE_Load( std::string_view stringFile, std::string_view stringName );
-      std::pair<bool, std::string> FILE_Save( std::string_view stringFile, std::string_view stringName );
+      std::pair<bool, std::string> FILE_Save( std::string_view stringFile, std::string_view stringName ) { return FILE_Save( stringFile, stringName, 0 ); }
+      std::pair<bool, std::string> FILE_Save( std::string_view stringFile, std::string_view stringName, unsigned uFlags );
 
    public:
       std::string m_stringName;     ///< document name
@@ -0,0 +1,1076 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/regex.hpp>
+
+#include "application_automaton.hpp"
+
+namespace application { namespace file {
+
+/// context for position between two characters, used to check line anchors
+enum enumContext : unsigned { eContextEdge = 0, eContextLF, eContextCR, eContextFF, eContextOther, eContextMax };
+
+static unsigned context_s( uint8_t uByte ) { return uByte == '\n' ? eContextLF : uByte == '\r' ? eContextCR : uByte == '\f' ? eContextFF : eContextOther; }
+static bool separator_s( unsigned uContext ) { return uContext == eContextLF || uContext == eContextCR || uContext == eContextFF; }
+/// `^` matches at start of text and after line separator but not between "\r\n" (same as boost)
+static bool bol_s( unsigned uBefore, unsigned uAfter ) { return uBefore == eContextEdge || ( separator_s( uBefore ) == true && !( uBefore == eContextCR && uAfter == eContextLF ) ); }
+/// `$` matches at end of text and before line separator but not between "\r\n" (same as boost)
+static bool eol_s( unsigned uBefore, unsigned uAfter ) { return uAfter == eContextEdge || ( separator_s( uAfter ) == true && !( uBefore == eContextCR && uAfter == eContextLF ) ); }
+
+constexpr std::size_t uMaxInstruction_ = 100000;                              // larger patterns use boost
+constexpr std::size_t uMaxState_ = 4096;                                      // states cached for each direction, more states are built for each step
+constexpr int iMaxRepeat_ = 1000;                                             // max count in `{n,m}`
+constexpr std::size_t uMaxExact_ = 16;                                        // max strings in exact literal set
+constexpr std::size_t uMaxPrefix_ = 8;                                        // max prefix literals searched for candidates
+
+/**
+ * ## CAutomaton::program =====================================================
+ */
+
+struct CAutomaton::program
+{
+   /// one bit for each byte value
+   struct byteset
+   {
+      uint64_t m_auBit[4] = { 0, 0, 0, 0 };
+
+      bool test( unsigned uByte ) const noexcept { return ( m_auBit[uByte >> 6] >> ( uByte & 63 ) ) & 1; }
+      void set( unsigned uByte ) noexcept { m_auBit[uByte >> 6] |= uint64_t( 1 ) << ( uByte & 63 ); }
+      void set( unsigned uFrom, unsigned uTo ) noexcept { for( unsigned u = uFrom; u <= uTo; u++ ) set( u ); }
+      void set( const byteset& set_ ) noexcept { for( unsigned u = 0; u < 4; u++ ) m_auBit[u] |= set_.m_auBit[u]; }
+      void invert() noexcept { for( auto& it : m_auBit ) it = ~it; }
+      bool operator==( const byteset& o ) const noexcept { return std::memcmp( m_auBit, o.m_auBit, sizeof( m_auBit ) ) == 0; }
+   };
+
+   /// parsed pattern
+   struct node
+   {
+      enum enumKind { eKindEmpty, eKindSet, eKindConcat, eKindAlternate, eKindRepeat, eKindBol, eKindEol };
+      enumKind m_eKind = eKindEmpty;
+      uint32_t m_uSet = 0;             ///< index for byte set if set node
+      int m_iMin = 0;                  ///< min count if repeat node
+      int m_iMax = 0;                  ///< max count if repeat node, -1 for no limit
+      bool m_bGreedy = true;           ///< greedy or lazy repeat
+      std::vector<node> m_vectorChild;
+   };
+
+   enum enumOp : uint8_t { eOpByte, eOpSplit, eOpBol, eOpEol, eOpMatch };
+
+   /// NFA instruction, split prefers `m_uNext` before `m_uArgument`
+   struct instruction
+   {
+      uint8_t m_uOp;
+      uint32_t m_uNext;                ///< next instruction (preferred for split)
+      uint32_t m_uArgument;            ///< byte set for byte instruction, second choice for split
+   };
+
+   /// DFA state, ordered list with NFA instructions (threads) and context for character consumed to reach state
+   struct state
+   {
+      std::vector<uint32_t> m_vectorThread;  ///< NFA threads before empty transitions are followed, in priority order
+      unsigned m_uContext = eContextEdge;    ///< context for character consumed to reach state
+      unsigned m_uMatch = 0;                 ///< one bit for each context on the other side, set if match is reached
+      bool m_bDead = false;                  ///< no threads, search is done
+      std::unique_ptr<std::atomic<const state*>[]> m_apNext;  ///< transition for each byte class, null if state is not cached
+   };
+
+   /// NFA with DFA states, forward machine finds end of leftmost first match, reverse machine finds longest match backwards from end
+   struct machine
+   {
+      std::vector<instruction> m_vectorInstruction;
+      uint32_t m_uStart = 0;
+      bool m_bReverse = false;
+      mutable std::mutex m_mutex;                                             ///< locks state map, transitions are read without lock
+      mutable std::unordered_map<std::string, std::unique_ptr<state>> m_mapState;
+      mutable std::atomic<const state*> m_apStart[eContextMax];
+   };
+
+   /// literals for node, exact set is all strings node can match
+   struct literal_info
+   {
+      bool m_bExact = false;                    ///< node only matches strings in exact set
+      std::vector<std::string> m_vectorExact;
+      std::vector<std::string> m_vectorPrefix;  ///< every match starts with one of these, empty if unknown
+      std::string m_stringRequired;             ///< every match contains this, empty if unknown
+   };
+
+   /// buffers used while searching, one for each search
+   struct work
+   {
+      std::vector<uint8_t> m_vectorVisit;
+      std::vector<uint32_t> m_vectorStack;
+      std::vector<uint32_t> m_vectorOut;
+      std::vector<uint32_t> m_vectorThread;
+      state m_astateScratch[2];              ///< states used when cache is full
+   };
+
+   struct parser;
+   struct compiler;
+
+   bool Compile();
+   uint32_t SET_Add( const byteset& set_ );
+   void Literal( const node& node_, literal_info& info_ ) const;
+   literal Literals( const node& nodeRoot ) const;
+
+   bool Closure( const machine& machine_, const std::vector<uint32_t>& vectorThread, unsigned uBefore, unsigned uAfter, work& work_ ) const;
+   const state* Intern( const machine& machine_, unsigned uContext, work& work_, const state* pstateFrom, unsigned uClass ) const;
+   const state* Start( const machine& machine_, unsigned uContext, work& work_ ) const;
+   const state* Next( const machine& machine_, const state* pstate, uint8_t uByte, work& work_ ) const;
+   const char* Forward( const char* pbszFirst, const char* pbszLast, unsigned uBefore, unsigned uEnd, work& work_ ) const;
+   const char* Reverse( const char* pbszFirst, const char* pbszEnd, unsigned uBefore, unsigned uAfter, work& work_ ) const;
+
+   std::string m_stringPattern;
+   flag_type m_uSyntax = eSyntaxDefault;
+   std::vector<byteset> m_vectorSet;                                           ///< byte sets used by byte instructions
+   uint8_t m_auClass[256] = {};                                                 ///< byte class for byte, bytes in same class have same transitions
+   uint8_t m_auContext[256] = {};                                               ///< context for byte
+   unsigned m_uClassCount = 0;
+   machine m_machineForward;
+   machine m_machineReverse;
+   literal m_literal;                                                           ///< literals in every match, used to skip text
+   std::unique_ptr<boost::regex> m_pregexFallback;                              ///< pattern compiled with boost if it can't be compiled to automaton
+};
+
+/**
+ * ## parser ==================================================================
+ */
+
+/// parse pattern to nodes, returns false for syntax that automaton do not support (or invalid syntax)
+struct CAutomaton::program::parser
+{
+   parser( program* pprogram, std::string_view stringPattern ): m_pprogram( pprogram ), m_stringPattern( stringPattern ), m_bIcase( ( pprogram->m_uSyntax & eSyntaxIcase ) != 0 ) {}
+
+   bool end() const noexcept { return m_uPosition >= m_stringPattern.length(); }
+   uint8_t peek() const noexcept { return static_cast<uint8_t>( m_stringPattern[m_uPosition] ); }
+
+   /// add byte to set, both cases are added for letters if case is ignored
+   void literal( byteset& set_, unsigned uByte ) const
+   {
+      set_.set( uByte );
+      if( m_bIcase == true && uByte < 0x80 && std::isalpha( static_cast<int>( uByte ) ) ) { set_.set( std::tolower( static_cast<int>( uByte ) ) ); set_.set( std::toupper( static_cast<int>( uByte ) ) ); }
+   }
+
+   bool Alternate( node& nodeResult );
+   bool Sequence( node& nodeResult );
+   bool Atom( node& nodeResult, bool& bSkip );
+   bool Quantifier( node& nodeAtom );
+   bool Escape( byteset& set_, int& iByte );
+   bool Set( node& nodeResult );
+
+   program* m_pprogram;
+   std::string_view m_stringPattern;
+   std::size_t m_uPosition = 0;
+   bool m_bIcase;
+};
+
+bool CAutomaton::program::parser::Alternate( node& nodeResult )
+{
+   node nodeFirst;
+   if( Sequence( nodeFirst ) == false ) return false;
+   if( end() == true || peek() != '|' ) { nodeResult = std::move( nodeFirst ); return true; }
+
+   nodeResult.m_eKind = node::eKindAlternate;
+   nodeResult.m_vectorChild.push_back( std::move( nodeFirst ) );
+   while( end() == false && peek() == '|' )
+   {
+      m_uPosition++;
+      node nodeNext;
+      if( Sequence( nodeNext ) == false ) return false;
+      nodeResult.m_vectorChild.push_back( std::move( nodeNext ) );
+   }
+   return true;
+}
+
+bool CAutomaton::program::parser::Sequence( node& nodeResult )
+{
+   nodeResult.m_eKind = node::eKindConcat;
+   while( end() == false && peek() != '|' && peek() != ')' )
+   {
+      node nodeAtom;
+      bool bSkip = false;
+      if( Atom( nodeAtom, bSkip ) == false ) return false;
+      if( bSkip == true ) continue;
+      if( Quantifier( nodeAtom ) == false ) return false;
+      nodeResult.m_vectorChild.push_back( std::move( nodeAtom ) );
+   }
+
+   if( nodeResult.m_vectorChild.size() == 1 ) { node nodeOne = std::move( nodeResult.m_vectorChild[0] ); nodeResult = std::move( nodeOne ); }
+   else if( nodeResult.m_vectorChild.empty() == true ) nodeResult.m_eKind = node::eKindEmpty;
+   return true;
+}
+
+/**
+ * @brief Parse one atom, group, set, escape or literal
+ * Lookahead is only accepted if the same pattern follows, `(?=X)X` matches the same as `X`.
+ * @param nodeResult gets parsed atom
+ * @param bSkip set to true if atom is removed (lookahead)
+ * @return true if ok, false if syntax is not supported
+*/
+bool CAutomaton::program::parser::Atom( node& nodeResult, bool& bSkip )
+{
+   uint8_t uByte = peek();
+   m_uPosition++;
+   switch( uByte )
+   {
+   case '(' :
+      if( end() == false && peek() == '?' )
+      {
+         if( m_uPosition + 1 >= m_stringPattern.length() ) return false;
+         uint8_t uKind = static_cast<uint8_t>( m_stringPattern[m_uPosition + 1] );
+         if( uKind == ':' ) m_uPosition += 2;
+         else if( uKind == '=' )
+         {
+            m_uPosition += 2;
+            std::size_t uBegin = m_uPosition;
+            node nodeAhead;
+            if( Alternate( nodeAhead ) == false || end() == true || peek() != ')' ) return false;
+            std::string_view stringAhead = m_stringPattern.substr( uBegin, m_uPosition - uBegin );
+            m_uPosition++;
+
+            if( stringAhead.empty() == true || stringAhead.find( '|' ) != std::string_view::npos ) return false;
+            if( m_stringPattern.substr( m_uPosition, stringAhead.length() ) != stringAhead ) return false;
+            std::size_t uAfter = m_uPosition + stringAhead.length();
+            if( uAfter < m_stringPattern.length() && std::strchr( "*+?{", m_stringPattern[uAfter] ) != nullptr ) return false;
+            bSkip = true;
+            return true;
+         }
+         else return false;                                                    // other groups (lookbehind, named, flags ...) are not supported
+      }
+      if( Alternate( nodeResult ) == false || end() == true || peek() != ')' ) return false;
+      m_uPosition++;
+      return true;
+   case '[' : return Set( nodeResult );
+   case '^' : nodeResult.m_eKind = node::eKindBol; return true;
+   case '$' : nodeResult.m_eKind = node::eKindEol; return true;
+   case '.' :
+   {
+      byteset setAny;
+      setAny.set( 0, 255 );
+      nodeResult.m_eKind = node::eKindSet;
+      nodeResult.m_uSet = m_pprogram->SET_Add( setAny );
+      return true;
+   }
+   case '\\' :
+   {
+      byteset set_;
+      int iByte = -1;
+      if( Escape( set_, iByte ) == false ) return false;
+      if( iByte >= 0 ) literal( set_, static_cast<unsigned>( iByte ) );
+      nodeResult.m_eKind = node::eKindSet;
+      nodeResult.m_uSet = m_pprogram->SET_Add( set_ );
+      return true;
+   }
+   case ')' : case '*' : case '+' : case '?' : case '{' : case '|' :
+      return false;
+   default :
+   {
+      byteset set_;
+      literal( set_, uByte );
+      nodeResult.m_eKind = node::eKindSet;
+      nodeResult.m_uSet = m_pprogram->SET_Add( set_ );
+      return true;
+   }
+   }
+}
+
+/// parse quantifier after atom if any, atom is moved into repeat node
+bool CAutomaton::program::parser::Quantifier( node& nodeAtom )
+{
+   if( end() == true ) return true;
+
+   int iMin = 0, iMax = -1;
+   uint8_t uByte = peek();
+   if( uByte == '*' ) { iMin = 0; iMax = -1; m_uPosition++; }
+   else if( uByte == '+' ) { iMin = 1; iMax = -1; m_uPosition++; }
+   else if( uByte == '?' ) { iMin = 0; iMax = 1; m_uPosition++; }
+   else if( uByte == '{' )
+   {
+      m_uPosition++;
+      auto number_ = [this]( int& iNumber ) -> bool {
+         std::size_t uBegin = m_uPosition;
+         iNumber = 0;
+         while( end() == false && std::isdigit( peek() ) && iNumber <= iMaxRepeat_ ) { iNumber = iNumber * 10 + ( peek() - '0' ); m_uPosition++; }
+         return m_uPosition != uBegin;
+      };
+      if( number_( iMin ) == false ) return false;
+      iMax = iMin;
+      if( end() == false && peek() == ',' )
+      {
+         m_uPosition++;
+         if( number_( iMax ) == false ) iMax = -1;
+      }
+      if( end() == true || peek() != '}' ) return false;
+      m_uPosition++;
+      if( iMin > iMaxRepeat_ || iMax > iMaxRepeat_ || ( iMax != -1 && iMax < iMin ) ) return false;
+   }
+   else return true;
+
+   bool bGreedy = true;
+   if( end() == false && peek() == '?' ) { bGreedy = false; m_uPosition++; }
+   if( end() == false && std::strchr( "*+?{", m_stringPattern[m_uPosition] ) != nullptr ) return false; // possessive or repeated quantifier
+
+   node nodeRepeat;
+   nodeRepeat.m_eKind = node::eKindRepeat;
+   nodeRepeat.m_iMin = iMin;
+   nodeRepeat.m_iMax = iMax;
+   nodeRepeat.m_bGreedy = bGreedy;
+   nodeRepeat.m_vectorChild.push_back( std::move( nodeAtom ) );
+   nodeAtom = std::move( nodeRepeat );
+   return true;
+}
+
+/**
+ * @brief Parse escape after backslash, classes as boost with "C" locale
+ * @param set_ gets bytes for class escapes (`\d \w \s` ...)
+ * @param iByte gets byte for escaped character, -1 if escape is a class
+ * @return true if ok, false if escape is not supported (`\b`, back reference ...)
+*/
+bool CAutomaton::program::parser::Escape( byteset& set_, int& iByte )
+{
+   if( end() == true ) return false;
+   uint8_t uByte = peek();
+   m_uPosition++;
+
+   auto word_ = []( byteset& s ) { s.set( '0', '9' ); s.set( 'a', 'z' ); s.set( 'A', 'Z' ); s.set( '_' ); };
+   auto space_ = []( byteset& s ) { s.set( ' ' ); s.set( '\t', '\r' ); };     // \t \n \v \f \r
+   iByte = -1;
+   switch( uByte )
+   {
+   case 'd' : set_.set( '0', '9' ); return true;
+   case 'D' : set_.set( '0', '9' ); set_.invert(); return true;
+   case 'w' : word_( set_ ); return true;
+   case 'W' : word_( set_ ); set_.invert(); return true;
+   case 's' : space_( set_ ); return true;
+   case 'S' : space_( set_ ); set_.invert(); return true;
+   case 't' : iByte = '\t'; return true;
+   case 'n' : iByte = '\n'; return true;
+   case 'r' : iByte = '\r'; return true;
+   case 'f' : iByte = '\f'; return true;
+   case 'v' : iByte = '\v'; return true;
+   case 'a' : iByte = '\a'; return true;
+   case 'e' : iByte = 0x1b; return true;
+   case 'x' :
+   {
+      if( m_uPosition + 2 > m_stringPattern.length() || std::isxdigit( peek() ) == 0 || std::isxdigit( static_cast<uint8_t>( m_stringPattern[m_uPosition + 1] ) ) == 0 ) return false;
+      iByte = std::stoi( std::string( m_stringPattern.substr( m_uPosition, 2 ) ), nullptr, 16 );
+      m_uPosition += 2;
+      return true;
+   }
+   default :
+      if( uByte < 0x80 && std::isalnum( uByte ) ) return false;              // \b \B \A \z, back references and other escapes
+      iByte = uByte;
+      return true;
+   }
+}
+
+/// parse set after `[`, only ascii characters are supported in set
+bool CAutomaton::program::parser::Set( node& nodeResult )
+{
+   byteset set_;
+   bool bNegate = false;
+   if( end() == false && peek() == '^' ) { bNegate = true; m_uPosition++; }
+
+   // ## read one character or class, returns -1 for class that is added to set
+   auto item_ = [this, &set_]( int& iByte ) -> bool {
+      uint8_t uByte = peek();
+      m_uPosition++;
+      if( uByte == '\\' )
+      {
+         byteset setEscape;
+         if( Escape( setEscape, iByte ) == false ) return false;
+         if( iByte < 0 ) set_.set( setEscape );
+         return true;
+      }
+      if( uByte == '[' && end() == false && std::strchr( ":.=", m_stringPattern[m_uPosition] ) != nullptr ) return false; // posix classes
+      if( uByte >= 0x80 ) return false;                                        // multibyte characters in set
+      iByte = uByte;
+      return true;
+   };
+
+   bool bFirst = true;
+   while( true )
+   {
+      if( end() == true ) return false;
+      if( peek() == ']' && bFirst == false ) { m_uPosition++; break; }
+      bFirst = false;
+
+      int iFrom;
+      if( item_( iFrom ) == false ) return false;
+      if( iFrom < 0 ) continue;
+
+      if( m_uPosition + 1 < m_stringPattern.length() && peek() == '-' && m_stringPattern[m_uPosition + 1] != ']' )
+      {
+         m_uPosition++;
+         int iTo;
+         if( item_( iTo ) == false || iTo < iFrom ) return false;
+         for( int i = iFrom; i <= iTo; i++ ) literal( set_, static_cast<unsigned>( i ) );
+      }
+      else literal( set_, static_cast<unsigned>( iFrom ) );
+   }
+
+   if( bNegate == true ) set_.invert();
+   nodeResult.m_eKind = node::eKindSet;
+   nodeResult.m_uSet = m_pprogram->SET_Add( set_ );
+   return true;
+}
+
+/**
+ * ## compiler ================================================================
+ */
+
+/// compile nodes to NFA instructions, each node is compiled with the instruction that follows it
+struct CAutomaton::program::compiler
+{
+   compiler( std::vector<instruction>& vectorInstruction, bool bReverse ): m_vectorInstruction( vectorInstruction ), m_bReverse( bReverse ) {}
+
+   uint32_t add( uint8_t uOp, uint32_t uNext, uint32_t uArgument )
+   {
+      if( m_vectorInstruction.size() >= uMaxInstruction_ ) { m_bOverflow = true; return uNext; }
+      m_vectorInstruction.push_back( { uOp, uNext, uArgument } );
+      return static_cast<uint32_t>( m_vectorInstruction.size() - 1 );
+   }
+
+   uint32_t Compile( const node& node_, uint32_t uNext );
+
+   std::vector<instruction>& m_vectorInstruction;
+   bool m_bReverse;                    ///< concatenations are compiled in reverse order
+   bool m_bOverflow = false;           ///< too many instructions
+};
+
+uint32_t CAutomaton::program::compiler::Compile( const node& node_, uint32_t uNext )
+{
+   if( m_bOverflow == true ) return uNext;
+
+   switch( node_.m_eKind )
+   {
+   case node::eKindEmpty : return uNext;
+   case node::eKindSet : return add( eOpByte, uNext, node_.m_uSet );
+   case node::eKindBol : return add( eOpBol, uNext, 0 );
+   case node::eKindEol : return add( eOpEol, uNext, 0 );
+   case node::eKindConcat :
+      if( m_bReverse == false ) { for( auto it = node_.m_vectorChild.rbegin(); it != node_.m_vectorChild.rend(); it++ ) uNext = Compile( *it, uNext ); }
+      else { for( const auto& it : node_.m_vectorChild ) uNext = Compile( it, uNext ); }
+      return uNext;
+   case node::eKindAlternate :
+   {
+      uint32_t uEntry = Compile( node_.m_vectorChild.back(), uNext );
+      for( auto it = node_.m_vectorChild.rbegin() + 1; it != node_.m_vectorChild.rend(); it++ )
+      {
+         uint32_t uBranch = Compile( *it, uNext );
+         uEntry = add( eOpSplit, uBranch, uEntry );
+      }
+      return uEntry;
+   }
+   case node::eKindRepeat :
+   {
+      const node& nodeChild = node_.m_vectorChild[0];
+      uint32_t uTail = uNext;
+      if( node_.m_iMax == -1 )
+      {
+         uint32_t uLoop = add( eOpSplit, 0, 0 );
+         if( m_bOverflow == true ) return uNext;
+         uint32_t uBody = Compile( nodeChild, uLoop );
+         m_vectorInstruction[uLoop] = node_.m_bGreedy == true ? instruction{ eOpSplit, uBody, uNext } : instruction{ eOpSplit, uNext, uBody };
+         uTail = uLoop;
+      }
+      else
+      {
+         for( int i = node_.m_iMin; i < node_.m_iMax; i++ )                    // optional parts are nested, x{0,2} is (x(x)?)?
+         {
+            uint32_t uBody = Compile( nodeChild, uTail );
+            uTail = node_.m_bGreedy == true ? add( eOpSplit, uBody, uNext ) : add( eOpSplit, uNext, uBody );
+         }
+      }
+      for( int i = 0; i < node_.m_iMin; i++ ) uTail = Compile( nodeChild, uTail );
+      return uTail;
+   }
+   }
+   return uNext;
+}
+
+/**
+ * ## program =================================================================
+ */
+
+/// true if node can match empty text
+static bool nullable_s( const CAutomaton::program::node& node_ )
+{
+   using node = CAutomaton::program::node;
+   switch( node_.m_eKind )
+   {
+   case node::eKindSet : return false;
+   case node::eKindConcat : return std::all_of( node_.m_vectorChild.begin(), node_.m_vectorChild.end(), nullable_s );
+   case node::eKindAlternate : return std::any_of( node_.m_vectorChild.begin(), node_.m_vectorChild.end(), nullable_s );
+   case node::eKindRepeat : return node_.m_iMin == 0 || nullable_s( node_.m_vectorChild[0] );
+   default : return true;
+   }
+}
+
+/**
+ * @brief Check for repeat that may iterate over empty text, like `(^|[^a])+`, `(a*|b)*` or `(|a)+`
+ * Boost stops a repeat when an iteration matches empty text and the NFA does
+ * not, matched text can differ. These patterns are searched with boost.
+*/
+static bool empty_repeat_s( const CAutomaton::program::node& node_ )
+{
+   using node = CAutomaton::program::node;
+   if( node_.m_eKind == node::eKindRepeat && ( node_.m_iMax == -1 || node_.m_iMax > 1 ) && nullable_s( node_.m_vectorChild[0] ) == true ) return true;
+   return std::any_of( node_.m_vectorChild.begin(), node_.m_vectorChild.end(), empty_repeat_s );
+}
+
+uint32_t CAutomaton::program::SET_Add( const byteset& set_ )
+{
+   for( std::size_t u = 0; u < m_vectorSet.size(); u++ ) { if( m_vectorSet[u] == set_ ) return static_cast<uint32_t>( u ); }
+   m_vectorSet.push_back( set_ );
+   return static_cast<uint32_t>( m_vectorSet.size() - 1 );
+}
+
+/**
+ * @brief Compile pattern to forward and reverse NFA
+ * Forward NFA starts with lazy loop over any byte, it is the lowest priority
+ * and matches that start earlier are preferred.
+ * @return true if ok, false if pattern is not supported
+*/
+bool CAutomaton::program::Compile()
+{
+   parser parser_( this, m_stringPattern );
+   node nodeRoot;
+   if( parser_.Alternate( nodeRoot ) == false || parser_.end() == false ) return false;
+   if( empty_repeat_s( nodeRoot ) == true ) return false;                     // empty iterations are handled differently by boost
+
+   byteset setAny;
+   setAny.set( 0, 255 );
+   uint32_t uSetAny = SET_Add( setAny );
+
+   compiler compilerForward( m_machineForward.m_vectorInstruction, false );
+   uint32_t uMatch = compilerForward.add( eOpMatch, 0, 0 );
+   uint32_t uBody = compilerForward.Compile( nodeRoot, uMatch );
+   uint32_t uLoop = compilerForward.add( eOpSplit, uBody, 0 );
+   uint32_t uAny = compilerForward.add( eOpByte, uLoop, uSetAny );
+   if( compilerForward.m_bOverflow == true ) return false;
+   m_machineForward.m_vectorInstruction[uLoop].m_uArgument = uAny;
+   m_machineForward.m_uStart = uLoop;
+
+   compiler compilerReverse( m_machineReverse.m_vectorInstruction, true );
+   uMatch = compilerReverse.add( eOpMatch, 0, 0 );
+   m_machineReverse.m_uStart = compilerReverse.Compile( nodeRoot, uMatch );
+   m_machineReverse.m_bReverse = true;
+   if( compilerReverse.m_bOverflow == true ) return false;
+
+   // ## bytes that are in the same sets and have same context get same class
+   std::unordered_map<std::string, uint8_t> mapClass;
+   for( unsigned uByte = 0; uByte < 256; uByte++ )
+   {
+      m_auContext[uByte] = static_cast<uint8_t>( context_s( static_cast<uint8_t>( uByte ) ) );
+      std::string stringSignature( 1, static_cast<char>( m_auContext[uByte] ) );
+      for( const auto& it : m_vectorSet ) stringSignature += it.test( uByte ) ? '1' : '0';
+      auto [it, bInserted] = mapClass.try_emplace( stringSignature, static_cast<uint8_t>( mapClass.size() ) );
+      m_auClass[uByte] = it->second;
+   }
+   m_uClassCount = static_cast<unsigned>( mapClass.size() );
+
+   if( ( m_uSyntax & eSyntaxIcase ) == 0 ) m_literal = Literals( nodeRoot );
+   return true;
+}
+
+/// add all combinations of left and right strings to left, returns false and left is unchanged if there are too many
+static bool product_s( std::vector<std::string>& vectorLeft, const std::vector<std::string>& vectorRight )
+{
+   if( vectorLeft.size() * vectorRight.size() > uMaxExact_ ) return false;
+   std::vector<std::string> vectorResult;
+   for( const auto& itLeft : vectorLeft ) { for( const auto& itRight : vectorRight ) vectorResult.push_back( itLeft + itRight ); }
+   std::sort( vectorResult.begin(), vectorResult.end() );
+   vectorResult.erase( std::unique( vectorResult.begin(), vectorResult.end() ), vectorResult.end() );
+   vectorLeft.swap( vectorResult );
+   return true;
+}
+
+/// strings that match starts with, exact set is used if node is exact
+static const std::vector<std::string>& prefix_s( const CAutomaton::program::literal_info& info_ ) { return info_.m_bExact == true ? info_.m_vectorExact : info_.m_vectorPrefix; }
+
+/**
+ * @brief Collect literals for node
+ * Exact sets are kept for small sets of strings (literal text, small classes and
+ * alternations). Concatenation builds prefix from exact children at start and
+ * required literal from longest run of single strings.
+ * @param node_ node literals are collected for
+ * @param info_ gets literals
+*/
+void CAutomaton::program::Literal( const node& node_, literal_info& info_ ) const
+{
+   auto longest_ = [&info_]( const std::string& stringLiteral ) { if( stringLiteral.length() > info_.m_stringRequired.length() ) info_.m_stringRequired = stringLiteral; };
+
+   switch( node_.m_eKind )
+   {
+   case node::eKindEmpty : case node::eKindBol : case node::eKindEol :
+      info_.m_bExact = true;
+      info_.m_vectorExact.assign( 1, std::string() );
+      break;
+   case node::eKindSet :
+   {
+      std::vector<std::string> vectorByte;
+      for( unsigned u = 0; u < 256 && vectorByte.size() <= 4; u++ ) { if( m_vectorSet[node_.m_uSet].test( u ) == true ) vectorByte.push_back( std::string( 1, static_cast<char>( u ) ) ); }
+      if( vectorByte.size() <= 4 ) { info_.m_bExact = true; info_.m_vectorExact = std::move( vectorByte ); }
+      break;
+   }
+   case node::eKindConcat :
+   {
+      info_.m_bExact = true;
+      info_.m_vectorExact.assign( 1, std::string() );
+      std::vector<std::string> vectorPrefix( 1, std::string() );
+      bool bPrefixDone = false;
+      std::string stringRun;                                                   // text matched by children with one exact string
+      for( const auto& it : node_.m_vectorChild )
+      {
+         literal_info infoChild;
+         Literal( it, infoChild );
+         if( info_.m_bExact == true && ( infoChild.m_bExact == false || product_s( info_.m_vectorExact, infoChild.m_vectorExact ) == false ) ) { info_.m_bExact = false; info_.m_vectorExact.clear(); }
+
+         if( bPrefixDone == false )
+         {
+            if( infoChild.m_bExact == false || product_s( vectorPrefix, infoChild.m_vectorExact ) == false ) { bPrefixDone = true; if( infoChild.m_bExact == false && infoChild.m_vectorPrefix.empty() == false ) product_s( vectorPrefix, infoChild.m_vectorPrefix ); }
+         }
+
+         if( infoChild.m_bExact == true && infoChild.m_vectorExact.size() == 1 ) { stringRun += infoChild.m_vectorExact[0]; longest_( stringRun ); }
+         else
+         {
+            if( prefix_s( infoChild ).size() == 1 ) longest_( stringRun + prefix_s( infoChild )[0] );
+            longest_( infoChild.m_stringRequired );
+            stringRun.clear();
+         }
+      }
+      info_.m_vectorPrefix = std::move( vectorPrefix );
+      break;
+   }
+   case node::eKindAlternate :
+   {
+      info_.m_bExact = true;
+      bool bPrefix = true;
+      for( const auto& it : node_.m_vectorChild )
+      {
+         literal_info infoChild;
+         Literal( it, infoChild );
+         if( info_.m_bExact == true && infoChild.m_bExact == true && info_.m_vectorExact.size() + infoChild.m_vectorExact.size() <= uMaxExact_ ) info_.m_vectorExact.insert( info_.m_vectorExact.end(), infoChild.m_vectorExact.begin(), infoChild.m_vectorExact.end() );
+         else { info_.m_bExact = false; info_.m_vectorExact.clear(); }
+
+         const auto& vectorChildPrefix = prefix_s( infoChild );
+         if( vectorChildPrefix.empty() == true ) bPrefix = false;             // one branch without prefix and match can start anywhere
+         if( bPrefix == true ) info_.m_vectorPrefix.insert( info_.m_vectorPrefix.end(), vectorChildPrefix.begin(), vectorChildPrefix.end() );
+      }
+      if( bPrefix == false ) info_.m_vectorPrefix.clear();
+      break;
+   }
+   case node::eKindRepeat :
+   {
+      literal_info infoChild;
+      Literal( node_.m_vectorChild[0], infoChild );
+      if( infoChild.m_bExact == true && node_.m_iMax != -1 )                  // x{n,m} is union of x repeated n to m times
+      {
+         std::vector<std::string> vectorRepeat( 1, std::string() );
+         info_.m_bExact = true;
+         for( int i = 0; i < node_.m_iMin && info_.m_bExact == true; i++ ) info_.m_bExact = product_s( vectorRepeat, infoChild.m_vectorExact );
+         for( int i = node_.m_iMin; i <= node_.m_iMax && info_.m_bExact == true; i++ )
+         {
+            info_.m_vectorExact.insert( info_.m_vectorExact.end(), vectorRepeat.begin(), vectorRepeat.end() );
+            if( info_.m_vectorExact.size() > uMaxExact_ ) info_.m_bExact = false;
+            else if( i < node_.m_iMax ) info_.m_bExact = product_s( vectorRepeat, infoChild.m_vectorExact );
+         }
+         if( info_.m_bExact == false ) info_.m_vectorExact.clear();
+      }
+      if( node_.m_iMin > 0 )
+      {
+         info_.m_vectorPrefix = prefix_s( infoChild );
+         info_.m_stringRequired = infoChild.m_stringRequired;
+      }
+      break;
+   }
+   }
+
+   if( info_.m_bExact == true )
+   {
+      std::sort( info_.m_vectorExact.begin(), info_.m_vectorExact.end() );
+      info_.m_vectorExact.erase( std::unique( info_.m_vectorExact.begin(), info_.m_vectorExact.end() ), info_.m_vectorExact.end() );
+      info_.m_vectorPrefix = info_.m_vectorExact;
+      if( info_.m_vectorExact.size() == 1 ) longest_( info_.m_vectorExact[0] );
+   }
+
+   // ## prefix is only valid if all strings have text
+   if( std::any_of( info_.m_vectorPrefix.begin(), info_.m_vectorPrefix.end(), []( const std::string& s_ ) { return s_.empty(); } ) == true ) info_.m_vectorPrefix.clear();
+   if( info_.m_vectorPrefix.size() == 1 ) longest_( info_.m_vectorPrefix[0] );
+}
+
+/// select literals used to skip text, prefix literals are used if all have at least two characters and required literal if it isn't checked by prefix
+CAutomaton::literal CAutomaton::program::Literals( const node& nodeRoot ) const
+{
+   literal_info info_;
+   Literal( nodeRoot, info_ );
+
+   literal literal_;
+   const auto& vectorPrefix = info_.m_vectorPrefix;
+   if( vectorPrefix.empty() == false && vectorPrefix.size() <= uMaxPrefix_ && std::all_of( vectorPrefix.begin(), vectorPrefix.end(), []( const std::string& s_ ) { return s_.length() >= 2; } ) == true ) literal_.m_vectorPrefix = vectorPrefix;
+
+   const std::string& stringRequired = info_.m_stringRequired;
+   bool bInPrefix = std::any_of( literal_.m_vectorPrefix.begin(), literal_.m_vectorPrefix.end(), [&stringRequired]( const std::string& s_ ) { return s_.find( stringRequired ) != std::string::npos; } );
+   if( stringRequired.length() >= 2 && bInPrefix == false ) literal_.m_stringRequired = stringRequired;
+   return literal_;
+}
+
+/**
+ * @brief Follow empty transitions from threads in priority order
+ * Instructions that consume a byte are collected in work area. Forward machine
+ * stops at first match, threads with lower priority are cut (leftmost first).
+ * Reverse machine continues to find all matches (longest).
+ * @param vectorThread threads in priority order
+ * @param uBefore context for character before position
+ * @param uAfter context for character after position
+ * @return true if match is reached
+*/
+bool CAutomaton::program::Closure( const machine& machine_, const std::vector<uint32_t>& vectorThread, unsigned uBefore, unsigned uAfter, work& work_ ) const
+{
+   const auto& vectorInstruction = machine_.m_vectorInstruction;
+   work_.m_vectorVisit.assign( vectorInstruction.size(), 0 );
+   work_.m_vectorOut.clear();
+   work_.m_vectorStack.clear();
+
+   bool bMatch = false;
+   for( uint32_t uThread : vectorThread )
+   {
+      work_.m_vectorStack.push_back( uThread );
+      while( work_.m_vectorStack.empty() == false )
+      {
+         uint32_t u = work_.m_vectorStack.back();
+         work_.m_vectorStack.pop_back();
+         if( work_.m_vectorVisit[u] != 0 ) continue;
+         work_.m_vectorVisit[u] = 1;
+
+         const instruction& instruction_ = vectorInstruction[u];
+         switch( instruction_.m_uOp )
+         {
+         case eOpByte : work_.m_vectorOut.push_back( u ); break;
+         case eOpSplit :
+            work_.m_vectorStack.push_back( instruction_.m_uArgument );
+            work_.m_vectorStack.push_back( instruction_.m_uNext );               // preferred is taken first
+            break;
+         case eOpBol : if( bol_s( uBefore, uAfter ) == true ) work_.m_vectorStack.push_back( instruction_.m_uNext ); break;
+         case eOpEol : if( eol_s( uBefore, uAfter ) == true ) work_.m_vectorStack.push_back( instruction_.m_uNext ); break;
+         case eOpMatch :
+            bMatch = true;
+            if( machine_.m_bReverse == false ) return true;
+            break;
+         }
+      }
+   }
+
+   return bMatch;
+}
+
+/**
+ * @brief Get state for threads in work area, new states are added to cache and transition from state is stored
+ * When cache is full state is built in work area, it is used for one step.
+ * @param uContext context for character consumed to reach state
+ * @param pstateFrom state with transition to new state, null for start state
+ * @param uClass byte class for transition
+ * @return const state* state for threads
+*/
+const CAutomaton::program::state* CAutomaton::program::Intern( const machine& machine_, unsigned uContext, work& work_, const state* pstateFrom, unsigned uClass ) const
+{
+   auto init_ = [this, &machine_, &work_]( state& state_ ) {
+      state_.m_uMatch = 0;
+      state_.m_bDead = state_.m_vectorThread.empty();
+      for( unsigned u = 0; u < eContextMax && state_.m_bDead == false; u++ )
+      {
+         bool bMatch = machine_.m_bReverse == false ? Closure( machine_, state_.m_vectorThread, state_.m_uContext, u, work_ ) : Closure( machine_, state_.m_vectorThread, u, state_.m_uContext, work_ );
+         if( bMatch == true ) state_.m_uMatch |= 1u << u;
+      }
+   };
+
+   std::string stringKey( reinterpret_cast<const char*>( work_.m_vectorThread.data() ), work_.m_vectorThread.size() * sizeof( uint32_t ) );
+   stringKey += static_cast<char>( uContext );
+   {
+      std::lock_guard<std::mutex> lock_( machine_.m_mutex );
+      const state* pstate = nullptr;
+      auto it = machine_.m_mapState.find( stringKey );
+      if( it != machine_.m_mapState.end() ) pstate = it->second.get();
+      else if( machine_.m_mapState.size() < uMaxState_ )
+      {
+         auto pstateNew = std::make_unique<state>();
+         pstateNew->m_vectorThread = work_.m_vectorThread;
+         pstateNew->m_uContext = uContext;
+         init_( *pstateNew );
+         pstateNew->m_apNext = std::make_unique<std::atomic<const state*>[]>( m_uClassCount );
+         pstate = pstateNew.get();
+         machine_.m_mapState.emplace( std::move( stringKey ), std::move( pstateNew ) );
+      }
+
+      if( pstate != nullptr )
+      {
+         if( pstateFrom != nullptr && pstateFrom->m_apNext != nullptr ) pstateFrom->m_apNext[uClass].store( pstate, std::memory_order_release );
+         return pstate;
+      }
+   }
+
+   // ## cache is full, state is built in work area (not the one stepped from)
+   state& stateScratch = pstateFrom == &work_.m_astateScratch[0] ? work_.m_astateScratch[1] : work_.m_astateScratch[0];
+   stateScratch.m_vectorThread = work_.m_vectorThread;
+   stateScratch.m_uContext = uContext;
+   init_( stateScratch );
+   return &stateScratch;
+}
+
+const CAutomaton::program::state* CAutomaton::program::Start( const machine& machine_, unsigned uContext, work& work_ ) const
+{
+   const state* pstate = machine_.m_apStart[uContext].load( std::memory_order_acquire );
+   if( pstate != nullptr ) return pstate;
+
+   work_.m_vectorThread.assign( 1, machine_.m_uStart );
+   pstate = Intern( machine_, uContext, work_, nullptr, 0 );
+   if( pstate->m_apNext != nullptr ) machine_.m_apStart[uContext].store( pstate, std::memory_order_release );
+   return pstate;
+}
+
+/// step over byte, transition is taken from cache or built
+const CAutomaton::program::state* CAutomaton::program::Next( const machine& machine_, const state* pstate, uint8_t uByte, work& work_ ) const
+{
+   unsigned uClass = m_auClass[uByte];
+   if( pstate->m_apNext != nullptr )
+   {
+      const state* pstateNext = pstate->m_apNext[uClass].load( std::memory_order_acquire );
+      if( pstateNext != nullptr ) return pstateNext;
+   }
+
+   unsigned uContext = m_auContext[uByte];
+   if( machine_.m_bReverse == false ) Closure( machine_, pstate->m_vectorThread, pstate->m_uContext, uContext, work_ );
+   else Closure( machine_, pstate->m_vectorThread, uContext, pstate->m_uContext, work_ );
+
+   // ## threads that consume byte, duplicates are removed and first is kept
+   work_.m_vectorThread.clear();
+   std::fill( work_.m_vectorVisit.begin(), work_.m_vectorVisit.end(), 0 );
+   for( uint32_t u : work_.m_vectorOut )
+   {
+      const instruction& instruction_ = machine_.m_vectorInstruction[u];
+      if( m_vectorSet[instruction_.m_uArgument].test( uByte ) == false || work_.m_vectorVisit[instruction_.m_uNext] != 0 ) continue;
+      work_.m_vectorVisit[instruction_.m_uNext] = 1;
+      work_.m_vectorThread.push_back( instruction_.m_uNext );
+   }
+
+   return Intern( machine_, uContext, work_, pstate, uClass );
+}
+
+/**
+ * @brief Run forward machine and find where leftmost first match ends
+ * @param uBefore context before first character
+ * @param uEnd context after last character
+ * @return const char* end of match or nullptr if not found
+*/
+const char* CAutomaton::program::Forward( const char* pbszFirst, const char* pbszLast, unsigned uBefore, unsigned uEnd, work& work_ ) const
+{
+   const state* pstate = Start( m_machineForward, uBefore, work_ );
+   const char* pbszMatch = nullptr;
+   for( const char* pbsz = pbszFirst; pbsz != pbszLast; pbsz++ )
+   {
+      uint8_t uByte = static_cast<uint8_t>( *pbsz );
+      if( pstate->m_uMatch & ( 1u << m_auContext[uByte] ) ) pbszMatch = pbsz;
+      pstate = Next( m_machineForward, pstate, uByte, work_ );
+      if( pstate->m_bDead == true ) return pbszMatch;
+   }
+
+   if( pstate->m_uMatch & ( 1u << uEnd ) ) pbszMatch = pbszLast;
+   return pbszMatch;
+}
+
+/**
+ * @brief Run reverse machine from match end and find where longest match starts
+ * @param uBefore context before first character
+ * @param uAfter context after match end
+ * @return const char* start of match
+*/
+const char* CAutomaton::program::Reverse( const char* pbszFirst, const char* pbszEnd, unsigned uBefore, unsigned uAfter, work& work_ ) const
+{
+   const state* pstate = Start( m_machineReverse, uAfter, work_ );
+   const char* pbszStart = nullptr;
+   for( const char* pbsz = pbszEnd; pbsz != pbszFirst; pbsz-- )
+   {
+      uint8_t uByte = static_cast<uint8_t>( pbsz[-1] );
+      if( pstate->m_uMatch & ( 1u << m_auContext[uByte] ) ) pbszStart = pbsz;
+      pstate = Next( m_machineReverse, pstate, uByte, work_ );
+      if( pstate->m_bDead == true ) return pbszStart;
+   }
+
+   if( pstate->m_uMatch & ( 1u << uBefore ) ) pbszStart = pbszFirst;
+   return pbszStart;
+}
+
+/**
+ * ## CAutomaton ==============================================================
+ */
+
+/**
+ * @brief Compile pattern, patterns that are not supported by automaton are compiled with boost
+ * @param stringPattern regular expression
+ * @param uSyntax syntax flags (see: `enumSyntax`)
+ * @throws boost::regex_error if pattern is invalid
+*/
+CAutomaton::CAutomaton( std::string_view stringPattern, flag_type uSyntax ): m_pprogram( std::make_shared<program>() )
+{
+   m_pprogram->m_stringPattern = stringPattern;
+   m_pprogram->m_uSyntax = uSyntax;
+   if( m_pprogram->Compile() == false )
+   {
+      boost::regex::flag_type uBoostSyntax = boost::regex::perl;
+      if( uSyntax & eSyntaxIcase ) uBoostSyntax |= boost::regex::icase;
+      m_pprogram->m_pregexFallback = std::make_unique<boost::regex>( stringPattern.data(), stringPattern.data() + stringPattern.length(), uBoostSyntax );
+   }
+}
+
+const std::string& CAutomaton::str() const noexcept
+{
+   static const std::string stringEmpty_;
+   return m_pprogram != nullptr ? m_pprogram->m_stringPattern : stringEmpty_;
+}
+
+CAutomaton::flag_type CAutomaton::flags() const noexcept { return m_pprogram != nullptr ? m_pprogram->m_uSyntax : eSyntaxDefault; }
+
+bool CAutomaton::is_automaton() const noexcept { return m_pprogram != nullptr && m_pprogram->m_pregexFallback == nullptr; }
+
+const CAutomaton::literal& CAutomaton::literals() const noexcept
+{
+   static const literal literalEmpty_;
+   return m_pprogram != nullptr ? m_pprogram->m_literal : literalEmpty_;
+}
+
+/**
+ * @brief Extract literals for pattern without compiling it, used to skip text for other regular expression engines
+ * @param stringPattern regular expression (boost syntax)
+ * @param uSyntax syntax flags, no literals are extracted if case is ignored
+ * @return literal literals found in every match, empty if not found or pattern is not supported
+*/
+CAutomaton::literal CAutomaton::Literal_s( std::string_view stringPattern, flag_type uSyntax )
+{
+   if( uSyntax & eSyntaxIcase ) return literal();
+
+   program program_;
+   program_.m_uSyntax = uSyntax;
+   program::parser parser_( &program_, stringPattern );
+   program::node nodeRoot;
+   if( parser_.Alternate( nodeRoot ) == false || parser_.end() == false ) return literal();
+   return program_.Literals( nodeRoot );
+}
+
+std::size_t CAutomaton::state_count() const
+{
+   if( m_pprogram == nullptr ) return 0;
+   std::size_t uCount = 0;
+   for( const program::machine* pmachine : { &m_pprogram->m_machineForward, &m_pprogram->m_machineReverse } )
+   {
+      std::lock_guard<std::mutex> lock_( pmachine->m_mutex );
+      uCount += pmachine->m_mapState.size();
+   }
+   return uCount;
+}
+
+/**
+ * @brief Find first match in range
+ * @param pbszFirst start of range
+ * @param pbszLast end of range
+ * @param bPrevAvail true if character before first is readable (not start of text)
+ * @param bEnd true if last is end of text, if false `$` do not match at last
+ * @param uFlags match flags (see: `enumMatch`)
+ * @return std::pair<const char*, const char*> match or pair with nullptr if not found
+*/
+std::pair<const char*, const char*> CAutomaton::Find( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd, uint32_t uFlags ) const
+{
+   if( m_pprogram == nullptr ) return { nullptr, nullptr };
+   const program& program_ = *m_pprogram;
+
+   if( program_.m_pregexFallback != nullptr )
+   {
+      auto uMatchFlags = boost::regex_constants::match_default;
+      if( bPrevAvail == true ) uMatchFlags = uMatchFlags | boost::regex_constants::match_prev_avail;
+      if( uFlags & eMatchNotBol ) uMatchFlags = uMatchFlags | boost::regex_constants::match_not_bol;
+      if( bEnd == false ) uMatchFlags = uMatchFlags | boost::regex_constants::match_not_eol | boost::regex_constants::match_not_eob;
+      if( uFlags & eMatchNotEol ) uMatchFlags = uMatchFlags | boost::regex_constants::match_not_eol;
+
+      boost::cmatch cmatchResult;
+      if( boost::regex_search( pbszFirst, pbszLast, cmatchResult, *program_.m_pregexFallback, uMatchFlags ) == true ) return { cmatchResult[0].first, cmatchResult[0].second };
+      return { nullptr, nullptr };
+   }
+
+   unsigned uEnd = bEnd == true && ( uFlags & eMatchNotEol ) == 0 ? eContextEdge : eContextOther;
+
+   program::work work_;
+   auto find_ = [&]( const char* pbszFrom, bool bPrev ) -> std::pair<const char*, const char*> {
+      unsigned uBefore = bPrev == true ? context_s( static_cast<uint8_t>( pbszFrom[-1] ) ) : ( ( uFlags & eMatchNotBol ) ? eContextOther : eContextEdge );
+      const char* pbszEnd = program_.Forward( pbszFrom, pbszLast, uBefore, uEnd, work_ );
+      if( pbszEnd == nullptr ) return { nullptr, nullptr };
+
+      unsigned uAfter = pbszEnd == pbszLast ? uEnd : context_s( static_cast<uint8_t>( *pbszEnd ) );
+      const char* pbszStart = program_.Reverse( pbszFrom, pbszEnd, uBefore, uAfter, work_ );
+                                                                               assert( pbszStart != nullptr );
+      return { pbszStart, pbszEnd };
+   };
+
+   return program_.m_literal.Find( pbszFirst, pbszLast, bPrevAvail, find_ );
+}
+
+/**
+ * ## CAutomaton::literal =====================================================
+ */
+
+/// how common byte is in source text, literal is searched for with least common byte
+static unsigned frequency_s( uint8_t uByte )
+{
+   if( uByte == ' ' || uByte == '\n' || uByte == '\t' || uByte == '\r' ) return 250;
+   if( uByte >= 'a' && uByte <= 'z' ) return 200;
+   if( uByte >= 'A' && uByte <= 'Z' ) return 180;
+   if( uByte >= '0' && uByte <= '9' ) return 150;
+   if( uByte >= 0x20 && uByte < 0x7f ) return 100;
+   return 10;
+}
+
+/**
+ * @brief Find literal in range, memchr (vectorized in c runtime) skips to least common byte in literal and the rest is compared
+ * @return const char* start of literal or nullptr if not found
+*/
+static const char* find_literal_s( const char* pbszFirst, const char* pbszLast, std::string_view stringLiteral )
+{
+   std::size_t uLength = stringLiteral.length();
+   if( uLength == 0 || static_cast<std::size_t>( pbszLast - pbszFirst ) < uLength ) return nullptr;
+
+   std::size_t uRare = 0;
+   for( std::size_t u = 1; u < uLength; u++ ) { if( frequency_s( static_cast<uint8_t>( stringLiteral[u] ) ) <= frequency_s( static_cast<uint8_t>( stringLiteral[uRare] ) ) ) uRare = u; }
+
+   const char* pbszScan = pbszFirst + uRare;
+   const char* pbszScanEnd = pbszLast - ( uLength - uRare ) + 1;               // last position for rare byte where literal fits
+   while( pbszScan < pbszScanEnd )
+   {
+      const char* pbszRare = static_cast<const char*>( std::memchr( pbszScan, stringLiteral[uRare], pbszScanEnd - pbszScan ) );
+      if( pbszRare == nullptr ) return nullptr;
+      const char* pbszCandidate = pbszRare - uRare;
+      if( std::memcmp( pbszCandidate, stringLiteral.data(), uLength ) == 0 ) return pbszCandidate;
+      pbszScan = pbszRare + 1;
+   }
+   return nullptr;
+}
+
+const char* CAutomaton::literal::Candidate( const char* pbszFirst, const char* pbszLast ) const
+{
+   const char* pbszCandidate = nullptr;
+   for( const auto& it : m_vectorPrefix )
+   {
+      const char* pbszEnd = pbszLast;
+      if( pbszCandidate != nullptr ) pbszEnd = std::min( pbszLast, pbszCandidate - 1 + it.length() ); // only search before best candidate
+      const char* pbszFound = find_literal_s( pbszFirst, pbszEnd, it );
+      if( pbszFound != nullptr ) pbszCandidate = pbszFound;
+   }
+   return pbszCandidate;
+}
+
+bool CAutomaton::literal::Contains( const char* pbszFirst, const char* pbszLast ) const { return find_literal_s( pbszFirst, pbszLast, m_stringRequired ) != nullptr; }
+
+} }
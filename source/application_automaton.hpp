@@ -0,0 +1,121 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace application { namespace file {
+
+/**
+ * ## CAutomaton ==============================================================
+ */
+
+   /**
+    * @brief Regular expression compiled to automaton, search time is linear in text length
+    * Supports the subset used to convert sql: literals, escapes (`\d \w \s \t \xHH` ...),
+    * classes, `.`, groups, alternation, greedy and lazy quantifiers (`* + ? {n,m}`, `*?` ...)
+    * and line anchors `^ $`. Lookahead followed by the same pattern, as in
+    * `\/\*[\w\W]*?(?=\*\/)\*\/`, does not change the match and is removed.
+    *
+    * Pattern is compiled to an NFA and text is searched with a DFA that is built
+    * lazily from NFA states while searching. DFA states are shared by all threads
+    * using the same automaton (copies share states). Match is the same as for
+    * boost, leftmost match with greedy and lazy priorities: DFA is run forward to
+    * find match end and a reverse DFA finds where the match starts.
+    *
+    * Patterns with other features (back references, lookaround, word boundary ...)
+    * fall back to boost, check `is_automaton()` to see what is used. Repeated groups
+    * that can match empty text (`(^|[^a])+`, `(a*|b)*`) also use boost, boost ends
+    * the repeat at an empty iteration and the automaton can't follow that rule.
+    *
+~~~{.cpp}
+CAutomaton automatonComment( R"(--[^\r\n]*)" );                  // compiled once, used by all files
+gd::utf8::string stringSql( "SELECT 1; -- one\nSELECT 2; -- two" );
+Erase( stringSql, automatonComment, CAutomaton::eMatchDefault );
+~~~
+   */
+   class CAutomaton
+   {
+   public:
+      using flag_type = uint32_t;
+      enum enumSyntax : flag_type { eSyntaxDefault = 0, eSyntaxIcase = 0x01 };
+      enum enumMatch : uint32_t { eMatchDefault = 0, eMatchNotBol = 0x01, eMatchNotEol = 0x02 };
+      static constexpr flag_type ECMAScript = eSyntaxDefault;                  ///< default syntax, same name as for std and boost regex (see: `gd::regex::cache`)
+      static constexpr flag_type icase = eSyntaxIcase;
+
+      struct program;
+
+      /**
+       * @brief Literals found in every match, text without literals is skipped with a fast scan
+       * Prefix literals are found at start of every match, text before first position
+       * where one of them is found is skipped. Required literal is found somewhere in
+       * every match, if it is not found in range there is no match.
+       *
+       * Literals only move the start of the search, search is run once from first
+       * candidate and not for each candidate. A search that fails at one candidate
+       * may scan to end of text (unclosed comment) and running it again for the
+       * next candidate would make search time quadratic.
+       */
+      struct literal
+      {
+         std::vector<std::string> m_vectorPrefix;  ///< every match starts with one of these, empty if unknown
+         std::string m_stringRequired;             ///< every match contains this text, empty if unknown
+
+         bool empty() const noexcept { return m_vectorPrefix.empty() == true && m_stringRequired.empty() == true; }
+         /// first position in range where one of prefix literals is found, nullptr if not found
+         const char* Candidate( const char* pbszFirst, const char* pbszLast ) const;
+         /// true if required literal is found in range
+         bool Contains( const char* pbszFirst, const char* pbszLast ) const;
+         /// find match, `find_( pbszFrom, bPrevAvail )` is called once from first candidate, nothing is called if there is no candidate or required literal is missing
+         template<typename FIND>
+         std::pair<const char*, const char*> Find( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, FIND&& find_ ) const;
+      };
+
+   public:
+      CAutomaton() {}
+      explicit CAutomaton( std::string_view stringPattern, flag_type uSyntax = eSyntaxDefault );
+      CAutomaton( const char* pbszFirst, const char* pbszLast, flag_type uSyntax ): CAutomaton( std::string_view( pbszFirst, pbszLast - pbszFirst ), uSyntax ) {}
+      ~CAutomaton() {}
+
+   public:
+      bool empty() const noexcept { return m_pprogram == nullptr; }
+      /// pattern automaton was compiled from
+      const std::string& str() const noexcept;
+      flag_type flags() const noexcept;
+      /// true if pattern is searched with automaton, false if boost is used
+      bool is_automaton() const noexcept;
+      /// literals found in every match, empty if pattern is searched with boost
+      const literal& literals() const noexcept;
+      /// number of DFA states built for forward and reverse search
+      std::size_t state_count() const;
+
+      /// find first match in range, `bPrevAvail` is true if character before first is readable, `bEnd` is true if last is end of text
+      std::pair<const char*, const char*> Find( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd, uint32_t uFlags ) const;
+      std::pair<const char*, const char*> Find( const char* pbszFirst, const char* pbszLast ) const { return Find( pbszFirst, pbszLast, false, true, eMatchDefault ); }
+
+      /// extract literals found in every match for pattern, empty if pattern is not supported by automaton or case is ignored
+      static literal Literal_s( std::string_view stringPattern, flag_type uSyntax );
+
+   public:
+      std::shared_ptr<program> m_pprogram;   ///< compiled pattern and DFA states, shared by copies
+   };
+
+   template<typename FIND>
+   std::pair<const char*, const char*> CAutomaton::literal::Find( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, FIND&& find_ ) const
+   {
+      if( m_stringRequired.empty() == false && Contains( pbszFirst, pbszLast ) == false ) return { nullptr, nullptr };
+
+      if( m_vectorPrefix.empty() == false )
+      {
+         const char* pbszCandidate = Candidate( pbszFirst, pbszLast );
+         if( pbszCandidate == nullptr ) return { nullptr, nullptr };
+         return find_( pbszCandidate, pbszCandidate != pbszFirst || bPrevAvail );
+      }
+
+      return find_( pbszFirst, bPrevAvail );
+   }
+
+} }
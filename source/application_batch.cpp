@@ -0,0 +1,181 @@
+#include <cassert>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <mutex>
+#include <thread>
+
+#include "gd_file.h"
+
+#include "application.hpp"
+#include "application_batch.hpp"
+
+namespace application {
+
+   /**
+    * @brief Convert files in folder
+    * @param folderFrom folder with files to convert
+    * @param argumentsFilter filters selecting files in folder (see `gd::file::list_files_g`)
+    * @param folderTo folder converted files are written to, if empty the original file is replaced
+    * @return true if batch was run (check `errors` for files that failed), false and error information if files couldn't be listed
+   */
+   std::pair<bool, std::string> CBatch::Run( const file::CFolder& folderFrom, const gd::argument::arguments& argumentsFilter, const file::CFolder& folderTo )
+   {
+      std::vector<std::string> vectorFile;
+      try
+      {
+         vectorFile = gd::file::list_files_g( folderFrom.folder(), argumentsFilter );
+      }
+      catch( const std::exception& e )
+      {
+         return { false, std::format( "Failed to list files in {}: {} [CBatch::Run]", folderFrom.folder(), e.what() ) };
+      }
+
+      return Run( vectorFile, folderTo );
+   }
+
+   /**
+    * @brief Convert files on worker threads
+    * Files are split in blocks, one for each worker. Worker takes files from
+    * the back of its own queue and when empty it steals from the front of
+    * other queues. Exceptions not derived from `std::exception` are caught on
+    * the worker and the first is rethrown when all workers are done, errors
+    * are set before.
+    * @param vectorFile files to convert
+    * @param folderTo folder converted files are written to, if empty the original file is replaced
+    * @return true if batch was run (check `errors` for files that failed)
+   */
+   std::pair<bool, std::string> CBatch::Run( const std::vector<std::string>& vectorFile, const file::CFolder& folderTo )
+   {
+      m_uConverted = 0;
+      m_vectorError.clear();
+      if( vectorFile.empty() == true ) return { true, std::string() };
+
+      unsigned uWorkerCount = m_uWorkerCount;
+      if( uWorkerCount == 0 ) uWorkerCount = std::thread::hardware_concurrency();
+      if( uWorkerCount == 0 ) uWorkerCount = 1;
+      if( uWorkerCount > vectorFile.size() ) uWorkerCount = static_cast<unsigned>( vectorFile.size() );
+
+      /// queue with index to files for each worker
+      struct queue
+      {
+         std::mutex m_mutex;
+         std::deque<std::size_t> m_dequeFile;
+      };
+
+      std::vector<queue> vectorQueue( uWorkerCount );
+      for( std::size_t u = 0; u < vectorFile.size(); u++ )
+      {
+         vectorQueue[ u * uWorkerCount / vectorFile.size() ].m_dequeFile.push_back( u );
+      }
+
+      // ## get next file for worker, own queue first and then steal from other workers
+      auto next_ = [&vectorQueue, uWorkerCount]( unsigned uWorker, std::size_t& uFile ) -> bool {
+         {
+            queue& queueOwn = vectorQueue[ uWorker ];
+            std::lock_guard<std::mutex> lockQueue( queueOwn.m_mutex );
+            if( queueOwn.m_dequeFile.empty() == false )
+            {
+               uFile = queueOwn.m_dequeFile.back();
+               queueOwn.m_dequeFile.pop_back();
+               return true;
+            }
+         }
+
+         for( unsigned u = 1; u < uWorkerCount; u++ )
+         {
+            queue& queueSteal = vectorQueue[ ( uWorker + u ) % uWorkerCount ];
+            std::lock_guard<std::mutex> lockQueue( queueSteal.m_mutex );
+            if( queueSteal.m_dequeFile.empty() == false )
+            {
+               uFile = queueSteal.m_dequeFile.front();
+               queueSteal.m_dequeFile.pop_front();
+               return true;
+            }
+         }
+
+         return false;                                                         // no files left, new files are never added
+      };
+
+      std::vector<std::string> vectorResult( vectorFile.size() );             // error for each file, each file is only touched by one worker
+      std::exception_ptr pexceptionUnknown;                                    // first exception not derived from std::exception, rethrown after workers
+      std::mutex mutexException;
+
+      auto worker_ = [&]( unsigned uWorker ) {
+         std::size_t uFile;
+         while( next_( uWorker, uFile ) == true )
+         {
+            const std::string& stringFile = vectorFile[ uFile ];
+            std::string stringFileTo = stringFile;
+            if( folderTo.IsEmpty() == false ) stringFileTo = ( std::filesystem::path( folderTo.folder() ) / std::filesystem::path( stringFile ).filename() ).string();
+
+            try
+            {
+               CConvertCache::source sourceFrom;
+               bool bCache = false;                                            // store result in cache
+               if( m_pcache != nullptr )
+               {
+                  auto [bHit, stringError] = m_pcache->Get( stringFile, stringFileTo, sourceFrom );
+                  if( bHit == true ) continue;                                 // converted file copied from cache
+                  bCache = stringError.empty();
+               }
+
+               auto [bOk, stringError] = Convert( stringFile, stringFileTo, m_transform );
+               if( bOk == false ) vectorResult[ uFile ] = stringError.empty() == false ? stringError : std::string( "Unknown error [CBatch::Run]" );
+               else if( bCache == true ) m_pcache->Put( sourceFrom, stringFileTo );// cache errors do not fail conversion, file is converted again next time
+            }
+            catch( const std::exception& e )
+            {
+               vectorResult[ uFile ] = std::format( "{} [CBatch::Run]", e.what() );
+            }
+            catch( ... )
+            {
+               vectorResult[ uFile ] = "Unknown exception [CBatch::Run]";
+               std::lock_guard<std::mutex> lockException( mutexException );
+               if( pexceptionUnknown == nullptr ) pexceptionUnknown = std::current_exception();
+            }
+         }
+      };
+
+      std::vector<std::thread> vectorThread;
+      for( unsigned u = 1; u < uWorkerCount; u++ ) vectorThread.emplace_back( worker_, u );
+      worker_( 0 );                                                            // calling thread is the first worker
+      for( auto& it : vectorThread ) it.join();
+
+      for( std::size_t u = 0; u < vectorResult.size(); u++ )
+      {
+         if( vectorResult[ u ].empty() == true ) m_uConverted++;
+         else m_vectorError.push_back( { vectorFile[ u ], std::move( vectorResult[ u ] ) } );
+      }
+
+      if( pexceptionUnknown != nullptr ) std::rethrow_exception( pexceptionUnknown );
+
+      return { true, std::string() };
+   }
+
+   /**
+    * @brief Convert one file, same steps as when file is converted with `CDocument`
+    * @param stringFileFrom file to convert
+    * @param stringFileTo file converted text is saved to
+    * @param transform_ method transforming file, if not set file is only copied
+    * @return true if ok, otherwise false and error information
+   */
+   std::pair<bool, std::string> CBatch::Convert( std::string_view stringFileFrom, std::string_view stringFileTo, const transform_type& transform_ )
+   {
+      CDocument document;
+      auto [bOk, stringError] = document.FILE_Load( stringFileFrom, "batch" );
+      if( bOk == false ) return { bOk, stringError };
+
+      file::CFile* pFile = document.FILE_Get();                               assert( pFile != nullptr );
+      if( transform_ )
+      {
+         std::tie( bOk, stringError ) = transform_( *pFile );
+         if( bOk == false ) return { bOk, stringError };
+      }
+
+      unsigned uFlags = stringFileFrom == stringFileTo ? file::CFileWrite::eFlagAtomic : 0;// original file is only replaced when all text is written
+      return document.FILE_Save( stringFileTo, pFile->name(), uFlags );
+   }
+
+}
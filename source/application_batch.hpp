@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "gd_arguments.h"
+
+#include "application_file.hpp"
+#include "application_cache.hpp"
+
+namespace application {
+
+/**
+ * ## CBatch ==================================================================
+ */
+
+   /**
+    * @brief Convert many files, each file is loaded, transformed and saved on worker threads
+    * Files are split over workers and a worker that runs out of files steals
+    * files from other workers. Each file is converted with the same steps as
+    * when it is done serial with `CDocument` (load into one section, transform,
+    * save sections) so output is byte identical. Errors are collected for each
+    * file and do not stop the batch.
+    *
+~~~{.cpp}
+CBatch batch( []( file::CFile& fileSql ) {
+   return fileSql.SECTION_Erase( R"(--[^\r\n]*)" );                  // compiled once, shared by workers (see: `gd::regex::cache_g`)
+} );
+batch.Run( file::CFolder( "sql", "C:\\sql" ), { {"extension", ".sql"} }, file::CFolder( "out", "C:\\sql\\out" ) );
+for( const auto& it : batch.errors() ) std::cout << it.m_stringFile << ": " << it.m_stringError << "\n";
+~~~
+   */
+   class CBatch
+   {
+   public:
+      /// method called for each file, file has one section with file text
+      using transform_type = std::function<std::pair<bool, std::string>( file::CFile& fileTransform )>;
+
+      /// error information for file that failed
+      struct error
+      {
+         std::string m_stringFile;     ///< file that failed
+         std::string m_stringError;    ///< error information
+      };
+
+   public:
+      CBatch() {}
+      CBatch( transform_type transform_ ): m_transform( std::move( transform_ ) ) {}
+      CBatch( transform_type transform_, unsigned uWorkerCount ): m_transform( std::move( transform_ ) ), m_uWorkerCount( uWorkerCount ) {}
+      ~CBatch() {}
+
+   public:
+      unsigned worker_count() const noexcept { return m_uWorkerCount; }
+      void worker_count( unsigned uWorkerCount ) { m_uWorkerCount = uWorkerCount; }
+      void transform( transform_type transform_ ) { m_transform = std::move( transform_ ); }
+      /// set cache, files not changed since they were converted are copied from cache (cache is not owned)
+      void cache( CConvertCache* pcache ) { m_pcache = pcache; }
+      CConvertCache* cache() const noexcept { return m_pcache; }
+
+      /// number of files converted without errors in last run
+      std::size_t converted() const noexcept { return m_uConverted; }
+      /// errors from last run, in the same order as files were listed
+      const std::vector<error>& errors() const noexcept { return m_vectorError; }
+
+      /// Convert files in folder, converted files replace the original files
+      std::pair<bool, std::string> Run( const file::CFolder& folderFrom, const gd::argument::arguments& argumentsFilter ) { return Run( folderFrom, argumentsFilter, file::CFolder() ); }
+      std::pair<bool, std::string> Run( const file::CFolder& folderFrom, const gd::argument::arguments& argumentsFilter, const file::CFolder& folderTo );
+      std::pair<bool, std::string> Run( const std::vector<std::string>& vectorFile, const file::CFolder& folderTo );
+
+      static std::pair<bool, std::string> Convert( std::string_view stringFileFrom, std::string_view stringFileTo, const transform_type& transform_ );
+
+   public:
+      transform_type m_transform;      ///< method transforming each file
+      unsigned m_uWorkerCount = 0;     ///< number of worker threads, 0 = use number of hardware threads
+      CConvertCache* m_pcache = nullptr;///< cache with converted files, nullptr = no cache
+      std::size_t m_uConverted = 0;    ///< files converted in last run
+      std::vector<error> m_vectorError;///< errors from last run
+   };
+
+}
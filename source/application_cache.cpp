@@ -0,0 +1,161 @@
+#include <cassert>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <system_error>
+
+#include "application_cache.hpp"
+
+namespace application {
+
+   /// read entry file, returns false if entry is missing or can't be read
+   static bool read_entry_s( const std::string& stringFile, CConvertCache::source& sourceEntry, uint64_t& uOutputSize )
+   {
+      std::ifstream ifstreamEntry( stringFile, std::ifstream::binary );
+      if( ifstreamEntry.is_open() == false ) return false;
+
+      std::string stringVersion;
+      ifstreamEntry >> stringVersion;
+      if( stringVersion != "fw-cache-1" ) return false;
+
+      ifstreamEntry >> sourceEntry.m_uSize >> sourceEntry.m_iTime >> sourceEntry.m_uHash >> uOutputSize;
+      return ifstreamEntry.fail() == false;
+   }
+
+   /// write entry file, written to temporary file that replaces entry
+   static std::pair<bool, std::string> write_entry_s( const std::string& stringFile, const CConvertCache::source& sourceEntry, uint64_t uOutputSize )
+   {
+      std::string stringEntry = std::format( "fw-cache-1\n{} {} {} {}\n", sourceEntry.m_uSize, sourceEntry.m_iTime, sourceEntry.m_uHash, uOutputSize );
+      file::CFileWrite filewrite;
+      auto result_ = filewrite.Open( stringFile, file::CFileWrite::eFlagAtomic );
+      if( result_.first == false ) return result_;
+      filewrite.Write( stringEntry );
+      return filewrite.Close();
+   }
+
+   /// hash file content, file is memory mapped
+   static std::pair<bool, std::string> hash_file_s( const std::string& stringFile, uint64_t& uHash )
+   {
+      file::CFileMap filemapSource;
+      auto result_ = filemapSource.Open( stringFile );
+      if( result_.first == false ) return result_;
+
+      uHash = CConvertCache::Hash( filemapSource.data(), filemapSource.size() );
+      return { true, std::string() };
+   }
+
+   /**
+    * @brief Copy converted file from cache if source file is unchanged
+    * Source file is only read if size is the same but modified time has
+    * changed, content hash then decides. On miss `sourceFrom` has all
+    * information needed to store converted file with `Put`, get it before
+    * source file is converted if source file is replaced with result.
+    * @param stringFileFrom source file
+    * @param stringFileTo file converted text is copied to on hit
+    * @param sourceFrom gets information about source file
+    * @return true if converted file was copied, false on miss (error information is set if something failed)
+   */
+   std::pair<bool, std::string> CConvertCache::Get( std::string_view stringFileFrom, std::string_view stringFileTo, source& sourceFrom )
+   {
+      std::error_code errorcode;
+      std::filesystem::path pathFrom = std::filesystem::absolute( std::filesystem::path( stringFileFrom ), errorcode );
+      if( errorcode ) pathFrom = std::filesystem::path( stringFileFrom );
+
+      sourceFrom = source();
+      sourceFrom.m_stringFile = pathFrom.string();
+      sourceFrom.m_stringEntry = std::format( "{:016x}", Hash( sourceFrom.m_stringFile, m_uRuleHash ) );
+      sourceFrom.m_uSize = std::filesystem::file_size( pathFrom, errorcode );
+      if( errorcode ) return { false, std::format( "failed to read size for {} [CConvertCache::Get]", stringFileFrom ) };
+      sourceFrom.m_iTime = static_cast<int64_t>( std::filesystem::last_write_time( pathFrom, errorcode ).time_since_epoch().count() );
+      if( errorcode ) return { false, std::format( "failed to read time for {} [CConvertCache::Get]", stringFileFrom ) };
+
+      std::filesystem::path pathEntry = std::filesystem::path( m_stringFolder ) / sourceFrom.m_stringEntry;
+      source sourceEntry;
+      uint64_t uOutputSize = 0;
+      bool bHit = false;
+      if( read_entry_s( pathEntry.string() + ".entry", sourceEntry, uOutputSize ) == true && sourceEntry.m_uSize == sourceFrom.m_uSize )
+      {
+         if( sourceEntry.m_iTime == sourceFrom.m_iTime )
+         {
+            bHit = true;
+            sourceFrom.m_uHash = sourceEntry.m_uHash;
+         }
+         else
+         {
+            auto result_ = hash_file_s( sourceFrom.m_stringFile, sourceFrom.m_uHash );
+            if( result_.first == false ) return { false, result_.second };
+            bHit = sourceFrom.m_uHash == sourceEntry.m_uHash;
+         }
+      }
+
+      if( bHit == true )
+      {
+         std::filesystem::path pathOutput = pathEntry.string() + ".out";
+         if( std::filesystem::file_size( pathOutput, errorcode ) == uOutputSize && !errorcode )
+         {
+            std::filesystem::copy_file( pathOutput, std::filesystem::path( stringFileTo ), std::filesystem::copy_options::overwrite_existing, errorcode );
+            if( !errorcode )
+            {
+               if( sourceEntry.m_iTime != sourceFrom.m_iTime ) write_entry_s( pathEntry.string() + ".entry", sourceFrom, uOutputSize );// touched but not changed, store new time to skip hash next time
+               m_uHit++;
+               m_uHitBytes += uOutputSize;
+               return { true, std::string() };
+            }
+         }
+      }
+
+      if( sourceFrom.m_uHash == 0 )
+      {
+         auto result_ = hash_file_s( sourceFrom.m_stringFile, sourceFrom.m_uHash );
+         if( result_.first == false ) return { false, result_.second };
+      }
+
+      m_uMiss++;
+      return { false, std::string() };
+   }
+
+   /**
+    * @brief Store converted file in cache
+    * Converted file is copied to cache before entry is written, entry is
+    * written with temporary file and rename so a half written entry is never
+    * read.
+    * @param sourceFrom source information from `Get`
+    * @param stringFileTo converted file
+    * @return true if ok, otherwise false and error information
+   */
+   std::pair<bool, std::string> CConvertCache::Put( const source& sourceFrom, std::string_view stringFileTo )
+   {                                                                           assert( sourceFrom.m_stringEntry.empty() == false );
+      std::error_code errorcode;
+      std::filesystem::create_directories( m_stringFolder, errorcode );
+      if( errorcode ) return { false, std::format( "failed to create cache folder {} [CConvertCache::Put]", m_stringFolder ) };
+
+      std::filesystem::path pathEntry = std::filesystem::path( m_stringFolder ) / sourceFrom.m_stringEntry;
+      std::filesystem::path pathOutput = pathEntry.string() + ".out";
+      uint64_t uOutputSize = std::filesystem::file_size( std::filesystem::path( stringFileTo ), errorcode );
+      if( errorcode ) return { false, std::format( "failed to read size for {} [CConvertCache::Put]", stringFileTo ) };
+
+      std::filesystem::remove( pathEntry.string() + ".entry", errorcode );      // entry is invalid until output is copied
+      std::filesystem::copy_file( std::filesystem::path( stringFileTo ), pathOutput, std::filesystem::copy_options::overwrite_existing, errorcode );
+      if( errorcode ) return { false, std::format( "failed to copy {} to cache [CConvertCache::Put]", stringFileTo ) };
+
+      return write_entry_s( pathEntry.string() + ".entry", sourceFrom, uOutputSize );
+   }
+
+   /**
+    * @brief 64 bit FNV-1a hash
+    * @param pubData data to hash
+    * @param uSize number of bytes
+    * @param uHash start value, pass result from earlier call to continue hash
+    * @return hash value
+   */
+   uint64_t CConvertCache::Hash( const uint8_t* pubData, std::size_t uSize, uint64_t uHash )
+   {
+      for( const uint8_t* pubEnd = pubData + uSize; pubData != pubEnd; pubData++ )
+      {
+         uHash ^= *pubData;
+         uHash *= 0x100000001b3ULL;
+      }
+      return uHash;
+   }
+
+}
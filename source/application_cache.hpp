@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "application_file.hpp"
+
+namespace application {
+
+/**
+ * ## CConvertCache ===========================================================
+ */
+
+   /**
+    * @brief Cache with converted files stored on disk, unchanged files are copied from cache instead of converted
+    * Each source file has one entry in cache folder, entry name is hash of
+    * file path and rule key. Entry stores size, modified time and content hash
+    * for source file and a copy of the converted file. If size and modified
+    * time are the same the file is not read, otherwise content hash decides if
+    * the file has changed. Rule key should change when rules change, use
+    * `file::CRuleProgram::key()` or a version text for custom transforms.
+    *
+~~~{.cpp}
+CConvertCache cacheSql( "C:\\temp\\fw_cache", programSql.key() );
+CConvertCache::source sourceSql;
+auto [bHit, stringError] = cacheSql.Get( "C:\\sql\\a.sql", "C:\\out\\a.sql", sourceSql );
+if( bHit == false && stringError.empty() == true )
+{
+   // convert file ...
+   cacheSql.Put( sourceSql, "C:\\out\\a.sql" );
+}
+std::cout << "hit: " << cacheSql.hit() << " miss: " << cacheSql.miss() << "\n";
+~~~
+   */
+   class CConvertCache
+   {
+   public:
+      /// information about source file, filled in `Get` and used to store result with `Put`
+      struct source
+      {
+         std::string m_stringFile;     ///< source file
+         std::string m_stringEntry;    ///< entry name in cache (without extension)
+         uint64_t m_uSize = 0;         ///< file size
+         int64_t m_iTime = 0;          ///< last write time
+         uint64_t m_uHash = 0;         ///< content hash, 0 if not calculated
+      };
+
+   public:
+      CConvertCache() {}
+      CConvertCache( std::string_view stringFolder, std::string_view stringRuleKey ): m_stringFolder( stringFolder ), m_uRuleHash( Hash( stringRuleKey ) ) {}
+      CConvertCache( const CConvertCache& ) = delete;
+      CConvertCache& operator=( const CConvertCache& ) = delete;
+      ~CConvertCache() {}
+
+   public:
+      const std::string& folder() const noexcept { return m_stringFolder; }
+
+      /// files copied from cache
+      uint64_t hit() const noexcept { return m_uHit; }
+      /// files not found or changed
+      uint64_t miss() const noexcept { return m_uMiss; }
+      /// bytes copied from cache, these did not need to be converted
+      uint64_t hit_bytes() const noexcept { return m_uHitBytes; }
+      void clear_statistics() { m_uHit = 0; m_uMiss = 0; m_uHitBytes = 0; }
+
+      /// Copy converted file from cache if source is unchanged, returns true if copied
+      std::pair<bool, std::string> Get( std::string_view stringFileFrom, std::string_view stringFileTo, source& sourceFrom );
+      /// Store converted file for source read in `Get`
+      std::pair<bool, std::string> Put( const source& sourceFrom, std::string_view stringFileTo );
+
+      static uint64_t Hash( const uint8_t* pubData, std::size_t uSize, uint64_t uHash = 0xcbf29ce484222325ULL );
+      static uint64_t Hash( std::string_view stringData, uint64_t uHash = 0xcbf29ce484222325ULL ) { return Hash( reinterpret_cast<const uint8_t*>( stringData.data() ), stringData.length(), uHash ); }
+
+   public:
+      std::string m_stringFolder;                  ///< folder with cache entries
+      uint64_t m_uRuleHash = 0;                    ///< hash for rule key
+      std::atomic<uint64_t> m_uHit{ 0 };           ///< files copied from cache
+      std::atomic<uint64_t> m_uMiss{ 0 };          ///< files not in cache or changed
+      std::atomic<uint64_t> m_uHitBytes{ 0 };      ///< bytes copied from cache
+   };
+
+}
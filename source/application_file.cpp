@@ -1,8 +1,29 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <format> 
+#include <fstream>
 
 #include <fcntl.h>
-#include <io.h> 
 #include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#  include <io.h> 
+#else
+#  include <climits>
+#  include <cstdio>
+#  include <cerrno>
+#  include <sys/mman.h>
+#  include <sys/uio.h>
+#  include <unistd.h>
+#endif
+
+#include "gd_regex_cache.h"
 
 #include "application_file.hpp"
 
@@ -16,6 +37,91 @@ namespace application { namespace file {
  * ## Free functions ==========================================================
  */
 
+/// step past character after empty match, stops at end and steps one byte for bytes that do not start a character
+static const char* next_character_s( const char* pbszPosition, const char* pbszEnd )
+{                                                                              assert( pbszPosition < pbszEnd );
+   uint8_t uLead = static_cast<uint8_t>( *pbszPosition );
+   std::size_t uSize = uLead < 0xc0 ? 1 : ( uLead < 0xe0 ? 2 : ( uLead < 0xf0 ? 3 : 4 ) );
+   return pbszPosition + std::min<std::size_t>( uSize, pbszEnd - pbszPosition );
+}
+
+/**
+ * @brief Replace matches and build result in a new buffer
+ * All matches are collected first, this gives the exact size and character
+ * count for the result. Unmatched parts and insert text is then copied to the
+ * new buffer in one pass and the new buffer is swapped into the string.
+ * @param stringText text where matches are replaced
+ * @param find_ method returning first match in range or nullptr if not found
+ * @param insert_ method returning text inserted for match
+*/
+template<typename FIND, typename INSERT>
+static void replace_s( gd::utf8::string& stringText, FIND&& find_, INSERT&& insert_ )
+{
+   const char* pbszText = stringText.c_str();
+   const char* pbszEnd = pbszText + stringText.size();
+
+   // ## collect matches, search restarts at the end of each match
+   std::vector<std::pair<const char*, const char*>> vectorMatch;
+   std::vector<std::string_view> vectorInsert;
+   const char* pbszPosition = pbszText;
+   while( true )
+   {
+      auto [pbszMatch, pbszMatchEnd] = find_( pbszPosition, pbszEnd );
+      if( pbszMatch == nullptr ) break;
+
+      vectorMatch.push_back( { pbszMatch, pbszMatchEnd } );
+      vectorInsert.push_back( insert_( pbszMatch, pbszMatchEnd ) );
+      if( pbszMatchEnd == pbszMatch )                                          // empty match, step one character to avoid endless loop
+      {
+         if( pbszMatchEnd == pbszEnd ) break;
+         pbszMatchEnd = next_character_s( pbszMatchEnd, pbszEnd );
+      }
+      pbszPosition = pbszMatchEnd;
+   }
+
+   if( vectorMatch.empty() == true ) return;
+
+   // ## calculate size and number of characters for result, count is only updated if string is counted
+   auto count_ = []( const char* pbszFrom, const char* pbszTo ) -> uint32_t { return pbszFrom < pbszTo ? gd::utf8::count( reinterpret_cast<const uint8_t*>( pbszFrom ), reinterpret_cast<const uint8_t*>( pbszTo ) ).first : 0; };
+   bool bCounted = stringText.is_counted();
+   uint64_t uSize = stringText.size();
+   uint64_t uCount = bCounted == true ? stringText.count() : 0;
+   for( std::size_t u = 0; u < vectorMatch.size(); u++ )
+   {
+      const auto& match_ = vectorMatch[u];
+      std::string_view stringInsert = vectorInsert[u];
+      uSize = uSize - ( match_.second - match_.first ) + stringInsert.length();
+      if( bCounted == true ) uCount = uCount - count_( match_.first, match_.second ) + count_( stringInsert.data(), stringInsert.data() + stringInsert.length() );
+   }
+   if( bCounted == false ) uCount = gd::utf8::string::buffer::npos;
+                                                                               assert( uSize < 0xffffffff );
+   // ## copy to new buffer, same allocator as text
+   gd::utf8::string stringResult( stringText.get_allocator() );
+   stringResult.allocate( static_cast<uint32_t>( uSize ) );
+   uint8_t* pubResult = stringResult.c_buffer();
+   pbszPosition = pbszText;
+   for( std::size_t u = 0; u < vectorMatch.size(); u++ )
+   {
+      const auto& match_ = vectorMatch[u];
+      std::memcpy( pubResult, pbszPosition, match_.first - pbszPosition );
+      pubResult += match_.first - pbszPosition;
+      std::memcpy( pubResult, vectorInsert[u].data(), vectorInsert[u].length() );
+      pubResult += vectorInsert[u].length();
+      pbszPosition = match_.second;
+   }
+   std::memcpy( pubResult, pbszPosition, pbszEnd - pbszPosition );
+
+   stringResult.set_size( static_cast<uint32_t>( uSize ), static_cast<uint32_t>( uCount ) );
+   stringText.swap( stringResult );
+}
+
+/// replace matches with the same text
+template<typename FIND>
+static void replace_s( gd::utf8::string& stringText, std::string_view stringInsert, FIND&& find_ )
+{
+   replace_s( stringText, std::forward<FIND>( find_ ), [stringInsert]( const char*, const char* ) { return stringInsert; } );
+}
+
 /**
  * @brief Replace matched parts and insert text
  * @param stringText text where parts are replaced
@@ -26,244 +132,1675 @@ namespace application { namespace file {
 */
 std::pair<bool, std::string> Replace( gd::utf8::string& stringText, const boost::regex& regexMatch, std::string_view stringInsert, uint32_t uFlags )
 {
-   using namespace gd::utf8;
-   auto pbszPosition = stringText.c_str();
    boost::cmatch cmatchResult;
-   while( boost::regex_search( pbszPosition, cmatchResult, regexMatch, static_cast<boost::regex_constants::match_flags>( uFlags ) ) )
+   replace_s( stringText, stringInsert, [&]( const char* pbszFirst, const char* pbszLast ) -> std::pair<const char*, const char*> {
+      if( boost::regex_search( pbszFirst, pbszLast, cmatchResult, regexMatch, static_cast<boost::regex_constants::match_flags>( uFlags ) ) == true ) return { cmatchResult[0].first, cmatchResult[0].second };
+      return { nullptr, nullptr };
+   } );
+
+   return std::pair<bool, std::string>( true, std::string() );
+}
+
+
+std::pair<bool, std::string> Replace( gd::utf8::string& stringText, const std::regex& regexMatch, std::string_view stringInsert, uint32_t uFlags )
+{
+   std::cmatch cmatchResult;
+   replace_s( stringText, stringInsert, [&]( const char* pbszFirst, const char* pbszLast ) -> std::pair<const char*, const char*> {
+      if( std::regex_search( pbszFirst, pbszLast, cmatchResult, regexMatch, static_cast<std::regex_constants::match_flag_type>( uFlags ) ) == true ) return { cmatchResult[0].first, cmatchResult[0].second };
+      return { nullptr, nullptr };
+   } );
+
+   return std::pair<bool, std::string>( true, std::string() );
+}
+
+
+/**
+ * @brief Replace matched parts with automaton, search time is linear in text length
+ * @param stringText text where parts are replaced
+ * @param automatonMatch compiled pattern used to match
+ * @param stringInsert text to insert on each match
+ * @param uFlags match flags (see: `CAutomaton::enumMatch`)
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> Replace( gd::utf8::string& stringText, const CAutomaton& automatonMatch, std::string_view stringInsert, uint32_t uFlags )
+{
+   const char* pbszText = stringText.c_str();
+   replace_s( stringText, stringInsert, [&]( const char* pbszFirst, const char* pbszLast ) -> std::pair<const char*, const char*> {
+      return automatonMatch.Find( pbszFirst, pbszLast, pbszFirst != pbszText, true, uFlags );
+   } );
+
+   return std::pair<bool, std::string>( true, std::string() );
+}
+
+/**
+ * @brief Replace all keywords in table with one pass over text
+ * @param stringText text where keywords are replaced
+ * @param keywordtable keywords and replacement text
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> Replace( gd::utf8::string& stringText, const CKeywordTable& keywordtable )
+{
+   const char* pbszText = stringText.c_str();
+   replace_s( stringText, [&]( const char* pbszFirst, const char* pbszLast ) -> std::pair<const char*, const char*> {
+      return keywordtable.Find( pbszFirst, pbszLast, pbszFirst != pbszText, true );
+   }, [&keywordtable]( const char* pbszMatch, const char* pbszMatchEnd ) { return keywordtable.Insert( pbszMatch, pbszMatchEnd ); } );
+
+   return std::pair<bool, std::string>( true, std::string() );
+}
+
+/**
+ * @brief Split text into tokens and return spans for tokens of selected kinds, adjacent tokens are joined
+ * @param lexerSql lexer used to split text
+ * @param stringText text to split
+ * @param uKind token kinds to select (see: `CSqlLexer::enumToken`)
+ * @return std::vector<CEraseList::span> sorted spans with byte offsets
+*/
+static std::vector<CEraseList::span> token_span_s( const CSqlLexer& lexerSql, std::string_view stringText, uint32_t uKind )
+{
+   std::vector<CSqlLexer::token> vectorToken;
+   lexerSql.Split( stringText, vectorToken );
+
+   std::vector<CEraseList::span> vectorSpan;
+   for( const auto& it : vectorToken )
    {
-      auto pbszBegin = cmatchResult.prefix().second;
-      auto pbszEnd = cmatchResult.suffix().first;
-      auto uOffset = pbszBegin - stringText.c_str();
-      stringText.replace( reinterpret_cast<string::const_pointer>( pbszBegin ), reinterpret_cast<string::const_pointer>( pbszEnd ), stringInsert );
-      pbszPosition = stringText.c_str() + uOffset + stringInsert.length();
+      if( ( it.m_uKind & uKind ) == 0 ) continue;
+      if( vectorSpan.empty() == false && vectorSpan.back().second == it.m_uOffset ) vectorSpan.back().second += it.m_uLength;
+      else vectorSpan.push_back( CEraseList::span( it.m_uOffset, it.m_uOffset + it.m_uLength ) );
    }
+   return vectorSpan;
+}
 
-   stringText.squeeze();
+/**
+ * @brief Replace keywords in tokens of selected kinds, for example keywords outside strings and comments
+ * Keywords are searched in each run of selected tokens, keyword can span
+ * tokens in same run (`NVARCHAR(` is identifier and symbol).
+ * @param stringText text where keywords are replaced
+ * @param lexerSql lexer used to split text into tokens
+ * @param uKind token kinds where keywords are replaced (see: `CSqlLexer::enumToken`)
+ * @param keywordtable keywords and replacement text
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> Replace( gd::utf8::string& stringText, const CSqlLexer& lexerSql, uint32_t uKind, const CKeywordTable& keywordtable )
+{
+   const char* pbszText = stringText.c_str();
+   std::vector<CEraseList::span> vectorSpan = token_span_s( lexerSql, std::string_view( pbszText, stringText.size() ), uKind );
+
+   std::size_t uSpan = 0;
+   replace_s( stringText, [&]( const char* pbszFirst, const char* ) -> std::pair<const char*, const char*> {
+      for( ; uSpan < vectorSpan.size(); uSpan++ )
+      {
+         const char* pbszSpan = pbszText + vectorSpan[uSpan].first;
+         const char* pbszSpanEnd = pbszText + vectorSpan[uSpan].second;
+         if( pbszSpanEnd <= pbszFirst ) continue;                              // search is past span
+
+         const char* pbszFrom = std::max( pbszSpan, pbszFirst );
+         auto result_ = keywordtable.Find( pbszFrom, pbszSpanEnd, pbszFrom != pbszText, true );
+         if( result_.first != nullptr ) return result_;
+      }
+      return { nullptr, nullptr };
+   }, [&keywordtable]( const char* pbszMatch, const char* pbszMatchEnd ) { return keywordtable.Insert( pbszMatch, pbszMatchEnd ); } );
 
-   return std::pair<bool, std::string>();
+   return std::pair<bool, std::string>( true, std::string() );
 }
 
 
-std::pair<bool, std::string> Erase( gd::utf8::string& stringText, const boost::regex& regexMatch, uint32_t uFlags )
+/**
+ * ## CRule ===================================================================
+ */
+
+#ifdef BOOST_RE_REGEX_HPP
+/// find first match in range with boost regular expression (see: `CRule::match_type`)
+static std::pair<const char*, const char*> find_boost_s( const boost::regex& regexMatch, uint32_t uFlags, const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd )
 {
-   auto pbszPosition = stringText.c_str();
+   auto uMatchFlags = static_cast<boost::regex_constants::match_flag_type>( uFlags );
+   if( bPrevAvail == true ) uMatchFlags = uMatchFlags | boost::regex_constants::match_prev_avail;
+   if( bEnd == false ) uMatchFlags = uMatchFlags | boost::regex_constants::match_not_eol | boost::regex_constants::match_not_eob; // last is not end of text
+
    boost::cmatch cmatchResult;
-   while( boost::regex_search( pbszPosition, cmatchResult, regexMatch, static_cast<boost::regex_constants::match_flags>( uFlags ) ) )
-   {
-      auto pbszBegin = cmatchResult.prefix().second;
-      auto pbszEnd = cmatchResult.suffix().first;
-      auto _count = pbszEnd - pbszBegin;
-      uint8_t* p = stringText.c_buffer() + ((uint8_t*)pbszBegin - (uint8_t*)stringText.c_buffer());
+   if( boost::regex_search( pbszFirst, pbszLast, cmatchResult, regexMatch, uMatchFlags ) == true ) return { cmatchResult[0].first, cmatchResult[0].second };
+   return { nullptr, nullptr };
+}
+
+/**
+ * @brief Create match method for boost regular expression
+ * Literals found in every match are extracted from pattern when rule is created.
+ * Text is scanned for literals and boost is run once from first candidate or
+ * if range contains required literal, text without literals costs one scan.
+ */
+static CRule::match_type match_boost_s( const boost::regex& regexMatch, uint32_t uFlags )
+{
+   CAutomaton::literal literal_;
+   if( ( regexMatch.flags() & ~( boost::regex::nosubs | boost::regex::optimize ) ) == 0 ) literal_ = CAutomaton::Literal_s( regexMatch.str(), CAutomaton::eSyntaxDefault );
 
-      stringText.insert( p, p + _count, _count, 0 );                  // set character that are used to remove characters to 0
-      pbszPosition = pbszEnd;
+   if( literal_.empty() == true )
+   {
+      return [regexMatch, uFlags]( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd ) -> std::pair<const char*, const char*> {
+         return find_boost_s( regexMatch, uFlags, pbszFirst, pbszLast, bPrevAvail, bEnd );
+      };
    }
 
-   stringText.squeeze();
+   return [regexMatch, uFlags, literal_]( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd ) -> std::pair<const char*, const char*> {
+      return literal_.Find( pbszFirst, pbszLast, bPrevAvail, [&]( const char* pbszFrom, bool bPrev ) {
+         return find_boost_s( regexMatch, uFlags, pbszFrom, pbszLast, bPrev, bEnd );
+      } );
+   };
+}
 
-   return std::pair<bool, std::string>();
+CRule::CRule( const boost::regex& regexMatch, uint32_t uFlags ): m_uType( eTypeErase ), m_match( match_boost_s( regexMatch, uFlags ) ) {
+   m_stringKey = std::format( "{}:{}:{}:{}", m_uType, uFlags, regexMatch.flags(), regexMatch.str() );
+}
+CRule::CRule( const boost::regex& regexMatch, std::string_view stringInsert, uint32_t uFlags ): m_uType( eTypeReplace ), m_match( match_boost_s( regexMatch, uFlags ) ), m_stringInsert( stringInsert ) {
+   m_stringKey = std::format( "{}:{}:{}:{}:{}:{}", m_uType, uFlags, regexMatch.flags(), regexMatch.str().length(), regexMatch.str(), stringInsert );
 }
+#endif
 
-std::pair<bool, std::string> Replace( gd::utf8::string& stringText, const std::regex& regexMatch, std::string_view stringInsert, uint32_t uFlags )
+/// find first match in range with stl regular expression (see: `CRule::match_type`)
+static std::pair<const char*, const char*> find_std_s( const std::regex& regexMatch, uint32_t uFlags, const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd )
 {
-   auto pbszPosition = stringText.c_str();
+   auto uMatchFlags = static_cast<std::regex_constants::match_flag_type>( uFlags );
+   if( bPrevAvail == true ) uMatchFlags |= std::regex_constants::match_prev_avail;
+   if( bEnd == false ) uMatchFlags |= std::regex_constants::match_not_eol;
+
    std::cmatch cmatchResult;
-   while( std::regex_search( pbszPosition, cmatchResult, regexMatch, static_cast<std::regex_constants::match_flag_type>( uFlags ) ) )
-   {
-      auto pbszBegin = cmatchResult.prefix().second;
-      auto pbszEnd = cmatchResult.suffix().first;
-      auto _count = pbszEnd - pbszBegin;
-      uint8_t* p = stringText.c_buffer() + ((uint8_t*)pbszBegin - (uint8_t*)stringText.c_buffer());
+   if( std::regex_search( pbszFirst, pbszLast, cmatchResult, regexMatch, uMatchFlags ) == true ) return { cmatchResult[0].first, cmatchResult[0].second };
+   return { nullptr, nullptr };
+}
+
+/// create match method for stl regular expression
+static CRule::match_type match_std_s( const std::regex& regexMatch, uint32_t uFlags )
+{
+   return [regexMatch, uFlags]( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd ) -> std::pair<const char*, const char*> {
+      return find_std_s( regexMatch, uFlags, pbszFirst, pbszLast, bPrevAvail, bEnd );
+   };
+}
+
+CRule::CRule( const std::regex& regexMatch, uint32_t uFlags ): m_uType( eTypeErase ), m_match( match_std_s( regexMatch, uFlags ) ) {}
+CRule::CRule( const std::regex& regexMatch, std::string_view stringInsert, uint32_t uFlags ): m_uType( eTypeReplace ), m_match( match_std_s( regexMatch, uFlags ) ), m_stringInsert( stringInsert ) {}
+
+/// create match method for automaton, copy shares compiled pattern and states
+static CRule::match_type match_automaton_s( const CAutomaton& automatonMatch, uint32_t uFlags )
+{
+   return [automatonMatch, uFlags]( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd ) -> std::pair<const char*, const char*> {
+      return automatonMatch.Find( pbszFirst, pbszLast, bPrevAvail, bEnd, uFlags );
+   };
+}
+
+CRule::CRule( const CAutomaton& automatonMatch, uint32_t uFlags ): m_uType( eTypeErase ), m_match( match_automaton_s( automatonMatch, uFlags ) ) {
+   m_stringKey = std::format( "{}:{}:a{}:{}", m_uType, uFlags, automatonMatch.flags(), automatonMatch.str() );
+}
+CRule::CRule( const CAutomaton& automatonMatch, std::string_view stringInsert, uint32_t uFlags ): m_uType( eTypeReplace ), m_match( match_automaton_s( automatonMatch, uFlags ) ), m_stringInsert( stringInsert ) {
+   m_stringKey = std::format( "{}:{}:a{}:{}:{}:{}", m_uType, uFlags, automatonMatch.flags(), automatonMatch.str().length(), automatonMatch.str(), stringInsert );
+}
+
+/// replace rule for keyword table, insert text is taken from table for each match (copy shares compiled table)
+CRule::CRule( const CKeywordTable& keywordtable ): m_uType( eTypeReplace ) {
+   m_match = [keywordtable]( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd ) { return keywordtable.Find( pbszFirst, pbszLast, bPrevAvail, bEnd ); };
+   m_insert = [keywordtable]( const char* pbszMatch, const char* pbszMatchEnd ) { return keywordtable.Insert( pbszMatch, pbszMatchEnd ); };
+   m_stringKey = std::format( "{}:k{}", m_uType, keywordtable.key() );
+}
 
-      stringText.insert( p, p + _count, _count, 0 );                  // set character that are used to remove characters to 0
-      pbszPosition = pbszEnd;
-   }
 
-   stringText.squeeze();
+/**
+ * ## Erase ===================================================================
+ */
 
-   return std::pair<bool, std::string>();
+#ifdef BOOST_RE_REGEX_HPP
+/**
+ * @brief Erase matched parts, text is compacted once after all matches are found
+ * @param stringText text where matched parts are erased
+ * @param regexMatch regular expression used to match
+ * @param uFlags for regular expression searches, how to search
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> Erase( gd::utf8::string& stringText, const boost::regex& regexMatch, uint32_t uFlags )
+{
+   CEraseList eraselist;
+   auto result_ = Erase( std::string_view( stringText.c_str(), stringText.size() ), regexMatch, uFlags, eraselist );
+   if( result_.first == true ) eraselist.Apply( stringText );
+   return result_;
 }
 
+/**
+ * @brief Add matched parts to erase list, text is not changed
+ * Text is searched as if spans in list were removed, erased text is never matched.
+ * @param stringText text to search
+ * @param regexMatch regular expression used to match
+ * @param uFlags for regular expression searches, how to search
+ * @param eraselist list that gets erased spans
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> Erase( std::string_view stringText, const boost::regex& regexMatch, uint32_t uFlags, CEraseList& eraselist )
+{
+   eraselist.Find( stringText, [&regexMatch, uFlags]( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd ) {
+      return find_boost_s( regexMatch, uFlags, pbszFirst, pbszLast, bPrevAvail, bEnd );
+   } );
+
+   return { true, std::string() };
+}
+#endif
 
 std::pair<bool, std::string> Erase( gd::utf8::string& stringText, const std::regex& regexMatch, uint32_t uFlags )
 {
-   auto pbszPosition = stringText.c_str();
-   std::cmatch cmatchResult;
-   while( std::regex_search( pbszPosition, cmatchResult, regexMatch, static_cast<std::regex_constants::match_flag_type>( uFlags ) ) )
-   {
-      auto pbszBegin = cmatchResult.prefix().second;
-      auto pbszEnd = cmatchResult.suffix().first;
-      auto _count = pbszEnd - pbszBegin;
-      uint8_t* p = stringText.c_buffer() + ((uint8_t*)pbszBegin - (uint8_t*)stringText.c_buffer());
+   CEraseList eraselist;
+   auto result_ = Erase( std::string_view( stringText.c_str(), stringText.size() ), regexMatch, uFlags, eraselist );
+   if( result_.first == true ) eraselist.Apply( stringText );
+   return result_;
+}
 
-      stringText.insert( p, p + _count, _count, 0 );                  // set character that are used to remove characters to 0
-      pbszPosition = pbszEnd;
-   }
+std::pair<bool, std::string> Erase( std::string_view stringText, const std::regex& regexMatch, uint32_t uFlags, CEraseList& eraselist )
+{
+   eraselist.Find( stringText, [&regexMatch, uFlags]( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd ) {
+      return find_std_s( regexMatch, uFlags, pbszFirst, pbszLast, bPrevAvail, bEnd );
+   } );
+
+   return { true, std::string() };
+}
+
+std::pair<bool, std::string> Erase( gd::utf8::string& stringText, const CAutomaton& automatonMatch, uint32_t uFlags )
+{
+   CEraseList eraselist;
+   auto result_ = Erase( std::string_view( stringText.c_str(), stringText.size() ), automatonMatch, uFlags, eraselist );
+   if( result_.first == true ) eraselist.Apply( stringText );
+   return result_;
+}
 
-   stringText.squeeze();
+std::pair<bool, std::string> Erase( std::string_view stringText, const CAutomaton& automatonMatch, uint32_t uFlags, CEraseList& eraselist )
+{
+   eraselist.Find( stringText, [&automatonMatch, uFlags]( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd ) {
+      return automatonMatch.Find( pbszFirst, pbszLast, bPrevAvail, bEnd, uFlags );
+   } );
 
-   return std::pair<bool, std::string>();
+   return { true, std::string() };
 }
 
 /**
- * @brief check if tag is found
- * @param stringTag tag name, if empty then true is returned
- * @return if group is found return true, otherwise false
+ * @brief Erase tokens of selected kinds, for example all comments
+ * @param stringText text where tokens are erased
+ * @param lexerSql lexer used to split text into tokens
+ * @param uKind token kinds to erase (see: `CSqlLexer::enumToken`)
+ * @return true if ok, otherwise false and error information
 */
-bool CSection::HasGroup( std::string_view stringTag ) const noexcept 
-{ 
-   if( stringTag.empty() == true ) return true;                               // empty group name will always return true
+std::pair<bool, std::string> Erase( gd::utf8::string& stringText, const CSqlLexer& lexerSql, uint32_t uKind )
+{
+   CEraseList eraselist;
+   auto result_ = Erase( std::string_view( stringText.c_str(), stringText.size() ), lexerSql, uKind, eraselist );
+   if( result_.first == true ) eraselist.Apply( stringText );
+   return result_;
+}
 
-   if( m_stringTag == stringTag ) return true;
+/**
+ * @brief Add tokens of selected kinds to erase list, text is not changed
+ * Text is split into tokens as it is, spans already in list are not skipped
+ * (a comment marker in erased text still starts a comment).
+ * @param stringText text to split into tokens
+ * @param lexerSql lexer used to split text into tokens
+ * @param uKind token kinds to erase (see: `CSqlLexer::enumToken`)
+ * @param eraselist list that gets erased spans
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> Erase( std::string_view stringText, const CSqlLexer& lexerSql, uint32_t uKind, CEraseList& eraselist )
+{
+   eraselist.Add( token_span_s( lexerSql, stringText, uKind ) );
+   return { true, std::string() };
+}
 
-   if( m_stringTag.find( std::format( "[{}]", stringTag ) ) != m_stringTag.cend() ) return true;
 
-   return false;
-}
+/**
+ * ## CRuleProgram ============================================================
+ */
 
 /**
- * @brief Split section code into one or more sections
- * @param vectorPosition positions where string is split into subsections and added as sections 
+ * @brief Text identifying rules, changes if rules or rule order is changed
+ * @return text with key for each rule, empty if one rule has no key
 */
-void CSection::Split( std::vector<std::size_t> vectorPosition, bool bKeep )
+std::string CRuleProgram::key() const
 {
-   auto itFrom = m_stringCode.cbegin();
-   for( auto itCount = std::begin( vectorPosition ); itCount != std::end( vectorPosition ) && *itCount < m_stringCode.count(); itCount++ )
+   std::string stringKey;
+   for( const auto& it : m_vectorRule )
    {
-      auto itTo = itFrom + *itCount;
-      auto stringSection = m_stringCode.substr( itFrom, itTo );
-      itFrom = itTo;
-      m_vectorSection.push_back( CSection( m_pFile, m_stringTag, stringSection ) );
+      if( it.key().empty() == true ) return std::string();
+      stringKey += std::format( "{}:{}\n", it.key().length(), it.key() );   // length prefix, keys may contain any character
    }
+   return stringKey;
+}
+
+/**
+ * @brief Apply all rules to utf8 string
+ * @param stringText text rules are applied to, gets the result
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CRuleProgram::Apply( gd::utf8::string& stringText ) const
+{
+   if( m_vectorRule.empty() == true || stringText.empty() == true ) return { true, std::string() };
+
+   std::string stringResult;
+   auto result_ = Apply( std::string_view( stringText.c_str(), stringText.size() ), stringResult );
+   if( result_.first == false ) return result_;
+
+   stringText.assign( reinterpret_cast<const uint8_t*>( stringResult.data() ), stringResult.size() );// characters are counted once
+   return { true, std::string() };
+}
+
+/**
+ * @brief Apply all rules to text, each rule reads from one buffer and writes to the other
+ * First rule reads text directly, text is only copied if there are no rules.
+ * @param stringText text rules are applied to, can't point into result
+ * @param stringResult gets text after all rules are applied
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CRuleProgram::Apply( std::string_view stringText, std::string& stringResult ) const
+{                                                                              assert( stringText.data() != stringResult.data() || stringText.empty() == true );
+   if( m_vectorRule.empty() == true ) { stringResult.assign( stringText ); return { true, std::string() }; }
 
-   if( itFrom < m_stringCode.cend() )
+   Apply( m_vectorRule[0], stringText, stringResult );                         // first rule reads text, no copy before rules
+   std::string stringBuffer;                                                   // second buffer, swapped with result after each rule
+   for( std::size_t u = 1; u < m_vectorRule.size(); u++ )
    {
-      auto stringSection = m_stringCode.substr( itFrom, m_stringCode.cend() );
-      m_vectorSection.push_back( CSection( m_pFile, m_stringTag, stringSection ) );
+      Apply( m_vectorRule[u], stringResult, stringBuffer );
+      stringResult.swap( stringBuffer );
    }
 
-   if( bKeep == false ) m_stringCode.clear();
+   return { true, std::string() };
 }
 
-
 /**
- * @brief Join sections into one utf8 string and return
- * @param stringTag tags if
- * @return 
+ * @brief Apply rule to text, unmatched text and insert text for replace rules are copied to result
+ * Search restarts at the end of each match, same as `Erase` and `Replace`.
+ * @param ruleApply rule to apply
+ * @param stringText text rule is applied to
+ * @param stringResult gets text after rule is applied
 */
-gd::utf8::string CSection::Join( std::string_view stringGroup )
+void CRuleProgram::Apply( const CRule& ruleApply, std::string_view stringText, std::string& stringResult )
 {
-   gd::utf8::string stringResult;
-   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
+   stringResult.clear();
+   stringResult.reserve( stringText.length() );
+
+   const char* pbszPosition = stringText.data();
+   const char* pbszEnd = pbszPosition + stringText.length();
+   bool bPrevAvail = false;
+   while( pbszPosition <= pbszEnd )
    {
-      if( stringGroup.empty() == false || it->HasGroup( stringGroup ) )
+      auto [pbszMatch, pbszMatchEnd] = ruleApply.Find( pbszPosition, pbszEnd, bPrevAvail, true );
+      if( pbszMatch == nullptr ) break;
+
+      stringResult.append( pbszPosition, pbszMatch );
+      if( ruleApply.IsReplace() == true ) stringResult.append( ruleApply.Insert( pbszMatch, pbszMatchEnd ) );
+
+      bPrevAvail = false;
+      if( pbszMatchEnd == pbszMatch )                                          // empty match, step one character to avoid endless loop
       {
-         stringResult += it->code();
+         if( pbszMatchEnd == pbszEnd ) { pbszPosition = pbszEnd; break; }
+         const char* pbszNext = next_character_s( pbszMatchEnd, pbszEnd );
+         stringResult.append( pbszMatchEnd, pbszNext );
+         pbszMatchEnd = pbszNext;
+         bPrevAvail = true;
       }
+      pbszPosition = pbszMatchEnd;
    }
 
-   return stringResult;
+   stringResult.append( pbszPosition, pbszEnd );
 }
 
 
 /**
- * ## CFile ===================================================================
+ * ## CEraseList ==============================================================
  */
 
-#ifdef BOOST_RE_REGEX_HPP
-std::pair<bool, std::string> CFile::SECTION_Replace( const boost::regex& regexMatch, std::string_view stringInsert, std::string_view stringGroup, uint32_t uFlags )
+void CEraseList::Add( uint64_t uOffset, uint64_t uLength )
 {
-   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
-   {
-      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
+   Add( std::vector<span>{ span( uOffset, uOffset + uLength ) } );
+}
 
-      auto [bOk, stringError] = it->Replace( regexMatch, stringInsert, uFlags );
-      if( bOk == false ) return { bOk, stringError };
+/**
+ * @brief Merge sorted spans with list, overlapping and adjacent spans are joined
+ * @param vectorSpan spans sorted by offset, spans may overlap spans in list
+*/
+void CEraseList::Add( const std::vector<span>& vectorSpan )
+{
+   if( vectorSpan.empty() == true ) return;
+
+   std::vector<span> vectorMerge;
+   vectorMerge.reserve( m_vectorSpan.size() + vectorSpan.size() );
+   auto add_ = [&vectorMerge]( const span& spanAdd ) {
+      if( spanAdd.first >= spanAdd.second ) return;                           // empty span
+      if( vectorMerge.empty() == false && spanAdd.first <= vectorMerge.back().second ) vectorMerge.back().second = std::max( vectorMerge.back().second, spanAdd.second );
+      else vectorMerge.push_back( spanAdd );
+   };
+
+   auto itList = m_vectorSpan.cbegin();
+   auto itAdd = vectorSpan.cbegin();
+   while( itList != m_vectorSpan.cend() || itAdd != vectorSpan.cend() )
+   {
+      if( itAdd == vectorSpan.cend() || ( itList != m_vectorSpan.cend() && itList->first <= itAdd->first ) ) add_( *itList++ );
+      else add_( *itAdd++ );
    }
 
-   return { true, std::string() };
+   m_vectorSpan.swap( vectorMerge );
+   m_uErased = 0;
+   for( const auto& it : m_vectorSpan ) m_uErased += it.second - it.first;
 }
 
+/**
+ * @brief Find matches in text with erased spans removed
+ * Kept parts are copied to one compacted text that is searched in one pass,
+ * so anchors like `$` and matches that cross erased spans work as if erased
+ * text was removed. Matches are mapped back to offsets in text, erased spans
+ * inside a match are merged with it. Empty matches step one character (same
+ * as `CRuleProgram::Apply`).
+ * @param stringText text that spans in list are erased from
+ * @param match_ method returning first match in range or nullptr if not found
+*/
+void CEraseList::Find( std::string_view stringText, const CRule::match_type& match_ )
+{                                                                              assert( m_vectorSpan.empty() == true || m_vectorSpan.back().second <= stringText.length() );
+   std::string_view stringSearch = stringText;
+   std::string stringCompact;
+   std::vector<span> vectorPart;                                               // kept parts, offset in compacted text and offset in text
+   if( m_vectorSpan.empty() == false )
+   {
+      stringCompact.reserve( stringText.length() - m_uErased );
+      for_each( stringText, [&stringText, &stringCompact, &vectorPart]( const uint8_t* pubText, std::size_t uLength ) {
+         vectorPart.push_back( span( stringCompact.length(), reinterpret_cast<const char*>( pubText ) - stringText.data() ) );
+         stringCompact.append( reinterpret_cast<const char*>( pubText ), uLength );
+      } );
+      stringSearch = stringCompact;
+   }
 
+   // ## offset in searched text to offset in text, `uOffset` is in part that starts before it
+   auto offset_ = [&vectorPart]( uint64_t uOffset ) -> uint64_t {
+      if( vectorPart.empty() == true ) return uOffset;
+      auto itPart = std::upper_bound( vectorPart.cbegin(), vectorPart.cend(), uOffset, []( uint64_t u_, const span& span_ ) { return u_ < span_.first; } );
+      --itPart;
+      return itPart->second + ( uOffset - itPart->first );
+   };
 
-std::pair<bool, std::string> CFile::SECTION_Erase( const boost::regex& regexMatch, std::string_view stringGroup, uint32_t uFlags )
-{
-   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
+   std::vector<span> vectorMatch;
+   const char* pbszText = stringSearch.data();
+   const char* pbszPosition = pbszText;
+   const char* pbszEnd = pbszText + stringSearch.length();
+   bool bPrevAvail = false;
+   while( pbszPosition <= pbszEnd )
    {
-      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
+      auto [pbszMatch, pbszMatchEnd] = match_( pbszPosition, pbszEnd, bPrevAvail, true );
+      if( pbszMatch == nullptr ) break;
 
-      auto [bOk, stringError] = it->Erase( regexMatch, uFlags );
-      if( bOk == false ) return { bOk, stringError };
+      if( pbszMatchEnd > pbszMatch ) vectorMatch.push_back( span( offset_( pbszMatch - pbszText ), offset_( pbszMatchEnd - pbszText - 1 ) + 1 ) );// last byte is mapped, end may be at start of next part
+
+      bPrevAvail = false;
+      if( pbszMatchEnd == pbszMatch )                                          // empty match, step one character to avoid endless loop
+      {
+         if( pbszMatchEnd == pbszEnd ) break;
+         pbszMatchEnd = next_character_s( pbszMatchEnd, pbszEnd );
+         bPrevAvail = true;
+      }
+      pbszPosition = pbszMatchEnd;
    }
 
-   return { true, std::string() };
+   Add( vectorMatch );
 }
-#endif
 
-std::pair<bool, std::string> CFile::SECTION_Replace( const std::regex& regexMatch, std::string_view stringInsert, std::string_view stringGroup, uint32_t uFlags )
+/**
+ * @brief Copy parts that are not erased to new buffer and swap it into string
+ * @param stringText text spans are removed from
+*/
+void CEraseList::Apply( gd::utf8::string& stringText )
 {
-   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
-   {
-      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
+   if( m_vectorSpan.empty() == true ) return;
 
-      auto [bOk, stringError] = it->Replace( regexMatch, stringInsert, uFlags );
-      if( bOk == false ) return { bOk, stringError };
+   gd::utf8::string stringResult( stringText.get_allocator() );
+   Apply( std::string_view( stringText.c_str(), stringText.size() ), stringResult );
+   stringText.swap( stringResult );
+}
+
+/**
+ * @brief Copy parts that are not erased to result, kept characters are counted while they are copied
+ * @param stringText text spans are removed from
+ * @param stringResult gets text without erased spans, allocator in result is used
+*/
+void CEraseList::Apply( std::string_view stringText, gd::utf8::string& stringResult )
+{                                                                              assert( m_vectorSpan.empty() == true || m_vectorSpan.back().second <= stringText.length() );
+   stringResult.clear();
+   uint64_t uSize = stringText.length() - m_uErased;
+   if( uSize > 0 )
+   {
+      stringResult.allocate( static_cast<uint32_t>( uSize ) );
+      uint8_t* pubResult = stringResult.c_buffer();
+      uint32_t uCount = 0;
+      for_each( stringText, [&pubResult, &uCount]( const uint8_t* pubText, std::size_t uLength ) {
+         std::memcpy( pubResult, pubText, uLength );
+         uCount += gd::utf8::count( pubText, pubText + uLength ).first;
+         pubResult += uLength;
+      } );
+      stringResult.set_size( static_cast<uint32_t>( uSize ), uCount );
    }
 
-   return { true, std::string() };
+   clear();
 }
 
 
-std::pair<bool, std::string> CFile::SECTION_Erase( const std::regex& regexMatch, std::string_view stringGroup, uint32_t uFlags )
-{
-   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
-   {
-      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
-
-      auto [bOk, stringError] = it->Erase( regexMatch, uFlags );
-      if( bOk == false ) return { bOk, stringError };
-   }
+/**
+ * ## CPieceTable =============================================================
+ */
 
-   return { true, std::string() };
+/**
+ * @brief Create table with one piece for selected text in original string
+ * @param stringOriginal text to edit, string buffer is shared if reference counted
+ * @param uOffset byte offset to text in original
+ * @param uLength number of bytes from offset
+*/
+CPieceTable::CPieceTable( const gd::utf8::string& stringOriginal, uint32_t uOffset, uint32_t uLength ): m_stringOriginal( stringOriginal )
+{                                                                              assert( uOffset + uLength <= m_stringOriginal.size() );
+   m_vectorNode.push_back( node() );
+   if( uLength > 0 ) m_uRoot = new_node( piece{ eBufferOriginal, uOffset, uLength }, random() );
 }
 
 /**
- * @brief Set name for file from the full path
- * Tries to extract file name from full path and set it as the name
+ * @brief Insert text at byte offset, text is added to add buffer
+ * If text is inserted directly after last inserted text the piece is extended
+ * instead of adding a new piece.
+ * @param uOffset byte offset where text is inserted
+ * @param stringInsert text to insert
 */
-void CFile::SetNameFromPath()
-{
-   auto iPosition = m_stringPath.rfind( '\\' );
-   if( iPosition == std::string::npos ) iPosition = m_stringPath.rfind( '/' );
+void CPieceTable::Insert( uint64_t uOffset, std::string_view stringInsert )
+{                                                                              assert( uOffset <= size() ); assert( m_stringAdd.size() + stringInsert.length() < 0xffffffff );
+   if( stringInsert.empty() == true ) return;
 
-   if( iPosition == std::string::npos ) m_stringName = m_stringPath;
-   else
+   auto [uLeft, uRight] = split( m_uRoot, uOffset );
+
+   // ## extend last piece in left part if it ends where add buffer ends
+   uint32_t uLast = uLeft;
+   while( uLast != 0 && m_vectorNode[uLast].m_uRight != 0 ) uLast = m_vectorNode[uLast].m_uRight;
+   if( uLast != 0 && m_vectorNode[uLast].m_piece.m_uBuffer == eBufferAdd && m_vectorNode[uLast].m_piece.m_uOffset + m_vectorNode[uLast].m_piece.m_uLength == m_stringAdd.size() )
    {
-      m_stringName = m_stringPath.substr( iPosition + 1 );
-      iPosition = m_stringName.rfind( '.' );
-      if( iPosition != std::string::npos ) m_stringName = m_stringName.substr( 0, iPosition );
+      m_stringAdd.append( stringInsert );
+      m_vectorNode[uLast].m_piece.m_uLength += static_cast<uint32_t>( stringInsert.length() );
+      for( uint32_t uNode = uLeft; uNode != 0; uNode = m_vectorNode[uNode].m_uRight ) m_vectorNode[uNode].m_uSize += stringInsert.length();// size for all nodes on path to last
+      m_uRoot = merge( uLeft, uRight );
+      return;
    }
+
+   uint32_t uNew = new_node( piece{ eBufferAdd, static_cast<uint32_t>( m_stringAdd.size() ), static_cast<uint32_t>( stringInsert.length() ) }, random() );
+   m_stringAdd.append( stringInsert );
+   m_uRoot = merge( merge( uLeft, uNew ), uRight );
 }
 
+/**
+ * @brief Erase bytes starting at byte offset
+ * @param uOffset byte offset to first byte erased
+ * @param uLength number of bytes to erase, erase stops at end of text
+*/
+void CPieceTable::Erase( uint64_t uOffset, uint64_t uLength )
+{                                                                              assert( uOffset <= size() );
+   if( uLength == 0 ) return;
 
-std::pair<bool, std::string> CFile::FILE_Load( std::string stringFileName, std::string_view stringName )
-{
-   constexpr int BUFFER_SIZE = 4*1024;
-   int iFileHandle = _open( stringFileName.c_str(), _O_RDONLY );
-   if( iFileHandle == -1 ) return { false, std::format("failed to open {}", stringFileName.c_str()) };
+   auto [uLeft, uRight] = split( m_uRoot, uOffset );
+   auto [uErase, uKeep] = split( uRight, uLength );
+   free_node( uErase );
+   m_uRoot = merge( uLeft, uKeep );
+}
 
-   uint8_t pBuffer[BUFFER_SIZE + 1];
-   std::vector<uint8_t> vectorBuffer;
-   std::size_t uCount;
-   while( (uCount = read( iFileHandle, pBuffer, BUFFER_SIZE )) != 0 )
-   {
-      vectorBuffer.insert( vectorBuffer.end(), pBuffer, pBuffer + uCount );
-   }
- 
+/**
+ * @brief Build text from pieces
+ * @param pallocator allocator for text, nullptr = new/delete
+ * @return string with edited text, characters are counted when needed
+*/
+gd::utf8::string CPieceTable::Text( gd::utf8::allocator* pallocator ) const
+{                                                                              assert( size() < 0xffffffff );
+   gd::utf8::string stringText( pallocator );
+   if( empty() == true ) return stringText;
 
-   return { true, std::string() };
+   stringText.allocate( static_cast<uint32_t>( size() ) );
+   uint8_t* pubText = stringText.c_buffer();
+   for_each( [&pubText]( const uint8_t* pubPiece, std::size_t uSize ) {
+      std::memcpy( pubText, pubPiece, uSize );
+      pubText += uSize;
+   } );
+
+   stringText.set_size( static_cast<uint32_t>( size() ), gd::utf8::string::buffer::npos );
+   return stringText;
 }
 
+/**
+ * @brief Call method for each piece in text order
+ * @param callback_ gets pointer to piece text and number of bytes
+*/
+void CPieceTable::for_each( const std::function<void( const uint8_t* pubText, std::size_t uSize )>& callback_ ) const
+{
+   std::vector<uint32_t> vectorStack;                                          // nodes where left part is visited
+   uint32_t uNode = m_uRoot;
+   while( uNode != 0 || vectorStack.empty() == false )
+   {
+      while( uNode != 0 ) { vectorStack.push_back( uNode ); uNode = m_vectorNode[uNode].m_uLeft; }
+
+      uNode = vectorStack.back();
+      vectorStack.pop_back();
+      const piece& pieceText = m_vectorNode[uNode].m_piece;
+      callback_( data( pieceText ), pieceText.m_uLength );
+      uNode = m_vectorNode[uNode].m_uRight;
+   }
+}
+
+/// add node, free nodes are reused
+uint32_t CPieceTable::new_node( const piece& pieceText, uint32_t uPriority )
+{
+   uint32_t uNode;
+   if( m_vectorFree.empty() == false ) { uNode = m_vectorFree.back(); m_vectorFree.pop_back(); }
+   else { uNode = static_cast<uint32_t>( m_vectorNode.size() ); m_vectorNode.push_back( node() ); }
+
+   m_vectorNode[uNode] = node{ pieceText, pieceText.m_uLength, uPriority, 0, 0 };
+   return uNode;
+}
+
+/// free node and all nodes in subtree
+void CPieceTable::free_node( uint32_t uNode )
+{
+   std::vector<uint32_t> vectorStack;
+   if( uNode != 0 ) vectorStack.push_back( uNode );
+   while( vectorStack.empty() == false )
+   {
+      uNode = vectorStack.back();
+      vectorStack.pop_back();
+      if( m_vectorNode[uNode].m_uLeft != 0 ) vectorStack.push_back( m_vectorNode[uNode].m_uLeft );
+      if( m_vectorNode[uNode].m_uRight != 0 ) vectorStack.push_back( m_vectorNode[uNode].m_uRight );
+      m_vectorFree.push_back( uNode );
+   }
+}
+
+/**
+ * @brief Split tree at byte offset, piece at offset is split in two if offset is inside piece
+ * @param uNode tree to split
+ * @param uOffset bytes that goes to left tree
+ * @return pair with left tree and right tree
+*/
+std::pair<uint32_t, uint32_t> CPieceTable::split( uint32_t uNode, uint64_t uOffset )
+{
+   if( uNode == 0 ) return { 0, 0 };
+
+   uint64_t uLeftSize = m_vectorNode[m_vectorNode[uNode].m_uLeft].m_uSize;
+   uint32_t uLength = m_vectorNode[uNode].m_piece.m_uLength;
+   if( uOffset <= uLeftSize )
+   {
+      auto [uLeft, uRight] = split( m_vectorNode[uNode].m_uLeft, uOffset );
+      m_vectorNode[uNode].m_uLeft = uRight;
+      update( uNode );
+      return { uLeft, uNode };
+   }
+
+   if( uOffset >= uLeftSize + uLength )
+   {
+      auto [uLeft, uRight] = split( m_vectorNode[uNode].m_uRight, uOffset - uLeftSize - uLength );
+      m_vectorNode[uNode].m_uRight = uLeft;
+      update( uNode );
+      return { uNode, uRight };
+   }
+
+   // ## offset is inside piece, right part gets new node with same priority so heap order is kept
+   uint32_t uCut = static_cast<uint32_t>( uOffset - uLeftSize );
+   piece pieceRight = m_vectorNode[uNode].m_piece;
+   pieceRight.m_uOffset += uCut;
+   pieceRight.m_uLength -= uCut;
+   uint32_t uNew = new_node( pieceRight, m_vectorNode[uNode].m_uPriority );
+   m_vectorNode[uNode].m_piece.m_uLength = uCut;
+   m_vectorNode[uNew].m_uRight = m_vectorNode[uNode].m_uRight;
+   m_vectorNode[uNode].m_uRight = 0;
+   update( uNew );
+   update( uNode );
+   return { uNode, uNew };
+}
+
+/**
+ * @brief Merge two trees, all text in left tree is before text in right tree
+ * @return root for merged tree
+*/
+uint32_t CPieceTable::merge( uint32_t uLeft, uint32_t uRight )
+{
+   if( uLeft == 0 ) return uRight;
+   if( uRight == 0 ) return uLeft;
+
+   if( m_vectorNode[uLeft].m_uPriority >= m_vectorNode[uRight].m_uPriority )
+   {
+      uint32_t uMerge = merge( m_vectorNode[uLeft].m_uRight, uRight );
+      m_vectorNode[uLeft].m_uRight = uMerge;
+      update( uLeft );
+      return uLeft;
+   }
+
+   uint32_t uMerge = merge( uLeft, m_vectorNode[uRight].m_uLeft );
+   m_vectorNode[uRight].m_uLeft = uMerge;
+   update( uRight );
+   return uRight;
+}
+
+
+/**
+ * @brief check if tag is found
+ * @param stringTag tag name, if empty then true is returned
+ * @return if group is found return true, otherwise false
+*/
+bool CSection::HasGroup( std::string_view stringTag ) const noexcept 
+{ 
+   if( stringTag.empty() == true ) return true;                               // empty group name will always return true
+
+   if( m_stringTag == stringTag ) return true;
+
+   if( m_stringTag.find( std::format( "[{}]", stringTag ) ) != m_stringTag.cend() ) return true;
+
+   return false;
+}
+
+/**
+ * @brief Split section code into one or more sections
+ * Sections are views into the buffer for this section, no text is copied.
+ * Buffer that isn't reference counted is copied once to a shared buffer.
+ * Positions are found with character index so each split is near O(1), if
+ * section itself is a view characters are walked from last position.
+ * @param vectorPosition positions where string is split into subsections and added as sections 
+*/
+void CSection::Split( std::vector<std::size_t> vectorPosition, bool bKeep )
+{
+   EDIT_End();
+   gd::utf8::string& stringShared = IsView() == true ? m_stringShared : m_stringCode;// buffer shared with new sections
+   if( stringShared.is_refcount() == false && stringShared.is_inline() == false )
+   {
+      // ## unique text is copied once to reference counted buffer, otherwise each section gets its own copy
+      gd::utf8::string stringCopy( stringShared.get_allocator() );
+      stringCopy.assign( stringShared.c_buffer(), static_cast<std::size_t>( stringShared.size() ) );
+      stringShared = std::move( stringCopy );
+   }
+   uint32_t uBase = IsView() == true ? m_uOffset : 0;
+   std::string_view stringText = view();
+   const uint8_t* pubBegin = reinterpret_cast<const uint8_t*>( stringText.data() );
+   const uint8_t* pubEnd = pubBegin + stringText.length();
+   const uint8_t* pubFrom = pubBegin;
+   std::size_t uCharacter = 0;                                                 // character where next section starts
+   for( auto itCount = std::begin( vectorPosition ); itCount != std::end( vectorPosition ); itCount++ )
+   {
+      uCharacter += *itCount;
+      const uint8_t* pubTo = pubFrom;
+      if( IsView() == false )
+      {
+         if( uCharacter >= m_stringCode.count() ) break;
+         pubTo = m_stringCode.position( uCharacter ).get();
+      }
+      else
+      {
+         for( std::size_t u = 0; u < *itCount && pubTo < pubEnd; u++ ) pubTo = gd::utf8::move::next( pubTo );
+         if( pubTo >= pubEnd ) break;
+      }
+
+      m_vectorSection.push_back( CSection( m_pFile, m_stringTag, stringShared, uBase + static_cast<uint32_t>( pubFrom - pubBegin ), static_cast<uint32_t>( pubTo - pubFrom ) ) );
+      pubFrom = pubTo;
+   }
+
+   if( pubFrom < pubEnd ) m_vectorSection.push_back( CSection( m_pFile, m_stringTag, stringShared, uBase + static_cast<uint32_t>( pubFrom - pubBegin ), static_cast<uint32_t>( pubEnd - pubFrom ) ) );
+
+   if( bKeep == false ) SetCode( gd::utf8::string() );
+}
+
+/**
+ * @brief Copy text from shared buffer to section code and end view
+*/
+void CSection::Detach()
+{
+   if( IsView() == false ) return;
+
+   gd::utf8::string stringCode( m_pallocator != nullptr ? m_pallocator.get() : m_stringShared.get_allocator() );
+   stringCode.assign( reinterpret_cast<const uint8_t*>( m_stringShared.c_str() ) + m_uOffset, static_cast<std::size_t>( m_uLength ) );
+   SetCode( std::move( stringCode ) );
+}
+
+/**
+ * @brief Start edit, views are not copied, piece table points into shared buffer
+*/
+void CSection::EDIT_Begin()
+{
+   if( m_ppiecetable != nullptr ) return;
+
+   EDIT_End();                                                                 // erased spans are removed first
+   if( IsView() == true ) m_ppiecetable = std::make_unique<CPieceTable>( m_stringShared, m_uOffset, m_uLength );
+   else m_ppiecetable = std::make_unique<CPieceTable>( m_stringCode );
+}
+
+/**
+ * @brief Rebuild code from piece table or remove spans in erase list, and end edit
+ * Piece table and erase list are not active at the same time, piece table is
+ * started after erased spans are removed and erase rules end piece table edit.
+*/
+void CSection::EDIT_End()
+{
+   if( m_ppiecetable != nullptr )
+   {
+      SetCode( m_ppiecetable->Text( m_pallocator != nullptr ? m_pallocator.get() : m_ppiecetable->original().get_allocator() ) );
+   }
+   else if( m_eraselist.empty() == false )
+   {
+      gd::utf8::string stringResult( m_pallocator != nullptr ? m_pallocator.get() : m_stringCode.get_allocator() );
+      m_eraselist.Apply( view(), stringResult );
+      SetCode( std::move( stringResult ) );
+   }
+}
+
+/// allocator from file, section keeps it so text allocated from it is valid if section outlives file
+std::shared_ptr<gd::utf8::allocator> CSection::allocator_s( const CFile* pFile )
+{
+   return pFile != nullptr ? pFile->m_pallocator : nullptr;
+}
+
+/**
+ * @brief Join sections into one utf8 string and return
+ * @param stringTag tags if
+ * @return 
+*/
+gd::utf8::string CSection::Join( std::string_view stringGroup )
+{
+   gd::utf8::string stringResult( m_pallocator.get() );
+   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
+   {
+      if( stringGroup.empty() == false || it->HasGroup( stringGroup ) )
+      {
+         it->EDIT_End();
+         auto stringCode = it->view();
+         stringResult.append( reinterpret_cast<const uint8_t*>( stringCode.data() ), static_cast<uint32_t>( stringCode.length() ) );
+      }
+   }
+
+   return stringResult;
+}
+
+
+/**
+ * ## CFile ===================================================================
+ */
+
+#ifdef BOOST_RE_REGEX_HPP
+std::pair<bool, std::string> CFile::SECTION_Replace( const boost::regex& regexMatch, std::string_view stringInsert, std::string_view stringGroup, uint32_t uFlags )
+{
+   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
+   {
+      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
+
+      auto [bOk, stringError] = it->Replace( regexMatch, stringInsert, uFlags );
+      if( bOk == false ) return { bOk, stringError };
+   }
+
+   return { true, std::string() };
+}
+
+
+
+std::pair<bool, std::string> CFile::SECTION_Erase( const boost::regex& regexMatch, std::string_view stringGroup, uint32_t uFlags )
+{
+   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
+   {
+      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
+
+      auto [bOk, stringError] = it->Erase( regexMatch, uFlags );
+      if( bOk == false ) return { bOk, stringError };
+   }
+
+   return { true, std::string() };
+}
+
+/**
+ * @brief Replace matches for pattern in sections, pattern is compiled once for all files using it
+ * @param stringPattern regular expression pattern (boost syntax)
+ * @param stringInsert text inserted for each match
+ * @param stringGroup if set then only sections with group are changed
+ * @param uFlags for regular expression searches, how to search
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFile::SECTION_Replace( std::string_view stringPattern, std::string_view stringInsert, std::string_view stringGroup, uint32_t uFlags )
+{
+   std::shared_ptr<const boost::regex> pregexMatch;
+   try { pregexMatch = gd::regex::cache_g().get<boost::regex>( stringPattern ); }
+   catch( const std::exception& e ) { return { false, std::format( "invalid pattern \"{}\": {}", stringPattern, e.what() ) }; }
+
+   return SECTION_Replace( *pregexMatch, stringInsert, stringGroup, uFlags );
+}
+
+/**
+ * @brief Erase matches for pattern in sections, pattern is compiled once for all files using it
+ * @param stringPattern regular expression pattern (boost syntax)
+ * @param stringGroup if set then only sections with group are changed
+ * @param uFlags for regular expression searches, how to search
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFile::SECTION_Erase( std::string_view stringPattern, std::string_view stringGroup, uint32_t uFlags )
+{
+   std::shared_ptr<const boost::regex> pregexMatch;
+   try { pregexMatch = gd::regex::cache_g().get<boost::regex>( stringPattern ); }
+   catch( const std::exception& e ) { return { false, std::format( "invalid pattern \"{}\": {}", stringPattern, e.what() ) }; }
+
+   return SECTION_Erase( *pregexMatch, stringGroup, uFlags );
+}
+#endif
+
+std::pair<bool, std::string> CFile::SECTION_Replace( const std::regex& regexMatch, std::string_view stringInsert, std::string_view stringGroup, uint32_t uFlags )
+{
+   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
+   {
+      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
+
+      auto [bOk, stringError] = it->Replace( regexMatch, stringInsert, uFlags );
+      if( bOk == false ) return { bOk, stringError };
+   }
+
+   return { true, std::string() };
+}
+
+
+std::pair<bool, std::string> CFile::SECTION_Erase( const std::regex& regexMatch, std::string_view stringGroup, uint32_t uFlags )
+{
+   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
+   {
+      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
+
+      auto [bOk, stringError] = it->Erase( regexMatch, uFlags );
+      if( bOk == false ) return { bOk, stringError };
+   }
+
+   return { true, std::string() };
+}
+
+std::pair<bool, std::string> CFile::SECTION_Replace( const CAutomaton& automatonMatch, std::string_view stringInsert, std::string_view stringGroup, uint32_t uFlags )
+{
+   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
+   {
+      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
+
+      auto [bOk, stringError] = it->Replace( automatonMatch, stringInsert, uFlags );
+      if( bOk == false ) return { bOk, stringError };
+   }
+
+   return { true, std::string() };
+}
+
+/**
+ * @brief Replace keywords in sections, each section is scanned once for all keywords
+ * @param keywordtable keywords and replacement text
+ * @param stringGroup sections in group, all sections if empty
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFile::SECTION_Replace( const CKeywordTable& keywordtable, std::string_view stringGroup )
+{
+   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
+   {
+      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
+
+      auto [bOk, stringError] = it->Replace( keywordtable );
+      if( bOk == false ) return { bOk, stringError };
+   }
+
+   return { true, std::string() };
+}
+
+/**
+ * @brief Replace keywords in tokens of selected kinds in sections
+ * @param lexerSql lexer used to split code into tokens
+ * @param uKind token kinds where keywords are replaced (see: `CSqlLexer::enumToken`)
+ * @param keywordtable keywords and replacement text
+ * @param stringGroup sections in group, all sections if empty
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFile::SECTION_Replace( const CSqlLexer& lexerSql, uint32_t uKind, const CKeywordTable& keywordtable, std::string_view stringGroup )
+{
+   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
+   {
+      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
+
+      auto [bOk, stringError] = it->Replace( lexerSql, uKind, keywordtable );
+      if( bOk == false ) return { bOk, stringError };
+   }
+
+   return { true, std::string() };
+}
+
+std::pair<bool, std::string> CFile::SECTION_Erase( const CAutomaton& automatonMatch, std::string_view stringGroup, uint32_t uFlags )
+{
+   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
+   {
+      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
+
+      auto [bOk, stringError] = it->Erase( automatonMatch, uFlags );
+      if( bOk == false ) return { bOk, stringError };
+   }
+
+   return { true, std::string() };
+}
+
+/**
+ * @brief Erase tokens of selected kinds in sections, each section is split into tokens once
+ * @param lexerSql lexer used to split code into tokens
+ * @param uKind token kinds to erase (see: `CSqlLexer::enumToken`)
+ * @param stringGroup sections in group, all sections if empty
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFile::SECTION_Erase( const CSqlLexer& lexerSql, uint32_t uKind, std::string_view stringGroup )
+{
+   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
+   {
+      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
+
+      auto [bOk, stringError] = it->Erase( lexerSql, uKind );
+      if( bOk == false ) return { bOk, stringError };
+   }
+
+   return { true, std::string() };
+}
+
+/**
+ * @brief Apply rule program to sections
+ * @param programApply rules applied to each section
+ * @param stringGroup if set then only sections with group are changed
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFile::SECTION_Apply( const CRuleProgram& programApply, std::string_view stringGroup )
+{
+   for( auto it = std::begin( m_vectorSection ); it != std::end( m_vectorSection ); it++ )
+   {
+      if( stringGroup.length() && it->HasGroup( stringGroup ) == false ) continue;
+
+      auto [bOk, stringError] = it->Apply( programApply );
+      if( bOk == false ) return { bOk, stringError };
+   }
+
+   return { true, std::string() };
+}
+
+/**
+ * @brief Set name for file from the full path
+ * Tries to extract file name from full path and set it as the name
+*/
+void CFile::SetNameFromPath()
+{
+   auto iPosition = m_stringPath.rfind( '\\' );
+   if( iPosition == std::string::npos ) iPosition = m_stringPath.rfind( '/' );
+
+   if( iPosition == std::string::npos ) m_stringName = m_stringPath;
+   else
+   {
+      m_stringName = m_stringPath.substr( iPosition + 1 );
+      iPosition = m_stringName.rfind( '.' );
+      if( iPosition != std::string::npos ) m_stringName = m_stringName.substr( 0, iPosition );
+   }
+}
+
+
+/**
+ * @brief Load file into section
+ * @param stringFileName file to load
+ * @param stringName tag for section getting file data
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFile::FILE_Load( std::string stringFileName, std::string_view stringName )
+{
+   CFileMap filemapText;
+   auto result_ = filemapText.Open( stringFileName );
+   if( result_.first == false ) return result_;
+
+   gd::utf8::string stringCode( allocator() );
+   result_ = filemapText.Text( stringCode );                                   // text without BOM, UTF-16 is converted to UTF-8
+   if( result_.first == false ) return result_;
+
+   SECTION_Append( gd::utf8::string( stringName ), stringCode );
+
+   return { true, std::string() };
+}
+
+
+/**
+ * ## CFileStream =============================================================
+ */
+
+/**
+ * @brief Convert text from stream and write result to stream
+ * Text is read in window sized blocks and each block is pushed through all rules.
+ * UTF-8 BOM is skipped and not written to result (same as when file is loaded).
+ * @param istreamFrom stream text is read from
+ * @param ostreamTo stream converted text is written to
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFileStream::Convert( std::istream& istreamFrom, std::ostream& ostreamTo )
+{                                                                              assert( m_uWindow > 0 ); assert( m_uOverlap > 0 );
+   m_vectorStage.assign( m_vectorRule.size(), stage() );
+
+   std::vector<char> vectorBuffer( m_uWindow );
+   bool bFirst = true;
+   while( istreamFrom.good() == true )
+   {
+      istreamFrom.read( vectorBuffer.data(), static_cast<std::streamsize>( vectorBuffer.size() ) );
+      std::size_t uRead = static_cast<std::size_t>( istreamFrom.gcount() );
+      const char* pbszRead = vectorBuffer.data();
+      if( bFirst == true && uRead >= 3 && (uint8_t)pbszRead[0] == 0xEF && (uint8_t)pbszRead[1] == 0xBB && (uint8_t)pbszRead[2] == 0xBF )
+      {
+         pbszRead += 3;
+         uRead -= 3;
+      }
+      bFirst = false;
+
+      if( uRead > 0 ) Process( 0, pbszRead, uRead, false, ostreamTo );
+   }
+
+   if( istreamFrom.bad() == true ) return { false, "failed to read from stream [CFileStream::Convert]" };
+
+   Process( 0, nullptr, 0, true, ostreamTo );                                  // flush text kept in rules
+   m_vectorStage.clear();
+
+   if( ostreamTo.good() == false ) return { false, "failed to write to stream [CFileStream::Convert]" };
+
+   return { true, std::string() };
+}
+
+/**
+ * @brief Convert file and write result to another file
+ * @param stringFileFrom file that is converted
+ * @param stringFileTo file converted text is written to
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFileStream::Convert( std::string_view stringFileFrom, std::string_view stringFileTo )
+{
+   std::ifstream ifstreamFrom( std::string( stringFileFrom ), std::ifstream::binary );
+   if( ifstreamFrom.is_open() == false ) return { false, std::format( "failed to open {} [CFileStream::Convert]", stringFileFrom ) };
+
+   std::ofstream ofstreamTo( std::string( stringFileTo ), std::ofstream::binary );
+   if( ofstreamTo.is_open() == false ) return { false, std::format( "failed to open {} [CFileStream::Convert]", stringFileTo ) };
+
+   return Convert( ifstreamFrom, ofstreamTo );
+}
+
+/**
+ * @brief Push text through rule, result is pushed to next rule or written to stream if last rule
+ * Text is collected until there is at least window + overlap bytes. Matches 
+ * that starts in the last overlap bytes are left to next window.
+ * @param uRule index to rule text is pushed to
+ * @param pbszText text added to rule
+ * @param uLength text length
+ * @param bEnd true if end of text, all text in rule is processed
+ * @param ostreamTo stream converted text is written to
+*/
+void CFileStream::Process( std::size_t uRule, const char* pbszText, std::size_t uLength, bool bEnd, std::ostream& ostreamTo )
+{
+   if( uRule == m_vectorRule.size() )                                          // passed all rules ?
+   {
+      if( uLength > 0 ) ostreamTo.write( pbszText, static_cast<std::streamsize>( uLength ) );
+      return;
+   }
+
+   const CRule& ruleActive = m_vectorRule[uRule];
+   stage& stageActive = m_vectorStage[uRule];
+   std::string& stringPending = stageActive.m_stringPending;
+   if( uLength > 0 ) stringPending.append( pbszText, uLength );
+
+   std::size_t uBegin = stageActive.m_bContext == true ? 1 : 0;               // skip context character
+   std::size_t uEnd = stringPending.size();
+   if( bEnd == false && uEnd - uBegin < m_uWindow + m_uOverlap ) return;       // wait for more text
+
+   // ## Find matches that start before safe position, text after safe position is kept for next window
+   std::size_t uSafe = bEnd == true ? uEnd : uEnd - m_uOverlap;
+   const char* pbszBuffer = stringPending.data();
+   std::string stringResult;
+   stringResult.reserve( uEnd - uBegin );
+
+   std::size_t uPosition = uBegin;
+   bool bPrevAvail = stageActive.m_bRestart == false;                         // continue search from previous window
+   while( true )
+   {
+      auto [pbszMatch, pbszMatchEnd] = ruleActive.Find( pbszBuffer + uPosition, pbszBuffer + uEnd, bPrevAvail, bEnd );
+      if( pbszMatch == nullptr ) break;
+
+      std::size_t uMatch = pbszMatch - pbszBuffer;
+      if( bEnd == false && uMatch >= uSafe ) break;                            // match is handled in next window
+
+      stringResult.append( pbszBuffer + uPosition, uMatch - uPosition );
+      if( ruleActive.IsReplace() == true ) stringResult.append( ruleActive.Insert( pbszMatch, pbszMatchEnd ) );
+
+      std::size_t uMatchEnd = pbszMatchEnd - pbszBuffer;
+      bPrevAvail = false;                                                      // search restarts at end of match, same as for text in memory
+      if( uMatchEnd == uMatch )                                                // empty match, step one character to avoid endless loop
+      {
+         if( uMatchEnd == uEnd ) { uPosition = uEnd; break; }
+         std::size_t uNext = next_character_s( pbszBuffer + uMatchEnd, pbszBuffer + uEnd ) - pbszBuffer;
+         stringResult.append( pbszBuffer + uMatchEnd, uNext - uMatchEnd );
+         uMatchEnd = uNext;
+         bPrevAvail = true;
+      }
+      uPosition = uMatchEnd;
+   }
+
+   std::size_t uKeep = bEnd == true ? uEnd : ( uPosition > uSafe ? uPosition : uSafe );// text from this position is kept for next window
+   stringResult.append( pbszBuffer + uPosition, uKeep - uPosition );
+   if( uKeep != uPosition ) bPrevAvail = true;
+
+   if( bEnd == true )
+   {
+      stringPending.clear();
+      stageActive.m_bContext = false;
+      stageActive.m_bRestart = true;
+   }
+   else
+   {                                                                          assert( uKeep > 0 );
+      stringPending.erase( 0, uKeep - 1 );                                     // keep one character as context for next search
+      stageActive.m_bContext = true;
+      stageActive.m_bRestart = bPrevAvail == false;
+   }
+
+   Process( uRule + 1, stringResult.data(), stringResult.size(), bEnd, ostreamTo );
+}
+
+
+/**
+ * ## CFileMap ================================================================
+ */
+
+/**
+ * @brief Open file for reading, file is mapped into memory if possible
+ * Regular files are mapped, if that fails or file is some special file (pipe 
+ * for example) it is read into internal buffer.
+ * @param stringFile file to open
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFileMap::Open( std::string_view stringFile )
+{
+   Close();
+
+   std::string stringPath( stringFile );
+   bool bRegular = false;                                                      // regular file, only regular files are mapped
+   std::pair<bool, std::string> result_( true, std::string() );
+
+#ifdef _WIN32
+   HANDLE hFile = ::CreateFileA( stringPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+   if( hFile == INVALID_HANDLE_VALUE ) return { false, std::format( "failed to open {} [CFileMap::Open]", stringFile ) };
+
+   LARGE_INTEGER largeintegerSize;
+   if( ::GetFileType( hFile ) == FILE_TYPE_DISK && ::GetFileSizeEx( hFile, &largeintegerSize ) != FALSE )
+   {
+      bRegular = true;
+      m_uSize = static_cast<std::size_t>( largeintegerSize.QuadPart );
+      if( m_uSize > 0 )
+      {
+         m_hMap = ::CreateFileMappingA( hFile, nullptr, PAGE_READONLY, 0, 0, nullptr );
+         if( m_hMap != nullptr )
+         {
+            m_pMap = ::MapViewOfFile( static_cast<HANDLE>( m_hMap ), FILE_MAP_READ, 0, 0, 0 );
+            if( m_pMap == nullptr ) { ::CloseHandle( static_cast<HANDLE>( m_hMap ) ); m_hMap = nullptr; }
+         }
+      }
+   }
+
+   if( m_pMap == nullptr && ( bRegular == false || m_uSize > 0 ) ) result_ = Read( reinterpret_cast<intptr_t>( hFile ), stringFile );
+
+   ::CloseHandle( hFile );                                                     // mapping object holds its own reference to file
+#else
+   int iFile = ::open( stringPath.c_str(), O_RDONLY );
+   if( iFile == -1 ) return { false, std::format( "failed to open {} [CFileMap::Open]", stringFile ) };
+
+   struct stat statFile;
+   if( ::fstat( iFile, &statFile ) == 0 && S_ISREG( statFile.st_mode ) )
+   {
+      bRegular = true;
+      m_uSize = static_cast<std::size_t>( statFile.st_size );
+      if( m_uSize > 0 )
+      {
+         void* pMap = ::mmap( nullptr, m_uSize, PROT_READ, MAP_PRIVATE, iFile, 0 );
+         if( pMap != MAP_FAILED )
+         {
+            m_pMap = pMap;
+            ::madvise( pMap, m_uSize, MADV_SEQUENTIAL );                      // file is read from start to end
+         }
+      }
+   }
+
+   if( m_pMap == nullptr && ( bRegular == false || m_uSize > 0 ) ) result_ = Read( iFile, stringFile );
+
+   ::close( iFile );                                                           // mapping is valid after file is closed
+#endif
+
+   if( result_.first == false ) { Close(); return result_; }
+
+   if( m_pMap != nullptr ) m_pubData = static_cast<const uint8_t*>( m_pMap );
+   m_bOpen = true;
+   DetectBOM();
+
+   return result_;
+}
+
+/**
+ * @brief Release mapped view or buffer holding file data
+*/
+void CFileMap::Close()
+{
+   if( m_pMap != nullptr )
+   {
+#ifdef _WIN32
+      ::UnmapViewOfFile( m_pMap );
+      ::CloseHandle( static_cast<HANDLE>( m_hMap ) );
+      m_hMap = nullptr;
+#else
+      ::munmap( m_pMap, m_uSize );
+#endif
+      m_pMap = nullptr;
+   }
+
+   m_vectorBuffer.clear();
+   m_vectorBuffer.shrink_to_fit();
+   m_pubData = nullptr;
+   m_uSize = 0;
+   m_uBOM = eBOMNone;
+   m_bOpen = false;
+}
+
+/**
+ * @brief Read file into internal buffer, used when file can't be mapped
+ * @param iFileHandle handle to open file
+ * @param stringFile file name used in error message
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFileMap::Read( intptr_t iFileHandle, std::string_view stringFile )
+{
+   constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+
+   m_vectorBuffer.resize( m_uSize > 0 ? m_uSize + 1 : BUFFER_SIZE );            // one extra byte to detect end of file without growing buffer
+   std::size_t uRead = 0;                                                      // number of bytes read into buffer
+   while( true )
+   {
+      if( uRead == m_vectorBuffer.size() ) m_vectorBuffer.resize( m_vectorBuffer.size() * 2 );
+
+      std::size_t uAvailable = m_vectorBuffer.size() - uRead;
+#ifdef _WIN32
+      DWORD dwCount = 0;
+      if( ::ReadFile( reinterpret_cast<HANDLE>( iFileHandle ), m_vectorBuffer.data() + uRead, static_cast<DWORD>( uAvailable < 0x40000000 ? uAvailable : 0x40000000 ), &dwCount, nullptr ) == FALSE )
+      {
+         if( ::GetLastError() == ERROR_BROKEN_PIPE ) break;                    // write end of pipe is closed
+         return { false, std::format( "failed to read {} [CFileMap::Read]", stringFile ) };
+      }
+      int64_t iCount = dwCount;
+#else
+      int64_t iCount = ::read( static_cast<int>( iFileHandle ), m_vectorBuffer.data() + uRead, uAvailable );
+      if( iCount < 0 ) return { false, std::format( "failed to read {} [CFileMap::Read]", stringFile ) };
+#endif
+      if( iCount == 0 ) break;
+      uRead += static_cast<std::size_t>( iCount );
+   }
+
+   m_vectorBuffer.resize( uRead );
+   m_uSize = uRead;
+   m_pubData = m_vectorBuffer.data();
+
+   return { true, std::string() };
+}
+
+/**
+ * @brief Copy file text without BOM to string
+ * Files with UTF-16 BOM are converted to UTF-8, other files are copied as is.
+ * @param stringText string getting file text, allocator in string is used
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFileMap::Text( gd::utf8::string& stringText ) const
+{
+   auto stringFileText = text();
+   if( m_uBOM != eBOMUtf16LE && m_uBOM != eBOMUtf16BE )
+   {
+      if( stringFileText.empty() == false ) stringText.assign( reinterpret_cast<const uint8_t*>( stringFileText.data() ), stringFileText.length() );
+      return { true, std::string() };
+   }
+
+   if( stringFileText.length() % 2 != 0 ) return { false, "UTF-16 text with odd number of bytes [CFileMap::Text]" };
+
+   // ## read units in file byte order, data in file may not be aligned for char16_t
+   std::vector<char16_t> vectorUnit( stringFileText.length() / 2 );
+   const uint8_t* pubUnit = reinterpret_cast<const uint8_t*>( stringFileText.data() );
+   unsigned uHigh = m_uBOM == eBOMUtf16LE ? 1 : 0;                             // index to most significant byte in unit
+   for( auto& it : vectorUnit ) { it = static_cast<char16_t>( ( pubUnit[uHigh] << 8 ) | pubUnit[1 - uHigh] ); pubUnit += 2; }
+
+   stringText.clear();
+   const char16_t* pwszBegin = vectorUnit.data();
+   const char16_t* pwszEnd = pwszBegin + vectorUnit.size();
+   uint32_t uSize = gd::utf8::size( pwszBegin, pwszEnd );
+   if( uSize > 0 )
+   {
+      stringText.allocate( uSize );
+      uint8_t* pubEnd = gd::utf8::convert( pwszBegin, pwszEnd, stringText.c_buffer() ); assert( pubEnd == stringText.c_buffer() + uSize ); (void)pubEnd;
+      stringText.set_size( uSize, gd::utf8::count( stringText.c_buffer(), stringText.c_buffer() + uSize ).first );
+   }
+
+   return { true, std::string() };
+}
+
+/**
+ * @brief Check start of file for BOM (byte order mark)
+*/
+void CFileMap::DetectBOM()
+{
+   m_uBOM = eBOMNone;
+   if( m_uSize >= 3 && m_pubData[0] == 0xEF && m_pubData[1] == 0xBB && m_pubData[2] == 0xBF ) m_uBOM = eBOMUtf8;
+   else if( m_uSize >= 2 && m_pubData[0] == 0xFF && m_pubData[1] == 0xFE ) m_uBOM = eBOMUtf16LE;
+   else if( m_uSize >= 2 && m_pubData[0] == 0xFE && m_pubData[1] == 0xFF ) m_uBOM = eBOMUtf16BE;
+}
+
+/**
+ * @brief Create file, with `eFlagAtomic` text is written to temporary file in same folder
+ * Temporary file gets a unique name (process id and counter) and is created only
+ * if it doesn't exist, other files are never overwritten. If file exists the
+ * temporary file gets permissions (and owner if allowed) from file, so they
+ * are kept when it replaces file.
+ * @param stringFile file to write
+ * @param uFlags flags (see: enumFlag)
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFileWrite::Open( std::string_view stringFile, unsigned uFlags )
+{
+   static std::atomic<uint32_t> uTemporary_s{ 0 };                             // counter for unique temporary names in process
+   constexpr unsigned TEMPORARY_TRY_MAX = 100;                                 // max names tried if temporary files exists
+
+   Abort();
+
+   m_stringFile = stringFile;
+   m_uFlags = uFlags;
+   m_uWritten = 0;
+   m_uPending = 0;
+   m_stringFileTemporary.clear();
+   bool bAtomic = ( uFlags & eFlagAtomic ) != 0;
+
+#ifdef _WIN32
+   HANDLE hFile = INVALID_HANDLE_VALUE;
+   if( bAtomic == true )
+   {
+      for( unsigned uTry = 0; uTry < TEMPORARY_TRY_MAX && hFile == INVALID_HANDLE_VALUE; uTry++ )
+      {
+         m_stringFileTemporary = std::format( "{}.{}.{}.tmp", m_stringFile, ::GetCurrentProcessId(), uTemporary_s++ );// same folder, rename is then atomic
+         hFile = ::CreateFileA( m_stringFileTemporary.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+         if( hFile == INVALID_HANDLE_VALUE && ::GetLastError() != ERROR_FILE_EXISTS ) break;
+      }
+   }
+   else hFile = ::CreateFileA( m_stringFile.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+
+   if( hFile == INVALID_HANDLE_VALUE )
+   {
+      std::string stringOpen = bAtomic == true ? m_stringFileTemporary : m_stringFile;
+      m_stringFileTemporary.clear();
+      return { false, std::format( "failed to create {} [CFileWrite::Open]", stringOpen ) };
+   }
+   m_iFile = reinterpret_cast<intptr_t>( hFile );
+   m_uBatch = BATCH_MAX;
+#else
+   int iFile = -1;
+   if( bAtomic == true )
+   {
+      for( unsigned uTry = 0; uTry < TEMPORARY_TRY_MAX && iFile == -1; uTry++ )
+      {
+         m_stringFileTemporary = std::format( "{}.{}.{}.tmp", m_stringFile, static_cast<long>( ::getpid() ), uTemporary_s++ );// same folder, rename is then atomic
+         iFile = ::open( m_stringFileTemporary.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666 );
+         if( iFile == -1 && errno != EEXIST ) break;
+      }
+
+      struct stat statFile;
+      if( iFile != -1 && ::stat( m_stringFile.c_str(), &statFile ) == 0 )     // keep permissions and owner from file that is replaced
+      {
+         ::fchmod( iFile, statFile.st_mode & 07777 );
+         if( ::fchown( iFile, statFile.st_uid, statFile.st_gid ) != 0 ) {}    // only allowed for some users, group may still change
+      }
+   }
+   else iFile = ::open( m_stringFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+
+   if( iFile == -1 )
+   {
+      std::string stringOpen = bAtomic == true ? m_stringFileTemporary : m_stringFile;
+      m_stringFileTemporary.clear();
+      return { false, std::format( "failed to create {} [CFileWrite::Open]", stringOpen ) };
+   }
+   m_iFile = iFile;
+   m_uBatch = BATCH_MAX;
+#  ifdef IOV_MAX
+   if( m_uBatch > IOV_MAX ) m_uBatch = IOV_MAX;
+#  endif
+#endif
+
+   return { true, std::string() };
+}
+
+/**
+ * @brief Add buffer to write, buffers are written when batch is full
+ * @param pubData pointer to data, need to be valid until flushed
+ * @param uSize number of bytes
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFileWrite::Write( const uint8_t* pubData, std::size_t uSize )
+{                                                                              assert( IsOpen() == true );
+   if( uSize == 0 ) return { true, std::string() };
+
+   m_pbufferPending[m_uPending] = { pubData, uSize };
+   m_uPending++;
+   if( m_uPending == m_uBatch ) return Flush();
+
+   return { true, std::string() };
+}
+
+/**
+ * @brief Write pending buffers to file
+ * Posix writes all pending buffers with `writev`, if not all bytes are
+ * written it continues from where it stopped.
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFileWrite::Flush()
+{                                                                              assert( IsOpen() == true );
+#ifdef _WIN32
+   for( std::size_t u = 0; u < m_uPending; u++ )
+   {
+      const uint8_t* pubData = m_pbufferPending[u].m_pubData;
+      std::size_t uSize = m_pbufferPending[u].m_uSize;
+      while( uSize > 0 )
+      {
+         DWORD dwWrite = static_cast<DWORD>( uSize < 0x40000000 ? uSize : 0x40000000 );
+         DWORD dwCount = 0;
+         if( ::WriteFile( reinterpret_cast<HANDLE>( m_iFile ), pubData, dwWrite, &dwCount, nullptr ) == FALSE ) { m_uPending = 0; return { false, std::format( "failed to write {} [CFileWrite::Flush]", m_stringFile ) }; }
+         pubData += dwCount;
+         uSize -= dwCount;
+         m_uWritten += dwCount;
+      }
+   }
+#else
+   struct iovec piovec[BATCH_MAX];
+   for( std::size_t u = 0; u < m_uPending; u++ )
+   {
+      piovec[u].iov_base = const_cast<uint8_t*>( m_pbufferPending[u].m_pubData );
+      piovec[u].iov_len = m_pbufferPending[u].m_uSize;
+   }
+
+   struct iovec* piovecNext = piovec;                                          // first buffer not fully written
+   std::size_t uCount = m_uPending;
+   while( uCount > 0 )
+   {
+      ssize_t iWritten = ::writev( static_cast<int>( m_iFile ), piovecNext, static_cast<int>( uCount ) );
+      if( iWritten < 0 )
+      {
+         if( errno == EINTR ) continue;
+         m_uPending = 0;
+         return { false, std::format( "failed to write {} [CFileWrite::Flush]", m_stringFile ) };
+      }
+
+      m_uWritten += static_cast<uint64_t>( iWritten );
+      std::size_t uWritten = static_cast<std::size_t>( iWritten );
+      while( uCount > 0 && uWritten >= piovecNext->iov_len )                  // skip written buffers
+      {
+         uWritten -= piovecNext->iov_len;
+         piovecNext++;
+         uCount--;
+      }
+      if( uCount > 0 )                                                         // part of buffer written
+      {
+         piovecNext->iov_base = static_cast<uint8_t*>( piovecNext->iov_base ) + uWritten;
+         piovecNext->iov_len -= uWritten;
+      }
+   }
+#endif
+
+   m_uPending = 0;
+   return { true, std::string() };
+}
+
+/**
+ * @brief Flush pending buffers and close file
+ * If atomic the temporary file is flushed to disk and renamed to file name,
+ * on errors temporary file is removed and the original file is untouched.
+ * @return true if ok, otherwise false and error information
+*/
+std::pair<bool, std::string> CFileWrite::Close()
+{
+   if( IsOpen() == false ) return { true, std::string() };
+
+   auto result_ = Flush();
+   if( result_.first == false ) { Abort(); return result_; }
+
+   bool bAtomic = m_stringFileTemporary.empty() == false;
+#ifdef _WIN32
+   HANDLE hFile = reinterpret_cast<HANDLE>( m_iFile );
+   if( bAtomic == true && ::FlushFileBuffers( hFile ) == FALSE ) { Abort(); return { false, std::format( "failed to flush {} [CFileWrite::Close]", m_stringFile ) }; }
+   ::CloseHandle( hFile );
+   m_iFile = -1;
+   bool bReplaced = bAtomic == true && ::ReplaceFileA( m_stringFile.c_str(), m_stringFileTemporary.c_str(), nullptr, REPLACEFILE_IGNORE_MERGE_ERRORS, nullptr, nullptr ) != FALSE;// keeps attributes and security from file
+   if( bAtomic == true && bReplaced == false && ::MoveFileExA( m_stringFileTemporary.c_str(), m_stringFile.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) == FALSE )
+   {
+      ::DeleteFileA( m_stringFileTemporary.c_str() );
+      return { false, std::format( "failed to replace {} [CFileWrite::Close]", m_stringFile ) };
+   }
+#else
+   int iFile = static_cast<int>( m_iFile );
+   if( bAtomic == true && ::fsync( iFile ) != 0 ) { Abort(); return { false, std::format( "failed to flush {} [CFileWrite::Close]", m_stringFile ) }; }
+   int iClose = ::close( iFile );
+   m_iFile = -1;
+   if( iClose != 0 )
+   {
+      if( bAtomic == true ) ::unlink( m_stringFileTemporary.c_str() );
+      return { false, std::format( "failed to close {} [CFileWrite::Close]", m_stringFile ) };
+   }
+   if( bAtomic == true && ::rename( m_stringFileTemporary.c_str(), m_stringFile.c_str() ) != 0 )
+   {
+      ::unlink( m_stringFileTemporary.c_str() );
+      return { false, std::format( "failed to replace {} [CFileWrite::Close]", m_stringFile ) };
+   }
+#endif
+
+   m_stringFileTemporary.clear();
+   return { true, std::string() };
+}
+
+/**
+ * @brief Close file without flushing pending buffers, temporary file is removed
+*/
+void CFileWrite::Abort()
+{
+   m_uPending = 0;
+   if( IsOpen() == false ) return;
+
+#ifdef _WIN32
+   ::CloseHandle( reinterpret_cast<HANDLE>( m_iFile ) );
+   if( m_stringFileTemporary.empty() == false ) ::DeleteFileA( m_stringFileTemporary.c_str() );
+#else
+   ::close( static_cast<int>( m_iFile ) );
+   if( m_stringFileTemporary.empty() == false ) ::unlink( m_stringFileTemporary.c_str() );
+#endif
+   m_iFile = -1;
+   m_stringFileTemporary.clear();
+}
 
 
 } }
@@ -2,12 +2,21 @@
 #include <vector>
 #include <string_view>
 #include <format>
+#include <functional>
+#include <initializer_list>
+#include <istream>
+#include <memory>
+#include <ostream>
 #include <regex>
 
 #include <boost/regex.hpp>
 
 #include "gd_utf8_string.hpp"
 
+#include "application_automaton.hpp"
+#include "application_keyword.hpp"
+#include "application_lexer.hpp"
+
 namespace application { namespace file {
 
 #  ifdef BOOST_RE_REGEX_HPP
@@ -16,39 +25,343 @@ namespace application { namespace file {
 #  endif
 	extern std::pair<bool, std::string> Replace( gd::utf8::string& stringText, const std::regex& regexMatch, std::string_view stringInsert, uint32_t uFlags );
 	extern std::pair<bool, std::string> Erase( gd::utf8::string& stringText, const std::regex& regexMatch, uint32_t uFlags );
+	extern std::pair<bool, std::string> Replace( gd::utf8::string& stringText, const CAutomaton& automatonMatch, std::string_view stringInsert, uint32_t uFlags );
+	extern std::pair<bool, std::string> Erase( gd::utf8::string& stringText, const CAutomaton& automatonMatch, uint32_t uFlags );
+	extern std::pair<bool, std::string> Replace( gd::utf8::string& stringText, const CKeywordTable& keywordtable );
+	extern std::pair<bool, std::string> Replace( gd::utf8::string& stringText, const CSqlLexer& lexerSql, uint32_t uKind, const CKeywordTable& keywordtable );
+	extern std::pair<bool, std::string> Erase( gd::utf8::string& stringText, const CSqlLexer& lexerSql, uint32_t uKind );
+
+	class CEraseList;
+#  ifdef BOOST_RE_REGEX_HPP
+	extern std::pair<bool, std::string> Erase( std::string_view stringText, const boost::regex& regexMatch, uint32_t uFlags, CEraseList& eraselist );
+#  endif
+	extern std::pair<bool, std::string> Erase( std::string_view stringText, const std::regex& regexMatch, uint32_t uFlags, CEraseList& eraselist );
+	extern std::pair<bool, std::string> Erase( std::string_view stringText, const CAutomaton& automatonMatch, uint32_t uFlags, CEraseList& eraselist );
+	extern std::pair<bool, std::string> Erase( std::string_view stringText, const CSqlLexer& lexerSql, uint32_t uKind, CEraseList& eraselist );
 
 	class CFile;
 
+/**
+ * ## CRule ===================================================================
+ */
+
+	/**
+	 * @brief Erase or replace rule, holds compiled regular expression used to match text
+	 * Rule works on plain byte ranges and can be used both for text in memory and
+	 * for text that is streamed through window buffers (see `CFileStream`).
+	*/
+	class CRule
+	{
+	public:
+		enum enumType { eTypeErase = 1, eTypeReplace = 2 };
+
+		/// find first match in range, `bPrevAvail` is true if character before first is readable (not start of text)
+		using match_type = std::function<std::pair<const char*, const char*>( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd )>;
+		/// text inserted for matched text, used when insert text depends on match (keyword tables)
+		using insert_type = std::function<std::string_view( const char* pbszMatch, const char* pbszMatchEnd )>;
+
+	public:
+		CRule() {}
+#     ifdef BOOST_RE_REGEX_HPP
+		CRule( const boost::regex& regexMatch, uint32_t uFlags );
+		CRule( const boost::regex& regexMatch, std::string_view stringInsert, uint32_t uFlags );
+		CRule( const boost::regex& regexMatch ): CRule( regexMatch, boost::regex_constants::match_default ) {}
+		CRule( const boost::regex& regexMatch, std::string_view stringInsert ): CRule( regexMatch, stringInsert, boost::regex_constants::match_default ) {}
+#		endif
+		CRule( const std::regex& regexMatch, uint32_t uFlags );
+		CRule( const std::regex& regexMatch, std::string_view stringInsert, uint32_t uFlags );
+		CRule( const std::regex& regexMatch ): CRule( regexMatch, std::regex_constants::match_default ) {}
+		CRule( const std::regex& regexMatch, std::string_view stringInsert ): CRule( regexMatch, stringInsert, std::regex_constants::match_default ) {}
+		CRule( const CAutomaton& automatonMatch, uint32_t uFlags );
+		CRule( const CAutomaton& automatonMatch, std::string_view stringInsert, uint32_t uFlags );
+		CRule( const CAutomaton& automatonMatch ): CRule( automatonMatch, CAutomaton::eMatchDefault ) {}
+		CRule( const CAutomaton& automatonMatch, std::string_view stringInsert ): CRule( automatonMatch, stringInsert, CAutomaton::eMatchDefault ) {}
+		CRule( const CKeywordTable& keywordtable );
+		CRule( unsigned uType, match_type match_, std::string_view stringInsert ): m_uType( uType ), m_match( std::move( match_ ) ), m_stringInsert( stringInsert ) {}
+
+	public:
+		unsigned type() const noexcept { return m_uType; }
+		const std::string& insert() const noexcept { return m_stringInsert; }
+		/// text identifying rule (type, flags, pattern and insert text), empty if pattern is unknown (stl regex or custom match)
+		const std::string& key() const noexcept { return m_stringKey; }
+		bool IsErase() const noexcept { return m_uType == eTypeErase; }
+		bool IsReplace() const noexcept { return m_uType == eTypeReplace; }
+
+		/// find first match in range, returns pair with nullptr if not found
+		std::pair<const char*, const char*> Find( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd ) const { return m_match( pbszFirst, pbszLast, bPrevAvail, bEnd ); }
+		/// text inserted for match if replace rule
+		std::string_view Insert( const char* pbszMatch, const char* pbszMatchEnd ) const { return m_insert ? m_insert( pbszMatch, pbszMatchEnd ) : std::string_view( m_stringInsert ); }
+
+	public:
+		unsigned m_uType = 0;			///< rule type, erase or replace (see: enumType)
+		match_type m_match;				///< method used to find matches
+		std::string m_stringInsert;	///< text inserted for each match if replace rule
+		insert_type m_insert;			///< method returning insert text for match, used instead of `m_stringInsert` if set
+		std::string m_stringKey;		///< text identifying rule, used to detect changed rules (see: `CConvertCache`)
+	};
+
+/**
+ * ## CRuleProgram ============================================================
+ */
+
+	/**
+	 * @brief Ordered list of erase and replace rules applied to text
+	 * Rules are compiled once and applied after each other, one pass over text
+	 * for each rule. First rule reads the text and writes to a buffer, later
+	 * rules use two buffers that are swapped. Text is not squeezed or counted
+	 * for each rule, result is moved to the string and characters are counted
+	 * once at the end.
+	 * Result is the same as if `Erase` and `Replace` were called for each rule.
+	*/
+	class CRuleProgram
+	{
+	public:
+		CRuleProgram() {}
+		CRuleProgram( std::initializer_list<CRule> listRule ): m_vectorRule( listRule ) {}
+		~CRuleProgram() {}
+
+	public:
+		/// Add rule, rules are applied in the order they are added
+		void RULE_Add( CRule ruleAdd ) { m_vectorRule.push_back( std::move( ruleAdd ) ); }
+		const CRule& RULE_At( std::size_t uIndex ) const { return m_vectorRule[ uIndex ]; }
+		auto RULE_Size() const { return m_vectorRule.size(); }
+		auto RULE_Empty() const { return m_vectorRule.empty(); }
+		/// text identifying all rules in order, empty if one rule can't be identified
+		std::string key() const;
+
+		std::pair<bool, std::string> Apply( gd::utf8::string& stringText ) const;
+		std::pair<bool, std::string> Apply( std::string_view stringText, std::string& stringResult ) const;
+
+		static void Apply( const CRule& ruleApply, std::string_view stringText, std::string& stringResult );
+
+	public:
+		std::vector<CRule> m_vectorRule;	///< rules applied to text
+	};
+
+/**
+ * ## CEraseList ==============================================================
+ */
+
+	/**
+	 * @brief Sorted list with erased byte spans in text, text is not changed until list is applied
+	 * Erase rules add spans for matches and later rules search text as if erased
+	 * spans were removed, result is the same as erasing with each rule in turn.
+	 * Text is compacted once with `Apply` or written part by part with `for_each`.
+	 *
+~~~{.cpp}
+CEraseList eraselist;
+Erase( stringSql, std::regex( "--[^\\n]*" ), std::regex_constants::match_default, eraselist );
+Erase( stringSql, std::regex( "\\s+$" ), std::regex_constants::match_default, eraselist );
+eraselist.Apply( stringSql );
+~~~
+	*/
+	class CEraseList
+	{
+	public:
+		/// erased part of text, begin and end offset
+		using span = std::pair<uint64_t, uint64_t>;
+
+	public:
+		CEraseList() {}
+		~CEraseList() {}
+
+	public:
+		/// Add erased bytes starting at byte offset, overlapping and adjacent spans are merged
+		void Add( uint64_t uOffset, uint64_t uLength );
+		/// Add spans sorted by offset, spans are merged with list in one pass
+		void Add( const std::vector<span>& vectorSpan );
+		/// Find matches in text without erased spans and add them, search restarts at the end of each match
+		void Find( std::string_view stringText, const CRule::match_type& match_ );
+
+		/// Remove erased spans from text in one pass and clear list
+		void Apply( gd::utf8::string& stringText );
+		/// Copy text without erased spans to result and clear list
+		void Apply( std::string_view stringText, gd::utf8::string& stringResult );
+		/// Call callback with each part of text that isn't erased
+		template<typename CALLBACK>
+		void for_each( std::string_view stringText, CALLBACK&& callback_ ) const;
+
+		bool empty() const noexcept { return m_vectorSpan.empty(); }
+		void clear() { m_vectorSpan.clear(); m_uErased = 0; }
+		/// number of erased bytes
+		uint64_t erased() const noexcept { return m_uErased; }
+		std::size_t span_count() const noexcept { return m_vectorSpan.size(); }
+		const span& span_at( std::size_t uIndex ) const { return m_vectorSpan[uIndex]; }
+
+	public:
+		std::vector<span> m_vectorSpan;	///< erased spans sorted by offset, spans do not overlap or touch
+		uint64_t m_uErased = 0;				///< number of erased bytes in spans
+	};
+
+	template<typename CALLBACK>
+	void CEraseList::for_each( std::string_view stringText, CALLBACK&& callback_ ) const
+	{
+		uint64_t uPosition = 0;
+		for( const auto& it : m_vectorSpan )
+		{
+			if( it.first > uPosition ) callback_( reinterpret_cast<const uint8_t*>( stringText.data() + uPosition ), static_cast<std::size_t>( it.first - uPosition ) );
+			uPosition = it.second;
+		}
+		if( stringText.length() > uPosition ) callback_( reinterpret_cast<const uint8_t*>( stringText.data() + uPosition ), static_cast<std::size_t>( stringText.length() - uPosition ) );
+	}
+
+/**
+ * ## CPieceTable =============================================================
+ */
+
+	/**
+	 * @brief Edit text without moving it, text is a sequence of pieces pointing into original text or added text
+	 * Original text is shared (not copied) and inserted text is appended to one
+	 * add buffer. Pieces are kept in a balanced tree (treap) where each node
+	 * knows the size of its subtree, insert and erase at byte offset cost
+	 * O(log n) where n is the number of pieces. Text is only rebuilt with
+	 * `Text`, pieces can also be written as they are with `for_each`.
+	 *
+~~~{.cpp}
+CPieceTable piecetableSql( stringSql );
+piecetableSql.Erase( 0, 6 );
+piecetableSql.Insert( 0, "-- header\n" );
+auto stringResult = piecetableSql.Text();
+~~~
+	*/
+	class CPieceTable
+	{
+	public:
+		enum enumBuffer { eBufferOriginal = 0, eBufferAdd = 1 };
+
+		/// part of text, points into original or add buffer
+		struct piece
+		{
+			uint32_t m_uBuffer;				///< buffer piece points into (see: enumBuffer)
+			uint32_t m_uOffset;				///< offset in buffer
+			uint32_t m_uLength;				///< bytes in piece
+		};
+
+		/// tree node, index 0 is not used and marks a missing child
+		struct node
+		{
+			piece m_piece;
+			uint64_t m_uSize;					///< bytes in subtree
+			uint32_t m_uPriority;			///< random priority, parent has higher priority than children
+			uint32_t m_uLeft;					///< left child (text before)
+			uint32_t m_uRight;				///< right child (text after)
+		};
+
+	public:
+		CPieceTable() { m_vectorNode.push_back( node() ); }
+		explicit CPieceTable( const gd::utf8::string& stringOriginal ): CPieceTable( stringOriginal, 0, static_cast<uint32_t>( stringOriginal.size() ) ) {}
+		/// table for part of original text, `uOffset` and `uLength` select bytes in original
+		CPieceTable( const gd::utf8::string& stringOriginal, uint32_t uOffset, uint32_t uLength );
+		~CPieceTable() {}
+
+	public:
+		/// bytes in text
+		uint64_t size() const noexcept { return m_uRoot == 0 ? 0 : m_vectorNode[m_uRoot].m_uSize; }
+		bool empty() const noexcept { return size() == 0; }
+		/// number of pieces text is split into
+		std::size_t piece_count() const noexcept { return m_vectorNode.size() - 1 - m_vectorFree.size(); }
+		const gd::utf8::string& original() const noexcept { return m_stringOriginal; }
+
+		/// Insert text at byte offset
+		void Insert( uint64_t uOffset, std::string_view stringInsert );
+		/// Erase bytes starting at byte offset
+		void Erase( uint64_t uOffset, uint64_t uLength );
+		/// Replace bytes starting at byte offset with text
+		void Replace( uint64_t uOffset, uint64_t uLength, std::string_view stringInsert ) { Erase( uOffset, uLength ); Insert( uOffset, stringInsert ); }
+
+		/// Build text from pieces, allocator for original text is used if not set
+		gd::utf8::string Text() const { return Text( m_stringOriginal.get_allocator() ); }
+		gd::utf8::string Text( gd::utf8::allocator* pallocator ) const;
+		/// Call method for each piece in text order with pointer to text and size
+		void for_each( const std::function<void( const uint8_t* pubText, std::size_t uSize )>& callback_ ) const;
+
+	private:
+		const uint8_t* data( const piece& pieceText ) const { return ( pieceText.m_uBuffer == eBufferOriginal ? m_stringOriginal.c_buffer() : reinterpret_cast<const uint8_t*>( m_stringAdd.data() ) ) + pieceText.m_uOffset; }
+		uint32_t new_node( const piece& pieceText, uint32_t uPriority );
+		void free_node( uint32_t uNode );
+		void update( uint32_t uNode ) { auto& n_ = m_vectorNode[uNode]; n_.m_uSize = n_.m_piece.m_uLength + m_vectorNode[n_.m_uLeft].m_uSize + m_vectorNode[n_.m_uRight].m_uSize; }
+		std::pair<uint32_t, uint32_t> split( uint32_t uNode, uint64_t uOffset );
+		uint32_t merge( uint32_t uLeft, uint32_t uRight );
+		uint32_t random() { m_uSeed ^= m_uSeed << 13; m_uSeed ^= m_uSeed >> 17; m_uSeed ^= m_uSeed << 5; return m_uSeed; }
+
+	public:
+		gd::utf8::string m_stringOriginal;	///< text table was created from, shared with section
+		std::string m_stringAdd;				///< inserted text, only appended to
+		std::vector<node> m_vectorNode;		///< tree nodes, first node is empty (size 0)
+		std::vector<uint32_t> m_vectorFree;	///< nodes that can be reused
+		uint32_t m_uRoot = 0;					///< root node
+		uint32_t m_uSeed = 0x9e3779b9;		///< seed for node priority
+	};
+
 /**
  * ## CFile ===================================================================
  */
 
+	/**
+	 * @brief Section in file, holds code or is a view (offset and length) into a shared buffer
+	 * Sections created by `Split` are views into the buffer of the section that
+	 * was split, no text is copied. A view gets its own code when it is edited
+	 * (see: `Detach`). Use `view()` to read code without copying it.
+	*/
 	class CSection
 	{
 	public:
 		CSection() {}
-		CSection( CFile* pFile, gd::utf8::string& stringTag, gd::utf8::string& stringCode ): m_pFile(pFile), m_stringTag(stringTag), m_stringCode(stringCode) {}
-		CSection( CFile* pFile, gd::utf8::string&& stringTag, gd::utf8::string&& stringCode ): m_pFile(pFile), m_stringTag(stringTag), m_stringCode(stringCode) {}
-		CSection( const CSection& o ): m_pFile( o.m_pFile ), m_stringTag( o.m_stringTag ), m_stringCode( o.m_stringCode ) { };
-		CSection( CSection&& o ) noexcept : m_pFile( o.m_pFile ), m_stringTag( std::move( o.m_stringTag ) ), m_stringCode( std::move( o.m_stringCode ) ) { 
+		CSection( CFile* pFile, gd::utf8::string& stringTag, gd::utf8::string& stringCode ): m_pFile(pFile), m_pallocator( allocator_s( pFile ) ), m_stringTag(stringTag), m_stringCode(stringCode) {}
+		CSection( CFile* pFile, gd::utf8::string&& stringTag, gd::utf8::string&& stringCode ): m_pFile(pFile), m_pallocator( allocator_s( pFile ) ), m_stringTag(stringTag), m_stringCode(stringCode) {}
+		/// view into shared buffer, buffer is kept as long as section exists. Buffer should be reference counted, unique text is copied for each view
+		CSection( CFile* pFile, const gd::utf8::string& stringTag, const gd::utf8::string& stringShared, uint32_t uOffset, uint32_t uLength ): m_pFile(pFile), m_pallocator( allocator_s( pFile ) ), m_stringTag(stringTag), m_stringShared(stringShared), m_uOffset(uOffset), m_uLength(uLength) {}
+		CSection( const CSection& o ): m_pFile( o.m_pFile ), m_pallocator( o.m_pallocator ), m_stringTag( o.m_stringTag ), m_stringCode( o.m_stringCode ), m_stringShared( o.m_stringShared ), m_uOffset( o.m_uOffset ), m_uLength( o.m_uLength ), m_ppiecetable( o.m_ppiecetable ? std::make_unique<CPieceTable>( *o.m_ppiecetable ) : nullptr ), m_eraselist( o.m_eraselist ) { };
+		CSection( CSection&& o ) noexcept : m_pFile( o.m_pFile ), m_pallocator( std::move( o.m_pallocator ) ), m_stringTag( std::move( o.m_stringTag ) ), m_stringCode( std::move( o.m_stringCode ) ), m_stringShared( std::move( o.m_stringShared ) ), m_uOffset( o.m_uOffset ), m_uLength( o.m_uLength ), m_ppiecetable( std::move( o.m_ppiecetable ) ), m_eraselist( std::move( o.m_eraselist ) ) { 
 			o.m_pFile = nullptr; 
 		};
 		~CSection() {};
 
 	public:
-		void code( gd::utf8::string stringCode ) { m_stringCode = stringCode;  }
-		gd::utf8::string code() { return m_stringCode; }
-		const gd::utf8::string& code() const { return m_stringCode; }
+		void code( gd::utf8::string stringCode ) { SetCode( std::move( stringCode ) ); }
+		/// code with edits applied, active edit is ended and view is copied to code (see: `Detach`). Read const sections with `view()` and `eraselist()`
+		const gd::utf8::string& code() { EDIT_End(); Detach(); return m_stringCode; }
+		/// allocator for section text, nullptr = new/delete
+		gd::utf8::allocator* allocator() const noexcept { return m_pallocator.get(); }
+		/// read code without copying, valid as long as section isn't changed
+		std::string_view view() const { return IsView() == true ? std::string_view( m_stringShared.c_str() + m_uOffset, m_uLength ) : std::string_view( m_stringCode.c_str(), m_stringCode.size() ); }
 
 
 	public:
 		void SetGroup( gd::utf8::string&& m_stringTag ) { m_stringTag = std::move( m_stringTag ); }
-		void SetCode( gd::utf8::string&& stringCode ) { m_stringCode = std::move( stringCode ); }
+		void SetCode( gd::utf8::string&& stringCode ) { m_ppiecetable.reset(); m_eraselist.clear(); m_stringShared.clear(); m_uOffset = 0; m_uLength = 0; m_stringCode = std::move( stringCode ); }
+
+		/// check if section is a view into shared buffer
+		bool IsView() const noexcept { return m_stringShared.empty() == false; }
+		/// Give section its own code if it is a view, text is copied from shared buffer
+		void Detach();
 
 		bool HasGroup( std::string_view m_stringTag ) const noexcept;
 		/// Add group to section, if multiple groups then enclose each group in between square brackets "[groupname]"
 		void AddGroup( std::string_view stringTag ) { m_stringTag.append( std::format( "[{}]", stringTag ) ); }
 
+		/**
+		 * Edit code at byte offsets, edits are stored in piece table and code is
+		 * rebuilt once in `EDIT_End`. Rules, split and join end edit before they
+		 * work on code. Use `piecetable()` to write pieces without rebuilding code.
+		 * Erase rules do not use piece table, matches are added to erase list and
+		 * removed from code in `EDIT_End`.
+		 */
+		///@{
+		/// Start edit, edit methods start edit if not started
+		void EDIT_Begin();
+		/// Rebuild code from piece table or remove erased spans, and end edit
+		void EDIT_End();
+		bool EDIT_Active() const noexcept { return m_ppiecetable != nullptr; }
+		void EDIT_Insert( uint64_t uOffset, std::string_view stringInsert ) { EDIT_Begin(); m_ppiecetable->Insert( uOffset, stringInsert ); }
+		void EDIT_Erase( uint64_t uOffset, uint64_t uLength ) { EDIT_Begin(); m_ppiecetable->Erase( uOffset, uLength ); }
+		void EDIT_Replace( uint64_t uOffset, uint64_t uLength, std::string_view stringInsert ) { EDIT_Begin(); m_ppiecetable->Replace( uOffset, uLength, stringInsert ); }
+		/// piece table with edits, nullptr if section is not edited
+		const CPieceTable* piecetable() const noexcept { return m_ppiecetable.get(); }
+		/// spans erased from code but not removed yet
+		const CEraseList& eraselist() const noexcept { return m_eraselist; }
+		///@}
+
 		/// Split section into two sections and add them as child's. 
 		void Split( std::size_t uPosition ) { Split( std::vector< std::size_t >( { uPosition } ) ); }
 		void Split( std::vector<std::size_t> vectorPosition ) { Split( vectorPosition, false ); }
@@ -58,23 +371,36 @@ namespace application { namespace file {
 
 		/// ## Replace all matched text parts from regular expression in string
 #     ifdef BOOST_RE_REGEX_HPP
-		std::pair<bool, std::string>  Replace( const boost::regex& regexMatch, std::string_view stringInsert, uint32_t uFlags ) { return application::file::Replace( m_stringCode, regexMatch, stringInsert, uFlags ); }
-		std::pair<bool, std::string>  Replace( const boost::regex& regexMatch, std::string_view stringInsert ) { return application::file::Replace( m_stringCode, regexMatch, stringInsert, boost::regex_constants::match_default ); }
+		std::pair<bool, std::string>  Replace( const boost::regex& regexMatch, std::string_view stringInsert, uint32_t uFlags ) { EDIT_End(); Detach(); return application::file::Replace( m_stringCode, regexMatch, stringInsert, uFlags ); }
+		std::pair<bool, std::string>  Replace( const boost::regex& regexMatch, std::string_view stringInsert ) { return Replace( regexMatch, stringInsert, boost::regex_constants::match_default ); }
 #		endif
-		std::pair<bool, std::string>  Replace( const std::regex& regexMatch, std::string_view stringInsert , uint32_t uFlags ) { return application::file::Replace( m_stringCode, regexMatch, stringInsert, uFlags ); }
-		std::pair<bool, std::string>  Replace( const std::regex& regexMatch, std::string_view stringInsert ) { return application::file::Replace( m_stringCode, regexMatch, stringInsert, std::regex_constants::match_default ); }
+		std::pair<bool, std::string>  Replace( const std::regex& regexMatch, std::string_view stringInsert , uint32_t uFlags ) { EDIT_End(); Detach(); return application::file::Replace( m_stringCode, regexMatch, stringInsert, uFlags ); }
+		std::pair<bool, std::string>  Replace( const std::regex& regexMatch, std::string_view stringInsert ) { return Replace( regexMatch, stringInsert, std::regex_constants::match_default ); }
+		std::pair<bool, std::string>  Replace( const CAutomaton& automatonMatch, std::string_view stringInsert, uint32_t uFlags ) { EDIT_End(); Detach(); return application::file::Replace( m_stringCode, automatonMatch, stringInsert, uFlags ); }
+		std::pair<bool, std::string>  Replace( const CAutomaton& automatonMatch, std::string_view stringInsert ) { return Replace( automatonMatch, stringInsert, CAutomaton::eMatchDefault ); }
+		std::pair<bool, std::string>  Replace( const CKeywordTable& keywordtable ) { EDIT_End(); Detach(); return application::file::Replace( m_stringCode, keywordtable ); }
+		/// replace keywords only in tokens of selected kinds (see: `CSqlLexer::enumToken`)
+		std::pair<bool, std::string>  Replace( const CSqlLexer& lexerSql, uint32_t uKind, const CKeywordTable& keywordtable ) { EDIT_End(); Detach(); return application::file::Replace( m_stringCode, lexerSql, uKind, keywordtable ); }
 
 
 		/// ## Erase all matched text parts from regular expression in string
 #     ifdef BOOST_RE_REGEX_HPP
-		std::pair<bool, std::string>  Erase( const boost::regex& regexMatch, uint32_t uFlags ) { return application::file::Erase( m_stringCode, regexMatch, uFlags ); }
-		std::pair<bool, std::string>  Erase( const boost::regex& regexMatch ) { return application::file::Erase( m_stringCode, regexMatch, boost::regex_constants::match_default ); }
+		std::pair<bool, std::string>  Erase( const boost::regex& regexMatch, uint32_t uFlags ) { if( EDIT_Active() == true ) EDIT_End(); return application::file::Erase( view(), regexMatch, uFlags, m_eraselist ); }
+		std::pair<bool, std::string>  Erase( const boost::regex& regexMatch ) { return Erase( regexMatch, boost::regex_constants::match_default ); }
 #		endif
-		std::pair<bool, std::string>  Erase( const std::regex& regexMatch, uint32_t uFlags ) { return application::file::Erase( m_stringCode, regexMatch, uFlags ); }
-		std::pair<bool, std::string>  Erase( const std::regex& regexMatch ) { return application::file::Erase( m_stringCode, regexMatch, std::regex_constants::match_default ); }
+		std::pair<bool, std::string>  Erase( const std::regex& regexMatch, uint32_t uFlags ) { if( EDIT_Active() == true ) EDIT_End(); return application::file::Erase( view(), regexMatch, uFlags, m_eraselist ); }
+		std::pair<bool, std::string>  Erase( const std::regex& regexMatch ) { return Erase( regexMatch, std::regex_constants::match_default ); }
+		std::pair<bool, std::string>  Erase( const CAutomaton& automatonMatch, uint32_t uFlags ) { if( EDIT_Active() == true ) EDIT_End(); return application::file::Erase( view(), automatonMatch, uFlags, m_eraselist ); }
+		std::pair<bool, std::string>  Erase( const CAutomaton& automatonMatch ) { return Erase( automatonMatch, CAutomaton::eMatchDefault ); }
+		/// erase tokens of selected kinds, erased spans are removed first so code is split into tokens as it is
+		std::pair<bool, std::string>  Erase( const CSqlLexer& lexerSql, uint32_t uKind ) { EDIT_End(); return application::file::Erase( view(), lexerSql, uKind, m_eraselist ); }
+
+		/// ## Apply all rules in program to string
+		std::pair<bool, std::string>  Apply( const CRuleProgram& programApply ) { EDIT_End(); Detach(); return programApply.Apply( m_stringCode ); }
 
 		void SECTION_Append( gd::utf8::string m_stringTag, gd::utf8::string stringText ) { m_vectorSection.push_back( CSection( m_pFile, m_stringTag, stringText ) ); }
-		auto SECTION_At( std::size_t uIndex ) const { return m_vectorSection[ uIndex ]; }
+		CSection& SECTION_At( std::size_t uIndex ) { return m_vectorSection[ uIndex ]; }
+		const CSection& SECTION_At( std::size_t uIndex ) const { return m_vectorSection[ uIndex ]; }
 		auto SECTION_Begin() { return m_vectorSection.begin(); }
 		auto SECTION_Begin() const { return m_vectorSection.cbegin(); }
 		auto SECTION_End() { return m_vectorSection.end(); }
@@ -85,9 +411,18 @@ namespace application { namespace file {
 
 	public:
 		CFile* m_pFile = nullptr;		/// Parent - each section is connected to the owning file object
+		std::shared_ptr<gd::utf8::allocator> m_pallocator;///< allocator for section text, declared before text to outlive it (also if section outlives file)
 		gd::utf8::string m_stringTag;/// Code group, this is used to filter section parts when working with code
-		gd::utf8::string m_stringCode;/// Section code different file operations are working on
+		gd::utf8::string m_stringCode;/// Section code different file operations are working on, empty for views
+		gd::utf8::string m_stringShared;///< buffer section is a view into, empty if section owns code
+		uint32_t m_uOffset = 0;			///< byte offset to code in shared buffer
+		uint32_t m_uLength = 0;			///< code length in bytes in shared buffer
+		std::unique_ptr<CPieceTable> m_ppiecetable;///< edits to code not applied yet, nullptr if not edited
+		CEraseList m_eraselist;			///< spans erased from code by erase rules, removed in `EDIT_End`
 		std::vector<CSection> m_vectorSection;	///< file sections, file can be split in one or more sections
+
+		/// allocator from file, nullptr if file is nullptr or without allocator
+		static std::shared_ptr<gd::utf8::allocator> allocator_s( const CFile* pFile );
 	};
 
 /**
@@ -99,8 +434,8 @@ namespace application { namespace file {
 	public:
 		CFile() {};
 		CFile( std::string_view stringPath ) : m_stringPath( stringPath ) { SetNameFromPath(); }
-		CFile( const CFile& o ): m_stringName( o.m_stringName ), m_vectorSection( o.m_vectorSection ) {}
-		CFile( CFile&& o ) noexcept: m_stringName( std::move( o.m_stringName ) ), m_vectorSection( std::move( o.m_vectorSection ) ) {}
+		CFile( const CFile& o ): m_stringName( o.m_stringName ), m_pallocator( o.m_pallocator ), m_vectorSection( o.m_vectorSection ) {}
+		CFile( CFile&& o ) noexcept: m_stringName( std::move( o.m_stringName ) ), m_pallocator( std::move( o.m_pallocator ) ), m_vectorSection( std::move( o.m_vectorSection ) ) {}
 		~CFile() {};
 
 	public:
@@ -108,6 +443,10 @@ namespace application { namespace file {
       std::string name() { return m_stringName; }
       void name( std::string_view stringName ) { m_stringName = stringName; }
 
+      /// allocator for section text, nullptr = new/delete
+      gd::utf8::allocator* allocator() const { return m_pallocator.get(); }
+      /// Set allocator used for text loaded or split after this, allocator is kept as long as file or sections from file (or copies of them) exist
+      void SetAllocator( std::shared_ptr<gd::utf8::allocator> pallocator ) { m_pallocator = std::move( pallocator ); }
 
 	public:
 		std::pair<bool, std::string> FILE_Load( std::string stringFileName, std::string_view stringName );
@@ -116,7 +455,8 @@ namespace application { namespace file {
 
 		void SECTION_Append( gd::utf8::string stringText ) { SECTION_Append( gd::utf8::string(), stringText ); }
 		void SECTION_Append( gd::utf8::string stringTag, gd::utf8::string stringText ) { m_vectorSection.push_back( CSection( this, stringTag, stringText ) ); }
-		auto SECTION_At( std::size_t uPosition ) const { return m_vectorSection[ uPosition ]; }
+		CSection& SECTION_At( std::size_t uPosition ) { return m_vectorSection[ uPosition ]; }
+		const CSection& SECTION_At( std::size_t uPosition ) const { return m_vectorSection[ uPosition ]; }
 		auto SECTION_Begin() { return m_vectorSection.begin(); }
 		auto SECTION_Begin() const { return m_vectorSection.cbegin(); }
 		auto SECTION_End() { return m_vectorSection.end(); }
@@ -136,10 +476,23 @@ namespace application { namespace file {
 		std::pair<bool, std::string> SECTION_Replace( const boost::regex& regexMatch, std::string_view stringInsert, std::string_view stringTag, uint32_t uFlags );
 		std::pair<bool, std::string> SECTION_Replace( const boost::regex& regexMatch, std::string_view stringInsert, std::string_view stringTag ) { return SECTION_Replace( regexMatch, stringInsert, stringTag, boost::regex_constants::match_default ); }
 		std::pair<bool, std::string> SECTION_Replace( const boost::regex& regexMatch, std::string_view stringInsert ) { return SECTION_Replace( regexMatch, stringInsert, std::string_view() ); }
+		/// replace with pattern, compiled expression is taken from process wide cache (see: `gd::regex::cache_g`)
+		std::pair<bool, std::string> SECTION_Replace( std::string_view stringPattern, std::string_view stringInsert, std::string_view stringTag, uint32_t uFlags );
+		std::pair<bool, std::string> SECTION_Replace( std::string_view stringPattern, std::string_view stringInsert, std::string_view stringTag ) { return SECTION_Replace( stringPattern, stringInsert, stringTag, boost::regex_constants::match_default ); }
+		std::pair<bool, std::string> SECTION_Replace( std::string_view stringPattern, std::string_view stringInsert ) { return SECTION_Replace( stringPattern, stringInsert, std::string_view() ); }
 #		endif
 		std::pair<bool, std::string> SECTION_Replace( const std::regex& regexMatch, std::string_view stringInsert, std::string_view stringTag, uint32_t uFlags );
 		std::pair<bool, std::string> SECTION_Replace( const std::regex& regexMatch, std::string_view stringInsert, std::string_view stringTag ) { return SECTION_Replace( regexMatch, stringInsert, stringTag, std::regex_constants::match_default ); }
 		std::pair<bool, std::string> SECTION_Replace( const std::regex& regexMatch, std::string_view stringInsert ) { return SECTION_Replace( regexMatch, stringInsert, std::string_view() ); }
+		std::pair<bool, std::string> SECTION_Replace( const CAutomaton& automatonMatch, std::string_view stringInsert, std::string_view stringTag, uint32_t uFlags );
+		std::pair<bool, std::string> SECTION_Replace( const CAutomaton& automatonMatch, std::string_view stringInsert, std::string_view stringTag ) { return SECTION_Replace( automatonMatch, stringInsert, stringTag, CAutomaton::eMatchDefault ); }
+		std::pair<bool, std::string> SECTION_Replace( const CAutomaton& automatonMatch, std::string_view stringInsert ) { return SECTION_Replace( automatonMatch, stringInsert, std::string_view() ); }
+		/// replace all keywords in table with one pass for each section
+		std::pair<bool, std::string> SECTION_Replace( const CKeywordTable& keywordtable, std::string_view stringTag );
+		std::pair<bool, std::string> SECTION_Replace( const CKeywordTable& keywordtable ) { return SECTION_Replace( keywordtable, std::string_view() ); }
+		/// replace keywords in tokens of selected kinds, for example keywords outside strings and comments
+		std::pair<bool, std::string> SECTION_Replace( const CSqlLexer& lexerSql, uint32_t uKind, const CKeywordTable& keywordtable, std::string_view stringTag );
+		std::pair<bool, std::string> SECTION_Replace( const CSqlLexer& lexerSql, uint32_t uKind, const CKeywordTable& keywordtable ) { return SECTION_Replace( lexerSql, uKind, keywordtable, std::string_view() ); }
       ///@}
 
 
@@ -151,15 +504,34 @@ namespace application { namespace file {
 		std::pair<bool, std::string> SECTION_Erase( const boost::regex& regexMatch, std::string_view stringTag, uint32_t uFlags );
 		std::pair<bool, std::string> SECTION_Erase( const boost::regex& regexMatch, std::string_view stringTag ) { return SECTION_Erase( regexMatch, stringTag, boost::regex_constants::match_default ); }
 		std::pair<bool, std::string> SECTION_Erase( const boost::regex& regexMatch ) { return SECTION_Erase( regexMatch, std::string_view() ); }
+		/// erase with pattern, compiled expression is taken from process wide cache (see: `gd::regex::cache_g`)
+		std::pair<bool, std::string> SECTION_Erase( std::string_view stringPattern, std::string_view stringTag, uint32_t uFlags );
+		std::pair<bool, std::string> SECTION_Erase( std::string_view stringPattern, std::string_view stringTag ) { return SECTION_Erase( stringPattern, stringTag, boost::regex_constants::match_default ); }
+		std::pair<bool, std::string> SECTION_Erase( std::string_view stringPattern ) { return SECTION_Erase( stringPattern, std::string_view() ); }
 #		endif
 		std::pair<bool, std::string> SECTION_Erase( const std::regex& regexMatch, std::string_view stringTag, uint32_t uFlags );
 		std::pair<bool, std::string> SECTION_Erase( const std::regex& regexMatch, std::string_view stringTag ) { return SECTION_Erase( regexMatch, stringTag, std::regex_constants::match_default ); }
 		std::pair<bool, std::string> SECTION_Erase( const std::regex& regexMatch ) { return SECTION_Erase( regexMatch, std::string_view() ); }
+		std::pair<bool, std::string> SECTION_Erase( const CAutomaton& automatonMatch, std::string_view stringTag, uint32_t uFlags );
+		std::pair<bool, std::string> SECTION_Erase( const CAutomaton& automatonMatch, std::string_view stringTag ) { return SECTION_Erase( automatonMatch, stringTag, CAutomaton::eMatchDefault ); }
+		std::pair<bool, std::string> SECTION_Erase( const CAutomaton& automatonMatch ) { return SECTION_Erase( automatonMatch, std::string_view() ); }
+		/// erase tokens of selected kinds, for example all comments (see: `CSqlLexer::eTokenComment`)
+		std::pair<bool, std::string> SECTION_Erase( const CSqlLexer& lexerSql, uint32_t uKind, std::string_view stringTag );
+		std::pair<bool, std::string> SECTION_Erase( const CSqlLexer& lexerSql, uint32_t uKind ) { return SECTION_Erase( lexerSql, uKind, std::string_view() ); }
+      ///@}
+
+      /**
+       * Apply rule program to sections, each rule is applied after the other to each section
+       */
+      ///@{
+		std::pair<bool, std::string> SECTION_Apply( const CRuleProgram& programApply, std::string_view stringTag );
+		std::pair<bool, std::string> SECTION_Apply( const CRuleProgram& programApply ) { return SECTION_Apply( programApply, std::string_view() ); }
       ///@}
 
 	public:
 		std::string m_stringName;					///< file name
 		std::string m_stringPath;					///< full file path if file is used
+		std::shared_ptr<gd::utf8::allocator> m_pallocator;///< allocator for section text, declared before sections to outlive them
 		std::vector<CSection> m_vectorSection;	///< file sections, file can be split in one or more sections
 
 	};
@@ -188,6 +560,178 @@ namespace application { namespace file {
 
 	};
 
+/**
+ * ## CFileStream =============================================================
+ */
+
+	/**
+	 * @brief Convert text with erase and replace rules using fixed size windows
+	 * Text is pushed through rules in window sized blocks, each rule keeps 
+	 * `overlap` bytes from previous block so matches that span the block boundary
+	 * are found. Peak memory depends on window size and number of rules, not on 
+	 * file size. 
+	 * @note Matches can't be longer than overlap, set overlap to the longest
+	 * text any rule may match.
+	*/
+	class CFileStream
+	{
+	public:
+		/// state for each rule when text is streamed
+		struct stage
+		{
+			std::string m_stringPending;	///< text not yet processed, first character is context if m_bContext is true
+			bool m_bContext = false;		///< first character in pending text is already processed and used as context
+			bool m_bRestart = true;			///< search starts at end of match or start of text (no context)
+		};
+
+	public:
+		CFileStream() {}
+		CFileStream( std::size_t uWindow, std::size_t uOverlap ): m_uWindow( uWindow ), m_uOverlap( uOverlap ) {}
+		~CFileStream() {}
+
+	public:
+		std::size_t window() const noexcept { return m_uWindow; }
+		std::size_t overlap() const noexcept { return m_uOverlap; }
+
+		/// Add rule, rules are applied in the order they are added
+		void RULE_Add( CRule ruleAdd ) { m_vectorRule.push_back( std::move( ruleAdd ) ); }
+		auto RULE_Size() const { return m_vectorRule.size(); }
+
+		std::pair<bool, std::string> Convert( std::istream& istreamFrom, std::ostream& ostreamTo );
+		std::pair<bool, std::string> Convert( std::string_view stringFileFrom, std::string_view stringFileTo );
+
+	private:
+		void Process( std::size_t uRule, const char* pbszText, std::size_t uLength, bool bEnd, std::ostream& ostreamTo );
+
+	public:
+		std::size_t m_uWindow = 1024 * 1024;	///< window size, text is read and processed in blocks with this size
+		std::size_t m_uOverlap = 64 * 1024;		///< max length for match, this is kept between windows for each rule
+		std::vector<CRule> m_vectorRule;			///< rules applied to text
+		std::vector<stage> m_vectorStage;		///< stream state for each rule
+	};
+
+/**
+ * ## CFileMap ================================================================
+ */
+
+	/**
+	 * @brief Read only access to file content
+	 * File is memory mapped if possible, if mapping fails (pipes, special files)
+	 * file is read into one buffer. Use `text()` to get file content without BOM,
+	 * no copy is made when reading from mapped file. `text()` is raw bytes, use
+	 * `Text` to get UTF-8 text also for files with UTF-16 BOM.
+	*/
+	class CFileMap
+	{
+	public:
+		enum enumBOM { eBOMNone = 0, eBOMUtf8 = 1, eBOMUtf16LE = 2, eBOMUtf16BE = 3 };
+
+	public:
+		CFileMap() {}
+		CFileMap( const CFileMap& ) = delete;
+		CFileMap& operator=( const CFileMap& ) = delete;
+		~CFileMap() { Close(); }
+
+	public:
+		const uint8_t* data() const noexcept { return m_pubData; }
+		std::size_t size() const noexcept { return m_uSize; }
+		/// BOM found in file (see: enumBOM)
+		unsigned bom() const noexcept { return m_uBOM; }
+		/// number of bytes used by BOM
+		std::size_t bom_size() const noexcept { return m_uBOM == eBOMUtf8 ? 3 : ( m_uBOM == eBOMNone ? 0 : 2 ); }
+		/// file content without BOM
+		std::string_view text() const noexcept { return std::string_view( reinterpret_cast<const char*>( m_pubData ) + bom_size(), m_uSize - bom_size() ); }
+		/// copy file content without BOM to string, UTF-16 text is converted to UTF-8
+		std::pair<bool, std::string> Text( gd::utf8::string& stringText ) const;
+
+		bool IsOpen() const noexcept { return m_bOpen; }
+		bool IsMapped() const noexcept { return m_pMap != nullptr; }
+
+		std::pair<bool, std::string> Open( std::string_view stringFile );
+		void Close();
+
+	private:
+		std::pair<bool, std::string> Read( intptr_t iFileHandle, std::string_view stringFile );
+		void DetectBOM();
+
+	public:
+		const uint8_t* m_pubData = nullptr;	///< pointer to file data, mapped or in buffer
+		std::size_t m_uSize = 0;				///< file size in bytes
+		unsigned m_uBOM = eBOMNone;			///< BOM found in file
+		bool m_bOpen = false;					///< if file is open
+		void* m_pMap = nullptr;					///< address to mapped view if file is mapped
+#ifdef _WIN32
+		void* m_hMap = nullptr;					///< handle to file mapping object
+#endif
+		std::vector<uint8_t> m_vectorBuffer;///< buffer used when file can't be mapped
+	};
+
+/**
+ * ## CFileWrite ==============================================================
+ */
+
+	/**
+	 * @brief Write file from many buffers without joining them
+	 * Buffers added with `Write` are collected (only pointer and size) and
+	 * written with one system call for each batch (`writev` on posix, batch
+	 * size is IOV_MAX). Memory used is the same for any number of buffers.
+	 * With `eFlagAtomic` text is written to a temporary file that replaces the
+	 * file when `Close` is called, readers never see a half written file.
+	 * The temporary file has a unique name and keeps permissions from file.
+	 * Buffers need to be valid until they are flushed, that is at next
+	 * `Flush` or `Close`.
+	 *
+~~~{.cpp}
+file::CFileWrite filewrite;
+filewrite.Open( "C:\\temp\\out.sql", file::CFileWrite::eFlagAtomic );
+for( auto it = fileSql.SECTION_Begin(); it != fileSql.SECTION_End(); it++ ) filewrite.Write( it->code().c_buffer(), it->code().size() );
+auto [bOk, stringError] = filewrite.Close();
+~~~
+	*/
+	class CFileWrite
+	{
+	public:
+		enum enumFlag { eFlagAtomic = 0x01 };
+		static constexpr std::size_t BATCH_MAX = 1024;	///< max buffers for each write call
+
+		/// buffer waiting to be written
+		struct buffer
+		{
+			const uint8_t* m_pubData;
+			std::size_t m_uSize;
+		};
+
+	public:
+		CFileWrite() {}
+		CFileWrite( const CFileWrite& ) = delete;
+		CFileWrite& operator=( const CFileWrite& ) = delete;
+		~CFileWrite() { Abort(); }
+
+	public:
+		bool IsOpen() const noexcept { return m_iFile != -1; }
+		/// number of bytes written to file
+		uint64_t written() const noexcept { return m_uWritten; }
+
+		std::pair<bool, std::string> Open( std::string_view stringFile, unsigned uFlags = 0 );
+		std::pair<bool, std::string> Write( const uint8_t* pubData, std::size_t uSize );
+		std::pair<bool, std::string> Write( std::string_view stringData ) { return Write( reinterpret_cast<const uint8_t*>( stringData.data() ), stringData.length() ); }
+		std::pair<bool, std::string> Flush();
+		/// flush and close file, temporary file replaces file if atomic
+		std::pair<bool, std::string> Close();
+		/// close file without saving, temporary file is removed
+		void Abort();
+
+	public:
+		intptr_t m_iFile = -1;					///< file handle (HANDLE on windows)
+		unsigned m_uFlags = 0;					///< flags from Open (see: enumFlag)
+		uint64_t m_uWritten = 0;				///< bytes written
+		std::string m_stringFile;				///< file name
+		std::string m_stringFileTemporary;	///< temporary file used when atomic
+		std::size_t m_uBatch = BATCH_MAX;	///< max buffers for each write call
+		std::size_t m_uPending = 0;			///< buffers waiting to be written
+		buffer m_pbufferPending[BATCH_MAX];	///< buffers waiting to be written
+	};
+
 
 
 
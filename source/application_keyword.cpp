@@ -0,0 +1,219 @@
+#include <cassert>
+#include <format>
+#include <stdexcept>
+
+#include "application_keyword.hpp"
+
+namespace application { namespace file {
+
+constexpr uint32_t uNoState_ = 0xffffffff;                                    // no trie edge, only used while table is built
+
+/// word character for whole word match, non ascii bytes are part of utf8 letters
+static bool word_s( uint8_t uByte ) { return ( uByte >= 'a' && uByte <= 'z' ) || ( uByte >= 'A' && uByte <= 'Z' ) || ( uByte >= '0' && uByte <= '9' ) || uByte == '_' || uByte >= 0x80; }
+
+/**
+ * ## CKeywordTable::table ====================================================
+ */
+
+struct CKeywordTable::table
+{
+   void Compile();
+   uint32_t Next( uint32_t uState, uint8_t uByte ) const noexcept { return m_vectorNext[uState * m_uClassCount + m_auClass[uByte]]; }
+   bool Word( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd, const char* pbszMatch, const char* pbszMatchEnd ) const;
+
+   std::vector<keyword> m_vectorKeyword;
+   uint32_t m_uFlags = eFlagDefault;
+   uint16_t m_auClass[256] = {};                                               ///< byte class, bytes not found in keywords are class 0
+   uint32_t m_uClassCount = 1;
+   bool m_abStart[256] = {};                                                   ///< true if byte starts a keyword, other bytes are skipped in start state
+   std::vector<uint32_t> m_vectorNext;                                         ///< transition for state and class (state * class count + class)
+   std::vector<uint32_t> m_vectorDepth;                                        ///< length of text matched to reach state
+   std::vector<int64_t> m_vectorOutput;                                        ///< keyword ending in state, -1 if none
+   std::vector<uint32_t> m_vectorOutputLink;                                   ///< next state with keyword in failure chain, 0 if none
+};
+
+/**
+ * @brief Build automaton from keywords
+ * Keywords are added to trie, failure links are then resolved breadth first and
+ * missing edges get the transition from the failure state. The result is a full
+ * transition table, each byte in text costs one lookup.
+*/
+void CKeywordTable::table::Compile()
+{
+   bool bIcase = ( m_uFlags & eFlagIcase ) != 0;
+   auto fold_ = [bIcase]( uint8_t uByte ) -> uint8_t { return bIcase == true && uByte >= 'A' && uByte <= 'Z' ? uByte + ( 'a' - 'A' ) : uByte; };
+
+   // ## byte classes, only bytes used in keywords get own class
+   for( const auto& it : m_vectorKeyword )
+   {
+      if( it.first.empty() == true ) throw std::invalid_argument( "empty keyword [CKeywordTable]" );
+      for( auto ch : it.first )
+      {
+         uint8_t uByte = fold_( static_cast<uint8_t>( ch ) );
+         if( m_auClass[uByte] == 0 ) m_auClass[uByte] = static_cast<uint16_t>( m_uClassCount++ );
+      }
+   }
+   if( bIcase == true ) { for( unsigned u = 'A'; u <= 'Z'; u++ ) m_auClass[u] = m_auClass[u + ( 'a' - 'A' )]; }
+
+   // ## trie, first keyword is used if the same keyword is added again
+   auto add_state_ = [this]( uint32_t uDepth ) -> uint32_t {
+      uint32_t uState = static_cast<uint32_t>( m_vectorDepth.size() );
+      m_vectorNext.resize( m_vectorNext.size() + m_uClassCount, uNoState_ );
+      m_vectorDepth.push_back( uDepth );
+      m_vectorOutput.push_back( -1 );
+      m_vectorOutputLink.push_back( 0 );
+      return uState;
+   };
+
+   add_state_( 0 );
+   for( std::size_t uIndex = 0; uIndex < m_vectorKeyword.size(); uIndex++ )
+   {
+      uint32_t uState = 0;
+      for( auto ch : m_vectorKeyword[uIndex].first )
+      {
+         uint32_t uSlot = uState * m_uClassCount + m_auClass[static_cast<uint8_t>( ch )];
+         if( m_vectorNext[uSlot] == uNoState_ ) { uint32_t uAdd = add_state_( m_vectorDepth[uState] + 1 ); m_vectorNext[uSlot] = uAdd; }// add_state_ resizes vector
+         uState = m_vectorNext[uSlot];
+      }
+      if( m_vectorOutput[uState] == -1 ) m_vectorOutput[uState] = static_cast<int64_t>( uIndex );
+   }
+
+   // ## failure links, breadth first so failure state is always resolved before state
+   std::vector<uint32_t> vectorFail( m_vectorDepth.size(), 0 );
+   std::vector<uint32_t> vectorQueue;
+   vectorQueue.reserve( m_vectorDepth.size() );
+   vectorQueue.push_back( 0 );
+   for( std::size_t uQueue = 0; uQueue < vectorQueue.size(); uQueue++ )
+   {
+      uint32_t uState = vectorQueue[uQueue];
+      for( uint32_t uClass = 0; uClass < m_uClassCount; uClass++ )
+      {
+         uint32_t& uNext = m_vectorNext[uState * m_uClassCount + uClass];
+         uint32_t uFailNext = uState == 0 ? 0 : m_vectorNext[vectorFail[uState] * m_uClassCount + uClass];
+         if( uNext == uNoState_ ) { uNext = uFailNext; continue; }           // missing edge, same as for failure state
+
+         vectorFail[uNext] = uFailNext;
+         m_vectorOutputLink[uNext] = m_vectorOutput[uFailNext] != -1 ? uFailNext : m_vectorOutputLink[uFailNext];
+         vectorQueue.push_back( uNext );
+      }
+   }
+
+   for( unsigned u = 0; u < 256; u++ ) m_abStart[u] = m_vectorNext[m_auClass[u]] != 0;
+}
+
+/// check that keyword matched in range is a whole word, word after match is unknown if range ends before text
+bool CKeywordTable::table::Word( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd, const char* pbszMatch, const char* pbszMatchEnd ) const
+{
+   if( word_s( static_cast<uint8_t>( pbszMatch[0] ) ) == true && ( pbszMatch > pbszFirst || bPrevAvail == true ) && word_s( static_cast<uint8_t>( pbszMatch[-1] ) ) == true ) return false;
+   if( word_s( static_cast<uint8_t>( pbszMatchEnd[-1] ) ) == true )
+   {
+      if( pbszMatchEnd < pbszLast ) return word_s( static_cast<uint8_t>( *pbszMatchEnd ) ) == false;
+      return bEnd;
+   }
+   return true;
+}
+
+/**
+ * ## CKeywordTable ===========================================================
+ */
+
+/**
+ * @brief Compile keywords to automaton
+ * @param vectorKeyword keywords and replacement text
+ * @param uFlags how to match (see: `enumFlag`)
+ * @throws std::invalid_argument if a keyword is empty
+*/
+CKeywordTable::CKeywordTable( const std::vector<keyword>& vectorKeyword, uint32_t uFlags )
+{
+   auto ptable = std::make_shared<table>();
+   ptable->m_vectorKeyword = vectorKeyword;
+   ptable->m_uFlags = uFlags;
+   ptable->Compile();
+   m_ptable = std::move( ptable );
+}
+
+std::size_t CKeywordTable::size() const noexcept { return m_ptable != nullptr ? m_ptable->m_vectorKeyword.size() : 0; }
+
+uint32_t CKeywordTable::flags() const noexcept { return m_ptable != nullptr ? m_ptable->m_uFlags : eFlagDefault; }
+
+const CKeywordTable::keyword& CKeywordTable::at( std::size_t uIndex ) const
+{                                                                              assert( m_ptable != nullptr );
+   return m_ptable->m_vectorKeyword.at( uIndex );
+}
+
+std::size_t CKeywordTable::state_count() const noexcept { return m_ptable != nullptr ? m_ptable->m_vectorDepth.size() : 0; }
+
+std::string CKeywordTable::key() const
+{
+   std::string stringKey = std::format( "{}:{}", flags(), size() );
+   if( m_ptable == nullptr ) return stringKey;
+   for( const auto& it : m_ptable->m_vectorKeyword ) stringKey += std::format( ":{}:{}:{}:{}", it.first.length(), it.first, it.second.length(), it.second );
+   return stringKey;
+}
+
+/**
+ * @brief Find first keyword in range, leftmost longest
+ * Scan stops when no keyword can start at or before best match found. Bytes
+ * that can't start a keyword are skipped while automaton is in start state.
+ * @param pbszFirst start of range
+ * @param pbszLast end of range
+ * @param bPrevAvail true if character before first is readable
+ * @param bEnd true if last is end of text, false if text continues (whole word can't be decided at last)
+ * @return std::pair<const char*, const char*> matched keyword or pair with nullptr if not found
+*/
+std::pair<const char*, const char*> CKeywordTable::Find( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd ) const
+{
+   if( m_ptable == nullptr ) return { nullptr, nullptr };
+   const table& table_ = *m_ptable;
+   bool bWord = ( table_.m_uFlags & eFlagWord ) != 0;
+
+   const char* pbszMatch = nullptr;
+   const char* pbszMatchEnd = nullptr;
+   uint32_t uState = 0;
+   for( const char* pbsz = pbszFirst; pbsz < pbszLast; pbsz++ )
+   {
+      if( uState == 0 )
+      {
+         if( pbszMatch != nullptr ) break;                                    // keyword found and nothing started after it
+         while( pbsz < pbszLast && table_.m_abStart[static_cast<uint8_t>( *pbsz )] == false ) pbsz++;
+         if( pbsz == pbszLast ) break;
+      }
+
+      uState = table_.Next( uState, static_cast<uint8_t>( *pbsz ) );
+      const char* pbszEnd = pbsz + 1;
+      if( pbszMatch != nullptr && pbszEnd - table_.m_vectorDepth[uState] > pbszMatch ) break;// no keyword can start at or before match
+
+      uint32_t uOutput = table_.m_vectorOutput[uState] != -1 ? uState : table_.m_vectorOutputLink[uState];
+      for( ; uOutput != 0; uOutput = table_.m_vectorOutputLink[uOutput] )
+      {
+         const char* pbszStart = pbszEnd - table_.m_vectorDepth[uOutput];
+         if( pbszMatch != nullptr && pbszStart > pbszMatch ) break;           // later keywords in chain are shorter and start after
+         if( bWord == true && table_.Word( pbszFirst, pbszLast, bPrevAvail, bEnd, pbszStart, pbszEnd ) == false ) continue;
+
+         pbszMatch = pbszStart;                                                // starts before or is longer than previous match
+         pbszMatchEnd = pbszEnd;
+         break;
+      }
+   }
+
+   return { pbszMatch, pbszMatchEnd };
+}
+
+int64_t CKeywordTable::Index( const char* pbszFirst, const char* pbszLast ) const
+{
+   if( m_ptable == nullptr || pbszFirst == pbszLast ) return -1;
+   const table& table_ = *m_ptable;
+   uint32_t uState = 0;
+   for( const char* pbsz = pbszFirst; pbsz < pbszLast; pbsz++ ) uState = table_.Next( uState, static_cast<uint8_t>( *pbsz ) );
+   if( table_.m_vectorDepth[uState] != static_cast<uint32_t>( pbszLast - pbszFirst ) ) return -1;// text left trie
+   return table_.m_vectorOutput[uState];
+}
+
+std::string_view CKeywordTable::Insert( const char* pbszMatch, const char* pbszMatchEnd ) const
+{
+   int64_t iIndex = Index( pbszMatch, pbszMatchEnd );
+   if( iIndex == -1 ) return std::string_view();
+   return m_ptable->m_vectorKeyword[static_cast<std::size_t>( iIndex )].second;
+}
+
+} }
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace application { namespace file {
+
+/**
+ * ## CKeywordTable ===========================================================
+ */
+
+   /**
+    * @brief Table with literal keywords and replacement text, all keywords are found in one pass
+    * Keywords are compiled to an Aho-Corasick automaton (trie with failure links
+    * resolved to a full transition table over byte classes). Text is scanned once,
+    * time is linear in text length and does not depend on number of keywords.
+    *
+    * Match is leftmost longest, if two keywords start at the same position the
+    * longest is selected. If the same keyword is added twice the first is used.
+    *
+    * Flags:
+    * - `eFlagWord` keyword is only matched as whole word, a keyword that starts
+    *   (ends) with a word character can't have a word character before (after) it.
+    *   Word characters are `[A-Za-z0-9_]` and all non ascii bytes (utf8).
+    * - `eFlagIcase` ascii letters in text and keywords are compared without case.
+    *
+~~~{.cpp}
+CKeywordTable keywordtableSql( { { "DATETIME", "TIMESTAMP" }, { "NVARCHAR(", "VARCHAR(" }, { "GETDATE()", "NOW()" } }, CKeywordTable::eFlagWord | CKeywordTable::eFlagIcase );
+fileSql.SECTION_Replace( keywordtableSql );                        // all keywords in one pass for each section
+~~~
+   */
+   class CKeywordTable
+   {
+   public:
+      enum enumFlag : uint32_t { eFlagDefault = 0, eFlagWord = 0x01, eFlagIcase = 0x02 };
+      /// keyword and text it is replaced with
+      using keyword = std::pair<std::string, std::string>;
+
+      struct table;
+
+   public:
+      CKeywordTable() {}
+      explicit CKeywordTable( const std::vector<keyword>& vectorKeyword, uint32_t uFlags = eFlagDefault );
+      CKeywordTable( std::initializer_list<keyword> listKeyword, uint32_t uFlags = eFlagDefault ): CKeywordTable( std::vector<keyword>( listKeyword ), uFlags ) {}
+      ~CKeywordTable() {}
+
+   public:
+      bool empty() const noexcept { return m_ptable == nullptr; }
+      /// number of keywords in table
+      std::size_t size() const noexcept;
+      uint32_t flags() const noexcept;
+      const keyword& at( std::size_t uIndex ) const;
+      /// number of states in automaton
+      std::size_t state_count() const noexcept;
+      /// text identifying table (flags and all keywords), used as key for compiled rules
+      std::string key() const;
+
+      /// find first keyword in range, `bPrevAvail` is true if character before first is readable, `bEnd` is true if last is end of text
+      std::pair<const char*, const char*> Find( const char* pbszFirst, const char* pbszLast, bool bPrevAvail, bool bEnd ) const;
+      std::pair<const char*, const char*> Find( const char* pbszFirst, const char* pbszLast ) const { return Find( pbszFirst, pbszLast, false, true ); }
+      /// index for keyword matching text, -1 if text isn't a keyword
+      int64_t Index( const char* pbszFirst, const char* pbszLast ) const;
+      /// replacement text for matched keyword, empty if text isn't a keyword
+      std::string_view Insert( const char* pbszMatch, const char* pbszMatchEnd ) const;
+
+   public:
+      std::shared_ptr<const table> m_ptable;  ///< compiled keywords, shared by copies
+   };
+
+} }
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "application_lexer.hpp"
+
+namespace application { namespace file {
+
+/// byte class, first byte in token selects what is scanned
+enum enumClass : uint8_t { eClassOther, eClassSpace, eClassLetter, eClassDigit, eClassPrefix, eClassPart, eClassQuote, eClassDoubleQuote, eClassBracket, eClassBacktick, eClassMinus, eClassSlash, eClassDot };
+
+/// what is scanned in token
+enum enumMode : uint32_t { eModeNone = 0, eModeWhitespace, eModeIdentifier, eModeNumber, eModeLineComment, eModeBlockComment, eModeString, eModeQuoteDouble, eModeQuoteBracket, eModeQuoteBacktick, eModeSymbol };
+
+static constexpr std::array<uint8_t, 256> class_table_s()
+{
+   std::array<uint8_t, 256> arrayClass{};
+   for( unsigned u = 0; u < 256; u++ )
+   {
+      uint8_t uClass = eClassOther;
+      if( u == ' ' || u == '\t' || u == '\n' || u == '\r' || u == '\f' || u == '\v' ) uClass = eClassSpace;
+      else if( ( u >= 'a' && u <= 'z' ) || ( u >= 'A' && u <= 'Z' ) || u == '_' || u >= 0x80 ) uClass = eClassLetter;// non ascii bytes are part of utf8 letters
+      else if( u >= '0' && u <= '9' ) uClass = eClassDigit;
+      else if( u == '@' || u == '#' ) uClass = eClassPrefix;
+      else if( u == '$' ) uClass = eClassPart;
+      else if( u == '\'' ) uClass = eClassQuote;
+      else if( u == '"' ) uClass = eClassDoubleQuote;
+      else if( u == '[' ) uClass = eClassBracket;
+      else if( u == '`' ) uClass = eClassBacktick;
+      else if( u == '-' ) uClass = eClassMinus;
+      else if( u == '/' ) uClass = eClassSlash;
+      else if( u == '.' ) uClass = eClassDot;
+      arrayClass[u] = uClass;
+   }
+   return arrayClass;
+}
+
+static constexpr std::array<uint8_t, 256> arrayClass_s = class_table_s();
+
+static uint8_t class_s( char ch ) { return arrayClass_s[static_cast<uint8_t>( ch )]; }
+static bool word_s( char ch ) { uint8_t uClass = class_s( ch ); return uClass == eClassLetter || uClass == eClassDigit || uClass == eClassPrefix || uClass == eClassPart; }
+static bool number_s( char ch ) { return word_s( ch ) == true || ch == '.'; }
+
+/**
+ * @brief Select what to scan from first character in token
+ * @param pbszToken start of token
+ * @param pbszLast end of text
+ * @param bEnd true if last is end of text
+ * @param pbszResume gets position where scanning continues
+ * @return unsigned mode for token, eModeNone if next part of text is needed to decide
+*/
+static unsigned mode_s( const char* pbszToken, const char* pbszLast, bool bEnd, const char*& pbszResume )
+{
+   pbszResume = pbszToken + 1;
+   bool bNext = pbszToken + 1 < pbszLast;                                      // second character is available
+   char chNext = bNext == true ? pbszToken[1] : '\0';
+   switch( class_s( *pbszToken ) )
+   {
+   case eClassSpace : return eModeWhitespace;
+   case eClassLetter :
+      if( ( *pbszToken == 'N' || *pbszToken == 'n' ) )
+      {
+         if( bNext == false && bEnd == false ) return eModeNone;
+         if( chNext == '\'' ) { pbszResume = pbszToken + 2; return eModeString; }// N'...' unicode string
+      }
+      return eModeIdentifier;
+   case eClassPrefix : case eClassPart : return eModeIdentifier;
+   case eClassDigit : return eModeNumber;
+   case eClassQuote : return eModeString;
+   case eClassDoubleQuote : return eModeQuoteDouble;
+   case eClassBracket : return eModeQuoteBracket;
+   case eClassBacktick : return eModeQuoteBacktick;
+   case eClassMinus :
+   case eClassSlash :
+   case eClassDot :
+   {
+      if( bNext == false && bEnd == false ) return eModeNone;
+      if( *pbszToken == '-' && chNext == '-' ) { pbszResume = pbszToken + 2; return eModeLineComment; }
+      if( *pbszToken == '/' && chNext == '*' ) { pbszResume = pbszToken + 2; return eModeBlockComment; }
+      if( *pbszToken == '.' && bNext == true && class_s( chNext ) == eClassDigit ) return eModeNumber;
+      return eModeSymbol;
+   }
+   }
+   return eModeSymbol;
+}
+
+/// find end for quoted text, quote character is escaped by writing it twice
+static const char* quote_end_s( char chQuote, const char* pbszFrom, const char* pbszLast, const char*& pbszResume )
+{
+   while( pbszFrom < pbszLast )
+   {
+      const char* pbszQuote = static_cast<const char*>( std::memchr( pbszFrom, chQuote, pbszLast - pbszFrom ) );
+      if( pbszQuote == nullptr ) break;
+      if( pbszQuote + 1 == pbszLast ) { pbszResume = pbszQuote; return nullptr; }// escaped or end, decided by next character
+      if( pbszQuote[1] != chQuote ) return pbszQuote + 1;
+      pbszFrom = pbszQuote + 2;
+   }
+   pbszResume = pbszLast;
+   return nullptr;
+}
+
+/**
+ * @brief Find end for token
+ * @param uMode what is scanned
+ * @param pbszToken start of token
+ * @param pbszFrom position where scanning continues
+ * @param pbszLast end of text
+ * @param pbszResume gets position where scanning continues if token reaches end of text
+ * @return const char* end of token, nullptr if token may continue after last
+*/
+static const char* end_s( unsigned uMode, const char* pbszToken, const char* pbszFrom, const char* pbszLast, const char*& pbszResume )
+{
+   switch( uMode )
+   {
+   case eModeWhitespace :
+      while( pbszFrom < pbszLast && class_s( *pbszFrom ) == eClassSpace ) pbszFrom++;
+      break;
+   case eModeIdentifier :
+      while( pbszFrom < pbszLast && word_s( *pbszFrom ) == true ) pbszFrom++;
+      break;
+   case eModeNumber :
+      while( pbszFrom < pbszLast && number_s( *pbszFrom ) == true ) pbszFrom++;
+      break;
+   case eModeLineComment :
+   {
+      const char* pbszLF = static_cast<const char*>( std::memchr( pbszFrom, '\n', pbszLast - pbszFrom ) );
+      const char* pbszCR = static_cast<const char*>( std::memchr( pbszFrom, '\r', ( pbszLF != nullptr ? pbszLF : pbszLast ) - pbszFrom ) );
+      pbszFrom = pbszCR != nullptr ? pbszCR : ( pbszLF != nullptr ? pbszLF : pbszLast );
+      break;
+   }
+   case eModeBlockComment :
+      pbszFrom = std::max( pbszFrom, pbszToken + 3 );                         // first possible '/' in "*/"
+      while( pbszFrom < pbszLast )
+      {
+         const char* pbszSlash = static_cast<const char*>( std::memchr( pbszFrom, '/', pbszLast - pbszFrom ) );
+         if( pbszSlash == nullptr ) break;
+         if( pbszSlash[-1] == '*' ) return pbszSlash + 1;
+         pbszFrom = pbszSlash + 1;
+      }
+      pbszResume = pbszLast;
+      return nullptr;
+   case eModeString : return quote_end_s( '\'', pbszFrom, pbszLast, pbszResume );
+   case eModeQuoteDouble : return quote_end_s( '"', pbszFrom, pbszLast, pbszResume );
+   case eModeQuoteBracket : return quote_end_s( ']', pbszFrom, pbszLast, pbszResume );
+   case eModeQuoteBacktick : return quote_end_s( '`', pbszFrom, pbszLast, pbszResume );
+   default : return pbszToken + 1;
+   }
+
+   if( pbszFrom < pbszLast ) return pbszFrom;
+   pbszResume = pbszLast;
+   return nullptr;
+}
+
+/**
+ * ## CSqlLexer ===============================================================
+ */
+
+CSqlLexer::CSqlLexer(): CSqlLexer( keywords_s() ) {}
+
+/**
+ * @brief Create lexer with keywords
+ * @param vectorKeyword words that are marked as keyword tokens, case is ignored
+*/
+CSqlLexer::CSqlLexer( const std::vector<std::string>& vectorKeyword )
+{
+   for( auto stringKeyword : vectorKeyword )
+   {
+      std::transform( stringKeyword.begin(), stringKeyword.end(), stringKeyword.begin(), []( char ch ) { return ch >= 'a' && ch <= 'z' ? static_cast<char>( ch - ( 'a' - 'A' ) ) : ch; } );
+      m_uMaxKeyword = std::max( m_uMaxKeyword, stringKeyword.length() );
+      m_vectorKeyword.push_back( std::move( stringKeyword ) );
+   }
+   std::sort( m_vectorKeyword.begin(), m_vectorKeyword.end() );
+   m_vectorKeyword.erase( std::unique( m_vectorKeyword.begin(), m_vectorKeyword.end() ), m_vectorKeyword.end() );
+}
+
+void CSqlLexer::Split( std::string_view stringText, std::vector<token>& vectorToken ) const
+{
+   state state_;
+   Scan( state_, stringText, true, vectorToken );
+}
+
+std::size_t CSqlLexer::Scan( state& state_, std::string_view stringText, bool bEnd, std::vector<token>& vectorToken ) const
+{
+   const char* pbszText = stringText.data();
+   const char* pbszLast = pbszText + stringText.length();
+   const char* pbszToken = pbszText;
+   while( pbszToken < pbszLast )
+   {
+      unsigned uMode = state_.m_uMode;
+      const char* pbszResume = pbszToken + state_.m_uScanned;                   // unfinished token from last part continues here
+      state_ = state();
+      if( uMode == eModeNone )
+      {
+         uMode = mode_s( pbszToken, pbszLast, bEnd, pbszResume );
+         if( uMode == eModeNone ) break;                                       // next part decides what token it is
+      }
+
+      const char* pbszEnd = end_s( uMode, pbszToken, pbszResume, pbszLast, pbszResume );
+      if( pbszEnd == nullptr )
+      {
+         if( bEnd == false )
+         {
+            state_.m_uMode = uMode;
+            state_.m_uScanned = static_cast<uint64_t>( pbszResume - pbszToken );
+            break;
+         }
+         pbszEnd = pbszLast;                                                   // unterminated comment or string ends at end of text
+      }
+
+      uint32_t uKind = eTokenSymbol;
+      switch( uMode )
+      {
+      case eModeWhitespace : uKind = eTokenWhitespace; break;
+      case eModeIdentifier : uKind = IsKeyword( std::string_view( pbszToken, pbszEnd - pbszToken ) ) == true ? eTokenKeyword : eTokenIdentifier; break;
+      case eModeNumber : uKind = eTokenNumber; break;
+      case eModeLineComment : case eModeBlockComment : uKind = eTokenComment; break;
+      case eModeString : uKind = eTokenString; break;
+      case eModeQuoteDouble : case eModeQuoteBracket : case eModeQuoteBacktick : uKind = eTokenIdentifier; break;
+      }
+
+      vectorToken.push_back( { uKind, static_cast<uint64_t>( pbszToken - pbszText ), static_cast<uint64_t>( pbszEnd - pbszToken ) } );
+      pbszToken = pbszEnd;
+   }
+
+   return static_cast<std::size_t>( pbszToken - pbszText );
+}
+
+bool CSqlLexer::IsKeyword( std::string_view stringWord ) const
+{
+   if( stringWord.empty() == true || stringWord.length() > m_uMaxKeyword ) return false;
+
+   auto upper_ = []( char ch ) { return ch >= 'a' && ch <= 'z' ? static_cast<char>( ch - ( 'a' - 'A' ) ) : ch; };
+   auto it = std::lower_bound( m_vectorKeyword.begin(), m_vectorKeyword.end(), stringWord, [&upper_]( const std::string& stringKeyword, std::string_view stringFind ) {
+      return std::lexicographical_compare( stringKeyword.begin(), stringKeyword.end(), stringFind.begin(), stringFind.end(), [&upper_]( char chLeft, char chRight ) { return upper_( chLeft ) < upper_( chRight ); } );
+   } );                                                                        // word is compared in upper case without copy
+   if( it == m_vectorKeyword.end() || it->length() != stringWord.length() ) return false;
+   return std::equal( it->begin(), it->end(), stringWord.begin(), [&upper_]( char chKeyword, char chFind ) { return chKeyword == upper_( chFind ); } );
+}
+
+const std::vector<std::string>& CSqlLexer::keywords_s()
+{
+   static const std::vector<std::string> vectorKeyword_ = {
+      "ADD", "ALL", "ALTER", "AND", "ANY", "AS", "ASC", "BEGIN", "BETWEEN", "BY", "CASE", "CHECK", "COLUMN", "COMMIT", "CONSTRAINT",
+      "CREATE", "CROSS", "DATABASE", "DEFAULT", "DELETE", "DESC", "DISTINCT", "DROP", "ELSE", "END", "EXEC", "EXECUTE", "EXISTS",
+      "FOREIGN", "FROM", "FULL", "FUNCTION", "GO", "GRANT", "GROUP", "HAVING", "IF", "IN", "INDEX", "INNER", "INSERT", "INTO", "IS",
+      "JOIN", "KEY", "LEFT", "LIKE", "NOT", "NULL", "ON", "OR", "ORDER", "OUTER", "PRIMARY", "PROCEDURE", "REFERENCES", "RETURN",
+      "RIGHT", "ROLLBACK", "SELECT", "SET", "TABLE", "THEN", "TOP", "TRANSACTION", "TRIGGER", "TRUNCATE", "UNION", "UNIQUE",
+      "UPDATE", "USE", "VALUES", "VIEW", "WHEN", "WHERE", "WHILE", "WITH",
+   };
+   return vectorKeyword_;
+}
+
+} }
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace application { namespace file {
+
+/**
+ * ## CSqlLexer ===============================================================
+ */
+
+   /**
+    * @brief Split sql text into tokens in one pass, rules can then target token kinds
+    * Lexer is table driven, each byte is classified with a lookup table and
+    * comments, strings and quoted identifiers are searched with memchr for the
+    * character that ends them. Time is linear in text length, also for
+    * unterminated comments and strings (they end at end of text).
+    *
+    * Tokens:
+    * - whitespace, run of space, tab, and line breaks
+    * - comment, `--` to end of line (line break not included) and block comment from `/` `*` to `*` `/` (not nested)
+    * - string, `'...'` with `''` as escaped quote, also `N'...'`
+    * - identifier, names, `@variable`, `#temp`, and quoted names `"..."`, `[...]` and `` `...` ``
+    * - keyword, identifier found in keyword list (case is ignored)
+    * - number, digit followed by digits, letters and dots (`1`, `1.5`, `0x1F`, `1e3`)
+    * - symbol, any other character
+    *
+    * Text can be scanned in parts (streaming), a token that may continue in next
+    * part is kept and scanning resumes where it stopped when more text is added.
+    *
+~~~{.cpp}
+CSqlLexer lexerSql;
+std::vector<CSqlLexer::token> vectorToken;
+lexerSql.Split( "SELECT 'a--b' -- comment\nFROM t", vectorToken ); // keyword, whitespace, string, whitespace, comment, whitespace, keyword, whitespace, identifier
+fileSql.SECTION_Erase( lexerSql, CSqlLexer::eTokenComment );       // drop all comments, '--' inside strings is kept
+~~~
+   */
+   class CSqlLexer
+   {
+   public:
+      enum enumToken : uint32_t
+      {
+         eTokenWhitespace  = 0x01,
+         eTokenComment     = 0x02,
+         eTokenString      = 0x04,
+         eTokenIdentifier  = 0x08,
+         eTokenKeyword     = 0x10,
+         eTokenNumber      = 0x20,
+         eTokenSymbol      = 0x40,
+         eTokenAll         = 0x7f,
+      };
+
+      /// token kind and position in text
+      struct token
+      {
+         uint32_t m_uKind;       ///< token kind (see: `enumToken`)
+         uint64_t m_uOffset;     ///< offset to token in text
+         uint64_t m_uLength;     ///< token length in bytes
+      };
+
+      /// state for text scanned in parts, token that wasn't finished in last part
+      struct state
+      {
+         uint32_t m_uMode = 0;   ///< what is scanned in unfinished token, 0 if none
+         uint64_t m_uScanned = 0;///< bytes scanned in unfinished token, scanning resumes after these
+      };
+
+   public:
+      CSqlLexer();
+      explicit CSqlLexer( const std::vector<std::string>& vectorKeyword );
+      ~CSqlLexer() {}
+
+   public:
+      /// split text into tokens, tokens are appended to vector
+      void Split( std::string_view stringText, std::vector<token>& vectorToken ) const;
+      /**
+       * @brief Scan part of text, tokens that are finished are appended to vector
+       * Text not consumed is the start of an unfinished token, it has to be passed
+       * again at the start of next part (state remembers how much is scanned).
+       * @return std::size_t number of bytes consumed
+       */
+      std::size_t Scan( state& state_, std::string_view stringText, bool bEnd, std::vector<token>& vectorToken ) const;
+
+      /// true if word is in keyword list, case is ignored
+      bool IsKeyword( std::string_view stringWord ) const;
+      const std::vector<std::string>& keywords() const noexcept { return m_vectorKeyword; }
+
+      /// default keywords, sql reserved words
+      static const std::vector<std::string>& keywords_s();
+
+   public:
+      std::vector<std::string> m_vectorKeyword;   ///< upper case keywords, sorted
+      std::size_t m_uMaxKeyword = 0;              ///< length for longest keyword, longer identifiers are not checked
+   };
+
+} }
@@ -19,6 +19,7 @@
 #endif
 
 #include "gd_file.h"
+#include "gd_regex_cache.h"
 
 
 _GD_FILE_BEGIN
@@ -160,15 +161,16 @@ std::vector<std::string> list_files_g(const std::string_view& stringFolder, cons
 {
    std::vector<std::string> vectorFile;
 
+   // ## filter is compiled once, compiled expression is shared with other listings using same filter
+   std::shared_ptr<const std::regex> pregexFilter;
+   if( argumentsFilter["filter"].is_text() ) pregexFilter = gd::regex::cache_g().get<std::regex>( argumentsFilter["filter"].get_string() );
+
    // ## filter method is used when filter is found in arguments, file name is matched against wildcard or regular expression
-   auto filter_ = [](const std::string stringFileName, const auto& argumentFilter) -> bool {
-      if( argumentFilter.is_text() )
+   auto filter_ = [](const std::string& stringFileName, const std::regex* pregexFind) -> bool {
+      if( pregexFind != nullptr )
       {
-         std::string stringFilterOrRegex = argumentFilter.get_string();
-
          std::smatch smatchFirst;
-         std::regex regexFind(stringFilterOrRegex);
-         if( std::regex_search(stringFileName, smatchFirst, regexFind) == false ) return false; // not matched
+         if( std::regex_search(stringFileName, smatchFirst, *pregexFind) == false ) return false; // not matched
       }
       return true;
    };
@@ -214,7 +216,7 @@ std::vector<std::string> list_files_g(const std::string_view& stringFolder, cons
 
       const std::string stringFile = itFile.path().filename().string();
 
-      if( filter_(stringFile, argumentsFilter["filter"]) == false ) continue;    // filter using regex or wildcard
+      if( filter_(stringFile, pregexFilter.get()) == false ) continue;           // filter using regex or wildcard
 
       if( day_count_(itFile.path(), argumentsFilter["to_days"]) == false ) continue;// filter on time (days ?)
 
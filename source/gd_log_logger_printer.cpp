@@ -304,21 +304,21 @@ std::pair<bool, std::string> printer_file::file_write_s(int iFileHandle, const s
 {                                                                                assert( iFileHandle >= 0 );
    enum { eBufferSize = 100 };
    char pBuffer[eBufferSize];
-   std::unique_ptr<char> pHeap;
+   std::unique_ptr<char[]> pHeap;
    char* pbszUtf8Text = pBuffer;
 
    // ## convert unicode text to utf8
-   auto uUtf8Size = gd::utf8::size(stringText.data());                           // how big buffer is needed to store unicode as utf8 text
-   uUtf8Size++;                                                                  // make room for zero terminator
+   const wchar_t* pwszEnd = stringText.data() + stringText.length();
+   auto uUtf8Size = gd::utf8::size(stringText.data(), pwszEnd);                  // exact size needed to store unicode as utf8 text
    if( uUtf8Size > static_cast<decltype(uUtf8Size)>(eBufferSize) )
    {  // cant fit in local buffer, allocate on heap
       pHeap.reset(new char[uUtf8Size]);
       pbszUtf8Text = pHeap.get();
    }
 
-   gd::utf8::convert_unicode(stringText.data(), pbszUtf8Text, pbszUtf8Text + uUtf8Size );
+   uint8_t* pubEnd = gd::utf8::convert(stringText.data(), pwszEnd, reinterpret_cast<uint8_t*>(pbszUtf8Text));
 
-   return file_write_s( iFileHandle, pbszUtf8Text );
+   return file_write_s( iFileHandle, std::string_view( pbszUtf8Text, reinterpret_cast<char*>(pubEnd) - pbszUtf8Text ) );
 }
 
 void printer_file::file_close_s(int iFileHandle)
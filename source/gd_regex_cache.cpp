@@ -0,0 +1,70 @@
+#include <format>
+#include <mutex>
+
+#include "gd_regex_cache.h"
+
+
+_GD_REGEX_BEGIN
+
+std::size_t cache::size() const
+{
+   std::shared_lock<std::shared_mutex> lock_( m_sharedmutex );
+   return m_mapRegex.size();
+}
+
+void cache::clear()
+{
+   std::unique_lock<std::shared_mutex> lock_( m_sharedmutex );
+   m_mapRegex.clear();
+}
+
+/**
+ * @brief Find compiled expression, readers do not block each other
+ * @param stringKey key for expression (see: `key_s`)
+ * @return std::shared_ptr<const void> compiled expression or nullptr if not found
+ */
+std::shared_ptr<const void> cache::find( const std::string& stringKey )
+{
+   {
+      std::shared_lock<std::shared_mutex> lock_( m_sharedmutex );
+      auto it = m_mapRegex.find( stringKey );
+      if( it != m_mapRegex.end() )
+      {
+         m_uHit++;
+         return it->second;
+      }
+   }
+
+   m_uMiss++;
+   return nullptr;
+}
+
+/**
+ * @brief Insert compiled expression, if key was inserted by another thread the stored expression is returned
+ * Expression is compiled before lock is taken so threads searching in cache are not blocked while compiling.
+ * @param stringKey key for expression (see: `key_s`)
+ * @param pregex compiled expression
+ * @return std::shared_ptr<const void> expression stored in cache for key
+ */
+std::shared_ptr<const void> cache::insert( std::string&& stringKey, std::shared_ptr<const void> pregex )
+{
+   std::unique_lock<std::shared_mutex> lock_( m_sharedmutex );
+   if( m_mapRegex.size() >= max_size() && m_mapRegex.find( stringKey ) == m_mapRegex.end() ) m_mapRegex.clear();// full, expressions in use are owned by callers
+
+   auto [it, bInserted] = m_mapRegex.try_emplace( std::move( stringKey ), std::move( pregex ) );
+   return it->second;
+}
+
+std::string cache::key_s( std::string_view stringEngine, uint64_t uSyntax, std::string_view stringPattern )
+{
+   return std::format( "{}:{}:{}:{}", stringEngine.length(), stringEngine, uSyntax, stringPattern );// length prefix, engine name may contain any character
+}
+
+/// process wide cache, created first time it is used
+cache& cache_g()
+{
+   static cache cache_;
+   return cache_;
+}
+
+_GD_REGEX_END
@@ -0,0 +1,119 @@
+/**
+ * \file gd_regex_cache.h
+ *
+ * \brief Process wide cache with compiled regular expressions
+ *
+ * Compiling a regular expression costs much more than most searches with it.
+ * Code that matches the same pattern for each file in a folder or each file in
+ * a batch should take the compiled expression from the cache instead of
+ * building it again. Entries are keyed by engine (regex type), syntax flags
+ * and pattern. Compiled expressions are shared and immutable, any number of
+ * threads can search with the same expression.
+ *
+ *
+
+-------------------------------------------------
+*take compiled expressions from the process wide cache*
+```cpp
+auto pregexSql = gd::regex::cache_g().get<boost::regex>( R"(--[^\r\n]*)" );
+auto pregexFile = gd::regex::cache_g().get<std::regex>( R"(^log_\d+\.txt$)", std::regex::ECMAScript | std::regex::icase );
+
+bool bMatch = std::regex_search( stringFile, *pregexFile );
+
+std::cout << "hit: " << gd::regex::cache_g().hit() << " miss: " << gd::regex::cache_g().miss() << "\n";
+```
+
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+
+
+#ifndef _GD_REGEX_BEGIN
+
+#  define _GD_REGEX_BEGIN namespace gd { namespace regex {
+#  define _GD_REGEX_END } }
+
+#endif
+
+_GD_REGEX_BEGIN
+
+/**
+ * @brief Thread safe cache for compiled regular expressions
+ * Works with any regex type that can be constructed from a character range and
+ * syntax flags (`std::regex`, `boost::regex`). Regex type is part of the key so
+ * the same pattern compiled by different engines is stored in different entries.
+ * When cache is full all entries are released, expressions in use are kept
+ * alive by callers until they are done with them.
+ */
+class cache
+{
+public:
+   cache() {}
+   explicit cache( std::size_t uMaxSize ): m_uMaxSize( uMaxSize ) {}
+   cache( const cache& ) = delete;
+   cache& operator=( const cache& ) = delete;
+   ~cache() {}
+
+public:
+   /// expressions found in cache
+   uint64_t hit() const noexcept { return m_uHit; }
+   /// expressions compiled because they were not found
+   uint64_t miss() const noexcept { return m_uMiss; }
+   void clear_statistics() { m_uHit = 0; m_uMiss = 0; }
+
+   std::size_t max_size() const noexcept { return m_uMaxSize.load( std::memory_order_relaxed ); }
+   void max_size( std::size_t uMaxSize ) { m_uMaxSize.store( uMaxSize, std::memory_order_relaxed ); }
+   std::size_t size() const;
+   void clear();
+
+   /**
+    * @brief Get compiled regular expression for pattern, expression is compiled and stored if not found
+    * Errors compiling pattern are thrown by regex type (`std::regex_error` or `boost::regex_error`), nothing is stored then.
+    * @param stringPattern regular expression pattern
+    * @param uSyntax syntax flags for regex type
+    * @return std::shared_ptr<const REGEX> compiled regular expression
+    */
+   template<typename REGEX>
+   std::shared_ptr<const REGEX> get( std::string_view stringPattern, typename REGEX::flag_type uSyntax = REGEX::ECMAScript )
+   {
+      std::string stringKey = key_s( typeid( REGEX ).name(), static_cast<uint64_t>( uSyntax ), stringPattern );
+      auto pregex_ = find( stringKey );
+      if( pregex_ == nullptr )
+      {
+         pregex_ = std::make_shared<const REGEX>( stringPattern.data(), stringPattern.data() + stringPattern.length(), uSyntax );
+         pregex_ = insert( std::move( stringKey ), std::move( pregex_ ) );
+      }
+      return std::static_pointer_cast<const REGEX>( pregex_ );
+   }
+
+   /// find compiled expression for key, counts hit or miss
+   std::shared_ptr<const void> find( const std::string& stringKey );
+   /// insert compiled expression for key, returns expression that is stored if another thread was first
+   std::shared_ptr<const void> insert( std::string&& stringKey, std::shared_ptr<const void> pregex );
+
+   /// text identifying compiled expression (engine, syntax flags and pattern)
+   static std::string key_s( std::string_view stringEngine, uint64_t uSyntax, std::string_view stringPattern );
+
+public:
+   mutable std::shared_mutex m_sharedmutex;                                    ///< readers search in parallel, insert locks
+   std::unordered_map<std::string, std::shared_ptr<const void>> m_mapRegex;     ///< compiled expressions for key
+   std::atomic<std::size_t> m_uMaxSize{ 1024 };                                 ///< max number of expressions before cache is cleared, may be changed while cache is used
+   std::atomic<uint64_t> m_uHit{ 0 };                                           ///< expressions found in cache
+   std::atomic<uint64_t> m_uMiss{ 0 };                                          ///< expressions compiled
+};
+
+/// process wide cache shared by file listing, sections and batch conversions
+cache& cache_g();
+
+_GD_REGEX_END
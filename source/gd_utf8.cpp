@@ -3,6 +3,21 @@
 #include <stdexcept>
 #include <initializer_list>
 #include <vector>
+#include <atomic>
+#include <bit>
+#include <algorithm>
+#include <cstring>
+
+#if defined( _M_X64 ) || defined( __x86_64__ )
+#  define GD_UTF8_SIMD_X86
+#  include <immintrin.h>
+#  if defined( _MSC_VER )
+#    include <intrin.h>
+#    define GD_UTF8_TARGET_AVX2
+#  else
+#    define GD_UTF8_TARGET_AVX2 __attribute__(( target( "avx2,popcnt" ) ))
+#  endif
+#endif
 
 #include "gd_utf8.hpp"
 
@@ -218,6 +233,871 @@ namespace gd {
          return 0;
       }
 
+      /// true if utf16 unit at position starts a valid surrogate pair
+      static inline bool is_pair_s( const char16_t* pwszPosition, const char16_t* pwszEnd )
+      {
+         return ( pwszPosition[0] & 0xfc00 ) == 0xd800 && pwszPosition + 1 < pwszEnd && ( pwszPosition[1] & 0xfc00 ) == 0xdc00;
+      }
+
+      /// add utf8 size for utf16 character at position, surrogate pair is 4 bytes and lone surrogates are stored as 3 bytes
+      static inline const char16_t* size_step_s( const char16_t* pwszPosition, const char16_t* pwszEnd, uint32_t& uSize )
+      {
+         char16_t uUnit = *pwszPosition;
+         if( uUnit < 0x80 ) uSize += 1;
+         else if( uUnit < 0x800 ) uSize += 2;
+         else if( is_pair_s( pwszPosition, pwszEnd ) == true ) { uSize += 4; return pwszPosition + 2; }
+         else uSize += 3;
+         return pwszPosition + 1;
+      }
+
+      /// convert utf16 character at position to utf8, returns position for next character
+      static inline const char16_t* convert_step_s( const char16_t* pwszPosition, const char16_t* pwszEnd, uint8_t*& pubTo )
+      {
+         if( is_pair_s( pwszPosition, pwszEnd ) == true )
+         {
+            uint32_t uCharacter = 0x10000 + ( ( static_cast<uint32_t>( pwszPosition[0] ) - 0xd800 ) << 10 ) + ( static_cast<uint32_t>( pwszPosition[1] ) - 0xdc00 );
+            pubTo += convert( uCharacter, pubTo );
+            return pwszPosition + 2;
+         }
+         pubTo += convert( static_cast<uint32_t>( *pwszPosition ), pubTo );
+         return pwszPosition + 1;
+      }
+
+      /// utf8 size for utf32 character, same as bytes written by `convert( uint32_t, uint8_t* )`
+      static inline uint32_t size32_s( uint32_t uCharacter )
+      {
+         return 1 + ( uCharacter >= 0x80 ) + ( uCharacter >= 0x800 ) + ( uCharacter >= 0x10000 );
+      }
+
+      /// convert utf8 character at position to utf16, stray continuation bytes are skipped and each lead byte gives one unit (two for 4 byte leads)
+      static inline const uint8_t* convert_step_s( const uint8_t* pubPosition, const uint8_t* pubEnd, char16_t*& pwszTo )
+      {
+         uint32_t uLead = *pubPosition++;
+         if( uLead < 0x80 ) { *pwszTo++ = static_cast<char16_t>( uLead ); return pubPosition; }
+         if( uLead < 0xc0 ) return pubPosition;                                // continuation byte without lead
+
+         uint32_t uTail = uLead < 0xe0 ? 1 : ( uLead < 0xf0 ? 2 : 3 );
+         uint32_t uCharacter = uLead & ( 0x3f >> uTail );
+         for( ; uTail > 0 && pubPosition < pubEnd && ( *pubPosition & 0xc0 ) == 0x80; uTail--, pubPosition++ ) uCharacter = ( uCharacter << 6 ) | ( *pubPosition & 0x3f );
+
+         if( uLead < 0xf0 ) { *pwszTo++ = static_cast<char16_t>( uCharacter ); return pubPosition; }
+
+         uCharacter = std::clamp( uCharacter, 0x10000u, 0x10ffffu ) - 0x10000;  // 4 byte lead always gives surrogate pair
+         pwszTo[0] = static_cast<char16_t>( 0xd800 + ( uCharacter >> 10 ) );
+         pwszTo[1] = static_cast<char16_t>( 0xdc00 + ( uCharacter & 0x3ff ) );
+         pwszTo += 2;
+         return pubPosition;
+      }
+
+      /**
+       * ## simd ==============================================================
+       * Validate and count using 16 (SSE2) or 32 (AVX2) bytes at the time.
+       * Each byte in block is classified as continuation or lead byte using
+       * signed compares, masks are used to check that every lead byte is
+       * followed by the right number of continuation bytes. Blocks that fail
+       * are checked again with the scalar version from last character start
+       * so results are the same as the scalar version.
+       */
+
+      namespace simd {
+         static std::atomic<unsigned> uLevel_s{ 0xffffffff };                 // active level, 0xffffffff = not selected
+
+         /// highest simd level supported by cpu and operating system
+         unsigned level_supported()
+         {
+#ifdef GD_UTF8_SIMD_X86
+#  if defined( _MSC_VER )
+            int piRegister[4];
+            __cpuid( piRegister, 0 );
+            if( piRegister[0] >= 7 )
+            {
+               __cpuid( piRegister, 1 );
+               bool bOsXSave = ( piRegister[2] & ( 1 << 27 ) ) != 0;
+               bool bAvx = ( piRegister[2] & ( 1 << 28 ) ) != 0;
+               if( bOsXSave == true && bAvx == true && ( _xgetbv( 0 ) & 0x06 ) == 0x06 )// os saves ymm registers
+               {
+                  __cpuidex( piRegister, 7, 0 );
+                  if( ( piRegister[1] & ( 1 << 5 ) ) != 0 ) return eLevelAVX2;
+               }
+            }
+#  else
+            __builtin_cpu_init();
+            if( __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "popcnt" ) ) return eLevelAVX2;
+#  endif
+            return eLevelSSE2;                                                 // SSE2 is always available on x64
+#else
+            return eLevelScalar;
+#endif
+         }
+
+         unsigned level()
+         {
+            unsigned uLevel = uLevel_s.load( std::memory_order_relaxed );
+            if( uLevel == 0xffffffff )
+            {
+               uLevel = level_supported();
+               uLevel_s.store( uLevel, std::memory_order_relaxed );
+            }
+            return uLevel;
+         }
+
+         unsigned level( unsigned uLevel )
+         {
+            unsigned uSupported = level_supported();
+            if( uLevel > uSupported ) uLevel = uSupported;
+            uLevel_s.store( uLevel, std::memory_order_relaxed );
+            return uLevel;
+         }
+      }
+
+#ifdef GD_UTF8_SIMD_X86
+
+      /// masks for bytes in block, bit is set for each byte of that type
+      struct block_mask
+      {
+         uint64_t m_uContinuation;  ///< 0x80 - 0xBF
+         uint64_t m_uLead2;         ///< 0xC2 - 0xDF
+         uint64_t m_uLead3;         ///< 0xE0 - 0xEF
+         uint64_t m_uLead4;         ///< 0xF0 - 0xF4
+         uint64_t m_uInvalid;       ///< 0xC0, 0xC1, 0xF5 - 0xFF
+      };
+
+      /**
+       * @brief check block masks, every lead byte needs continuation bytes and every continuation byte needs lead byte
+       * @param mask_ masks for block
+       * @param uWidth block width in bytes
+       * @param uCarry continuation bytes needed from previous block, gets continuation bytes needed in next block
+       * @return true if block is valid
+      */
+      static inline bool validate_mask_s( const block_mask& mask_, unsigned uWidth, uint64_t& uCarry )
+      {
+         uint64_t uRequired = uCarry | ( ( mask_.m_uLead2 | mask_.m_uLead3 | mask_.m_uLead4 ) << 1 ) | ( ( mask_.m_uLead3 | mask_.m_uLead4 ) << 2 ) | ( mask_.m_uLead4 << 3 );
+         uint64_t uBlock = ( uint64_t(1) << uWidth ) - 1;
+         uCarry = uRequired >> uWidth;
+         return mask_.m_uInvalid == 0 && ( uRequired & uBlock ) == mask_.m_uContinuation;
+      }
+
+      /**
+       * @brief count characters in block, result is the same as `scalar::count` also for invalid text
+       * If every lead byte is followed by its continuation bytes all bytes that
+       * aren't continuation bytes are counted. Otherwise a lead byte takes bytes
+       * that aren't continuation bytes and block is counted one character at the
+       * time, as `scalar::count` does.
+       * @param mask_ masks for block
+       * @param pubBlock start of block
+       * @param uWidth block width in bytes (max 32)
+       * @param uSkip bytes at start of block taken by character in previous block, gets bytes taken in next block
+       * @return number of characters starting in block
+      */
+      static inline uint32_t count_mask_s( const block_mask& mask_, const uint8_t* pubBlock, unsigned uWidth, unsigned& uSkip )
+      {                                                                        assert( uWidth <= 32 ); assert( uSkip < 4 );
+         uint64_t uRequired = ( ( uint64_t(1) << uSkip ) - 1 ) | ( ( mask_.m_uLead2 | mask_.m_uLead3 | mask_.m_uLead4 ) << 1 ) | ( ( mask_.m_uLead3 | mask_.m_uLead4 ) << 2 ) | ( mask_.m_uLead4 << 3 );
+         uint64_t uBlock = ( uint64_t(1) << uWidth ) - 1;
+         if( ( uRequired & uBlock & ~mask_.m_uContinuation ) == 0 )
+         {
+            uSkip = static_cast<unsigned>( std::bit_width( uRequired >> uWidth ) );
+            return uWidth - static_cast<uint32_t>( std::popcount( mask_.m_uContinuation ) );
+         }
+
+         // ## lead byte without all continuation bytes, same steps as scalar count
+         uint32_t uCount = 0;
+         const uint8_t* pubPosition = pubBlock + uSkip;
+         const uint8_t* pubBlockEnd = pubBlock + uWidth;
+         while( pubPosition < pubBlockEnd )
+         {
+            auto uSize = pNeededByteCount_s[*pubPosition];
+            if( uSize == 0 )
+            {
+               if( (*pubPosition & UTF8_VALIDATE_TAIL_MASK) != UTF8_MIN_ENCODE ) uCount++;
+               pubPosition++;
+               continue;
+            }
+            pubPosition += uSize;
+            uCount++;
+         }
+         uSkip = static_cast<unsigned>( pubPosition - pubBlockEnd );
+         return uCount;
+      }
+
+      // ## SSE2, 16 bytes
+
+      /// mask for bytes in signed range, bytes from 0x80 are negative
+      static inline uint64_t range_sse2_s( __m128i v_, char iFirst, char iLast )
+      {
+         __m128i vRange = _mm_and_si128( _mm_cmpgt_epi8( v_, _mm_set1_epi8( iFirst - 1 ) ), _mm_cmplt_epi8( v_, _mm_set1_epi8( iLast + 1 ) ) );
+         return static_cast<uint32_t>( _mm_movemask_epi8( vRange ) );
+      }
+
+      static inline block_mask classify_sse2_s( __m128i v_ )
+      {
+         block_mask mask_;
+         mask_.m_uContinuation = static_cast<uint32_t>( _mm_movemask_epi8( _mm_cmplt_epi8( v_, _mm_set1_epi8( (char)0xC0 ) ) ) );
+         mask_.m_uLead2 = range_sse2_s( v_, (char)0xC2, (char)0xDF );
+         mask_.m_uLead3 = range_sse2_s( v_, (char)0xE0, (char)0xEF );
+         mask_.m_uLead4 = range_sse2_s( v_, (char)0xF0, (char)0xF4 );
+         uint64_t uHigh = static_cast<uint32_t>( _mm_movemask_epi8( v_ ) );
+         mask_.m_uInvalid = uHigh & ~( mask_.m_uContinuation | mask_.m_uLead2 | mask_.m_uLead3 | mask_.m_uLead4 );
+         return mask_;
+      }
+
+      static std::pair<bool, const uint8_t*> validate_sse2_s( const uint8_t* pubBegin, const uint8_t* pubEnd )
+      {
+         const uint8_t* pubPosition = pubBegin;
+         const uint8_t* pubCharacter = pubBegin;                               // last known start of character
+         uint64_t uCarry = 0;
+         while( pubEnd - pubPosition >= 16 )
+         {
+            __m128i v_ = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pubPosition ) );
+            if( _mm_movemask_epi8( v_ ) != 0 || uCarry != 0 )
+            {
+               if( validate_mask_s( classify_sse2_s( v_ ), 16, uCarry ) == false ) break;
+            }
+            pubPosition += 16;
+            if( uCarry == 0 ) pubCharacter = pubPosition;
+         }
+
+         return scalar::validate( pubCharacter, pubEnd );                     // tail or block with error
+      }
+
+      static std::pair<uint32_t, const uint8_t*> count_sse2_s( const uint8_t* pubszText, const uint8_t* pubszEnd, unsigned uSkip = 0 )
+      {
+         uint32_t uCount = 0;
+         const uint8_t* pubPosition = pubszText;
+         while( pubszEnd - pubPosition >= 16 )
+         {
+            __m128i v_ = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pubPosition ) );
+            if( _mm_movemask_epi8( v_ ) == 0 && uSkip == 0 ) uCount += 16;     // ascii
+            else uCount += count_mask_s( classify_sse2_s( v_ ), pubPosition, 16, uSkip );
+            pubPosition += 16;
+         }
+
+         pubPosition += std::min<std::size_t>( uSkip, pubszEnd - pubPosition ); // bytes taken by last character in blocks
+         auto [uTail, pubTailEnd] = scalar::count( pubPosition, pubszEnd );
+         return { uCount + uTail, pubTailEnd };
+      }
+
+      // ## AVX2, 32 bytes
+
+      /// mask for bytes in signed range, bytes from 0x80 are negative
+      GD_UTF8_TARGET_AVX2 static inline uint64_t range_avx2_s( __m256i v_, char iFirst, char iLast )
+      {
+         __m256i vRange = _mm256_and_si256( _mm256_cmpgt_epi8( v_, _mm256_set1_epi8( iFirst - 1 ) ), _mm256_cmpgt_epi8( _mm256_set1_epi8( iLast + 1 ), v_ ) );
+         return static_cast<uint32_t>( _mm256_movemask_epi8( vRange ) );
+      }
+
+      GD_UTF8_TARGET_AVX2 static inline block_mask classify_avx2_s( __m256i v_ )
+      {
+         block_mask mask_;
+         mask_.m_uContinuation = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpgt_epi8( _mm256_set1_epi8( (char)0xC0 ), v_ ) ) );
+         mask_.m_uLead2 = range_avx2_s( v_, (char)0xC2, (char)0xDF );
+         mask_.m_uLead3 = range_avx2_s( v_, (char)0xE0, (char)0xEF );
+         mask_.m_uLead4 = range_avx2_s( v_, (char)0xF0, (char)0xF4 );
+         uint64_t uHigh = static_cast<uint32_t>( _mm256_movemask_epi8( v_ ) );
+         mask_.m_uInvalid = uHigh & ~( mask_.m_uContinuation | mask_.m_uLead2 | mask_.m_uLead3 | mask_.m_uLead4 );
+         return mask_;
+      }
+
+      GD_UTF8_TARGET_AVX2 static std::pair<bool, const uint8_t*> validate_avx2_s( const uint8_t* pubBegin, const uint8_t* pubEnd )
+      {
+         const uint8_t* pubPosition = pubBegin;
+         const uint8_t* pubCharacter = pubBegin;                               // last known start of character
+         uint64_t uCarry = 0;
+         while( pubEnd - pubPosition >= 32 )
+         {
+            __m256i v_ = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pubPosition ) );
+            if( _mm256_movemask_epi8( v_ ) != 0 || uCarry != 0 )
+            {
+               if( validate_mask_s( classify_avx2_s( v_ ), 32, uCarry ) == false ) break;
+            }
+            pubPosition += 32;
+            if( uCarry == 0 ) pubCharacter = pubPosition;
+         }
+
+         return scalar::validate( pubCharacter, pubEnd );                     // tail or block with error
+      }
+
+      GD_UTF8_TARGET_AVX2 static std::pair<uint32_t, const uint8_t*> count_avx2_s( const uint8_t* pubszText, const uint8_t* pubszEnd )
+      {
+         uint64_t uCount = 0;
+         unsigned uSkip = 0;                                                   // bytes in block taken by character in previous block
+         const uint8_t* pubPosition = pubszText;
+         while( pubszEnd - pubPosition >= 32 )
+         {
+            __m256i v_ = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pubPosition ) );
+            if( _mm256_movemask_epi8( v_ ) == 0 && uSkip == 0 ) uCount += 32;  // ascii
+            else uCount += count_mask_s( classify_avx2_s( v_ ), pubPosition, 32, uSkip );
+            pubPosition += 32;
+         }
+
+         auto [uTail, pubTailEnd] = count_sse2_s( pubPosition, pubszEnd, uSkip );
+         return { static_cast<uint32_t>( uCount + uTail ), pubTailEnd };
+      }
+
+      // ## find, positions where first byte and second byte (offset uSecond) match are compared with memcmp
+
+      static const uint8_t* find_sse2_s( const uint8_t* pubPosition, const uint8_t* pubEnd, const uint8_t* pubFind, uint32_t uSize, uint32_t uSecond )
+      {                                                                        assert( uSize > 1 ); assert( uSecond < uSize );
+         const __m128i vFirst = _mm_set1_epi8( (char)pubFind[0] );
+         const __m128i vSecond = _mm_set1_epi8( (char)pubFind[uSecond] );
+         const uint8_t* pubLast = pubEnd - uSize;                              // last position where text can start
+         while( pubLast - pubPosition >= 15 )                                  // 16 positions, loads stay within pubEnd
+         {
+            __m128i v1_ = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pubPosition ) );
+            __m128i v2_ = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pubPosition + uSecond ) );
+            unsigned uMask = static_cast<unsigned>( _mm_movemask_epi8( _mm_and_si128( _mm_cmpeq_epi8( v1_, vFirst ), _mm_cmpeq_epi8( v2_, vSecond ) ) ) );
+            while( uMask != 0 )
+            {
+               const uint8_t* pubMatch = pubPosition + std::countr_zero( uMask );
+               if( memcmp( pubMatch, pubFind, uSize ) == 0 ) return pubMatch;
+               uMask &= uMask - 1;
+            }
+            pubPosition += 16;
+         }
+
+         return scalar::find( pubPosition, pubEnd, pubFind, uSize );
+      }
+
+      GD_UTF8_TARGET_AVX2 static const uint8_t* find_avx2_s( const uint8_t* pubPosition, const uint8_t* pubEnd, const uint8_t* pubFind, uint32_t uSize, uint32_t uSecond )
+      {                                                                        assert( uSize > 1 ); assert( uSecond < uSize );
+         const __m256i vFirst = _mm256_set1_epi8( (char)pubFind[0] );
+         const __m256i vSecond = _mm256_set1_epi8( (char)pubFind[uSecond] );
+         const uint8_t* pubLast = pubEnd - uSize;
+         while( pubLast - pubPosition >= 31 )
+         {
+            __m256i v1_ = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pubPosition ) );
+            __m256i v2_ = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pubPosition + uSecond ) );
+            uint32_t uMask = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_and_si256( _mm256_cmpeq_epi8( v1_, vFirst ), _mm256_cmpeq_epi8( v2_, vSecond ) ) ) );
+            while( uMask != 0 )
+            {
+               const uint8_t* pubMatch = pubPosition + std::countr_zero( uMask );
+               if( memcmp( pubMatch, pubFind, uSize ) == 0 ) return pubMatch;
+               uMask &= uMask - 1;
+            }
+            pubPosition += 32;
+         }
+
+         return find_sse2_s( pubPosition, pubEnd, pubFind, uSize, uSecond );
+      }
+
+      // ## squeeze, blocks without marker are stored as is, mixed blocks are compacted byte by byte
+
+      static std::pair<uint32_t, uint8_t*> squeeze_sse2_s( uint8_t* pubPosition, uint8_t* pubEnd, uint8_t uMarker )
+      {                                                                        assert( uMarker < 0x80 );
+         uint32_t uCount = 0;
+         uint8_t* pubInsert = pubPosition;                                     // write position, never after read position
+         const __m128i vMarker = _mm_set1_epi8( (char)uMarker );
+         const __m128i vContinuation = _mm_set1_epi8( (char)0xC0 );
+         while( pubEnd - pubPosition >= 16 )
+         {
+            __m128i v_ = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pubPosition ) );
+            uint32_t uRemove = static_cast<uint32_t>( _mm_movemask_epi8( _mm_cmpeq_epi8( v_, vMarker ) ) );
+            uint32_t uContinuation = static_cast<uint32_t>( _mm_movemask_epi8( _mm_cmplt_epi8( v_, vContinuation ) ) );
+            uCount += 16 - std::popcount( uContinuation ) - std::popcount( uRemove );
+            if( uRemove == 0 )
+            {
+               _mm_storeu_si128( reinterpret_cast<__m128i*>( pubInsert ), v_ );
+               pubInsert += 16;
+            }
+            else if( uRemove != 0xffff )
+            {
+               for( uint32_t uKeep = ~uRemove & 0xffff; uKeep != 0; uKeep &= uKeep - 1 ) *pubInsert++ = pubPosition[std::countr_zero( uKeep )];
+            }
+            pubPosition += 16;
+         }
+
+         auto [uTail, pubTailEnd] = scalar::squeeze( pubPosition, pubEnd, uMarker );
+         if( pubInsert != pubPosition ) memmove( pubInsert, pubPosition, pubTailEnd - pubPosition );
+         return { uCount + uTail, pubInsert + ( pubTailEnd - pubPosition ) };
+      }
+
+      GD_UTF8_TARGET_AVX2 static std::pair<uint32_t, uint8_t*> squeeze_avx2_s( uint8_t* pubPosition, uint8_t* pubEnd, uint8_t uMarker )
+      {                                                                        assert( uMarker < 0x80 );
+         uint32_t uCount = 0;
+         uint8_t* pubInsert = pubPosition;                                     // write position, never after read position
+         const __m256i vMarker = _mm256_set1_epi8( (char)uMarker );
+         const __m256i vContinuation = _mm256_set1_epi8( (char)0xC0 );
+         while( pubEnd - pubPosition >= 32 )
+         {
+            __m256i v_ = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pubPosition ) );
+            uint32_t uRemove = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( v_, vMarker ) ) );
+            uint32_t uContinuation = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpgt_epi8( vContinuation, v_ ) ) );
+            uCount += 32 - _mm_popcnt_u32( uContinuation ) - _mm_popcnt_u32( uRemove );
+            if( uRemove == 0 )
+            {
+               _mm256_storeu_si256( reinterpret_cast<__m256i*>( pubInsert ), v_ );
+               pubInsert += 32;
+            }
+            else if( uRemove != 0xffffffff )
+            {
+               for( uint32_t uKeep = ~uRemove; uKeep != 0; uKeep &= uKeep - 1 ) *pubInsert++ = pubPosition[std::countr_zero( uKeep )];
+            }
+            pubPosition += 32;
+         }
+
+         auto [uTail, pubTailEnd] = squeeze_sse2_s( pubPosition, pubEnd, uMarker );// tail is less than 32 bytes
+         if( pubInsert != pubPosition ) memmove( pubInsert, pubPosition, pubTailEnd - pubPosition );
+         return { uCount + uTail, pubInsert + ( pubTailEnd - pubPosition ) };
+      }
+
+      /// check 64 bytes in each round, high bits from all blocks are combined before the test
+      static bool is_ascii_sse2_s( const uint8_t* pubPosition, const uint8_t* pubEnd )
+      {
+         while( pubEnd - pubPosition >= 64 )
+         {
+            __m128i v_ = _mm_or_si128( _mm_or_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( pubPosition ) ), _mm_loadu_si128( reinterpret_cast<const __m128i*>( pubPosition + 16 ) ) ),
+                                       _mm_or_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( pubPosition + 32 ) ), _mm_loadu_si128( reinterpret_cast<const __m128i*>( pubPosition + 48 ) ) ) );
+            if( _mm_movemask_epi8( v_ ) != 0 ) return false;
+            pubPosition += 64;
+         }
+
+         for( ; pubEnd - pubPosition >= 16; pubPosition += 16 )
+         {
+            if( _mm_movemask_epi8( _mm_loadu_si128( reinterpret_cast<const __m128i*>( pubPosition ) ) ) != 0 ) return false;
+         }
+
+         return scalar::is_ascii( pubPosition, pubEnd );
+      }
+
+      GD_UTF8_TARGET_AVX2 static bool is_ascii_avx2_s( const uint8_t* pubPosition, const uint8_t* pubEnd )
+      {
+         while( pubEnd - pubPosition >= 128 )
+         {
+            __m256i v_ = _mm256_or_si256( _mm256_or_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pubPosition ) ), _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pubPosition + 32 ) ) ),
+                                          _mm256_or_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pubPosition + 64 ) ), _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pubPosition + 96 ) ) ) );
+            if( _mm256_movemask_epi8( v_ ) != 0 ) return false;
+            pubPosition += 128;
+         }
+
+         return is_ascii_sse2_s( pubPosition, pubEnd );
+      }
+
+      /// utf8 size for utf16 text, 8 units at the time. Blocks with surrogates are sized one character at the time
+      static uint32_t size16_sse2_s( const char16_t* pwszPosition, const char16_t* pwszEnd )
+      {
+         uint32_t uSize = 0;
+         const __m128i vZero = _mm_setzero_si128();
+         const __m128i vAscii = _mm_set1_epi16( (short)0xff80 );
+         const __m128i vTwo = _mm_set1_epi16( (short)0xf800 );
+         const __m128i vSurrogate = _mm_set1_epi16( (short)0xd800 );
+         while( pwszEnd - pwszPosition >= 8 )
+         {
+            __m128i v_ = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pwszPosition ) );
+            __m128i vHigh = _mm_and_si128( v_, vTwo );
+            if( _mm_movemask_epi8( _mm_cmpeq_epi16( vHigh, vSurrogate ) ) == 0 )
+            {
+               uint32_t uOne = static_cast<uint32_t>( _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128( v_, vAscii ), vZero ) ) );// two bits for each unit below 0x80
+               uint32_t uTwo = static_cast<uint32_t>( _mm_movemask_epi8( _mm_cmpeq_epi16( vHigh, vZero ) ) );// two bits for each unit below 0x800
+               uSize += 24 - ( std::popcount( uOne ) + std::popcount( uTwo ) ) / 2;
+               pwszPosition += 8;
+            }
+            else
+            {
+               for( const char16_t* pwszBlock = pwszPosition + 8; pwszPosition < pwszBlock; ) pwszPosition = size_step_s( pwszPosition, pwszEnd, uSize );
+            }
+         }
+
+         while( pwszPosition < pwszEnd ) pwszPosition = size_step_s( pwszPosition, pwszEnd, uSize );
+         return uSize;
+      }
+
+      /// convert utf16 to utf8, blocks with 8 ascii units are packed and stored, other blocks are converted one character at the time
+      static uint8_t* convert16_sse2_s( const char16_t* pwszPosition, const char16_t* pwszEnd, uint8_t* pubTo )
+      {
+         const __m128i vZero = _mm_setzero_si128();
+         const __m128i vAscii = _mm_set1_epi16( (short)0xff80 );
+         while( pwszEnd - pwszPosition >= 8 )
+         {
+            __m128i v_ = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pwszPosition ) );
+            if( _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128( v_, vAscii ), vZero ) ) == 0xffff )
+            {
+               _mm_storel_epi64( reinterpret_cast<__m128i*>( pubTo ), _mm_packus_epi16( v_, v_ ) );
+               pubTo += 8;
+               pwszPosition += 8;
+            }
+            else
+            {
+               for( const char16_t* pwszBlock = pwszPosition + 8; pwszPosition < pwszBlock; ) pwszPosition = convert_step_s( pwszPosition, pwszEnd, pubTo );
+            }
+         }
+
+         while( pwszPosition < pwszEnd ) pwszPosition = convert_step_s( pwszPosition, pwszEnd, pubTo );
+         return pubTo;
+      }
+
+      /// utf8 size for utf32 text, 4 units at the time
+      static uint32_t size32_sse2_s( const char32_t* pwszPosition, const char32_t* pwszEnd )
+      {
+         uint32_t uSize = 0;
+         const __m128i vZero = _mm_setzero_si128();
+         const __m128i vTwo = _mm_set1_epi32( (int)0xffffff80 );
+         const __m128i vThree = _mm_set1_epi32( (int)0xfffff800 );
+         const __m128i vFour = _mm_set1_epi32( (int)0xffff0000 );
+         while( pwszEnd - pwszPosition >= 4 )
+         {
+            __m128i v_ = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pwszPosition ) );
+            uint32_t uTwo = static_cast<uint32_t>( _mm_movemask_epi8( _mm_cmpeq_epi32( _mm_and_si128( v_, vTwo ), vZero ) ) );// four bits for each unit that doesn't need the byte
+            uint32_t uThree = static_cast<uint32_t>( _mm_movemask_epi8( _mm_cmpeq_epi32( _mm_and_si128( v_, vThree ), vZero ) ) );
+            uint32_t uFour = static_cast<uint32_t>( _mm_movemask_epi8( _mm_cmpeq_epi32( _mm_and_si128( v_, vFour ), vZero ) ) );
+            uSize += 16 - ( std::popcount( uTwo ) + std::popcount( uThree ) + std::popcount( uFour ) ) / 4;
+            pwszPosition += 4;
+         }
+
+         for( ; pwszPosition < pwszEnd; pwszPosition++ ) uSize += size32_s( *pwszPosition );
+         return uSize;
+      }
+
+      /// convert utf32 to utf8, blocks with 4 ascii units are packed and stored
+      static uint8_t* convert32_sse2_s( const char32_t* pwszPosition, const char32_t* pwszEnd, uint8_t* pubTo )
+      {
+         const __m128i vZero = _mm_setzero_si128();
+         const __m128i vAscii = _mm_set1_epi32( (int)0xffffff80 );
+         while( pwszEnd - pwszPosition >= 4 )
+         {
+            __m128i v_ = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pwszPosition ) );
+            if( _mm_movemask_epi8( _mm_cmpeq_epi32( _mm_and_si128( v_, vAscii ), vZero ) ) == 0xffff )
+            {
+               __m128i v16_ = _mm_packs_epi32( v_, v_ );
+               uint32_t uAscii = static_cast<uint32_t>( _mm_cvtsi128_si32( _mm_packus_epi16( v16_, v16_ ) ) );
+               std::memcpy( pubTo, &uAscii, 4 );
+               pubTo += 4;
+            }
+            else
+            {
+               for( int i = 0; i < 4; i++ ) pubTo += convert( static_cast<uint32_t>( pwszPosition[i] ), pubTo );
+            }
+            pwszPosition += 4;
+         }
+
+         for( ; pwszPosition < pwszEnd; pwszPosition++ ) pubTo += convert( static_cast<uint32_t>( *pwszPosition ), pubTo );
+         return pubTo;
+      }
+
+      /// utf16 units needed for utf8 text, each lead byte is one unit and 4 byte leads are two
+      static uint32_t size8_sse2_s( const uint8_t* pubPosition, const uint8_t* pubEnd )
+      {
+         uint32_t uSize = 0;
+         const __m128i vContinuation = _mm_set1_epi8( (char)0xc0 );
+         const __m128i vFour = _mm_set1_epi8( (char)0xf0 );
+         while( pubEnd - pubPosition >= 16 )
+         {
+            __m128i v_ = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pubPosition ) );
+            uint32_t uContinuation = static_cast<uint32_t>( _mm_movemask_epi8( _mm_cmplt_epi8( v_, vContinuation ) ) );
+            uint32_t uFour = static_cast<uint32_t>( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_max_epu8( v_, vFour ), v_ ) ) );
+            uSize += 16 - std::popcount( uContinuation ) + std::popcount( uFour );
+            pubPosition += 16;
+         }
+
+         return uSize + scalar::size_utf16( pubPosition, pubEnd );
+      }
+
+      /// convert utf8 to utf16, blocks with 16 ascii bytes are widened and stored
+      static char16_t* convert8_sse2_s( const uint8_t* pubPosition, const uint8_t* pubEnd, char16_t* pwszTo )
+      {
+         const __m128i vZero = _mm_setzero_si128();
+         while( pubEnd - pubPosition >= 16 )
+         {
+            __m128i v_ = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pubPosition ) );
+            if( _mm_movemask_epi8( v_ ) == 0 )
+            {
+               _mm_storeu_si128( reinterpret_cast<__m128i*>( pwszTo ), _mm_unpacklo_epi8( v_, vZero ) );
+               _mm_storeu_si128( reinterpret_cast<__m128i*>( pwszTo + 8 ), _mm_unpackhi_epi8( v_, vZero ) );
+               pwszTo += 16;
+               pubPosition += 16;
+            }
+            else
+            {
+               for( const uint8_t* pubBlock = pubPosition + 16; pubPosition < pubBlock; ) pubPosition = convert_step_s( pubPosition, pubEnd, pwszTo );
+            }
+         }
+
+         while( pubPosition < pubEnd ) pubPosition = convert_step_s( pubPosition, pubEnd, pwszTo );
+         return pwszTo;
+      }
+
+      GD_UTF8_TARGET_AVX2 static uint32_t size16_avx2_s( const char16_t* pwszPosition, const char16_t* pwszEnd )
+      {
+         uint32_t uSize = 0;
+         const __m256i vZero = _mm256_setzero_si256();
+         const __m256i vAscii = _mm256_set1_epi16( (short)0xff80 );
+         const __m256i vTwo = _mm256_set1_epi16( (short)0xf800 );
+         const __m256i vSurrogate = _mm256_set1_epi16( (short)0xd800 );
+         while( pwszEnd - pwszPosition >= 16 )
+         {
+            __m256i v_ = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pwszPosition ) );
+            __m256i vHigh = _mm256_and_si256( v_, vTwo );
+            if( _mm256_movemask_epi8( _mm256_cmpeq_epi16( vHigh, vSurrogate ) ) == 0 )
+            {
+               uint32_t uOne = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi16( _mm256_and_si256( v_, vAscii ), vZero ) ) );
+               uint32_t uTwo = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi16( vHigh, vZero ) ) );
+               uSize += 48 - ( _mm_popcnt_u32( uOne ) + _mm_popcnt_u32( uTwo ) ) / 2;
+               pwszPosition += 16;
+            }
+            else
+            {
+               for( const char16_t* pwszBlock = pwszPosition + 16; pwszPosition < pwszBlock; ) pwszPosition = size_step_s( pwszPosition, pwszEnd, uSize );
+            }
+         }
+
+         return uSize + size16_sse2_s( pwszPosition, pwszEnd );
+      }
+
+      GD_UTF8_TARGET_AVX2 static uint8_t* convert16_avx2_s( const char16_t* pwszPosition, const char16_t* pwszEnd, uint8_t* pubTo )
+      {
+         const __m256i vZero = _mm256_setzero_si256();
+         const __m256i vAscii = _mm256_set1_epi16( (short)0xff80 );
+         while( pwszEnd - pwszPosition >= 16 )
+         {
+            __m256i v_ = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pwszPosition ) );
+            if( _mm256_movemask_epi8( _mm256_cmpeq_epi16( _mm256_and_si256( v_, vAscii ), vZero ) ) == -1 )
+            {
+               _mm_storeu_si128( reinterpret_cast<__m128i*>( pubTo ), _mm_packus_epi16( _mm256_castsi256_si128( v_ ), _mm256_extracti128_si256( v_, 1 ) ) );
+               pubTo += 16;
+               pwszPosition += 16;
+            }
+            else
+            {
+               for( const char16_t* pwszBlock = pwszPosition + 16; pwszPosition < pwszBlock; ) pwszPosition = convert_step_s( pwszPosition, pwszEnd, pubTo );
+            }
+         }
+
+         return convert16_sse2_s( pwszPosition, pwszEnd, pubTo );
+      }
+
+      GD_UTF8_TARGET_AVX2 static uint32_t size32_avx2_s( const char32_t* pwszPosition, const char32_t* pwszEnd )
+      {
+         uint32_t uSize = 0;
+         const __m256i vZero = _mm256_setzero_si256();
+         const __m256i vTwo = _mm256_set1_epi32( (int)0xffffff80 );
+         const __m256i vThree = _mm256_set1_epi32( (int)0xfffff800 );
+         const __m256i vFour = _mm256_set1_epi32( (int)0xffff0000 );
+         while( pwszEnd - pwszPosition >= 8 )
+         {
+            __m256i v_ = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pwszPosition ) );
+            uint32_t uTwo = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi32( _mm256_and_si256( v_, vTwo ), vZero ) ) );
+            uint32_t uThree = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi32( _mm256_and_si256( v_, vThree ), vZero ) ) );
+            uint32_t uFour = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi32( _mm256_and_si256( v_, vFour ), vZero ) ) );
+            uSize += 32 - ( _mm_popcnt_u32( uTwo ) + _mm_popcnt_u32( uThree ) + _mm_popcnt_u32( uFour ) ) / 4;
+            pwszPosition += 8;
+         }
+
+         return uSize + size32_sse2_s( pwszPosition, pwszEnd );
+      }
+
+      GD_UTF8_TARGET_AVX2 static uint8_t* convert32_avx2_s( const char32_t* pwszPosition, const char32_t* pwszEnd, uint8_t* pubTo )
+      {
+         const __m256i vZero = _mm256_setzero_si256();
+         const __m256i vAscii = _mm256_set1_epi32( (int)0xffffff80 );
+         while( pwszEnd - pwszPosition >= 8 )
+         {
+            __m256i v_ = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pwszPosition ) );
+            if( _mm256_movemask_epi8( _mm256_cmpeq_epi32( _mm256_and_si256( v_, vAscii ), vZero ) ) == -1 )
+            {
+               __m128i v16_ = _mm_packs_epi32( _mm256_castsi256_si128( v_ ), _mm256_extracti128_si256( v_, 1 ) );
+               _mm_storel_epi64( reinterpret_cast<__m128i*>( pubTo ), _mm_packus_epi16( v16_, v16_ ) );
+               pubTo += 8;
+            }
+            else
+            {
+               for( int i = 0; i < 8; i++ ) pubTo += convert( static_cast<uint32_t>( pwszPosition[i] ), pubTo );
+            }
+            pwszPosition += 8;
+         }
+
+         return convert32_sse2_s( pwszPosition, pwszEnd, pubTo );
+      }
+
+      GD_UTF8_TARGET_AVX2 static uint32_t size8_avx2_s( const uint8_t* pubPosition, const uint8_t* pubEnd )
+      {
+         uint32_t uSize = 0;
+         const __m256i vContinuation = _mm256_set1_epi8( (char)0xc0 );
+         const __m256i vFour = _mm256_set1_epi8( (char)0xf0 );
+         while( pubEnd - pubPosition >= 32 )
+         {
+            __m256i v_ = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pubPosition ) );
+            uint32_t uContinuation = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpgt_epi8( vContinuation, v_ ) ) );
+            uint32_t uFour = static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( _mm256_max_epu8( v_, vFour ), v_ ) ) );
+            uSize += 32 - _mm_popcnt_u32( uContinuation ) + _mm_popcnt_u32( uFour );
+            pubPosition += 32;
+         }
+
+         return uSize + size8_sse2_s( pubPosition, pubEnd );
+      }
+
+      GD_UTF8_TARGET_AVX2 static char16_t* convert8_avx2_s( const uint8_t* pubPosition, const uint8_t* pubEnd, char16_t* pwszTo )
+      {
+         while( pubEnd - pubPosition >= 32 )
+         {
+            __m256i v_ = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( pubPosition ) );
+            if( _mm256_movemask_epi8( v_ ) == 0 )
+            {
+               _mm256_storeu_si256( reinterpret_cast<__m256i*>( pwszTo ), _mm256_cvtepu8_epi16( _mm256_castsi256_si128( v_ ) ) );
+               _mm256_storeu_si256( reinterpret_cast<__m256i*>( pwszTo + 16 ), _mm256_cvtepu8_epi16( _mm256_extracti128_si256( v_, 1 ) ) );
+               pwszTo += 32;
+               pubPosition += 32;
+            }
+            else
+            {
+               for( const uint8_t* pubBlock = pubPosition + 32; pubPosition < pubBlock; ) pubPosition = convert_step_s( pubPosition, pubEnd, pwszTo );
+            }
+         }
+
+         return convert8_sse2_s( pubPosition, pubEnd, pwszTo );
+      }
+
+#endif // GD_UTF8_SIMD_X86
+
+      /// find text using simd level, `uSecond` is offset to second byte used to filter positions
+      static const uint8_t* find_s( const uint8_t* pubPosition, const uint8_t* pubEnd, const uint8_t* pubFind, uint32_t uSize, uint32_t uSecond )
+      {
+         switch( simd::level() )
+         {
+#ifdef GD_UTF8_SIMD_X86
+         case simd::eLevelAVX2: return find_avx2_s( pubPosition, pubEnd, pubFind, uSize, uSecond );
+         case simd::eLevelSSE2: return find_sse2_s( pubPosition, pubEnd, pubFind, uSize, uSecond );
+#endif
+         default: return scalar::find( pubPosition, pubEnd, pubFind, uSize );
+         }
+      }
+
+      /** ---------------------------------------------------------------------
+       * @brief remove marker bytes from text and count characters that are kept
+       * Text is compacted in place, selects implementation based on cpu (see `simd::level`)
+       * @param pubBegin start of text
+       * @param pubEnd end of text
+       * @param uMarker ascii byte that is removed, ascii never appears within multibyte characters
+       * @return number of characters kept and new end of text
+      */
+      std::pair<uint32_t, uint8_t*> squeeze( uint8_t* pubBegin, uint8_t* pubEnd, uint8_t uMarker )
+      {                                                                        assert( pubBegin <= pubEnd ); assert( uMarker < 0x80 );
+         switch( simd::level() )
+         {
+#ifdef GD_UTF8_SIMD_X86
+         case simd::eLevelAVX2: return squeeze_avx2_s( pubBegin, pubEnd, uMarker );
+         case simd::eLevelSSE2: return squeeze_sse2_s( pubBegin, pubEnd, uMarker );
+#endif
+         default: return scalar::squeeze( pubBegin, pubEnd, uMarker );
+         }
+      }
+
+      /** ---------------------------------------------------------------------
+       * @brief check if text is ascii only
+       * Selects implementation based on cpu (see `simd::level`)
+       * @param pubBegin start of text
+       * @param pubEnd end of text
+       * @return true if no byte has the high bit set
+      */
+      bool is_ascii( const uint8_t* pubBegin, const uint8_t* pubEnd )
+      {                                                                        assert( pubBegin <= pubEnd );
+         switch( simd::level() )
+         {
+#ifdef GD_UTF8_SIMD_X86
+         case simd::eLevelAVX2: return is_ascii_avx2_s( pubBegin, pubEnd );
+         case simd::eLevelSSE2: return is_ascii_sse2_s( pubBegin, pubEnd );
+#endif
+         default: return scalar::is_ascii( pubBegin, pubEnd );
+         }
+      }
+
+      /** ---------------------------------------------------------------------
+       * @brief exact number of bytes needed to store utf16 text as utf8
+       * Surrogate pairs are one 4 byte character, lone surrogates are stored as 3 bytes.
+       * Use it to allocate once before calling `convert` with the same range
+       * @param pwszBegin start of utf16 text
+       * @param pwszEnd end of utf16 text
+       * @return uint32_t number of utf8 bytes, zero terminator not included
+      */
+      uint32_t size( const char16_t* pwszBegin, const char16_t* pwszEnd )
+      {                                                                        assert( pwszBegin <= pwszEnd );
+         switch( simd::level() )
+         {
+#ifdef GD_UTF8_SIMD_X86
+         case simd::eLevelAVX2: return size16_avx2_s( pwszBegin, pwszEnd );
+         case simd::eLevelSSE2: return size16_sse2_s( pwszBegin, pwszEnd );
+#endif
+         default: return scalar::size( pwszBegin, pwszEnd );
+         }
+      }
+
+      /// exact number of bytes needed to store utf32 text as utf8, same as bytes written by `convert`
+      uint32_t size( const char32_t* pwszBegin, const char32_t* pwszEnd )
+      {                                                                        assert( pwszBegin <= pwszEnd );
+         switch( simd::level() )
+         {
+#ifdef GD_UTF8_SIMD_X86
+         case simd::eLevelAVX2: return size32_avx2_s( pwszBegin, pwszEnd );
+         case simd::eLevelSSE2: return size32_sse2_s( pwszBegin, pwszEnd );
+#endif
+         default: return scalar::size( pwszBegin, pwszEnd );
+         }
+      }
+
+      /** ---------------------------------------------------------------------
+       * @brief exact number of utf16 units needed to store utf8 text
+       * Each lead byte gives one unit and 4 byte leads give a surrogate pair,
+       * continuation bytes without lead are skipped.
+       * @param pubBegin start of utf8 text
+       * @param pubEnd end of utf8 text
+       * @return uint32_t number of utf16 units, zero terminator not included
+      */
+      uint32_t size_utf16( const uint8_t* pubBegin, const uint8_t* pubEnd )
+      {                                                                        assert( pubBegin <= pubEnd );
+         switch( simd::level() )
+         {
+#ifdef GD_UTF8_SIMD_X86
+         case simd::eLevelAVX2: return size8_avx2_s( pubBegin, pubEnd );
+         case simd::eLevelSSE2: return size8_sse2_s( pubBegin, pubEnd );
+#endif
+         default: return scalar::size_utf16( pubBegin, pubEnd );
+         }
+      }
+
+      /** ---------------------------------------------------------------------
+       * @brief convert utf16 text to utf8
+       * Ascii blocks are converted with simd, other blocks one character at the time.
+       * Buffer needs room for `size( pwszBegin, pwszEnd )` bytes, zero terminator is not written
+       * @param pwszBegin start of utf16 text
+       * @param pwszEnd end of utf16 text
+       * @param pubTo buffer getting utf8 text
+       * @return uint8_t* position after last converted character
+      */
+      uint8_t* convert( const char16_t* pwszBegin, const char16_t* pwszEnd, uint8_t* pubTo )
+      {                                                                        assert( pwszBegin <= pwszEnd );
+         switch( simd::level() )
+         {
+#ifdef GD_UTF8_SIMD_X86
+         case simd::eLevelAVX2: return convert16_avx2_s( pwszBegin, pwszEnd, pubTo );
+         case simd::eLevelSSE2: return convert16_sse2_s( pwszBegin, pwszEnd, pubTo );
+#endif
+         default: return scalar::convert( pwszBegin, pwszEnd, pubTo );
+         }
+      }
+
+      /// convert utf32 text to utf8, buffer needs room for `size( pwszBegin, pwszEnd )` bytes
+      uint8_t* convert( const char32_t* pwszBegin, const char32_t* pwszEnd, uint8_t* pubTo )
+      {                                                                        assert( pwszBegin <= pwszEnd );
+         switch( simd::level() )
+         {
+#ifdef GD_UTF8_SIMD_X86
+         case simd::eLevelAVX2: return convert32_avx2_s( pwszBegin, pwszEnd, pubTo );
+         case simd::eLevelSSE2: return convert32_sse2_s( pwszBegin, pwszEnd, pubTo );
+#endif
+         default: return scalar::convert( pwszBegin, pwszEnd, pubTo );
+         }
+      }
+
+      /// convert utf8 text to utf16, buffer needs room for `size_utf16( pubBegin, pubEnd )` units
+      char16_t* convert( const uint8_t* pubBegin, const uint8_t* pubEnd, char16_t* pwszTo )
+      {                                                                        assert( pubBegin <= pubEnd );
+         switch( simd::level() )
+         {
+#ifdef GD_UTF8_SIMD_X86
+         case simd::eLevelAVX2: return convert8_avx2_s( pubBegin, pubEnd, pwszTo );
+         case simd::eLevelSSE2: return convert8_sse2_s( pubBegin, pubEnd, pwszTo );
+#endif
+         default: return scalar::convert( pubBegin, pubEnd, pwszTo );
+         }
+      }
+
       /** ---------------------------------------------------------------------
        * @brief count utf8 characters in buffer
        * @param pubszText pointer to buffer with text where characters are counted
@@ -225,6 +1105,8 @@ namespace gd {
       */
       std::pair<uint32_t, const uint8_t*> count( const uint8_t* pubszText )
       {
+         if( simd::level() != simd::eLevelScalar ) return count( pubszText, pubszText + std::strlen( reinterpret_cast<const char*>( pubszText ) ) );
+
          uint32_t uCount = 0; // counted characters in buffer
          const uint8_t* pubszPosition = pubszText;
          while( *pubszPosition != '\0' )
@@ -239,22 +1121,160 @@ namespace gd {
 
       /**
        * @brief count utf8 characters in buffer
+       * Selects implementation based on cpu (see `simd::level`)
        * @param pubszText pointer to buffer with text where characters are counted
        * @param pubszEnd pointer to end of buffer
        * @return number of utf8 characters in buffer
       */
       std::pair<uint32_t, const uint8_t*> count( const uint8_t* pubszText, const uint8_t* pubszEnd )
-      {                                                                        assert( pubszText < pubszEnd ); assert( pubszEnd - pubszText < 0x00100000 );
-         uint32_t uCount = 0; // counted characters in buffer
-         const uint8_t* pubszPosition = pubszText;
-         while( pubszPosition < pubszEnd )
+      {                                                                        assert( pubszText <= pubszEnd );
+         switch( simd::level() )
          {
-            pubszPosition += pNeededByteCount_s[*pubszPosition];
-            uCount++;
+#ifdef GD_UTF8_SIMD_X86
+         case simd::eLevelAVX2: return count_avx2_s( pubszText, pubszEnd );
+         case simd::eLevelSSE2: return count_sse2_s( pubszText, pubszEnd );
+#endif
+         default: return scalar::count( pubszText, pubszEnd );
+         }
+      }
+
+      namespace scalar {
+         /**
+          * @brief count utf8 characters in buffer, one character at the time
+          * @param pubszText pointer to buffer with text where characters are counted
+          * @param pubszEnd pointer to end of buffer
+          * @return number of utf8 characters in buffer
+         */
+         std::pair<uint32_t, const uint8_t*> count( const uint8_t* pubszText, const uint8_t* pubszEnd )
+         {                                                                     assert( pubszText <= pubszEnd );
+            uint32_t uCount = 0; // counted characters in buffer
+            const uint8_t* pubszPosition = pubszText;
+            while( pubszPosition < pubszEnd )
+            {
+               auto uSize = pNeededByteCount_s[*pubszPosition];
+               if( uSize == 0 )                                                // invalid lead byte, continuation bytes are not counted
+               {
+                  if( (*pubszPosition & UTF8_VALIDATE_TAIL_MASK) != UTF8_MIN_ENCODE ) uCount++;
+                  pubszPosition++;
+                  continue;
+               }
+               pubszPosition += uSize;
+               uCount++;
+            }
 
+            if( pubszPosition > pubszEnd ) pubszPosition = pubszEnd;           // last character was cut
+            return std::pair<uint32_t, const uint8_t*>(uCount, pubszPosition);
          }
 
-         return std::pair<uint32_t, const uint8_t*>(uCount, pubszPosition);
+         /**
+          * @brief find text, first byte is compared and then the rest with memcmp
+          * @param pubszPosition text that string is searched for
+          * @param pubszEnd end of text
+          * @param pubszFind string to find
+          * @param uSize length of string to find
+          * @return position where text starts or nullptr if not found
+         */
+         const uint8_t* find( const uint8_t* pubszPosition, const uint8_t* pubszEnd, const uint8_t* pubszFind, uint32_t uSize )
+         {                                                                     assert( pubszPosition <= pubszEnd );
+            if( uSize == 0 ) return pubszPosition;
+            if( pubszEnd - pubszPosition < static_cast<std::ptrdiff_t>( uSize ) ) return nullptr;
+
+            const uint8_t* pubszLast = pubszEnd - uSize;                       // last position where text can start
+            uSize--;
+            while( pubszPosition <= pubszLast )
+            {
+               if( *pubszPosition == *pubszFind )
+               {
+                  if( memcmp( pubszPosition + 1, pubszFind + 1, uSize ) == 0  ) return pubszPosition;
+               }
+
+               pubszPosition++;
+            }
+
+            return nullptr;
+         }
+
+         /**
+          * @brief remove marker bytes from text, one byte at the time
+          * @param pubBegin start of text
+          * @param pubEnd end of text
+          * @param uMarker ascii byte that is removed
+          * @return number of characters kept (continuation bytes are not counted) and new end of text
+         */
+         std::pair<uint32_t, uint8_t*> squeeze( uint8_t* pubBegin, uint8_t* pubEnd, uint8_t uMarker )
+         {                                                                     assert( pubBegin <= pubEnd );
+            uint32_t uCount = 0;
+            uint8_t* pubInsert = pubBegin;
+            for( uint8_t* pubPosition = pubBegin; pubPosition < pubEnd; pubPosition++ )
+            {
+               uint8_t uByte = *pubPosition;
+               if( uByte == uMarker ) continue;
+               if( ( uByte & UTF8_VALIDATE_TAIL_MASK ) != UTF8_MIN_ENCODE ) uCount++;
+               *pubInsert++ = uByte;
+            }
+
+            return { uCount, pubInsert };
+         }
+
+         /// check if text is ascii only, eight bytes at the time
+         bool is_ascii( const uint8_t* pubBegin, const uint8_t* pubEnd )
+         {                                                                     assert( pubBegin <= pubEnd );
+            const uint8_t* pubPosition = pubBegin;
+            for( ; pubEnd - pubPosition >= 8; pubPosition += 8 )
+            {
+               uint64_t uBlock;
+               std::memcpy( &uBlock, pubPosition, 8 );
+               if( ( uBlock & 0x8080808080808080ull ) != 0 ) return false;
+            }
+
+            for( ; pubPosition < pubEnd; pubPosition++ ) { if( *pubPosition >= 0x80 ) return false; }
+            return true;
+         }
+
+         /// utf8 size for utf16 text, one character at the time
+         uint32_t size( const char16_t* pwszBegin, const char16_t* pwszEnd )
+         {                                                                     assert( pwszBegin <= pwszEnd );
+            uint32_t uSize = 0;
+            for( const char16_t* pwszPosition = pwszBegin; pwszPosition < pwszEnd; ) pwszPosition = size_step_s( pwszPosition, pwszEnd, uSize );
+            return uSize;
+         }
+
+         /// utf8 size for utf32 text, one character at the time
+         uint32_t size( const char32_t* pwszBegin, const char32_t* pwszEnd )
+         {                                                                     assert( pwszBegin <= pwszEnd );
+            uint32_t uSize = 0;
+            for( const char32_t* pwszPosition = pwszBegin; pwszPosition < pwszEnd; pwszPosition++ ) uSize += size32_s( *pwszPosition );
+            return uSize;
+         }
+
+         /// utf16 units for utf8 text, one byte at the time
+         uint32_t size_utf16( const uint8_t* pubBegin, const uint8_t* pubEnd )
+         {                                                                     assert( pubBegin <= pubEnd );
+            uint32_t uSize = 0;
+            for( const uint8_t* pubPosition = pubBegin; pubPosition < pubEnd; pubPosition++ ) uSize += ( ( *pubPosition & 0xc0 ) != 0x80 ) + ( *pubPosition >= 0xf0 );
+            return uSize;
+         }
+
+         /// convert utf16 to utf8, one character at the time
+         uint8_t* convert( const char16_t* pwszBegin, const char16_t* pwszEnd, uint8_t* pubTo )
+         {                                                                     assert( pwszBegin <= pwszEnd );
+            for( const char16_t* pwszPosition = pwszBegin; pwszPosition < pwszEnd; ) pwszPosition = convert_step_s( pwszPosition, pwszEnd, pubTo );
+            return pubTo;
+         }
+
+         /// convert utf32 to utf8, one character at the time
+         uint8_t* convert( const char32_t* pwszBegin, const char32_t* pwszEnd, uint8_t* pubTo )
+         {                                                                     assert( pwszBegin <= pwszEnd );
+            for( const char32_t* pwszPosition = pwszBegin; pwszPosition < pwszEnd; pwszPosition++ ) pubTo += gd::utf8::convert( static_cast<uint32_t>( *pwszPosition ), pubTo );
+            return pubTo;
+         }
+
+         /// convert utf8 to utf16, one character at the time
+         char16_t* convert( const uint8_t* pubBegin, const uint8_t* pubEnd, char16_t* pwszTo )
+         {                                                                     assert( pubBegin <= pubEnd );
+            for( const uint8_t* pubPosition = pubBegin; pubPosition < pubEnd; ) pubPosition = convert_step_s( pubPosition, pubEnd, pwszTo );
+            return pwszTo;
+         }
       }
 
 
@@ -331,12 +1351,31 @@ namespace gd {
 
       /** ---------------------------------------------------------------------
        * @brief Validate utf8 sequence
+       * Selects implementation based on cpu (see `simd::level`)
        * @param pubBegin start of utf8 sequence to validate
        * @param pubEnd end of utf8 sequence
        * @return true if validated, false and position if error
       */
       std::pair<bool, const uint8_t*> validate( const uint8_t* pubBegin, const uint8_t* pubEnd )
       {                                                                                            assert( pubBegin <= pubEnd );
+         switch( simd::level() )
+         {
+#ifdef GD_UTF8_SIMD_X86
+         case simd::eLevelAVX2: return validate_avx2_s( pubBegin, pubEnd );
+         case simd::eLevelSSE2: return validate_sse2_s( pubBegin, pubEnd );
+#endif
+         default: return scalar::validate( pubBegin, pubEnd );
+         }
+      }
+
+      /** ---------------------------------------------------------------------
+       * @brief Validate utf8 sequence, one character at the time
+       * @param pubBegin start of utf8 sequence to validate
+       * @param pubEnd end of utf8 sequence
+       * @return true if validated, false and position if error
+      */
+      std::pair<bool, const uint8_t*> scalar::validate( const uint8_t* pubBegin, const uint8_t* pubEnd )
+      {                                                                                            assert( pubBegin <= pubEnd );
 #ifdef _DEBUG
          const char* pbsz_d = (const char*)pubBegin;                           // simplify debugging
          const char8_t* putf8_d = (const char8_t*)pubBegin;                    // simplify debugging
@@ -352,7 +1391,7 @@ namespace gd {
                std::size_t uLength = pNeededByteCount_s[*pubPosition];
                if( uLength > 0 )
                {
-                  if( static_cast<std::size_t>(pubEnd - pubPosition) > uLength ) // do we have enough space
+                  if( static_cast<std::size_t>(pubEnd - pubPosition) >= uLength ) // do we have enough space
                   {
                      if( uLength == 2 )
                      {
@@ -534,18 +1573,11 @@ namespace gd {
       */
       std::tuple<bool, const char16_t*, char8_t*> convert_utf16_to_uft8(const char16_t* pwszUtf16, char8_t* pbszUtf8)
       {
-         const char16_t* pwszPosition = pwszUtf16;
-         while(*pwszPosition)
-         {
-            uint32_t uCharacter = gd::utf16::character(pwszPosition);
-            uint32_t uSize = convert(uCharacter, pbszUtf8);
-            pwszPosition++;
-            pbszUtf8 += uSize;
-         }
+         const char16_t* pwszEnd = pwszUtf16 + std::char_traits<char16_t>::length( pwszUtf16 );
+         uint8_t* pubEnd = convert( pwszUtf16, pwszEnd, reinterpret_cast<uint8_t*>(pbszUtf8) );
+         *pubEnd = '\0';
 
-         *pbszUtf8 = '\0';
-
-         return { true, pwszPosition, pbszUtf8 };
+         return { true, pwszEnd, reinterpret_cast<char8_t*>(pubEnd) };
       }
 #endif
 
@@ -557,35 +1589,23 @@ namespace gd {
       */
       std::tuple<bool, const wchar_t*, char*> convert_utf16_to_uft8(const wchar_t* pwszUtf16, char* pbszUtf8, utf8_tag)
       {
-         const wchar_t* pwszPosition = pwszUtf16;
-         while(*pwszPosition)
-         {
-            uint32_t uCharacter = gd::utf16::character(pwszPosition);
-            uint32_t uSize = convert(uCharacter, (uint8_t*)pbszUtf8);
-            pwszPosition++;
-            pbszUtf8 += uSize;
-         }
+         const wchar_t* pwszEnd = pwszUtf16 + std::char_traits<wchar_t>::length( pwszUtf16 );
+         uint8_t* pubEnd = convert( pwszUtf16, pwszEnd, reinterpret_cast<uint8_t*>(pbszUtf8) );
+         *pubEnd = '\0';
 
-         *pbszUtf8 = '\0';
-
-         return { true, pwszPosition, pbszUtf8 };
+         return { true, pwszEnd, reinterpret_cast<char*>(pubEnd) };
       }
 
 
       std::tuple<bool, const uint16_t*> convert_utf16_to_uft8(const uint16_t* pwszUtf16, std::string& stringUtf8)
       {
-         uint8_t puBuffer[SIZE32_MAX_UTF_SIZE + 1];
-         const uint16_t* pwszPosition = pwszUtf16;
-         while( *pwszPosition )
-         {
-            uint32_t uCharacter = gd::utf16::character(pwszPosition);
-            uint32_t uSize = size(static_cast<uint16_t>(*pwszPosition));
-            pwszPosition++;
-            uSize = convert(uCharacter, puBuffer);
-            stringUtf8.append(reinterpret_cast<const char*>(puBuffer), uSize);
-         }
+         const char16_t* pwszBegin = reinterpret_cast<const char16_t*>(pwszUtf16);
+         const char16_t* pwszEnd = pwszBegin + std::char_traits<char16_t>::length( pwszBegin );
+         size_t uOffset = stringUtf8.length();
+         stringUtf8.resize( uOffset + size( pwszBegin, pwszEnd ) );            // exact size, allocate once
+         convert( pwszBegin, pwszEnd, reinterpret_cast<uint8_t*>(stringUtf8.data()) + uOffset );
 
-         return { true, pwszPosition };
+         return { true, reinterpret_cast<const uint16_t*>(pwszEnd) };
       }
 
       /**
@@ -596,6 +1616,15 @@ namespace gd {
       */
       std::tuple<bool, const uint8_t*> convert_utf8_to_uft16(const uint8_t* pbszUtf8, std::wstring& stringUtf16)
       {
+         if constexpr( sizeof( wchar_t ) == 2 )
+         {
+            const uint8_t* pubEnd = pbszUtf8 + std::strlen( reinterpret_cast<const char*>(pbszUtf8) );
+            size_t uOffset = stringUtf16.length();
+            stringUtf16.resize( uOffset + size_utf16( pbszUtf8, pubEnd ) );    // exact size, allocate once
+            convert( pbszUtf8, pubEnd, reinterpret_cast<char16_t*>(stringUtf16.data()) + uOffset );
+            return { true, pubEnd };
+         }
+
          const uint8_t* pbszPosition = pbszUtf8;
          while( *pbszPosition )
          {
@@ -757,6 +1786,15 @@ namespace gd {
       */
       std::pair<bool, const uint16_t*> convert_unicode(const uint16_t* pwszFrom, uint8_t* pbszTo, const uint8_t* pbszEnd)
       {
+         // ## text that fits in buffer is converted in one pass
+         const wchar_t* pwszText = reinterpret_cast<const wchar_t*>(pwszFrom);
+         const wchar_t* pwszTextEnd = pwszText + std::char_traits<wchar_t>::length( pwszText );
+         if( pbszTo + size( pwszText, pwszTextEnd ) < pbszEnd )
+         {
+            *convert( pwszText, pwszTextEnd, pbszTo ) = '\0';
+            return std::make_pair(true, reinterpret_cast<const uint16_t*>(pwszTextEnd));
+         }
+
          const uint16_t* pwszPosition = pwszFrom;
          uint8_t* pbszInsert = pbszTo;
 
@@ -1067,7 +2105,7 @@ namespace gd {
             if(*pubszPosition != '\0')
             {
                if((*pubszPosition & 0x80) == 0)          return pubszPosition + 1;
-               else if((*pubszPosition & 0xc0) == 0xc0)  return pubszPosition + 2;
+               else if((*pubszPosition & 0xe0) == 0xc0)  return pubszPosition + 2;
                else if((*pubszPosition & 0xf0) == 0xe0)  return pubszPosition + 3;
                else if((*pubszPosition & 0xf8) == 0xf0)  return pubszPosition + 4;
                else throw std::runtime_error("invalid UTF-8 (operation = next)");
@@ -1277,20 +2315,12 @@ namespace gd {
           * @return 
          */
          const uint8_t* find( const uint8_t* pubszPosition, const uint8_t* pubszEnd, const uint8_t* pubszFind, uint32_t uSize )
-         {
-            pubszEnd -= uSize;
-            uSize--;
-            while( pubszPosition < pubszEnd )
-            {
-               if( *pubszPosition == *pubszFind )
-               {
-                  if( memcmp( pubszPosition + 1, pubszFind + 1, uSize ) == 0  ) return pubszPosition;
-               }
+         {                                                                     assert( pubszPosition <= pubszEnd );
+            if( uSize == 0 ) return pubszPosition;
+            if( pubszEnd - pubszPosition < static_cast<std::ptrdiff_t>( uSize ) ) return nullptr;
+            if( uSize == 1 ) return static_cast<const uint8_t*>( std::memchr( pubszPosition, *pubszFind, pubszEnd - pubszPosition ) );
 
-               pubszPosition++;
-            }
-
-            return nullptr;
+            return find_s( pubszPosition, pubszEnd, pubszFind, uSize, uSize - 1 );// filter on first and last byte
          }
 
 
@@ -1333,6 +2363,52 @@ namespace gd {
          
       } // move
 
+      /**
+       * @brief Set text to find and calculate filter bytes and skip table
+       * Second filter byte is the last byte, if that is same as first byte it
+       * selects the last byte that differs from first byte to avoid false
+       * positions in text with repeated characters.
+       * @param pubszFind text to find
+       * @param uSize length of text to find
+      */
+      void searcher::assign( const uint8_t* pubszFind, uint32_t uSize )
+      {
+         m_stringFind.assign( reinterpret_cast<const char*>( pubszFind ), uSize );
+         m_uSecond = uSize > 0 ? uSize - 1 : 0;
+         while( m_uSecond > 1 && pubszFind[m_uSecond] == pubszFind[0] ) m_uSecond--;
+
+         for( auto& uSkip : m_puSkip ) uSkip = uSize;
+         for( uint32_t u = 0; u + 1 < uSize; u++ ) m_puSkip[pubszFind[u]] = uSize - 1 - u;
+      }
+
+      /**
+       * @brief find text in range
+       * @param pubszPosition start of text to search in
+       * @param pubszEnd end of text
+       * @return position where text starts or nullptr if not found
+      */
+      const uint8_t* searcher::find( const uint8_t* pubszPosition, const uint8_t* pubszEnd ) const
+      {                                                                        assert( pubszPosition <= pubszEnd );
+         const uint8_t* pubFind = reinterpret_cast<const uint8_t*>( m_stringFind.data() );
+         uint32_t uSize = size();
+         if( uSize < 2 ) return move::find( pubszPosition, pubszEnd, pubFind, uSize );
+         if( pubszEnd - pubszPosition < static_cast<std::ptrdiff_t>( uSize ) ) return nullptr;
+
+         if( simd::level() != simd::eLevelScalar ) return find_s( pubszPosition, pubszEnd, pubFind, uSize, m_uSecond );
+
+         // ## Horspool, move window with skip for last byte in window
+         const uint8_t* pubLast = pubszEnd - uSize;
+         uint8_t uLast = pubFind[uSize - 1];
+         while( pubszPosition <= pubLast )
+         {
+            uint8_t uByte = pubszPosition[uSize - 1];
+            if( uByte == uLast && memcmp( pubszPosition, pubFind, uSize - 1 ) == 0 ) return pubszPosition;
+            pubszPosition += m_puSkip[uByte];
+         }
+
+         return nullptr;
+      }
+
       namespace json {
 
          /** ------------------------------------------------------------------
@@ -123,16 +123,19 @@ namespace gd {
          for( auto it : stringCountSize  ) uSize += size(static_cast<uint8_t>(it));
          return uSize;
       }
-      inline uint32_t size(const wchar_t* pwsz) { // ---------------------------------------------- size
-         uint32_t uSize = 0;
-         for( ; *pwsz != 0; pwsz++ ) uSize += size(static_cast<wchar_t>(*pwsz));
-         return uSize;
-      }
+      /// exact number of utf8 bytes needed for utf16 or utf32 text, surrogate pairs are one 4 byte character
+      uint32_t size( const char16_t* pwszBegin, const char16_t* pwszEnd ); // --------------------- size
+      uint32_t size( const char32_t* pwszBegin, const char32_t* pwszEnd ); // --------------------- size
+      /// exact number of utf8 bytes needed for wchar_t text (utf16 on windows, utf32 on other platforms)
       inline uint32_t size(const wchar_t* pwsz, const wchar_t* pwszEnd) { // ---------------------- size
-         uint32_t uSize = 0;
-         for( ; pwsz != pwszEnd; pwsz++ ) uSize += size(static_cast<wchar_t>(*pwsz));
-         return uSize;
+         if constexpr( sizeof( wchar_t ) == 2 ) return size( reinterpret_cast<const char16_t*>(pwsz), reinterpret_cast<const char16_t*>(pwszEnd) );
+         else return size( reinterpret_cast<const char32_t*>(pwsz), reinterpret_cast<const char32_t*>(pwszEnd) );
+      }
+      inline uint32_t size(const wchar_t* pwsz) { // ---------------------------------------------- size
+         return size( pwsz, pwsz + std::char_traits<wchar_t>::length( pwsz ) );
       }
+      /// exact number of utf16 units needed for utf8 text
+      uint32_t size_utf16( const uint8_t* pubBegin, const uint8_t* pubEnd ); // ------------------- size_utf16
 
       /// count needed size to store list of char values as utf8 string
       inline uint32_t size( std::initializer_list<char> listString ) { // ------------------------- size
@@ -158,11 +161,50 @@ namespace gd {
       std::pair<bool, const uint8_t*> validate_hex( const uint8_t* pubBegin, const uint8_t* pubEnd );
       inline std::pair<bool, const uint8_t*> validate_hex( const std::string_view& stringText ) { return validate_hex( reinterpret_cast<const uint8_t*>(stringText.data()), reinterpret_cast<const uint8_t*>(stringText.data()) + stringText.length() ); }
 
+      /// remove ascii marker bytes from text in place, returns number of characters kept and new end of text
+      std::pair<uint32_t, uint8_t*> squeeze( uint8_t* pubBegin, uint8_t* pubEnd, uint8_t uMarker );
+
+      /// check if text is ascii only (no byte with high bit set), each character is one byte
+      bool is_ascii( const uint8_t* pubBegin, const uint8_t* pubEnd );
+
+      /// scalar versions, one character at the time. Used as fallback when simd isn't supported
+      namespace scalar {
+         std::pair<bool, const uint8_t*> validate( const uint8_t* pubBegin, const uint8_t* pubEnd );
+         std::pair<uint32_t, const uint8_t*> count( const uint8_t* pubszText, const uint8_t* pubszEnd );
+         const uint8_t* find( const uint8_t* pubszPosition, const uint8_t* pubszEnd, const uint8_t* pubszFind, uint32_t uSize );
+         std::pair<uint32_t, uint8_t*> squeeze( uint8_t* pubBegin, uint8_t* pubEnd, uint8_t uMarker );
+         bool is_ascii( const uint8_t* pubBegin, const uint8_t* pubEnd );
+         uint32_t size( const char16_t* pwszBegin, const char16_t* pwszEnd );
+         uint32_t size( const char32_t* pwszBegin, const char32_t* pwszEnd );
+         uint32_t size_utf16( const uint8_t* pubBegin, const uint8_t* pubEnd );
+         uint8_t* convert( const char16_t* pwszBegin, const char16_t* pwszEnd, uint8_t* pubTo );
+         uint8_t* convert( const char32_t* pwszBegin, const char32_t* pwszEnd, uint8_t* pubTo );
+         char16_t* convert( const uint8_t* pubBegin, const uint8_t* pubEnd, char16_t* pwszTo );
+      }
+
+      /// simd level used by `validate`, `count`, `squeeze`, `is_ascii`, `move::find` and text range `size`/`convert`, selected from cpu features the first time it is used
+      namespace simd {
+         enum enumLevel { eLevelScalar = 0, eLevelSSE2 = 1, eLevelAVX2 = 2 };
+         unsigned level_supported();                                           ///< highest level supported by cpu
+         unsigned level();                                                     ///< active level
+         unsigned level( unsigned uLevel );                                    ///< set active level (max is supported level), returns level set
+      }
+
 
       ///@{
       uint32_t convert(uint8_t uCharacter, uint8_t* pbszTo); // ----------------------------------- convert
       uint32_t convert(uint16_t uCharacter, uint8_t* pbszTo); // ---------------------------------- convert
       uint32_t convert(uint32_t uCharacter, uint8_t* pbszTo); // ---------------------------------- convert
+
+      /// convert text range, buffer needs room for exact size from `size` or `size_utf16`. Zero terminator isn't written, returns end of converted text
+      uint8_t* convert( const char16_t* pwszBegin, const char16_t* pwszEnd, uint8_t* pubTo ); // - convert
+      uint8_t* convert( const char32_t* pwszBegin, const char32_t* pwszEnd, uint8_t* pubTo ); // - convert
+      char16_t* convert( const uint8_t* pubBegin, const uint8_t* pubEnd, char16_t* pwszTo ); // -- convert
+      /// convert wchar_t text (utf16 on windows, utf32 on other platforms) to utf8
+      inline uint8_t* convert( const wchar_t* pwszBegin, const wchar_t* pwszEnd, uint8_t* pubTo ) { // convert
+         if constexpr( sizeof( wchar_t ) == 2 ) return convert( reinterpret_cast<const char16_t*>(pwszBegin), reinterpret_cast<const char16_t*>(pwszEnd), pubTo );
+         else return convert( reinterpret_cast<const char32_t*>(pwszBegin), reinterpret_cast<const char32_t*>(pwszEnd), pubTo );
+      }
       uint32_t convert(uint32_t uCharacter, std::string& stringTo ); // --------------------------- convert
 
 #if defined(__cpp_char8_t)
@@ -432,6 +474,45 @@ namespace gd {
          inline const uint8_t* find( const uint8_t* pubszText, const uint8_t* pubszEnd, const uint8_t* pubszFind ) { return find( pubszText, pubszEnd, pubszFind, static_cast<uint32_t>( std::strlen( reinterpret_cast<const char*>(pubszFind) ) ) ); }
       }
 
+      /**
+       * @brief Find text that is searched for many times
+       * Bytes used to filter positions and skip table are calculated once when
+       * text to find is set. With simd two bytes in text to find are compared
+       * for 16 or 32 positions at the time, the second byte is selected to be
+       * different from the first if possible. Without simd it searches with
+       * skip table (Horspool).
+       *
+~~~{.cpp}
+gd::utf8::searcher searcherComment( "--" );
+for( auto p = searcherComment.find( pubBegin, pubEnd ); p != nullptr; p = searcherComment.find( p + 2, pubEnd ) ) { ... }
+~~~
+       */
+      class searcher
+      {
+      public:
+         searcher() {}
+         searcher( const uint8_t* pubszFind, uint32_t uSize ) { assign( pubszFind, uSize ); }
+         searcher( std::string_view stringFind ) { assign( reinterpret_cast<const uint8_t*>( stringFind.data() ), static_cast<uint32_t>( stringFind.length() ) ); }
+
+      public:
+         void assign( const uint8_t* pubszFind, uint32_t uSize );
+         /// find text in range, returns nullptr if not found
+         const uint8_t* find( const uint8_t* pubszPosition, const uint8_t* pubszEnd ) const;
+         template <typename UTF8_TYPE>
+         const UTF8_TYPE* find( const UTF8_TYPE* pubszPosition, const UTF8_TYPE* pubszEnd ) const {
+            static_assert(sizeof(UTF8_TYPE) == 1, "Value isn't compatible with uint8_t");
+            return reinterpret_cast<const UTF8_TYPE*>( find( reinterpret_cast<const uint8_t*>(pubszPosition), reinterpret_cast<const uint8_t*>(pubszEnd) ) );
+         }
+
+         uint32_t size() const noexcept { return static_cast<uint32_t>( m_stringFind.length() ); }
+         const std::string& text() const noexcept { return m_stringFind; }
+
+      public:
+         std::string m_stringFind;     ///< text to find
+         uint32_t m_uSecond = 0;       ///< offset to second byte used to filter positions, first byte is at offset 0
+         uint32_t m_puSkip[0x100];     ///< skip for last byte in window when searching without simd
+      };
+
       namespace json {
          // ## Validation methods
          bool is_encoded( uint8_t uChar );
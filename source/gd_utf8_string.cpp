@@ -8,6 +8,8 @@
 */
 
 
+#include <cstddef>
+#include <new>
 #include <stdexcept>
 #include <vector>
 #include <algorithm>
@@ -43,13 +45,8 @@ string::string( std::string_view stringText )
 */
 bool operator==( const string& stringEqualWith, std::string_view stringEqualTo )
 {
-   auto uCount = count( stringEqualTo ).first;
-   if( stringEqualWith.count() == uCount && uCount )
-   {
-      return stringEqualWith.compare( reinterpret_cast<const string::value_type*>(stringEqualTo.data()) );
-   }
-
-   return stringEqualWith.count() == uCount; // returns true if 0 length
+   if( stringEqualWith.size() != stringEqualTo.length() ) return false;       // compare size, characters do not need to be counted
+   return std::memcmp( stringEqualWith.c_str(), stringEqualTo.data(), stringEqualTo.length() ) == 0;
 }
 
 std::ostream& operator<<( std::ostream& ostreamTo, const string& s)
@@ -65,11 +62,17 @@ std::ostream& operator<<( std::ostream& ostreamTo, const string& s)
 */
 void string::copy(const string& o)
 {
+   if( this == &o ) return;
+   string::release( m_pbuffer );
    m_pbuffer = o.m_pbuffer;
 
    if( o.m_pbuffer->is_common_empty() == false )
    {
-      if(o.m_pbuffer->is_refcount() == true)
+      if( o.m_pbuffer->is_inline() == true )
+      {
+         _copy_inline( o );
+      }
+      else if(o.m_pbuffer->is_refcount() == true)
       {
          m_pbuffer->add_reference();
 #        ifdef DEBUG
@@ -79,6 +82,7 @@ void string::copy(const string& o)
       }
       else
       {
+         m_pbuffer = string::get_empty( o.m_pbuffer );                         // buffer is owned by other string
          _clone( o );
       }
    }
@@ -88,19 +92,22 @@ void string::copy(const string& o)
 string& string::assign( const char* pbszText, uint32_t uLength )
 {
    uint32_t uSize = gd::utf8::size( pbszText, uLength );
-   if( string::is_empty( m_pbuffer ) == true ) allocate_exact( uSize );
-   else if( uSize > m_pbuffer->capacity() ) allocate( uSize - m_pbuffer->capacity() );
+   m_pbuffer = string::safe_to_modify( m_pbuffer );
+   if( string::is_empty( m_pbuffer ) == true || uSize > m_pbuffer->capacity() ) allocate_exact( uSize );
 
    convert_ascii( pbszText, m_pbuffer->c_buffer() );
 
-   m_pbuffer->size( m_pbuffer->size() + uSize );
-   m_pbuffer->count( m_pbuffer->count() + uLength );
+   m_pbuffer->size( uSize );
+   m_pbuffer->count( uLength );
+   m_pbuffer->ascii( uSize == uLength );                                      // characters above ascii need two bytes
+   m_pbuffer->null_terminate();
 
    return *this;
 }
 
 /**
  * @brief assign text to string
+ * Text is checked for ascii only (see `is_ascii`), count equal to size means one byte for each character
  * @param pbszText pointer to utf8 formated text assigned to string
  * @param uSize size in bytes
  * @param uCount number of utf8 characters
@@ -113,8 +120,10 @@ string& string::assign( const value_type* pbszText, uint32_t uSize, uint32_t uCo
    if( uSize > m_pbuffer->capacity() ) allocate_exact( uSize );
 
    memcpy( c_buffer(), pbszText, uSize );
+   bool bAscii = uCount == uSize || gd::utf8::is_ascii( pbszText, pbszText + uSize );
    m_pbuffer->size( uSize );
-   m_pbuffer->count( uCount );
+   m_pbuffer->count( bAscii == true ? uSize : uCount );
+   _set_ascii( bAscii );
    m_pbuffer->c_buffer_end()[0] = '\0';
 
    return *this;
@@ -122,6 +131,7 @@ string& string::assign( const value_type* pbszText, uint32_t uSize, uint32_t uCo
 
 void string::push_back( uint8_t ch )
 {
+   bool bAscii = is_ascii();
    allocate( SIZE8_MAX_UTF_SIZE );
 
    auto pbszEnd = c_buffer_end();
@@ -130,13 +140,15 @@ void string::push_back( uint8_t ch )
    pbszEnd[uSize] = '\0';
 
    m_pbuffer->size( m_pbuffer->size() + uSize );
-   m_pbuffer->count( m_pbuffer->count() + 1 );
+   m_pbuffer->add_count( 1 );
+   _set_ascii( bAscii == true && uSize == 1 );
 }
 
 
 
 void string::push_back( uint16_t ch )
 {
+   bool bAscii = is_ascii();
    allocate( SIZE16_MAX_UTF_SIZE );
 
    auto pbszEnd = c_buffer_end();
@@ -145,7 +157,8 @@ void string::push_back( uint16_t ch )
    pbszEnd[uSize] = '\0';
 
    m_pbuffer->size( m_pbuffer->size() + uSize );
-   m_pbuffer->count( m_pbuffer->count() + 1 );
+   m_pbuffer->add_count( 1 );
+   _set_ascii( bAscii == true && uSize == 1 );
 }
 
 
@@ -155,6 +168,7 @@ void string::push_back( uint16_t ch )
  */
 void string::push_back( uint32_t ch )
 {
+   bool bAscii = is_ascii();
    allocate( SIZE32_MAX_UTF_SIZE );                                                     // add four bytes, max size for utf32_t character
 
    auto pbszEnd = c_buffer_end();
@@ -163,11 +177,13 @@ void string::push_back( uint32_t ch )
    pbszEnd[uSize] = '\0';
 
    m_pbuffer->size( m_pbuffer->size() + uSize );
-   m_pbuffer->count( m_pbuffer->count() + 1 );
+   m_pbuffer->add_count( 1 );
+   _set_ascii( bAscii == true && uSize == 1 );
 }
 
 string& string::append( const char* pbszText, uint32_t uLength )
 {
+   bool bAscii = is_ascii();
    uint32_t uSize = gd::utf8::size( pbszText, uLength );
    allocate( uSize );
 
@@ -175,25 +191,30 @@ string& string::append( const char* pbszText, uint32_t uLength )
    convert_ascii( pbszText, pbszEnd );
 
    m_pbuffer->size( m_pbuffer->size() + uSize );
-   m_pbuffer->count( m_pbuffer->count() + uLength );
+   m_pbuffer->add_count( uLength );
+   _set_ascii( bAscii == true && uSize == uLength );
 
    return *this;
 }
 
 string& string::append( const value_type* puText, uint32_t uSize )
 {
-   return append( puText, uSize, gd::utf8::count( puText ).first );
+   if( uSize == 0 ) return *this;
+   return append( puText, uSize, buffer::npos );                               // characters are counted when needed
 }
 
 string& string::append( const value_type* puText, uint32_t uSize, uint32_t uCount )
 {
+   bool bAscii = is_ascii();
    allocate( uSize );
 
    auto puEnd = c_buffer_end();
    memcpy( puEnd, puText, uSize );
 
    m_pbuffer->size( m_pbuffer->size() + uSize );
-   m_pbuffer->count( m_pbuffer->count() + uCount );
+   if( uCount == buffer::npos ) m_pbuffer->count_invalidate();
+   else m_pbuffer->add_count( uCount );
+   _set_ascii( bAscii == true && gd::utf8::is_ascii( puText, puText + uSize ) );// only added text is checked
    m_pbuffer->c_buffer_end()[0] = '\0';
 
    return *this;
@@ -205,12 +226,10 @@ string& string::replace( const_iterator itFrom, const_iterator itTo, const_point
                                                                               assert( string::verify_iterator( *this, itFrom ) == true );
                                                                               assert( string::verify_iterator( *this, itTo ) == true );
 
+   bool bAscii = is_ascii();
    std::size_t uSizeInString = itTo.get() - itFrom.get();// size in string that is replaced
-   const_pointer pInsert = itFrom.get(); // reinterpret_cast<pointer>( itFrom.get() );
-
-   // count number of characters that is removed
-   auto uReplaceCount = gd::utf8::count( itFrom, itTo ).first;
-   auto uInsertCount = gd::utf8::count( pbszText, pbszText + uLength ).first;
+   const_pointer pInsert = _safe_to_modify( itFrom.get() );                    // shared buffer is copied before edit
+   itTo = const_iterator( pInsert + uSizeInString );
 
    if( uLength > uSizeInString )
    {                                                                          assert( uLength - uSizeInString < 0x01000000 ); // realistic
@@ -221,9 +240,9 @@ string& string::replace( const_iterator itFrom, const_iterator itTo, const_point
       contract( itTo.get(), static_cast<uint32_t>( uSizeInString - uLength) );
    }
 
-   memcpy( (void*)pInsert, pbszText, uLength );
-   m_pbuffer->size( size() + (uLength - uSizeInString) );
-   m_pbuffer->count( count() + (uInsertCount - uReplaceCount) );
+   memcpy( (void*)pInsert, pbszText, uLength );                               // size is updated in expand or contract
+   m_pbuffer->count_invalidate();                                             // characters are counted when needed
+   _set_ascii( bAscii == true && gd::utf8::is_ascii( pbszText, pbszText + uLength ) );
 
    return *this;
 }
@@ -240,11 +259,13 @@ string& string::insert( iterator itFrom, iterator itTo, uint32_t uSize, uint32_t
 {                                                                             assert( uCharacter < 0x01000000 ); // realistic
                                                                               assert( string::verify_iterator( *this, itFrom ) == true );
                                                                               assert( string::verify_iterator( *this, itTo ) == true );
+   bool bAscii = is_ascii();
    value_type pChar[4];                            // buffer storing character
    auto uCharLength = gd::utf8::convert( uCharacter, pChar );// number of character values needed for character
    std::size_t uSizeNeeded = uCharLength * uSize;  // size needed in string to store character
    std::size_t uSizeInString = itTo.get() - itFrom.get();// size in string that is replaced
-   pointer pInsert = itFrom.get(); // reinterpret_cast<pointer>( itFrom.get() );
+   pointer pInsert = _safe_to_modify( itFrom.get() );                          // shared buffer is copied before edit
+   itTo = iterator( pInsert + uSizeInString );
 
    if( uSizeNeeded > uSizeInString )
    {                                                                          assert( uSizeNeeded - uSizeInString < 0x01000000 ); // realistic
@@ -269,6 +290,8 @@ string& string::insert( iterator itFrom, iterator itTo, uint32_t uSize, uint32_t
       pInsert += uCharLength;                                                 assert( verify_iterator( *this, pInsert ) );
    }
 
+   m_pbuffer->count_invalidate();                                             // characters are counted when needed
+   _set_ascii( bAscii == true && uCharLength == 1 );
    return *this;
 }
 
@@ -282,6 +305,34 @@ string& string::insert( iterator itFrom, iterator itTo, uint32_t uSize, uint32_t
 */
 std::size_t string::squeeze( iterator itFrom, iterator itEnd, uint32_t ch )
 {
+   if( itFrom == itEnd ) return size();                                       // nothing to squeeze, common empty buffer is never written to
+
+   std::size_t uSizeSqueeze = itEnd.get() - itFrom.get();
+   itFrom = iterator( _safe_to_modify( itFrom.get() ) );                       // shared buffer is copied before edit
+   itEnd = iterator( itFrom.get() + uSizeSqueeze );
+
+   if( ch < 0x80 )                                                            // ascii marker, bytes are removed in blocks and kept characters counted in same pass
+   {
+      uint8_t* pubFrom = itFrom.get();
+      uint8_t* pubEnd = itEnd.get();
+      uint8_t* pubTextEnd = end().get();
+      bool bWhole = pubFrom == begin().get() && pubEnd == pubTextEnd;
+      uint32_t uCount = m_pbuffer->get_count();
+
+      auto [uKept, pubInsert] = gd::utf8::squeeze( pubFrom, pubEnd, static_cast<uint8_t>( ch ) );
+      uint32_t uRemoved = static_cast<uint32_t>( pubEnd - pubInsert );        // each marker is one character
+      if( pubEnd != pubTextEnd ) memmove( pubInsert, pubEnd, pubTextEnd - pubEnd );
+
+      uint32_t uSize = static_cast<uint32_t>( pubTextEnd - begin().get() ) - uRemoved;
+      *( begin().get() + uSize ) = '\0';
+      m_pbuffer->size( uSize );
+      if( bWhole == true ) m_pbuffer->count( uKept );
+      else if( uCount != buffer::npos ) m_pbuffer->count( uCount - uRemoved );
+      else m_pbuffer->count_invalidate();
+
+      return uSize;
+   }
+
    uint8_t pCharacter[4];
    auto uCharSize = convert( ch, pCharacter );
 
@@ -305,9 +356,9 @@ std::size_t string::squeeze( iterator itFrom, iterator itEnd, uint32_t ch )
    
    *itInsert.get() = '\0';
    m_pbuffer->size( itInsert.get() - begin().get() );
-   m_pbuffer->count( gd::utf8::count( m_pbuffer->c_buffer() ).first );
+   m_pbuffer->count_invalidate();                                             // characters are counted when needed
 
-   return 0;
+   return size();
 }
 
 
@@ -328,15 +379,10 @@ string::const_iterator string::find( std::string_view stringFind ) const
 {
    if( stringFind.length() > size() ) return cend();
 
-   auto uCount = gd::utf8::count( stringFind.data() ).first;
-   if( uCount == stringFind.length() )
-   {                                                                          // no need to allocate
-      return find( reinterpret_cast<const_pointer>(stringFind.data()), stringFind.length() );
-   }
-
-   string stringFindCopy( stringFind );
+   auto pubFind = reinterpret_cast<const_pointer>( stringFind.data() );
+   if( is_ascii() == true && gd::utf8::is_ascii( pubFind, pubFind + stringFind.length() ) == false ) return cend();// ascii text can't have other characters
 
-   return find( stringFind );
+   return find( pubFind, static_cast<uint32_t>( stringFind.length() ) );     // utf8 text is found with byte compare
 }
 
 /**
@@ -384,7 +430,9 @@ string::const_iterator string::find( const_iterator itFrom, const_pointer pbszFi
 */
 string string::substr( const_iterator itFrom, const_iterator itTo )
 {
-   string s(itFrom, itTo);
+   uint32_t uSize = static_cast<uint32_t>( itTo.get() - itFrom.get() );
+   string s;
+   s.assign( itFrom.get(), uSize, is_ascii() == true ? uSize : buffer::npos );// ascii text is copied without check or count
    return std::move( s );
    //return string( itFrom, itTo );
 }
@@ -467,6 +515,13 @@ void string::sort( iterator itFirst, iterator itLast, std::function<bool( value_
       itLast = m_pbuffer->move_to( pbuffer, itLast.get() );
       m_pbuffer = pbuffer;                                                     DEBUG_ONLY( m_psz = m_pbuffer->c_str() );
    }
+   m_pbuffer->index_drop();                                                    // characters may change size
+   if( is_ascii() == true )                                                    // characters are bytes
+   {
+      std::sort( itFirst.get(), itLast.get(), compare );
+      return;
+   }
+
    std::vector<uint32_t> vectorValue;
    for( auto it = itFirst; it != itLast; it++ ) vectorValue.push_back( *it );
    std::sort( vectorValue.begin(), vectorValue.end(), compare );
@@ -540,10 +595,10 @@ void string::sort( iterator itFirst, iterator itLast, std::function<bool( value_
 string::iterator string::erase( iterator itFirst, iterator itLast, bool bCount )
 {                                                                             assert( itLast.get() > itFirst.get() ); assert( itLast.get() <= end().get() );
 
-   if( bCount == true ) m_pbuffer->count( gd::utf8::count( m_pbuffer->c_buffer() ).first );
-
    uint32_t uMoveSize{0};
    uint32_t uRemoveSize = static_cast<uint32_t>(itLast.get() - itFirst.get());
+   itFirst = iterator( _safe_to_modify( itFirst.get() ) );                     // shared buffer is copied before edit
+   itLast = iterator( itFirst.get() + uRemoveSize );
 
    if( itLast != end() ) { uMoveSize = static_cast<uint32_t>(end().get() - itLast.get()); }
 
@@ -555,7 +610,8 @@ string::iterator string::erase( iterator itFirst, iterator itLast, bool bCount )
    m_pbuffer->size( m_pbuffer->size() - uRemoveSize );
    m_pbuffer->c_buffer_end()[0] = '\0';
 
-   if( bCount == true ) m_pbuffer->count( gd::utf8::count( m_pbuffer->c_buffer() ).first );
+   m_pbuffer->count_invalidate();
+   if( bCount == true ) m_pbuffer->count();                                   // count now if asked for
 
    return itFirst;
 }
@@ -577,6 +633,7 @@ string::const_pointer string::expand( const_pointer pPosition, uint32_t uSize )
    std::memmove( (uint8_t*)pPosition + uSize, pPosition, uMoveSize + 1 );               // move data to make gap, add one will add the ending \0 character.
 
    m_pbuffer->size( m_pbuffer->size() + uSize );
+   _set_ascii( false );                                                       // gap is filled by caller
    return c_buffer() + uOffset;
 }
 
@@ -588,6 +645,7 @@ string::const_pointer string::expand( const_pointer pPosition, uint32_t uSize )
 */
 string::const_pointer string::contract( const_pointer pvPosition, uint32_t uSize )
 {
+   pvPosition = _safe_to_modify( pvPosition );                                 // shared buffer is copied before edit
    auto uMoveSize = c_buffer_end() - pvPosition;
    std::memmove( (uint8_t*)pvPosition - uSize, pvPosition, uMoveSize );
    m_pbuffer->size( m_pbuffer->size() - uSize );
@@ -603,9 +661,16 @@ string::const_pointer string::contract( const_pointer pvPosition, uint32_t uSize
 void string::allocate(uint32_t uSize)
 {                                                                              assert( m_pbuffer->check_flags() );
    //uSize += sizeof(string::buffer);
-   if( uSize + m_pbuffer->size() >= m_pbuffer->capacity() )
+   bool bShared = m_pbuffer->is_refcount() && m_pbuffer->get_reference() > 1;// shared buffer is never written to, new buffer even if capacity is enough
+   if( uSize + m_pbuffer->size() >= m_pbuffer->capacity() || bShared == true )
    {
-      uint32_t uFlags = m_pbuffer->is_type_reference() ? eBufferStorageReferenceCount : eBufferStorageSingle;
+      if( m_pbuffer->is_common_empty() == true && uSize < buffer_inline::capacity )// short text is stored in string object
+      {
+         _use_inline();
+         return;
+      }
+
+      uint32_t uFlags = m_pbuffer->get_allocate_storage();
       auto _size_old = m_pbuffer->size(); // + sizeof(string::buffer);
       uint32_t uSizeAll = uSize + m_pbuffer->size() + sizeof(string::buffer);
 
@@ -619,12 +684,14 @@ void string::allocate(uint32_t uSize)
          if( uAdd < 64 ) uSizeAll += 4096;
       }
 
-      uint8_t* puNew = new uint8_t[uSizeAll];
-      memcpy( puNew, m_pbuffer, _size_old + sizeof(string::buffer) );          assert( _size_old == 0 || m_pbuffer->c_buffer_end()[0] == '\0' );
+      buffer* pbufferNew = new_buffer( m_pallocator, uSizeAll + 1 );          // one extra for zero ending, same as exact size buffers
+      pbufferNew->flags( uFlags | ( m_pallocator != nullptr ? eBufferStorageAllocator : 0 ) | ( m_pbuffer->flags() & eBufferTextAscii ) );
+      memcpy( pbufferNew->c_buffer(), m_pbuffer->c_buffer(), _size_old );     assert( _size_old == 0 || m_pbuffer->c_buffer_end()[0] == '\0' );
+      pbufferNew->size( _size_old );
+      pbufferNew->count( m_pbuffer->get_count() );                             // header is not copied, reference counter may be changed by other threads
       string::release( m_pbuffer );
-      m_pbuffer = reinterpret_cast<string::buffer*>( puNew );
+      m_pbuffer = pbufferNew;
       m_pbuffer->set_reference( 1 );
-      m_pbuffer->flags(uFlags);
       m_pbuffer->capacity( uSizeAll - sizeof(string::buffer) );              // new capacity after increased size
       m_pbuffer->null_terminate();
 #  ifdef DEBUG
@@ -696,44 +763,53 @@ void string::allocate_exact(uint32_t uSize)
 void string::allocate_exact(string& stringObject, uint32_t uSize)
 {                                                                                assert(uSize < 0x01000000); // realistic !!
    buffer* pbufferOld = stringObject.m_pbuffer;
-   auto pbuffer = stringObject.m_pbuffer;
+   buffer* pbuffer;
+   uint32_t uFlags;
+   uint32_t uCapacity = uSize;
 
-   // ## allocate buffer
-   auto _size = uSize + sizeof(string::buffer);
-   uint8_t* puNew = new uint8_t[_size + 1];                                     // exact size + zero ending
-   pbuffer = reinterpret_cast<string::buffer*>(puNew);
-   uint32_t uFlags = pbufferOld->is_type_reference() ? eBufferStorageReferenceCount : eBufferStorageSingle;
+   // ## select buffer, short text is stored in string object
+   if( uSize <= buffer_inline::capacity )
+   {
+      pbuffer = &stringObject.m_bufferInline.m_buffer;
+      uFlags = pbufferOld->get_inline_storage();
+      uCapacity = buffer_inline::capacity;
+   }
+   else
+   {
+      auto _size = uSize + sizeof(string::buffer);
+      pbuffer = new_buffer( stringObject.m_pallocator, _size + 1 );             // exact size + zero ending
+      uFlags = pbufferOld->get_allocate_storage();
+      if( stringObject.m_pallocator != nullptr ) uFlags |= eBufferStorageAllocator;
+   }
 
-   if(string::is_empty(pbufferOld) == false)                                    // if old buffer has a valid string, copy
+   // ## text kept from old buffer
+   uint32_t uKeep = 0;                                                         // bytes kept
+   uint32_t uCount = 0;                                                        // characters kept
+   if(string::is_empty(pbufferOld) == false && pbufferOld->size() > 0)
    {
-      pbuffer->capacity(uSize);                                                 // set buffer size
-      if(pbufferOld->size() > 0)
+      uKeep = pbufferOld->size();
+      uCount = pbufferOld->get_count();
+      if(uKeep > uSize)                                                        // if string is larger then we need to walk backwards to find where to cut, utf8 remember... a character may be stored in multiple bytes
       {
-         if(pbufferOld->size() > uSize)                                         // if string is larger then we need to walk backwards to find where to cut, utf8 remember... a character may be stored in multiple bytes
+         auto pubszEnd = pbufferOld->c_buffer_end();
+         while(pubszEnd - pbufferOld->c_buffer() > uSize)
          {
-            auto uCount = pbufferOld->count();
-            auto pubszEnd = pbufferOld->c_buffer_end();
-            while(uCount > 0 && pubszEnd - pbufferOld->c_buffer() > uSize)
-            {
-               pubszEnd = move::previous(pubszEnd);
-               uCount--;
-            }
-
-            uSize = static_cast<uint32_t>(pubszEnd - pbufferOld->c_buffer());
-            pbuffer->count(uCount);
-            pbuffer->size(uSize);
+            pubszEnd = move::previous(pubszEnd);
+            if( uCount != buffer::npos ) uCount--;
          }
-         assert(pbufferOld->c_buffer_end()[0] == '\0');
-         memcpy(pbuffer->c_buffer(), pbufferOld->c_buffer(), uSize);
-         pbuffer->c_buffer()[uSize] = '\0';
-         string::release(pbufferOld);
+
+         uKeep = static_cast<uint32_t>(pubszEnd - pbufferOld->c_buffer());
       }
+      if( pbuffer != pbufferOld ) memcpy(pbuffer->c_buffer(), pbufferOld->c_buffer(), uKeep);
    }
-   else
-   {
-      pbuffer->reset(uSize);
-   }
-   pbuffer->flags(uFlags);                                                       // set flags
+
+   pbuffer->flags(uFlags | ( pbufferOld->flags() & eBufferTextAscii ));         // set flags, first because buffer may not be initialized. kept text is ascii if old text was
+   pbuffer->capacity( uCapacity );
+   pbuffer->set_reference( 1 );
+   pbuffer->size( uKeep );
+   pbuffer->count( uCount );
+   pbuffer->null_terminate();
+   if( pbuffer != pbufferOld ) string::release(pbufferOld);
 
    stringObject.m_pbuffer = pbuffer;
 
@@ -769,9 +845,9 @@ void string::_clone(const string& o)
    else if( o.m_pbuffer->is_common_empty() == false )
    {
       allocate_exact(o.size());
-      m_pbuffer->flags( eBufferStorageSingle );                               // string type is referenced counted
+      m_pbuffer->flags( ( m_pbuffer->flags() & ( eBufferStorageInline | eBufferStorageAllocator ) ) | eBufferStorageSingle | ( o.m_pbuffer->flags() & eBufferTextAscii ) );// copy is not reference counted
       m_pbuffer->size(o.size());
-      m_pbuffer->count(o.count());
+      m_pbuffer->count(o.m_pbuffer->get_count());                            // keep count state, may not be counted
       m_pbuffer->set_reference(1);
       memcpy(c_buffer(), o.c_buffer(), size());
    }
@@ -795,16 +871,212 @@ void string::_clone(const string& o)
 #  endif
 }
 
+/**
+ * @brief Copy text stored in other string object to this string object
+ * @param o string with text in string object
+*/
+void string::_copy_inline( const string& o )
+{                                                                             assert( o.m_pbuffer->is_inline() == true );
+   static_assert( offsetof( buffer_inline, m_puText ) == sizeof( buffer ), "text need to follow buffer header" );
+   m_bufferInline.m_buffer = o.m_bufferInline.m_buffer;
+   memcpy( m_bufferInline.m_puText, o.m_bufferInline.m_puText, o.size() + 1 ); // add null terminator
+   m_pbuffer = &m_bufferInline.m_buffer;
+#  ifdef DEBUG
+   m_psz = reinterpret_cast<const char*>( m_pbuffer->c_buffer() );
+#  endif
+}
+
+/**
+ * @brief Take text from other string, other string is empty after move
+ * Allocated buffers are taken, text stored in string object is copied.
+ * @param o string text is moved from
+*/
+void string::_move( string& o ) noexcept
+{
+   if( o.m_pbuffer->is_inline() == true ) _copy_inline( o );
+   else
+   {
+      m_pbuffer = o.m_pbuffer;
+#  ifdef DEBUG
+      m_psz = reinterpret_cast<const char*>( m_pbuffer->c_buffer() );
+#  endif
+   }
+
+   o.m_pbuffer = string::get_empty( o.m_pbuffer );
+#  ifdef DEBUG
+   o.m_psz = nullptr;
+#  endif
+}
+
+/**
+ * @brief Switch empty string to buffer in string object
+*/
+void string::_use_inline()
+{                                                                             assert( m_pbuffer->is_common_empty() == true );
+   uint32_t uFlags = m_pbuffer->get_inline_storage();
+   m_bufferInline.m_buffer.reset( buffer_inline::capacity );
+   m_bufferInline.m_buffer.flags( uFlags );
+   m_pbuffer = &m_bufferInline.m_buffer;
+#  ifdef DEBUG
+   m_psz = reinterpret_cast<const char*>( m_pbuffer->c_buffer() );
+#  endif
+}
+
+/**
+ * @brief Allocate memory for buffer
+ * Slot for character index is placed before buffer. If allocator is used,
+ * pointer to allocator is stored before index slot so the buffer can be
+ * returned to allocator when last string releases it.
+ * @param pallocator allocator or nullptr for new
+ * @param uSize bytes needed for buffer header and text
+ * @return pointer to buffer (not initialized, index slot is empty)
+*/
+string::buffer* string::new_buffer( gd::utf8::allocator* pallocator, std::size_t uSize )
+{
+   character_index** ppindex;
+   if( pallocator == nullptr ) ppindex = reinterpret_cast<character_index**>( new uint8_t[uSize + sizeof( character_index* )] );
+   else
+   {
+      auto ppallocator = static_cast<gd::utf8::allocator**>( pallocator->allocate( uSize + sizeof( character_index* ) + sizeof( gd::utf8::allocator* ) ) );
+      *ppallocator = pallocator;
+      ppindex = reinterpret_cast<character_index**>( ppallocator + 1 );
+   }
+
+   *ppindex = nullptr;
+   return reinterpret_cast<string::buffer*>( ppindex + 1 );
+}
+
+/**
+ * @brief Free buffer allocated with `new_buffer`, character index is freed if built
+ * @param pbuffer buffer to free
+*/
+void string::free_buffer( buffer* pbuffer )
+{
+   character_index** ppindex = pbuffer->index_slot();
+   delete *ppindex;
+
+   gd::utf8::allocator* pallocator = pbuffer->get_allocator();
+   if( pallocator == nullptr ) { delete[] reinterpret_cast<uint8_t*>( ppindex ); return; }
+
+   auto ppallocator = reinterpret_cast<gd::utf8::allocator**>( ppindex ) - 1;
+   pallocator->deallocate( ppallocator, pbuffer->size_allocated() + sizeof( character_index* ) + sizeof( gd::utf8::allocator* ) );
+}
+
+/**
+ * @brief Free character index, called when text in buffer is modified
+ * @param pbuffer buffer with character index
+*/
+void string::free_index( buffer* pbuffer )
+{                                                                              assert( pbuffer->is_heap() == true );
+   character_index** ppindex = pbuffer->index_slot();
+   delete *ppindex;
+   *ppindex = nullptr;
+}
+
+/**
+ * @brief Get character index for text, index is built if not found
+ * Index is stored with buffer and shared by all strings that share buffer.
+ * @return character index
+*/
+const string::character_index* string::get_character_index() const
+{                                                                              assert( m_pbuffer->is_heap() == true );
+   const character_index* pindex = m_pbuffer->get_index();
+   if( pindex != nullptr ) return pindex;
+
+   auto pindexNew = new character_index;
+   pindexNew->m_vectorOffset.reserve( size() / character_index::step + 1 );
+   const_pointer pubText = c_buffer();
+   uint32_t uCharacter = 0;
+   for( uint32_t u = 0, uSize = static_cast<uint32_t>( size() ); u < uSize; u++ )
+   {
+      if( ( pubText[u] & 0xC0 ) == 0x80 ) continue;                            // continuation byte
+      if( ( uCharacter % character_index::step ) == 0 ) pindexNew->m_vectorOffset.push_back( u );
+      uCharacter++;
+   }
+
+   pindex = m_pbuffer->set_index( pindexNew );
+   if( pindex != pindexNew ) delete pindexNew;                                 // other thread was first
+   return pindex;
+}
+
+/**
+ * @brief Position for character in text
+ * Text with only ASCII characters (flag or counted) is indexed directly, large text
+ * uses character index with checkpoints and small text is walked.
+ * @param uIndex character index
+ * @return iterator to character or end if index is past last character
+*/
+string::const_iterator string::position( size_type uIndex ) const
+{
+   const_pointer pubText = c_buffer();
+   const_pointer pubEnd = pubText + size();
+   if( is_ascii() == true || ( m_pbuffer->is_counted() == true && m_pbuffer->get_count() == size() ) ) return const_iterator( uIndex < size() ? pubText + uIndex : pubEnd );
+
+   if( size() >= character_index::min_size && m_pbuffer->is_heap() == true )
+   {
+      const character_index* pindex = get_character_index();
+      std::size_t uCheckpoint = uIndex / character_index::step;
+      if( uCheckpoint >= pindex->m_vectorOffset.size() ) return const_iterator( pubEnd );
+      pubText += pindex->m_vectorOffset[uCheckpoint];
+      uIndex %= character_index::step;
+   }
+
+   while( uIndex > 0 && pubText < pubEnd ) { pubText = gd::utf8::move::next( pubText ); uIndex--; }
+   return const_iterator( pubText < pubEnd ? pubText : pubEnd );
+}
+
+/**
+ * ## arena ===================================================================
+ */
+
+/**
+ * @brief Take memory from active block, new block is allocated if not enough space
+ * @param uSize bytes needed
+ * @return pointer to memory, aligned to 16 bytes
+*/
+void* arena::allocate( std::size_t uSize )
+{
+   uSize = ( uSize + 15 ) & ~std::size_t( 15 );
+   if( uSize > static_cast<std::size_t>( m_puEnd - m_puPosition ) )
+   {
+      std::size_t uBlock = uSize > m_uBlockSize ? uSize : m_uBlockSize;
+      uint8_t* puBlock = static_cast<uint8_t*>( ::operator new( uBlock, std::align_val_t( 16 ) ) );
+      m_vectorBlock.push_back( puBlock );
+      if( uBlock > m_uBlockSize ) { m_uSize += uSize; return puBlock; }       // large request has its own block, active block is kept
+
+      m_puPosition = puBlock;
+      m_puEnd = puBlock + uBlock;
+   }
+
+   void* p = m_puPosition;
+   m_puPosition += uSize;
+   m_uSize += uSize;
+   return p;
+}
+
+/**
+ * @brief Free all blocks
+*/
+void arena::release()
+{
+   for( auto it : m_vectorBlock ) ::operator delete( it, std::align_val_t( 16 ) );
+   m_vectorBlock.clear();
+   m_puPosition = nullptr;
+   m_puEnd = nullptr;
+   m_uSize = 0;
+}
+
 string::buffer* string::buffer::clone()
 {
    auto _size = size() + sizeof(string::buffer);
-   uint8_t* puNew = new uint8_t[_size + 1];                                    // exact size + zero ending
-   auto pbuffer = reinterpret_cast<string::buffer*>(puNew);
-   memcpy( puNew, this, _size ); 
+   auto pallocator = get_allocator();                                          // copy is allocated from same allocator
+   auto pbuffer = string::new_buffer( pallocator, _size + 1 );                 // exact size + zero ending
+   memcpy( pbuffer, this, _size ); 
    memcpy(pbuffer->c_buffer(), c_buffer(), size() + 1 );                       // add null terminator
-   uint32_t uFlags = is_type_reference() ? eBufferStorageReferenceCount : eBufferStorageSingle;
-   pbuffer->flags(uFlags);                                                     // set flags
+   pbuffer->flags( get_allocate_storage() | ( pallocator != nullptr ? eBufferStorageAllocator : 0 ) | ( m_uFlags & eBufferTextAscii ) );// set flags
    pbuffer->capacity( size() );
+   pbuffer->count( get_count() );
+   pbuffer->set_reference( 1 );
    return pbuffer;
 }
 
@@ -4,10 +4,13 @@
 #include <iostream>
 #include <fstream>
 #include <regex>
+#include <filesystem>
+#include <chrono>
 
 #include <windows.h>
 
 #include "application.hpp"
+#include "application_batch.hpp"
 
 #include "gd_utf8.hpp"
 
@@ -133,6 +136,91 @@ TEST_CASE( "Split string", "[split]" ) {
                                                                                REQUIRE( stringText == section.Join() );
 }
 
+TEST_CASE( "Split string with arena", "[split]" ) {
+   using namespace application::file;
+   auto parena = std::make_shared<gd::utf8::arena>();
+   gd::utf8::string stringText( std::string( 1000, 'a' ) + std::string( 1000, 'b' ) );
+   CFile fileTest;
+   fileTest.SetAllocator( parena );
+   fileTest.SECTION_Append( stringText );
+
+   auto section = fileTest.SECTION_At( 0 );
+   section.Split( std::vector<std::size_t>( 19, 100 ) );                       REQUIRE( section.SECTION_Size() == 20 );
+                                                                               REQUIRE( parena->size() == 0 );// sections are views, nothing is copied
+                                                                               REQUIRE( stringText == section.Join() );
+                                                                               REQUIRE( section.SECTION_At( 19 ).code().m_pbuffer->get_allocator() == parena.get() );
+                                                                               REQUIRE( parena->size() >= 100 );
+
+   // ## section keeps arena after file is gone, edits and replace allocate from it
+   std::weak_ptr<gd::utf8::allocator> pweakArena;
+   std::unique_ptr<CSection> psectionCopy;
+   {
+      CFile fileArena;
+      auto parenaFile = std::make_shared<gd::utf8::arena>();
+      pweakArena = parenaFile;
+      fileArena.SetAllocator( std::move( parenaFile ) );
+      fileArena.SECTION_Append( stringText );
+      fileArena.SECTION_At( 0 ).Split( { 100 } );
+      psectionCopy = std::make_unique<CSection>( fileArena.SECTION_At( 0 ).SECTION_At( 1 ) );
+   }
+                                                                               REQUIRE( pweakArena.expired() == false );
+   psectionCopy->EDIT_Insert( 0, "x" );
+   psectionCopy->Replace( std::regex( "b+" ), "c" );                           REQUIRE( psectionCopy->view() == "x" + std::string( 900, 'a' ) + "c" );
+                                                                               REQUIRE( psectionCopy->code().get_allocator() == pweakArena.lock().get() );
+   psectionCopy.reset();                                                       REQUIRE( pweakArena.expired() == true );
+}
+
+TEST_CASE( "Split file into section views", "[split]" ) {
+   using namespace application::file;
+   const char* pbszText = "SELECT åäö;\nSELECT 2;\nSELECT 3;\n";
+   gd::utf8::string stringText;
+   stringText.assign( reinterpret_cast<const uint8_t*>( pbszText ), std::strlen( pbszText ) );
+   const char* pbszBegin = stringText.c_str();
+   const char* pbszEnd = pbszBegin + stringText.size();
+   auto in_text_ = [pbszBegin, pbszEnd]( std::string_view stringView ) { return stringView.data() >= pbszBegin && stringView.data() + stringView.length() <= pbszEnd; };
+
+   CFile fileTest;
+   fileTest.SECTION_Append( stringText );
+   CSection& section = fileTest.SECTION_At( 0 );                              REQUIRE( &section == &*fileTest.SECTION_Begin() );
+   section.Split( { 12, 10 } );                                                REQUIRE( section.SECTION_Size() == 3 );
+                                                                               REQUIRE( section.view().empty() == true );
+   CSection& sectionFirst = section.SECTION_At( 0 );                          REQUIRE( sectionFirst.IsView() == true );
+                                                                               REQUIRE( in_text_( sectionFirst.view() ) == true );
+                                                                               REQUIRE( sectionFirst.view() == "SELECT åäö;\n" );
+                                                                               REQUIRE( section.SECTION_At( 2 ).view() == "SELECT 3;\n" );
+
+   // ## split view and keep it, sections point into same buffer
+   sectionFirst.Split( { 7 }, true );                                          REQUIRE( sectionFirst.SECTION_Size() == 2 );
+                                                                               REQUIRE( sectionFirst.SECTION_At( 1 ).view() == "åäö;\n" );
+                                                                               REQUIRE( in_text_( sectionFirst.SECTION_At( 1 ).view() ) == true );
+
+   // ## edit and erase gets own code, other sections are still views
+   CSection& sectionSecond = section.SECTION_At( 1 );
+   sectionSecond.EDIT_Insert( 7, "1 + " );                                     REQUIRE( sectionSecond.IsView() == true );
+   sectionSecond.EDIT_End();                                                   REQUIRE( sectionSecond.IsView() == false );
+                                                                               REQUIRE( sectionSecond.view() == "SELECT 1 + 2;\n" );
+   CSection& sectionThird = section.SECTION_At( 2 );
+   sectionThird.Erase( std::regex( "SELECT " ) );                              REQUIRE( sectionThird.IsView() == true );
+                                                                               REQUIRE( sectionThird.code().count() == 3 );
+                                                                               REQUIRE( sectionThird.IsView() == false );
+                                                                               REQUIRE( in_text_( section.SECTION_At( 0 ).view() ) == true );
+   gd::utf8::string stringJoin = section.Join();                               REQUIRE( std::string_view( stringJoin.c_str(), stringJoin.size() ) == "SELECT åäö;\nSELECT 1 + 2;\n3;\n" );
+}
+
+TEST_CASE( "Split unique text into views over one buffer", "[split]" ) {
+   using namespace application::file;
+   gd::utf8::string stringUnique( gd::utf8::string::unique );
+   stringUnique.assign( std::string( 300, 'a' ) );                             REQUIRE( stringUnique.is_refcount() == false );
+   CSection section( nullptr, gd::utf8::string( "sql" ), std::move( stringUnique ) );
+   section.Split( { 100, 100 } );                                              REQUIRE( section.SECTION_Size() == 3 );
+   const CSection& sectionFirst = section.SECTION_At( 0 );                    REQUIRE( sectionFirst.m_stringShared.is_refcount() == true );
+                                                                               REQUIRE( sectionFirst.m_stringShared.c_str() == section.SECTION_At( 2 ).m_stringShared.c_str() );
+                                                                               REQUIRE( sectionFirst.view() == std::string( 100, 'a' ) );
+   CSection& sectionLast = section.SECTION_At( 2 );
+   sectionLast.code();                                                         REQUIRE( sectionLast.IsView() == false );
+                                                                               REQUIRE( std::as_const( sectionLast ).view().size() == 100 );
+}
+
 
 /*
 TEST_CASE("test", "[vanderbilt]") {
@@ -282,6 +370,258 @@ TEST_CASE("convert lua file", "[folder]") {
    }
 }
 
+TEST_CASE("convert folder in batch", "[folder]") {
+   using namespace application;
+
+   std::filesystem::path pathFolder = std::filesystem::temp_directory_path() / "fw_test_batch";
+   std::filesystem::remove_all( pathFolder );
+   std::filesystem::create_directories( pathFolder / "serial" );
+   std::filesystem::create_directories( pathFolder / "batch" );
+
+   for( int i = 0; i < 40; i++ )
+   {
+      std::ofstream ofstreamFile( pathFolder / std::format( "script{:02}.sql", i ), std::ofstream::binary );
+      for( int j = 0; j < i * 10; j++ ) ofstreamFile << std::format( "-- row {}\nCREATE NONCLUSTERED INDEX i{} ON t{} (c{});\n", j, j, i, j );
+   }
+   { std::ofstream ofstreamFile( pathFolder / "skip.txt" ); ofstreamFile << "-- not sql"; }
+   { std::ofstream ofstreamFile( pathFolder / "fail.sql" ); ofstreamFile << "-- fail"; }
+
+   auto transform_ = []( file::CFile& fileSql ) -> std::pair<bool, std::string> {
+      if( fileSql.name() == "fail" ) return { false, "fail" };
+      fileSql.SECTION_Erase( boost::regex( R"(--[^\r\n]*)" ) );
+      fileSql.SECTION_Erase( boost::regex( R"( NONCLUSTERED)" ) );
+      return { true, std::string() };
+   };
+
+   CBatch batch( transform_, 4 );
+   auto [bOk, stringError] = batch.Run( file::CFolder( "sql", pathFolder.string() ), { {"extension", ".sql"} }, file::CFolder( "out", ( pathFolder / "batch" ).string() ) ); REQUIRE( bOk == true );
+                                                                               REQUIRE( batch.converted() == 40 );
+                                                                               REQUIRE( batch.errors().size() == 1 );
+                                                                               REQUIRE( batch.errors()[0].m_stringError == "fail" );
+
+   // ## compare with serial conversion
+   for( int i = 0; i < 40; i++ )
+   {
+      std::string stringName = std::format( "script{:02}.sql", i );
+      CDocument documentSerial;
+      std::tie( bOk, stringError ) = documentSerial.FILE_Load( ( pathFolder / stringName ).string(), "serial" ); REQUIRE( bOk == true );
+      file::CFile* pFile = documentSerial.FILE_Get();
+      std::tie( bOk, stringError ) = transform_( *pFile );                     REQUIRE( bOk == true );
+      std::tie( bOk, stringError ) = documentSerial.FILE_Save( ( pathFolder / "serial" / stringName ).string(), pFile->name() ); REQUIRE( bOk == true );
+
+      gd::utf8::string stringSerial, stringBatch;
+      FILE_Load( ( pathFolder / "serial" / stringName ).string(), stringSerial );
+      FILE_Load( ( pathFolder / "batch" / stringName ).string(), stringBatch );
+                                                                               REQUIRE( stringSerial == stringBatch );
+                                                                               REQUIRE( std::string_view( stringBatch.c_str() ).find( "--" ) == std::string_view::npos );
+   }
+
+   std::tie( bOk, stringError ) = batch.Run( file::CFolder( "missing", ( pathFolder / "missing" ).string() ), gd::argument::arguments() ); REQUIRE( bOk == false );
+
+   // ## exception not derived from std::exception is rethrown after all files are done
+   CBatch batchThrow( []( file::CFile& fileSql ) -> std::pair<bool, std::string> {
+      if( fileSql.name() == "script05" ) throw 5;
+      return { true, std::string() };
+   }, 4 );
+   REQUIRE_THROWS_AS( batchThrow.Run( file::CFolder( "sql", pathFolder.string() ), { {"extension", ".sql"} }, file::CFolder( "out", ( pathFolder / "batch" ).string() ) ), int );
+                                                                               REQUIRE( batchThrow.converted() == 40 );
+                                                                               REQUIRE( batchThrow.errors().size() == 1 );
+
+   std::filesystem::remove_all( pathFolder );
+}
+
+TEST_CASE("convert folder with cache", "[folder]") {
+   using namespace application;
+
+   std::filesystem::path pathFolder = std::filesystem::temp_directory_path() / "fw_test_cache";
+   std::filesystem::remove_all( pathFolder );
+   std::filesystem::create_directories( pathFolder / "out" );
+
+   auto write_ = [&pathFolder]( int i, std::string_view stringExtra ) {
+      std::ofstream ofstreamFile( pathFolder / std::format( "script{:02}.sql", i ), std::ofstream::binary );
+      for( int j = 0; j < 20; j++ ) ofstreamFile << std::format( "-- row {}\nSELECT {} FROM t{};{}\n", j, j, i, stringExtra );
+   };
+   for( int i = 0; i < 10; i++ ) write_( i, "" );
+
+   file::CRuleProgram programSql( { file::CRule( boost::regex( R"(--[^\r\n]*)" ) ) } );
+   std::string stringKey = programSql.key();                                   REQUIRE( stringKey.empty() == false );
+   file::CRuleProgram programStd( { file::CRule( std::regex( "--" ) ) } );    REQUIRE( programStd.key().empty() == true );
+
+   CConvertCache cacheSql( ( pathFolder / "cache" ).string(), stringKey );
+   CBatch batch( [&programSql]( file::CFile& fileSql ) { return fileSql.SECTION_Apply( programSql ); }, 2 );
+   batch.cache( &cacheSql );
+
+   auto run_ = [&]() {
+      auto [bOk, stringError] = batch.Run( file::CFolder( "sql", pathFolder.string() ), { {"extension", ".sql"} }, file::CFolder( "out", ( pathFolder / "out" ).string() ) ); REQUIRE( bOk == true );
+                                                                               REQUIRE( batch.converted() == 10 );
+   };
+
+   // ## first run converts all files
+   run_();                                                                     REQUIRE( cacheSql.hit() == 0 );
+                                                                               REQUIRE( cacheSql.miss() == 10 );
+
+   // ## second run copies all files from cache
+   std::filesystem::remove_all( pathFolder / "out" );
+   std::filesystem::create_directories( pathFolder / "out" );
+   cacheSql.clear_statistics();
+   run_();                                                                     REQUIRE( cacheSql.hit() == 10 );
+                                                                               REQUIRE( cacheSql.miss() == 0 );
+                                                                               REQUIRE( cacheSql.hit_bytes() > 0 );
+   for( int i = 0; i < 10; i++ )
+   {
+      std::string stringName = std::format( "script{:02}.sql", i );
+      gd::utf8::string stringResult;
+      FILE_Load( ( pathFolder / "out" / stringName ).string(), stringResult );
+                                                                               REQUIRE( std::string_view( stringResult.c_str() ).find( "--" ) == std::string_view::npos );
+                                                                               REQUIRE( std::string_view( stringResult.c_str() ).find( std::format( "FROM t{};", i ) ) != std::string_view::npos );
+   }
+
+   // ## changed file is converted, file with new time but same content is copied
+   write_( 3, " " );
+   auto timeWrite = std::filesystem::last_write_time( pathFolder / "script05.sql" );
+   std::filesystem::last_write_time( pathFolder / "script05.sql", timeWrite + std::chrono::seconds( 10 ) );
+   cacheSql.clear_statistics();
+   run_();                                                                     REQUIRE( cacheSql.hit() == 9 );
+                                                                               REQUIRE( cacheSql.miss() == 1 );
+   gd::utf8::string stringChanged;
+   FILE_Load( ( pathFolder / "out" / "script03.sql" ).string(), stringChanged );
+                                                                               REQUIRE( std::string_view( stringChanged.c_str() ).find( "; \n" ) != std::string_view::npos );
+
+   // ## other rules do not use entries for first rules
+   file::CRuleProgram programOther( { file::CRule( boost::regex( R"(SELECT)" ), "select" ) } );
+   CConvertCache cacheOther( ( pathFolder / "cache" ).string(), programOther.key() );
+   batch.cache( &cacheOther );
+   run_();                                                                     REQUIRE( cacheOther.hit() == 0 );
+                                                                               REQUIRE( cacheOther.miss() == 10 );
+
+   std::filesystem::remove_all( pathFolder );
+}
+
+TEST_CASE("save sections with gather write", "[file]") {
+   using namespace application;
+
+   std::filesystem::path pathFolder = std::filesystem::temp_directory_path() / "fw_test_save";
+   std::filesystem::remove_all( pathFolder );
+   std::filesystem::create_directories( pathFolder );
+   std::string stringFile = ( pathFolder / "sections.sql" ).string();
+
+   // ## more sections than one batch, some empty
+   std::string stringExpect;
+   auto pFile = std::make_unique<file::CFile>( stringFile );
+   for( int i = 0; i < 3000; i++ )
+   {
+      std::string stringText = i % 7 == 0 ? std::string() : std::format( "SELECT {} FROM t{};\n", i, i % 13 );
+      pFile->SECTION_Append( gd::utf8::string( "code" ), gd::utf8::string( stringText ) );
+      stringExpect += stringText;
+   }
+
+   CDocument document;
+   document.m_vectorFile.push_back( std::move( pFile ) );
+
+   // ## file named as old temporary file is not touched, no temporary files are left in folder
+   { std::ofstream ofstreamFile( stringFile + ".tmp", std::ofstream::binary ); ofstreamFile << "not temporary"; }
+   auto file_count_ = [&pathFolder]() { return std::distance( std::filesystem::directory_iterator( pathFolder ), std::filesystem::directory_iterator() ); };
+
+   for( unsigned uFlags : { 0u, (unsigned)file::CFileWrite::eFlagAtomic } )
+   {
+      { std::ofstream ofstreamFile( stringFile, std::ofstream::binary ); ofstreamFile << "old text that is longer than nothing"; }
+      auto permsFile = std::filesystem::perms::owner_read | std::filesystem::perms::owner_write | std::filesystem::perms::group_read;
+      std::filesystem::permissions( stringFile, permsFile );
+      permsFile = std::filesystem::status( stringFile ).permissions();         // permissions as set on platform
+      auto [bOk, stringError] = document.FILE_Save( stringFile, "sections", uFlags ); REQUIRE( bOk == true );
+
+      file::CFileMap filemapSaved;
+      std::tie( bOk, stringError ) = filemapSaved.Open( stringFile );          REQUIRE( bOk == true );
+                                                                               REQUIRE( filemapSaved.text() == stringExpect );
+                                                                               REQUIRE( std::filesystem::status( stringFile ).permissions() == permsFile );
+                                                                               REQUIRE( file_count_() == 2 );
+   }
+                                                                               REQUIRE( std::filesystem::file_size( stringFile + ".tmp" ) == 13 );
+
+   // ## two atomic writers to same file use different temporary files
+   {
+      file::CFileWrite filewriteFirst, filewriteSecond;
+      auto [bOk, stringError] = filewriteFirst.Open( stringFile, file::CFileWrite::eFlagAtomic ); REQUIRE( bOk == true );
+      std::tie( bOk, stringError ) = filewriteSecond.Open( stringFile, file::CFileWrite::eFlagAtomic ); REQUIRE( bOk == true );
+                                                                               REQUIRE( filewriteFirst.m_stringFileTemporary != filewriteSecond.m_stringFileTemporary );
+      filewriteFirst.Write( std::string_view( "first" ) );
+      filewriteSecond.Write( std::string_view( "second" ) );
+      std::tie( bOk, stringError ) = filewriteFirst.Close();                   REQUIRE( bOk == true );
+      std::tie( bOk, stringError ) = filewriteSecond.Close();                  REQUIRE( bOk == true );
+                                                                               REQUIRE( std::filesystem::file_size( stringFile ) == 6 );
+                                                                               REQUIRE( file_count_() == 2 );
+      document.FILE_Save( stringFile, "sections", file::CFileWrite::eFlagAtomic );
+   }
+
+   // ## failed save keeps original file
+   file::CFileWrite filewrite;
+   auto [bOk, stringError] = filewrite.Open( stringFile, file::CFileWrite::eFlagAtomic ); REQUIRE( bOk == true );
+   filewrite.Write( std::string_view( "partial" ) );
+   filewrite.Abort();
+                                                                               REQUIRE( std::filesystem::file_size( stringFile ) == stringExpect.length() );
+                                                                               REQUIRE( file_count_() == 2 );
+
+   std::tie( bOk, stringError ) = filewrite.Open( ( pathFolder / "missing" / "file.sql" ).string() ); REQUIRE( bOk == false );
+
+   std::filesystem::remove_all( pathFolder );
+}
+
+TEST_CASE("edit section with piece table", "[file]") {
+   using namespace application;
+
+   // ## random edits compared with same edits on std::string
+   std::string stringExpect;
+   for( int i = 0; i < 500; i++ ) stringExpect += std::format( "SELECT {} FROM t;\n", i );
+   gd::utf8::string stringOriginal( stringExpect );
+   file::CPieceTable piecetableText( stringOriginal );
+
+   uint32_t uRandom = 12345;
+   auto random_ = [&uRandom]( uint32_t uMax ) { uRandom = uRandom * 1103515245 + 12345; return uMax == 0 ? 0 : ( uRandom >> 8 ) % uMax; };
+   for( int i = 0; i < 5000; i++ )
+   {
+      uint32_t uOffset = random_( static_cast<uint32_t>( stringExpect.length() ) + 1 );
+      uint32_t uLength = random_( 8 );
+      std::string stringInsert = std::format( "<{}>", i );
+      switch( random_( 3 ) )
+      {
+      case 0: piecetableText.Insert( uOffset, stringInsert ); stringExpect.insert( uOffset, stringInsert ); break;
+      case 1: piecetableText.Erase( uOffset, uLength ); stringExpect.erase( uOffset, uLength ); break;
+      default: piecetableText.Replace( uOffset, uLength, stringInsert ); stringExpect.replace( uOffset, uLength, stringInsert ); break;
+      }
+   }
+                                                                               REQUIRE( piecetableText.size() == stringExpect.length() );
+                                                                               REQUIRE( piecetableText.piece_count() > 1000 );
+   auto stringText = piecetableText.Text();                                    REQUIRE( stringText == std::string_view( stringExpect ) );
+   piecetableText.Erase( 0, piecetableText.size() );                           REQUIRE( piecetableText.empty() == true );
+                                                                               REQUIRE( piecetableText.piece_count() == 0 );
+
+   // ## edits in section are saved without rebuilding code, rules end edit
+   std::filesystem::path pathFolder = std::filesystem::temp_directory_path() / "fw_test_piece";
+   std::filesystem::create_directories( pathFolder );
+   std::string stringFile = ( pathFolder / "edit.sql" ).string();
+
+   auto pFile = std::make_unique<file::CFile>( stringFile );
+   pFile->SECTION_Append( gd::utf8::string( "code" ), gd::utf8::string( "SELECT a FROM t;" ) );
+   auto itSection = pFile->SECTION_Begin();
+   itSection->EDIT_Erase( 7, 1 );
+   itSection->EDIT_Insert( 7, "b, c" );
+   itSection->EDIT_Insert( 0, "-- edited\n" );                                REQUIRE( itSection->EDIT_Active() == true );
+                                                                               REQUIRE( itSection->view() == "SELECT a FROM t;" );
+
+   CDocument document;
+   document.m_vectorFile.push_back( std::move( pFile ) );
+   auto [bOk, stringError] = document.FILE_Save( stringFile, "edit" );         REQUIRE( bOk == true );
+   file::CFileMap filemapSaved;
+   std::tie( bOk, stringError ) = filemapSaved.Open( stringFile );             REQUIRE( bOk == true );
+                                                                               REQUIRE( filemapSaved.text() == "-- edited\nSELECT b, c FROM t;" );
+   filemapSaved.Close();
+
+   itSection = document.m_vectorFile[0]->SECTION_Begin();
+   itSection->Replace( std::regex( "b, c" ), "d" );                            REQUIRE( itSection->EDIT_Active() == false );
+                                                                               REQUIRE( itSection->code() == std::string_view( "-- edited\nSELECT d FROM t;" ) );
+   std::filesystem::remove_all( pathFolder );
+}
+
 TEST_CASE("query file", "[sql]") {
 
    //changelog.sql
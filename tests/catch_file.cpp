@@ -1,13 +1,21 @@
+#include <chrono>
 #include <iterator>
+#include <random>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
 
 
 #include "catch.hpp"
 
 #include "gd_utf8.hpp"
 #include "gd_utf8_string.hpp"
+#include "gd_file.h"
+#include "gd_regex_cache.h"
 
 #include "application_file.hpp"
+#include "application.hpp"
 
 TEST_CASE("read file into application::CFile", "[file]") {
    using namespace application::file;
@@ -21,3 +29,698 @@ TEST_CASE("read file into application::CFile", "[file]") {
    fileTest.FILE_Load( stringFile, "root");
 
 }
+
+TEST_CASE("map file and load text without BOM", "[file]") {
+   using namespace application::file;
+
+   std::filesystem::path pathFile = std::filesystem::temp_directory_path() / "fw_test_map.txt";
+   {
+      std::ofstream ofstreamFile( pathFile, std::ofstream::binary );
+      const uint8_t pbBOM[] = { 0xEF, 0xBB, 0xBF };
+      ofstreamFile.write( (const char*)pbBOM, 3 );
+      ofstreamFile << "SELECT 1;\nSELECT 2;";
+   }
+
+   CFileMap filemapText;
+   auto [bOk, stringError] = filemapText.Open( pathFile.string() );            REQUIRE( bOk == true );
+                                                                               REQUIRE( filemapText.bom() == CFileMap::eBOMUtf8 );
+                                                                               REQUIRE( filemapText.size() == 22 );
+                                                                               REQUIRE( filemapText.text() == "SELECT 1;\nSELECT 2;" );
+   filemapText.Close();                                                        REQUIRE( filemapText.IsOpen() == false );
+
+   gd::utf8::string stringText;
+   std::tie( bOk, stringError ) = application::FILE_Load( pathFile.string(), stringText ); REQUIRE( bOk == true );
+                                                                               REQUIRE( stringText.size() == 19 );
+                                                                               REQUIRE( stringText.count() == 19 );
+                                                                               REQUIRE( stringText == "SELECT 1;\nSELECT 2;" );
+
+   CFile fileTest;
+   std::tie( bOk, stringError ) = fileTest.FILE_Load( pathFile.string(), "code" ); REQUIRE( bOk == true );
+                                                                               REQUIRE( fileTest.SECTION_Size() == 1 );
+                                                                               REQUIRE( fileTest.SECTION_At( 0 ).code() == stringText );
+
+   // ## UTF-16 files are converted to UTF-8, both byte orders
+   const char* pbszUtf8 = "A\xC3\xA5\xE2\x82\xAC\xF0\x9F\x98\x80\n";           // "Aå€😀\n"
+   const uint8_t pubUtf16LE[] = { 0xFF, 0xFE, 0x41, 0x00, 0xE5, 0x00, 0xAC, 0x20, 0x3D, 0xD8, 0x00, 0xDE, 0x0A, 0x00 };
+   const uint8_t pubUtf16BE[] = { 0xFE, 0xFF, 0x00, 0x41, 0x00, 0xE5, 0x20, 0xAC, 0xD8, 0x3D, 0xDE, 0x00, 0x00, 0x0A };
+   for( const uint8_t* pubUtf16 : { pubUtf16LE, pubUtf16BE } )
+   {
+      { std::ofstream ofstreamFile( pathFile, std::ofstream::binary ); ofstreamFile.write( (const char*)pubUtf16, sizeof( pubUtf16LE ) ); }
+      gd::utf8::string stringUtf16;
+      std::tie( bOk, stringError ) = application::FILE_Load( pathFile.string(), stringUtf16 ); REQUIRE( bOk == true );
+                                                                               REQUIRE( std::string_view( stringUtf16.c_str(), stringUtf16.size() ) == pbszUtf8 );
+                                                                               REQUIRE( stringUtf16.count() == 5 );
+      CFile fileUtf16;
+      std::tie( bOk, stringError ) = fileUtf16.FILE_Load( pathFile.string(), "code" ); REQUIRE( bOk == true );
+      auto stringCode = fileUtf16.SECTION_Begin()->code();                     REQUIRE( stringCode == stringUtf16 );
+   }
+   { std::ofstream ofstreamFile( pathFile, std::ofstream::binary ); ofstreamFile.write( (const char*)pubUtf16LE, 5 ); }
+   std::tie( bOk, stringError ) = application::FILE_Load( pathFile.string(), stringText ); REQUIRE( bOk == false ); // odd number of bytes
+
+   { std::ofstream ofstreamFile( pathFile, std::ofstream::binary ); }          // empty file
+   std::tie( bOk, stringError ) = filemapText.Open( pathFile.string() );       REQUIRE( bOk == true );
+                                                                               REQUIRE( filemapText.text().empty() == true );
+
+   std::tie( bOk, stringError ) = filemapText.Open( ( pathFile.parent_path() / "fw_test_not_found.txt" ).string() ); REQUIRE( bOk == false );
+
+   std::filesystem::remove( pathFile );
+}
+
+TEST_CASE("stream file through rules in windows", "[file]") {
+   using namespace application::file;
+
+   std::string stringSql;
+   for( int i = 0; i < 200; i++ )
+   {
+      stringSql += std::format( "-- comment number {}\nSELECT col{}, CAST(x AS DATETIME) FROM t{};\n", i, i, i );
+      if( i % 7 == 0 ) stringSql += std::format( "PRINT 'row {}'\n", i );
+      if( i % 3 == 0 ) stringSql += "DECLARE @s NVARCHAR(100);\n";
+   }
+
+   boost::regex regexComment( R"(--[^\n]*\n)" );
+   boost::regex regexPrint( R"(PRINT[^\n]*\n)" );
+   boost::regex regexDatetime( "DATETIME" );
+   boost::regex regexNvarchar( "NVARCHAR" );
+
+   // ## Expected result, same rules applied to text in memory
+   auto uFormat = boost::regex_constants::format_literal;
+   std::string stringText = boost::regex_replace( stringSql, regexComment, "", uFormat );
+   stringText = boost::regex_replace( stringText, regexPrint, "", uFormat );
+   stringText = boost::regex_replace( stringText, regexDatetime, "DATETIME2", uFormat );
+   stringText = boost::regex_replace( stringText, regexNvarchar, "NATIONAL CHARACTER VARYING", uFormat );
+
+   // ## Convert same text streamed in small windows
+   CFileStream filestreamConvert( 100, 64 );
+   filestreamConvert.RULE_Add( CRule( regexComment ) );
+   filestreamConvert.RULE_Add( CRule( regexPrint ) );
+   filestreamConvert.RULE_Add( CRule( regexDatetime, "DATETIME2" ) );
+   filestreamConvert.RULE_Add( CRule( regexNvarchar, "NATIONAL CHARACTER VARYING" ) ); REQUIRE( filestreamConvert.RULE_Size() == 4 );
+
+   std::istringstream istringstreamFrom( stringSql );
+   std::ostringstream ostringstreamTo;
+   auto [bOk, stringError] = filestreamConvert.Convert( istringstreamFrom, ostringstreamTo ); REQUIRE( bOk == true );
+   std::string stringResult = ostringstreamTo.str();                           REQUIRE( stringResult.size() == stringText.size() );
+                                                                               REQUIRE( stringResult == stringText );
+                                                                               REQUIRE( stringResult.find( "--" ) == std::string::npos );
+
+   // ## Convert file to file
+   std::filesystem::path pathFrom = std::filesystem::temp_directory_path() / "fw_test_stream_from.sql";
+   std::filesystem::path pathTo = std::filesystem::temp_directory_path() / "fw_test_stream_to.sql";
+   { std::ofstream ofstreamFile( pathFrom, std::ofstream::binary ); ofstreamFile << "\xEF\xBB\xBF" << stringSql; }
+
+   CFileStream filestreamFile( 256, 128 );
+   filestreamFile.RULE_Add( CRule( std::regex( R"(--[^\n]*\n)" ) ) );
+   filestreamFile.RULE_Add( CRule( std::regex( "DATETIME" ), "DATETIME2" ) );
+   std::tie( bOk, stringError ) = filestreamFile.Convert( pathFrom.string(), pathTo.string() ); REQUIRE( bOk == true );
+
+   gd::utf8::string stringFile;
+   std::tie( bOk, stringError ) = application::FILE_Load( pathTo.string(), stringFile ); REQUIRE( bOk == true );
+   std::string stringExpect = boost::regex_replace( stringSql, regexComment, "", uFormat );
+   stringExpect = boost::regex_replace( stringExpect, regexDatetime, "DATETIME2", uFormat );
+                                                                               REQUIRE( stringFile == stringExpect.c_str() );
+
+   std::filesystem::remove( pathFrom );
+   std::filesystem::remove( pathTo );
+}
+
+TEST_CASE("apply rule program to sections", "[file]") {
+   using namespace application::file;
+
+   std::string stringSql;
+   for( int i = 0; i < 100; i++ )
+   {
+      stringSql += std::format( "-- table {}\nCREATE TABLE t{} ( id BIGINT IDENTITY(1,1), created DATETIME, name NVARCHAR(MAX) );\n", i, i );
+      stringSql += std::format( "/* index\n for t{} */\nCREATE CLUSTERED INDEX i{} ON t{} (id);\nPRINT('done');\n", i, i, i );
+   }
+
+   auto uFormat = boost::regex_constants::format_literal;
+   std::vector<std::pair<boost::regex, std::string>> vectorRule = {
+      { boost::regex( R"((--[^\r\n]*)|(\/\*[\w\W]*?(?=\*\/)\*\/))" ), "" },
+      { boost::regex( R"(PRINT\([^\)]*\);)" ), "" },
+      { boost::regex( R"( DATETIME)" ), " TIMESTAMP" },
+      { boost::regex( R"( NVARCHAR\()" ), " VARCHAR(" },
+      { boost::regex( R"( VARCHAR\(\s*MAX[^\)]*\))" ), " TEXT" },
+      { boost::regex( R"( BIGINT\s+IDENTITY\s*\([^\)]*\))" ), " BIGSERIAL" },
+      { boost::regex( R"(CREATE\s+CLUSTERED\s+)" ), "CREATE " },
+   };
+
+   CRuleProgram programSql;
+   std::string stringExpect = stringSql;
+   for( const auto& it : vectorRule )
+   {
+      if( it.second.empty() == true ) programSql.RULE_Add( CRule( it.first ) );
+      else                             programSql.RULE_Add( CRule( it.first, it.second ) );
+      stringExpect = boost::regex_replace( stringExpect, it.first, it.second, uFormat );
+   }
+                                                                               REQUIRE( programSql.RULE_Size() == 7 );
+
+   CFile fileSql;
+   fileSql.SECTION_Append( gd::utf8::string( "sql" ), gd::utf8::string( stringSql ) );
+   fileSql.SECTION_Append( gd::utf8::string( "other" ), gd::utf8::string( stringSql ) );
+   auto [bOk, stringError] = fileSql.SECTION_Apply( programSql, "sql" );      REQUIRE( bOk == true );
+                                                                               REQUIRE( fileSql.SECTION_At( 0 ).code() == stringExpect.c_str() );
+                                                                               REQUIRE( fileSql.SECTION_At( 0 ).code().count() == stringExpect.length() );
+                                                                               REQUIRE( fileSql.SECTION_At( 1 ).code() == stringSql.c_str() );
+
+   // ## erase rules gives same result as erase for each rule
+   CRuleProgram programErase( { CRule( vectorRule[0].first ), CRule( vectorRule[1].first ) } );
+   CFile fileErase;
+   fileErase.SECTION_Append( gd::utf8::string( stringSql ) );
+   fileErase.SECTION_Append( gd::utf8::string( stringSql ) );
+   fileErase.SECTION_Apply( programErase );
+   fileErase.SECTION_Begin()[1].Erase( vectorRule[0].first );
+   fileErase.SECTION_Begin()[1].Erase( vectorRule[1].first );
+                                                                               REQUIRE( fileErase.SECTION_At( 0 ).code() == fileErase.SECTION_At( 1 ).code() );
+
+   // ## text is read directly by first rule, program with one or no rules
+   std::string stringOne;
+   CRuleProgram( { CRule( vectorRule[2].first, vectorRule[2].second ) } ).Apply( stringSql, stringOne ); REQUIRE( stringOne == boost::regex_replace( stringSql, vectorRule[2].first, vectorRule[2].second, uFormat ) );
+   std::string stringNone;
+   CRuleProgram().Apply( stringSql, stringNone );                              REQUIRE( stringNone == stringSql );
+}
+
+TEST_CASE("replace text in new buffer", "[file]") {
+   using namespace application::file;
+
+   std::string stringSql;
+   for( int i = 0; i < 2000; i++ ) stringSql += std::format( "SELECT n{} NVARCHAR(10), d DATETIME, s = 'åäö {}';\n", i, i );
+
+   auto uFormat = boost::regex_constants::format_literal;
+   std::vector<std::pair<std::string, std::string>> vectorReplace = {
+      { "NVARCHAR", "VARCHAR" },                                               // shrink
+      { "DATETIME", "TIMESTAMP WITH TIME ZONE" },                              // grow
+      { "åäö", "aao" },                                                        // multibyte to ascii
+      { "SELECT", "SELECT" },                                                  // same
+      { "not found", "x" },
+   };
+
+   for( const auto& it : vectorReplace )
+   {
+      boost::regex regexMatch( it.first );
+      std::string stringExpect = boost::regex_replace( stringSql, regexMatch, it.second, uFormat );
+
+      gd::utf8::string stringBoost;
+      stringBoost.assign( reinterpret_cast<const uint8_t*>( stringSql.data() ), stringSql.size() );
+      auto [bOk, stringError] = Replace( stringBoost, regexMatch, it.second, boost::regex_constants::match_default ); REQUIRE( bOk == true );
+                                                                               REQUIRE( stringBoost == stringExpect.c_str() );
+                                                                               REQUIRE( stringBoost.size() == stringExpect.length() );
+                                                                               REQUIRE( stringBoost.count() == gd::utf8::count( stringExpect.c_str() ).first );
+
+      gd::utf8::string stringStd;
+      stringStd.assign( reinterpret_cast<const uint8_t*>( stringSql.data() ), stringSql.size() );
+      std::tie( bOk, stringError ) = Replace( stringStd, std::regex( it.first ), it.second, std::regex_constants::match_default ); REQUIRE( bOk == true );
+                                                                               REQUIRE( stringStd == stringBoost );
+   }
+
+   // ## empty matches step whole characters, text is never inserted inside a character
+   std::string stringMixed = "å b€\n";
+   std::string stringDash = "-å- -b-€-\n-";
+   gd::utf8::string stringEmpty;
+   stringEmpty.assign( reinterpret_cast<const uint8_t*>( stringMixed.data() ), stringMixed.size() );
+   auto [bOk, stringError] = Replace( stringEmpty, boost::regex( "x*" ), "-", boost::regex_constants::match_default ); REQUIRE( bOk == true );
+                                                                               REQUIRE( stringEmpty == stringDash.c_str() );
+                                                                               REQUIRE( stringEmpty.count() == 11 );
+   CRuleProgram programEmpty( { CRule( boost::regex( "x*" ), "-" ) } );
+   std::string stringProgram;
+   programEmpty.Apply( stringMixed, stringProgram );                           REQUIRE( stringProgram == stringDash );
+
+   CFileStream filestreamEmpty( 4, 2 );
+   filestreamEmpty.RULE_Add( CRule( boost::regex( "x*" ), "-" ) );
+   std::istringstream istringstreamFrom( stringMixed );
+   std::ostringstream ostringstreamTo;
+   std::tie( bOk, stringError ) = filestreamEmpty.Convert( istringstreamFrom, ostringstreamTo ); REQUIRE( bOk == true );
+                                                                               REQUIRE( ostringstreamTo.str() == stringDash );
+
+   CEraseList eraselistEmpty;
+   std::tie( bOk, stringError ) = Erase( stringMixed, boost::regex( "b|x*" ), boost::regex_constants::match_default, eraselistEmpty ); REQUIRE( bOk == true );
+   gd::utf8::string stringErased;
+   eraselistEmpty.Apply( stringMixed, stringErased );                         REQUIRE( stringErased == "å €\n" );
+}
+
+TEST_CASE("erase matches with erase list", "[file]") {
+   using namespace application::file;
+
+   const char* pbszSql = "SELECT å -- c1\nFROM t; -- c2\nWHERE 1;";
+   const char* pbszExpect = "å \n t; \nWHERE 1;";
+   gd::utf8::string stringSql;
+   stringSql.assign( reinterpret_cast<const uint8_t*>( pbszSql ), std::strlen( pbszSql ) );
+
+   // ## spans are added and text is not changed until list is applied
+   std::string_view stringView( stringSql.c_str(), stringSql.size() );
+   CEraseList eraselist;
+   auto [bOk, stringError] = Erase( stringView, std::regex( "--[^\\n]*" ), std::regex_constants::match_default, eraselist ); REQUIRE( bOk == true );
+                                                                               REQUIRE( eraselist.span_count() == 2 );
+                                                                               REQUIRE( eraselist.erased() == 10 );
+                                                                               REQUIRE( stringSql.size() == std::strlen( pbszSql ) );
+   Erase( stringView, boost::regex( "c\\d" ), boost::regex_constants::match_default, eraselist ); REQUIRE( eraselist.erased() == 10 ); // erased text is skipped
+   Erase( stringView, std::regex( "FROM" ), std::regex_constants::match_default, eraselist ); REQUIRE( eraselist.span_count() == 3 );
+   eraselist.Add( 0, 3 );
+   eraselist.Add( 2, 5 );                                                      REQUIRE( eraselist.span_at( 0 ) == CEraseList::span( 0, 7 ) );
+                                                                               REQUIRE( eraselist.span_count() == 4 );
+   eraselist.Apply( stringSql );                                               REQUIRE( eraselist.empty() == true );
+                                                                               REQUIRE( std::string_view( stringSql.c_str(), stringSql.size() ) == pbszExpect );
+                                                                               REQUIRE( stringSql.is_counted() == true );
+                                                                               REQUIRE( stringSql.count() == gd::utf8::count( pbszExpect ).first );
+
+   // ## later rules see text as if erased spans were removed, same result as erasing rule by rule
+   auto erase_ = []( const char* pbszText, auto&& erase_rules_ ) {
+      gd::utf8::string stringText;
+      stringText.assign( reinterpret_cast<const uint8_t*>( pbszText ), std::strlen( pbszText ) );
+      CEraseList eraselistRules;
+      erase_rules_( std::string_view( stringText.c_str(), stringText.size() ), eraselistRules );
+      eraselistRules.Apply( stringText );
+      return std::string( stringText.c_str(), stringText.size() );
+   };
+   std::string stringErase = erase_( "SELECT 1;   -- one\n", []( std::string_view stringText, CEraseList& eraselist_ ) {
+      Erase( stringText, boost::regex( "--[^\\n]*" ), boost::regex_constants::match_default, eraselist_ );
+      Erase( stringText, boost::regex( "\\s+$" ), boost::regex_constants::match_default, eraselist_ );
+   } );                                                                        REQUIRE( stringErase == "SELECT 1;" ); // trailing blanks and new line matched by `\s+$`
+   stringErase = erase_( "ab/*x*/cd", []( std::string_view stringText, CEraseList& eraselist_ ) {
+      Erase( stringText, std::regex( "/\\*.*?\\*/" ), std::regex_constants::match_default, eraselist_ );
+      Erase( stringText, std::regex( "bc" ), std::regex_constants::match_default, eraselist_ );
+   } );                                                                        REQUIRE( stringErase == "ad" );
+   {
+      gd::utf8::string stringSequential;
+      stringSequential.assign( reinterpret_cast<const uint8_t*>( "SELECT 1;   -- one\n" ), 19 );
+      Erase( stringSequential, std::regex( "--[^\\n]*" ), std::regex_constants::match_default );
+      Erase( stringSequential, std::regex( "\\s+$" ), std::regex_constants::match_default );
+      stringErase = erase_( "SELECT 1;   -- one\n", []( std::string_view stringText, CEraseList& eraselist_ ) {
+         Erase( stringText, std::regex( "--[^\\n]*" ), std::regex_constants::match_default, eraselist_ );
+         Erase( stringText, std::regex( "\\s+$" ), std::regex_constants::match_default, eraselist_ );
+      } );                                                                     REQUIRE( stringErase == std::string( stringSequential.c_str(), stringSequential.size() ) );
+   }
+   {
+      CFile fileErase( "erase.sql" );
+      gd::utf8::string stringCode;
+      stringCode.assign( reinterpret_cast<const uint8_t*>( "SELECT 1;   -- one\n" ), 19 );
+      fileErase.SECTION_Append( gd::utf8::string( "sql" ), stringCode );
+      fileErase.SECTION_Erase( "--[^\\n]*" );
+      fileErase.SECTION_Erase( boost::regex( "\\s+$" ) );
+      auto stringCodeErased = fileErase.SECTION_Begin()->code();               REQUIRE( std::string_view( stringCodeErased.c_str(), stringCodeErased.size() ) == "SELECT 1;" );
+   }
+
+   // ## section keeps erased spans until code is used by other operations
+   std::filesystem::path pathFolder = std::filesystem::temp_directory_path() / "fw_test_erase";
+   std::filesystem::create_directories( pathFolder );
+   std::string stringFile = ( pathFolder / "erase.sql" ).string();
+
+   auto pFile = std::make_unique<CFile>( stringFile );
+   gd::utf8::string stringCode;
+   stringCode.assign( reinterpret_cast<const uint8_t*>( pbszSql ), std::strlen( pbszSql ) );
+   pFile->SECTION_Append( gd::utf8::string( "sql" ), stringCode );
+   auto itSection = pFile->SECTION_Begin();
+   itSection->Erase( std::regex( "--[^\\n]*" ) );
+   itSection->Erase( boost::regex( "WHERE 1" ) );                              REQUIRE( itSection->eraselist().span_count() == 3 );
+                                                                               REQUIRE( std::as_const( *itSection ).view().size() == std::strlen( pbszSql ) ); // erased spans are not removed
+
+   application::CDocument document;
+   document.m_vectorFile.push_back( std::move( pFile ) );
+   std::tie( bOk, stringError ) = document.FILE_Save( stringFile, "erase" );   REQUIRE( bOk == true );
+   CFileMap filemapSaved;
+   std::tie( bOk, stringError ) = filemapSaved.Open( stringFile );             REQUIRE( bOk == true );
+                                                                               REQUIRE( filemapSaved.text() == "SELECT å \nFROM t; \n;" );
+   filemapSaved.Close();
+
+   itSection = document.m_vectorFile[0]->SECTION_Begin();
+   itSection->Replace( std::regex( "t;" ), "u;" );                             REQUIRE( itSection->eraselist().empty() == true );
+   auto stringResult = itSection->code();                                      REQUIRE( std::string_view( stringResult.c_str(), stringResult.size() ) == "SELECT å \nFROM u; \n;" );
+   itSection->Erase( std::regex( "SELECT " ) );
+   itSection->EDIT_Insert( 0, "-- x\n" );                                      REQUIRE( itSection->eraselist().empty() == true );
+   itSection->EDIT_End();
+   stringResult = itSection->code();                                           REQUIRE( std::string_view( stringResult.c_str(), stringResult.size() ) == "-- x\nå \nFROM u; \n;" );
+   itSection->EDIT_Replace( 0, 4, "--" );                                      REQUIRE( itSection->EDIT_Active() == true );
+   stringResult = itSection->code();                                           REQUIRE( std::string_view( stringResult.c_str(), stringResult.size() ) == "--\nå \nFROM u; \n;" );
+                                                                               REQUIRE( itSection->EDIT_Active() == false );
+   std::filesystem::remove_all( pathFolder );
+}
+
+TEST_CASE("share compiled patterns in regex cache", "[file]") {
+   using namespace application::file;
+
+   // ## same pattern, flags and engine gives same compiled expression
+   gd::regex::cache cacheTest( 3 );
+   auto pregexA = cacheTest.get<std::regex>( "a+" );                          REQUIRE( cacheTest.miss() == 1 );
+   auto pregexB = cacheTest.get<std::regex>( "a+" );                          REQUIRE( cacheTest.hit() == 1 );
+                                                                               REQUIRE( pregexA == pregexB );
+   auto pregexCase = cacheTest.get<std::regex>( "a+", std::regex::ECMAScript | std::regex::icase ); REQUIRE( cacheTest.miss() == 2 );
+                                                                               REQUIRE( std::regex_search( "xAAx", *pregexCase ) == true );
+   auto pregexBoost = cacheTest.get<boost::regex>( "a+" );                    REQUIRE( cacheTest.size() == 3 );
+   REQUIRE_THROWS( cacheTest.get<std::regex>( "a(" ) );                        REQUIRE( cacheTest.size() == 3 );
+   cacheTest.get<std::regex>( "b+" );                                          REQUIRE( cacheTest.size() == 1 ); // full, cleared before insert
+                                                                               REQUIRE( std::regex_search( "xaax", *pregexA ) == true ); // still owned
+   cacheTest.clear_statistics();                                               REQUIRE( cacheTest.hit() + cacheTest.miss() == 0 );
+
+   // ## threads share compiled expression
+   std::vector<std::thread> vectorThread;
+   for( int i = 0; i < 4; i++ ) vectorThread.emplace_back( [&cacheTest]() { for( int j = 0; j < 100; j++ ) cacheTest.get<boost::regex>( "c+" ); } );
+   for( auto& it : vectorThread ) it.join();
+                                                                               REQUIRE( cacheTest.hit() + cacheTest.miss() == 400 );
+                                                                               REQUIRE( cacheTest.miss() <= 4 );
+
+   // ## sections in many files use process wide cache
+   auto& cacheProcess = gd::regex::cache_g();
+   uint64_t uHit = cacheProcess.hit(), uMiss = cacheProcess.miss();
+   const char* pbszSql = "SELECT 1; -- one\nSELECT 2; -- two\n";
+   for( int i = 0; i < 3; i++ )
+   {
+      CFile fileSql;
+      fileSql.SECTION_Append( gd::utf8::string( pbszSql ) );
+      auto [bOk, stringError] = fileSql.SECTION_Erase( R"(--[^\r\n]*)" );      REQUIRE( bOk == true );
+      std::tie( bOk, stringError ) = fileSql.SECTION_Replace( "SELECT", "select" ); REQUIRE( bOk == true );
+      auto stringResult = fileSql.SECTION_At( 0 ).code();                      REQUIRE( std::string_view( stringResult.c_str(), stringResult.size() ) == "select 1; \nselect 2; \n" );
+   }
+                                                                               REQUIRE( cacheProcess.hit() - uHit >= 4 );
+                                                                               REQUIRE( cacheProcess.miss() - uMiss <= 2 );
+   CFile fileError;
+   auto [bOk, stringError] = fileError.SECTION_Erase( "a(" );                 REQUIRE( bOk == false );
+
+   // ## file filter is compiled once for each listing
+   std::filesystem::path pathFolder = std::filesystem::temp_directory_path() / "fw_test_regex_cache";
+   std::filesystem::create_directories( pathFolder );
+   for( int i = 0; i < 5; i++ ) std::ofstream( pathFolder / std::format( "f{}.sql", i ) ) << "x";
+   std::ofstream( pathFolder / "g.sql" ) << "x";
+   uHit = cacheProcess.hit(); uMiss = cacheProcess.miss();
+   auto vectorFile = gd::file::list_files_g( pathFolder.string(), { {"filter", R"(^f\d\.sql$)"}, {"extension", ".sql"} } ); REQUIRE( vectorFile.size() == 5 );
+   vectorFile = gd::file::list_files_g( pathFolder.string(), { {"filter", R"(^f\d\.sql$)"}, {"extension", ".sql"} } ); REQUIRE( vectorFile.size() == 5 );
+                                                                               REQUIRE( cacheProcess.hit() + cacheProcess.miss() - uHit - uMiss == 2 );
+                                                                               REQUIRE( cacheProcess.hit() - uHit >= 1 );
+   std::filesystem::remove_all( pathFolder );
+}
+
+TEST_CASE("match with automaton", "[file]") {
+   using namespace application::file;
+
+   // ## patterns from sql conversion are compiled to automaton, other fall back to boost
+   std::vector<std::string> vectorPattern = {
+      R"((--[^\r\n]*)|(\/\*[\w\W]*?(?=\*\/)\*\/))", R"(PRINT\([^\)]*\);)", R"( VARCHAR\(\s*MAX[^\)]*\))", R"( BIGINT\s+IDENTITY\s*\([^\)]*\))",
+      R"(CREATE\s+CLUSTERED\s+)", R"(^\s\s+)", R"(a*?b)", R"((a|ab)(c|bcd))", R"(a{2,3}?)", R"(x*$)", R"(^$)", R"([^a-c\n]+)", R"(a.+?-)", R"((?:ab)*)",
+      R"((^|[^a])+)", R"((a*|b)*)", R"((|a)+)",                              // repeat with empty iteration, searched with boost
+   };
+   for( std::size_t u = 0; u + 3 < vectorPattern.size(); u++ ) { CAutomaton automaton_( vectorPattern[u] ); REQUIRE( automaton_.is_automaton() == true ); }
+   CAutomaton automatonBoundary( R"(\bab)" );                                REQUIRE( automatonBoundary.is_automaton() == false );
+   CAutomaton automatonBackReference( R"((a)\1)" );                          REQUIRE( automatonBackReference.is_automaton() == false );
+   for( const char* pbszEmpty : { R"((^|[^a])+)", R"((a*|b)*)", R"((|a)+)", R"((a*?)*)", R"((x?){3})" } ) { REQUIRE( CAutomaton( pbszEmpty ).is_automaton() == false ); }
+   REQUIRE_THROWS( CAutomaton( "a(" ) );
+
+   // ## same match as boost for random text
+   std::mt19937 random_( 7 );
+   const char* pbszAlphabet = "ab-*/\n\r cdx()";
+   for( const auto& itPattern : vectorPattern )
+   {
+      CAutomaton automaton_( itPattern );
+      boost::regex regexMatch( itPattern );
+      for( int i = 0; i < 300; i++ )
+      {
+         std::string stringText;
+         for( int iLength = random_() % 24; iLength > 0; iLength-- ) stringText += pbszAlphabet[random_() % std::strlen( pbszAlphabet )];
+         const char* pbszFirst = stringText.data();
+         const char* pbszLast = pbszFirst + stringText.length();
+         std::size_t uOffset = stringText.empty() == true ? 0 : random_() % stringText.length();
+
+         boost::cmatch cmatchResult;
+         auto uBoostFlags = uOffset > 0 ? boost::regex_constants::match_prev_avail : boost::regex_constants::match_default;
+         bool bBoost = boost::regex_search( pbszFirst + uOffset, pbszLast, cmatchResult, regexMatch, uBoostFlags );
+         auto [pbszMatch, pbszMatchEnd] = automaton_.Find( pbszFirst + uOffset, pbszLast, uOffset > 0, true, CAutomaton::eMatchDefault );
+                                                                               REQUIRE( bBoost == ( pbszMatch != nullptr ) );
+         if( bBoost == true )
+         {
+                                                                               REQUIRE( cmatchResult[0].first == pbszMatch );
+                                                                               REQUIRE( cmatchResult[0].second == pbszMatchEnd );
+         }
+      }
+   }
+
+   // ## replace and erase gives same result as boost
+   std::string stringSql;
+   for( int i = 0; i < 200; i++ ) stringSql += std::format( "-- table {}\nCREATE CLUSTERED INDEX i{} /* åäö\n */ ON t{} (id); PRINT('x');\n", i, i, i );
+   boost::regex regexComment( vectorPattern[0] );
+   std::string stringExpect = boost::regex_replace( stringSql, regexComment, "", boost::regex_constants::format_literal );
+
+   gd::utf8::string stringText;
+   stringText.assign( reinterpret_cast<const uint8_t*>( stringSql.data() ), stringSql.size() );
+   auto [bOk, stringError] = Erase( stringText, CAutomaton( vectorPattern[0] ), CAutomaton::eMatchDefault ); REQUIRE( bOk == true );
+                                                                               REQUIRE( std::string_view( stringText.c_str(), stringText.size() ) == stringExpect );
+   stringExpect = boost::regex_replace( stringExpect, boost::regex( vectorPattern[4] ), "CREATE ", boost::regex_constants::format_literal );
+   std::tie( bOk, stringError ) = Replace( stringText, CAutomaton( vectorPattern[4] ), "CREATE ", CAutomaton::eMatchDefault ); REQUIRE( bOk == true );
+                                                                               REQUIRE( std::string_view( stringText.c_str(), stringText.size() ) == stringExpect );
+                                                                               REQUIRE( stringText.count() == gd::utf8::count( stringExpect.c_str() ).first );
+
+   // ## states are shared by threads and rules
+   CAutomaton automatonPrint( vectorPattern[1] );
+   CRuleProgram programSql( { CRule( automatonPrint ), CRule( CAutomaton( vectorPattern[0] ) ) } ); REQUIRE( programSql.key().empty() == false );
+   std::vector<std::thread> vectorThread;
+   std::atomic<int> iDifferent{ 0 };
+   for( int i = 0; i < 4; i++ )
+   {
+      vectorThread.emplace_back( [&]() {
+         std::string stringResult;
+         programSql.Apply( stringSql, stringResult );
+         std::string stringBoost = boost::regex_replace( stringSql, boost::regex( vectorPattern[1] ), "", boost::regex_constants::format_literal );
+         stringBoost = boost::regex_replace( stringBoost, regexComment, "", boost::regex_constants::format_literal );
+         if( stringResult != stringBoost ) iDifferent++;
+      } );
+   }
+   for( auto& it : vectorThread ) it.join();
+                                                                               REQUIRE( iDifferent == 0 );
+                                                                               REQUIRE( automatonPrint.state_count() > 0 );
+
+   // ## search time is linear, patterns that backtrack in boost and unclosed comments
+   std::string stringLong( 1024 * 1024, 'x' );
+   auto timeStart = std::chrono::steady_clock::now();
+   CAutomaton automatonNested( R"((x+x+)+y)" );                              REQUIRE( automatonNested.is_automaton() == true );
+   auto [pbszNested, pbszNestedEnd] = automatonNested.Find( stringLong.data(), stringLong.data() + stringLong.length() ); REQUIRE( pbszNested == nullptr );
+   std::string stringOpen = "/*" + stringLong;
+   CAutomaton automatonComment( vectorPattern[0] );
+   auto [pbszOpen, pbszOpenEnd] = automatonComment.Find( stringOpen.data(), stringOpen.data() + stringOpen.length() ); REQUIRE( pbszOpen == nullptr );
+   auto uMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - timeStart ).count();
+                                                                               REQUIRE( uMilliseconds < 2000 ); // backtracking needs minutes
+                                                                               REQUIRE( automatonNested.state_count() < 16 );
+}
+
+TEST_CASE("skip text with required literals", "[file]") {
+   using namespace application::file;
+
+   // ## literals extracted from patterns
+   auto literalComment = CAutomaton::Literal_s( R"((--[^\r\n]*)|(\/\*[\w\W]*?(?=\*\/)\*\/))", CAutomaton::eSyntaxDefault );
+                                                                               REQUIRE( literalComment.m_vectorPrefix == std::vector<std::string>{ "--", "/*" } );
+   auto literalPrint = CAutomaton::Literal_s( R"(PRINT\([^\)]*\);)", CAutomaton::eSyntaxDefault );
+                                                                               REQUIRE( literalPrint.m_vectorPrefix == std::vector<std::string>{ "PRINT(" } );
+   auto literalBigint = CAutomaton::Literal_s( R"( BIGINT\s+IDENTITY\s*\([^\)]*\))", CAutomaton::eSyntaxDefault );
+                                                                               REQUIRE( literalBigint.m_vectorPrefix == std::vector<std::string>{ " BIGINT" } );
+                                                                               REQUIRE( literalBigint.m_stringRequired == "IDENTITY" );
+   auto literalEnd = CAutomaton::Literal_s( R"([^\)]*\);)", CAutomaton::eSyntaxDefault );
+                                                                               REQUIRE( literalEnd.m_vectorPrefix.empty() == true );
+                                                                               REQUIRE( literalEnd.m_stringRequired == ");" );
+                                                                               REQUIRE( CAutomaton::Literal_s( R"(^\s\s+)", CAutomaton::eSyntaxDefault ).empty() == true );
+                                                                               REQUIRE( CAutomaton::Literal_s( R"(PRINT)", CAutomaton::icase ).empty() == true );
+                                                                               REQUIRE( CAutomaton::Literal_s( R"(\bPRINT)", CAutomaton::eSyntaxDefault ).empty() == true );
+                                                                               REQUIRE( CAutomaton( R"(PRINT\([^\)]*\);)" ).literals().m_vectorPrefix.size() == 1 );
+
+   // ## same match as boost with and without prefilter, for automaton and boost rules
+   std::vector<std::string> vectorPattern = { R"(ab+c)", R"((ab|cd)x*)", R"(x?ab[^\n]*$)", R"(^ab)", R"([^x]*ab)", R"(a(b|c)d|--)", R"(x{2,3}a)" };
+   std::mt19937 random_( 11 );
+   const char* pbszAlphabet = "abcdx-\n ";
+   for( const auto& itPattern : vectorPattern )
+   {
+      CAutomaton automaton_( itPattern );                                    REQUIRE( automaton_.literals().empty() == false );
+      boost::regex regexMatch( itPattern );
+      CRule ruleBoost( regexMatch );
+      for( int i = 0; i < 300; i++ )
+      {
+         std::string stringText;
+         for( int iLength = random_() % 32; iLength > 0; iLength-- ) stringText += pbszAlphabet[random_() % std::strlen( pbszAlphabet )];
+         const char* pbszFirst = stringText.data();
+         const char* pbszLast = pbszFirst + stringText.length();
+         std::size_t uOffset = stringText.empty() == true ? 0 : random_() % stringText.length();
+
+         boost::cmatch cmatchResult;
+         auto uBoostFlags = uOffset > 0 ? boost::regex_constants::match_prev_avail : boost::regex_constants::match_default;
+         bool bBoost = boost::regex_search( pbszFirst + uOffset, pbszLast, cmatchResult, regexMatch, uBoostFlags );
+         auto matchAutomaton = automaton_.Find( pbszFirst + uOffset, pbszLast, uOffset > 0, true, CAutomaton::eMatchDefault );
+         auto matchRule = ruleBoost.Find( pbszFirst + uOffset, pbszLast, uOffset > 0, true );
+         std::pair<const char*, const char*> matchExpect( nullptr, nullptr );
+         if( bBoost == true ) matchExpect = { cmatchResult[0].first, cmatchResult[0].second };
+                                                                               REQUIRE( matchAutomaton == matchExpect );
+                                                                               REQUIRE( matchRule == matchExpect );
+      }
+   }
+
+   // ## text without literals is skipped
+   std::string stringText( 100000, ' ' );
+   stringText += "PRINT('done');";
+   auto [pbszPrint, pbszPrintEnd] = CAutomaton( R"(PRINT\([^\)]*\);)" ).Find( stringText.data(), stringText.data() + stringText.length() );
+                                                                               REQUIRE( pbszPrint == stringText.data() + 100000 );
+                                                                               REQUIRE( pbszPrintEnd == stringText.data() + stringText.length() );
+   auto [pbszEnd, pbszEndEnd] = CAutomaton( R"([^\)]*\);)" ).Find( stringText.data(), stringText.data() + 100000 );
+                                                                               REQUIRE( pbszEnd == nullptr );
+
+   // ## search runs once from first candidate, unclosed comment with many candidates is scanned in linear time
+   std::string stringOpen;
+   while( stringOpen.length() < 1024 * 1024 ) stringOpen += "/* ";
+   CAutomaton automatonComment( R"((--[^\r\n]*)|(\/\*[\w\W]*?(?=\*\/)\*\/))" );
+   auto timeStart = std::chrono::steady_clock::now();
+   auto [pbszOpen, pbszOpenEnd] = automatonComment.Find( stringOpen.data(), stringOpen.data() + stringOpen.length() ); REQUIRE( pbszOpen == nullptr );
+   gd::utf8::string stringComment( stringOpen.c_str() );
+   auto [bOk, stringError] = Erase( stringComment, automatonComment, CAutomaton::eMatchDefault ); REQUIRE( bOk == true );
+                                                                               REQUIRE( stringComment.size() == stringOpen.length() );
+   auto uMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - timeStart ).count();
+                                                                               REQUIRE( uMilliseconds < 2000 ); // quadratic search needs minutes
+}
+
+TEST_CASE("replace keywords in one pass", "[file]") {
+   using namespace application::file;
+
+   // ## leftmost longest, first keyword is used for duplicates
+   CKeywordTable keywordtableSql( { { "DATETIME", "TIMESTAMP" }, { "NVARCHAR(", "VARCHAR(" }, { "INT", "INTEGER" }, { "INTEGER", "INT4" }, { "INT", "X" } } );
+                                                                               REQUIRE( keywordtableSql.size() == 5 );
+   gd::utf8::string stringText( "CREATE TABLE t (id INT, n NVARCHAR(10), c DATETIME, i INTEGER, p POINT);" );
+   auto [bOk, stringError] = Replace( stringText, keywordtableSql );          REQUIRE( bOk == true );
+                                                                               REQUIRE( std::string_view( stringText.c_str(), stringText.size() ) == "CREATE TABLE t (id INTEGER, n VARCHAR(10), c TIMESTAMP, i INT4, p POINTEGER);" );
+                                                                               REQUIRE( stringText.count() == stringText.size() );
+
+   // ## whole words and case
+   CKeywordTable keywordtableWord( { { "INT", "INTEGER" }, { "GETDATE()", "NOW()" }, { "åä", "ö" } }, CKeywordTable::eFlagWord | CKeywordTable::eFlagIcase );
+   std::string_view stringWord( "int INTO point Int x_int GETDATE() getdate()x åä åäx" );
+   stringText.assign( reinterpret_cast<const uint8_t*>( stringWord.data() ), stringWord.length() );
+   std::tie( bOk, stringError ) = Replace( stringText, keywordtableWord );    REQUIRE( bOk == true );
+                                                                               REQUIRE( std::string_view( stringText.c_str(), stringText.size() ) == "INTEGER INTO point INTEGER x_int NOW() NOW()x ö åäx" );
+                                                                               REQUIRE( stringText.count() == gd::utf8::count( stringText.c_str() ).first );
+   const char* pbszInt = "int";
+                                                                               REQUIRE( keywordtableWord.Find( pbszInt, pbszInt + 3, false, false ).first == nullptr ); // next text may continue word
+                                                                               REQUIRE( keywordtableWord.Index( pbszInt, pbszInt + 3 ) == 0 );
+                                                                               REQUIRE( keywordtableWord.Index( pbszInt, pbszInt + 2 ) == -1 );
+   REQUIRE_THROWS( CKeywordTable( { { "", "x" } } ) );
+
+   // ## same result as searching each position for longest keyword
+   std::vector<CKeywordTable::keyword> vectorKeyword;
+   for( int i = 0; i < 300; i++ ) vectorKeyword.push_back( { std::format( "K{}", i * 7 % 1000 ), std::format( "<{}>", i ) } );
+   for( const char* pbsz : { "ab", "abc", "bc", "c", "b_", "K1" } ) vectorKeyword.push_back( { pbsz, std::string( "[" ) + pbsz + "]" } );
+   std::mt19937 random_( 3 );
+   const char* pbszAlphabet = "abcK0127_ ";
+   for( uint32_t uFlags : { CKeywordTable::eFlagDefault, CKeywordTable::eFlagWord, CKeywordTable::eFlagIcase } )
+   {
+      CKeywordTable keywordtable_( vectorKeyword, uFlags );                   REQUIRE( keywordtable_.state_count() > 300 );
+      auto word_ = []( char ch ) { return std::isalnum( static_cast<unsigned char>( ch ) ) != 0 || ch == '_'; };
+      auto equal_ = [uFlags]( std::string_view stringText, std::string_view stringKeyword ) {
+         if( ( uFlags & CKeywordTable::eFlagIcase ) == 0 ) return stringText == stringKeyword;
+         return std::equal( stringText.begin(), stringText.end(), stringKeyword.begin(), stringKeyword.end(), []( char a, char b ) { return std::tolower( a ) == std::tolower( b ); } );
+      };
+      for( int i = 0; i < 200; i++ )
+      {
+         std::string stringSource;
+         for( int iLength = random_() % 40; iLength > 0; iLength-- ) stringSource += pbszAlphabet[random_() % std::strlen( pbszAlphabet )];
+
+         std::string stringExpect;
+         for( std::size_t uPosition = 0; uPosition < stringSource.length(); )
+         {
+            const CKeywordTable::keyword* pkeyword = nullptr;
+            for( const auto& it : vectorKeyword )
+            {
+               std::size_t uLength = it.first.length();
+               if( uPosition + uLength > stringSource.length() || equal_( std::string_view( stringSource ).substr( uPosition, uLength ), it.first ) == false ) continue;
+               if( uFlags & CKeywordTable::eFlagWord )
+               {
+                  if( word_( it.first.front() ) == true && uPosition > 0 && word_( stringSource[uPosition - 1] ) == true ) continue;
+                  if( word_( it.first.back() ) == true && uPosition + uLength < stringSource.length() && word_( stringSource[uPosition + uLength] ) == true ) continue;
+               }
+               if( pkeyword == nullptr || uLength > pkeyword->first.length() ) pkeyword = &it;
+            }
+            if( pkeyword == nullptr ) { stringExpect += stringSource[uPosition]; uPosition++; continue; }
+            stringExpect += pkeyword->second;
+            uPosition += pkeyword->first.length();
+         }
+
+         gd::utf8::string stringResult( stringSource.c_str() );
+         Replace( stringResult, keywordtable_ );                               REQUIRE( std::string_view( stringResult.c_str(), stringResult.size() ) == stringExpect );
+         std::string stringRule;
+         CRuleProgram::Apply( CRule( keywordtable_ ), stringSource, stringRule ); REQUIRE( stringRule == stringExpect );
+      }
+   }
+
+   // ## rules, streams and sections
+   CRule ruleKeyword( keywordtableSql );                                      REQUIRE( ruleKeyword.key().empty() == false );
+                                                                               REQUIRE( ruleKeyword.key() != CRule( keywordtableWord ).key() );
+   std::string stringSql;
+   for( int i = 0; i < 2000; i++ ) stringSql += std::format( "c{} DATETIME, n{} NVARCHAR({}),\n", i, i, i );
+   std::string stringExpect;
+   CRuleProgram::Apply( ruleKeyword, stringSql, stringExpect );
+   std::istringstream istreamSql( stringSql );
+   std::ostringstream ostreamSql;
+   CFileStream filestream_( 4096, 64 );
+   filestream_.RULE_Add( ruleKeyword );
+   std::tie( bOk, stringError ) = filestream_.Convert( istreamSql, ostreamSql ); REQUIRE( bOk == true );
+                                                                               REQUIRE( ostreamSql.str() == stringExpect );
+
+   CFile fileSql;
+   fileSql.SECTION_Append( gd::utf8::string( stringSql.c_str() ) );
+   std::tie( bOk, stringError ) = fileSql.SECTION_Replace( keywordtableSql ); REQUIRE( bOk == true );
+   auto stringCode = fileSql.SECTION_At( 0 ).code();                          REQUIRE( std::string_view( stringCode.c_str(), stringCode.size() ) == stringExpect );
+}
+
+TEST_CASE("split sql into tokens", "[file]") {
+   using namespace application::file;
+
+   CSqlLexer lexerSql;
+   std::string_view stringSql( "SELECT N'a--b' , \"x/*y\", [c]]d] -- comment\r\nFROM t /* b */ WHERE id=1.5e3 AND s='it''s' @v #t" );
+   std::vector<CSqlLexer::token> vectorToken;
+   lexerSql.Split( stringSql, vectorToken );
+   std::string stringKind;
+   for( const auto& it : vectorToken )
+   {
+      if( it.m_uKind == CSqlLexer::eTokenWhitespace ) continue;
+      const char* pbszKind = it.m_uKind == CSqlLexer::eTokenComment ? "C" : it.m_uKind == CSqlLexer::eTokenString ? "S" : it.m_uKind == CSqlLexer::eTokenIdentifier ? "I" : it.m_uKind == CSqlLexer::eTokenKeyword ? "K" : it.m_uKind == CSqlLexer::eTokenNumber ? "N" : "Y";
+      stringKind += std::format( "{}({})", pbszKind, stringSql.substr( it.m_uOffset, it.m_uLength ) );
+   }
+                                                                               REQUIRE( stringKind == "K(SELECT)S(N'a--b')Y(,)I(\"x/*y\")Y(,)I([c]]d])C(-- comment)K(FROM)I(t)C(/* b */)K(WHERE)I(id)Y(=)N(1.5e3)K(AND)I(s)Y(=)S('it''s')I(@v)I(#t)" );
+   uint64_t uOffset = 0;
+   for( const auto& it : vectorToken ) { REQUIRE( it.m_uOffset == uOffset ); uOffset += it.m_uLength; }
+                                                                               REQUIRE( uOffset == stringSql.length() );
+                                                                               REQUIRE( lexerSql.IsKeyword( "select" ) == true );
+                                                                               REQUIRE( lexerSql.IsKeyword( "selects" ) == false );
+
+   // ## unterminated comment and string end at end of text, scanned once
+   std::string stringOpen = "SELECT 1 /*" + std::string( 1000000, '*' );
+   vectorToken.clear();
+   lexerSql.Split( stringOpen, vectorToken );                                  REQUIRE( vectorToken.back().m_uKind == CSqlLexer::eTokenComment );
+                                                                               REQUIRE( vectorToken.back().m_uLength == stringOpen.length() - 9 );
+   vectorToken.clear();
+   lexerSql.Split( "x '/*", vectorToken );                                     REQUIRE( vectorToken.back().m_uKind == CSqlLexer::eTokenString );
+
+   // ## same tokens when text is scanned in parts
+   std::string stringText;
+   for( int i = 0; i < 200; i++ ) stringText += std::format( "INSERT INTO t{} VALUES( N'{}''x', \"c\"\"{}\" ); -- row {}\n/* block {} */", i, i, i, i, i );
+   std::vector<CSqlLexer::token> vectorExpect;
+   lexerSql.Split( stringText, vectorExpect );
+   for( std::size_t uPart : { 1, 2, 3, 7, 64 } )
+   {
+      std::vector<CSqlLexer::token> vectorPart;
+      CSqlLexer::state state_;
+      std::size_t uStart = 0;                                                  // start of text not consumed
+      for( std::size_t uEnd = uPart; uStart < stringText.length(); uEnd += uPart )
+      {
+         uEnd = std::min( uEnd, stringText.length() );
+         std::size_t uFrom = vectorPart.size();
+         std::size_t uUsed = lexerSql.Scan( state_, std::string_view( stringText ).substr( uStart, uEnd - uStart ), uEnd == stringText.length(), vectorPart );
+         for( std::size_t u = uFrom; u < vectorPart.size(); u++ ) vectorPart[u].m_uOffset += uStart;
+         uStart += uUsed;
+         if( uEnd == stringText.length() ) break;
+      }
+                                                                               REQUIRE( vectorPart.size() == vectorExpect.size() );
+      for( std::size_t u = 0; u < vectorPart.size(); u++ ) { REQUIRE( vectorPart[u].m_uOffset == vectorExpect[u].m_uOffset ); REQUIRE( vectorPart[u].m_uKind == vectorExpect[u].m_uKind ); }
+   }
+
+   // ## erase and replace with token kinds
+   gd::utf8::string stringCode( "SELECT '--x' AS a, -- drop\nDATETIME /* DATETIME */ 'DATETIME' NVARCHAR(2)" );
+   auto [bOk, stringError] = Erase( stringCode, lexerSql, CSqlLexer::eTokenComment ); REQUIRE( bOk == true );
+                                                                               REQUIRE( std::string_view( stringCode.c_str(), stringCode.size() ) == "SELECT '--x' AS a, \nDATETIME  'DATETIME' NVARCHAR(2)" );
+   CKeywordTable keywordtableSql( { { "DATETIME", "TIMESTAMP" }, { "NVARCHAR(", "VARCHAR(" } }, CKeywordTable::eFlagWord );
+   std::tie( bOk, stringError ) = Replace( stringCode, lexerSql, CSqlLexer::eTokenAll & ~CSqlLexer::eTokenString, keywordtableSql ); REQUIRE( bOk == true );
+                                                                               REQUIRE( std::string_view( stringCode.c_str(), stringCode.size() ) == "SELECT '--x' AS a, \nTIMESTAMP  'DATETIME' VARCHAR(2)" );
+                                                                               REQUIRE( stringCode.count() == stringCode.size() );
+
+   CFile fileSql;
+   fileSql.SECTION_Append( gd::utf8::string( "a -- 'x\nb /* c */ 'd -- e'" ) );
+   std::tie( bOk, stringError ) = fileSql.SECTION_Erase( lexerSql, CSqlLexer::eTokenComment | CSqlLexer::eTokenWhitespace ); REQUIRE( bOk == true );
+   std::tie( bOk, stringError ) = fileSql.SECTION_Replace( lexerSql, CSqlLexer::eTokenIdentifier, CKeywordTable( { { "b", "B" }, { "d", "D" } } ) ); REQUIRE( bOk == true );
+   auto stringResult = fileSql.SECTION_At( 0 ).code();                        REQUIRE( std::string_view( stringResult.c_str(), stringResult.size() ) == "aB'd -- e'" );
+}
@@ -2,6 +2,9 @@
 #include <iterator>
 #include <array>
 #include <regex>
+#include <cstring>
+#include <chrono>
+#include <thread>
 
 #include "catch.hpp"
 
@@ -49,6 +52,304 @@ TEST_CASE("utf8 count, move and find operations", "[utf8]") {
 }
 
 
+TEST_CASE("utf8 validate and count with simd", "[utf8]") {
+   // ## build text with ascii and 2, 3 and 4 byte characters
+   std::string stringText;
+   const char* ppbszPart[] = { "SELECT * FROM t;\n", "åäö", "€", "😀", "abcdefghijklmnopqrstuvwxyz0123456789" };
+   for( unsigned u = 0; u < 3000; u++ ) stringText += ppbszPart[ ( u * 7 + u / 3 ) % 5 ];
+
+   const uint8_t* pubBegin = reinterpret_cast<const uint8_t*>( stringText.data() );
+   const uint8_t* pubEnd = pubBegin + stringText.length();
+   auto uExpect = gd::utf8::scalar::count( pubBegin, pubEnd ).first;
+
+   unsigned uSupported = gd::utf8::simd::level_supported();
+   for( unsigned uLevel = gd::utf8::simd::eLevelScalar; uLevel <= uSupported; uLevel++ )
+   {
+      gd::utf8::simd::level( uLevel );                                         REQUIRE( gd::utf8::simd::level() == uLevel );
+
+      // ## all lengths and offsets to test block boundaries
+      for( unsigned uOffset = 0; uOffset < 70; uOffset++ )
+      {
+         for( unsigned uLength = 0; uLength < 200; uLength += 3 )
+         {
+            auto pubFirst = pubBegin + uOffset;
+            auto pubLast = pubFirst + uLength;
+            auto resultCount = gd::utf8::count( pubFirst, pubLast );
+            auto resultScalar = gd::utf8::scalar::count( pubFirst, pubLast );  REQUIRE( resultCount == resultScalar );
+            auto resultValidate = gd::utf8::validate( pubFirst, pubLast );
+            auto resultValidateScalar = gd::utf8::scalar::validate( pubFirst, pubLast ); REQUIRE( resultValidate == resultValidateScalar );
+         }
+      }
+
+      auto [uCount, pubCountEnd] = gd::utf8::count( pubBegin, pubEnd );       REQUIRE( uCount == uExpect );
+                                                                               REQUIRE( pubCountEnd == pubEnd );
+                                                                               REQUIRE( gd::utf8::count( stringText.c_str() ).first == uExpect );
+                                                                               REQUIRE( gd::utf8::validate( pubBegin, pubEnd ).first == true );
+
+      // ## damage text at different positions, error position should be same as scalar
+      for( std::size_t uPosition = 1; uPosition < 400; uPosition += 7 )
+      {
+         for( uint8_t uByte : { (uint8_t)0x80, (uint8_t)0xC0, (uint8_t)0xE2, (uint8_t)0xF8, (uint8_t)'a' } )
+         {
+            std::string stringBad = stringText;
+            stringBad[ uPosition ] = (char)uByte;
+            auto pubBad = reinterpret_cast<const uint8_t*>( stringBad.data() );
+            auto resultSimd = gd::utf8::validate( pubBad, pubBad + stringBad.length() );
+            auto resultScalar = gd::utf8::scalar::validate( pubBad, pubBad + stringBad.length() ); REQUIRE( resultSimd == resultScalar );
+         }
+      }
+   }
+
+   gd::utf8::simd::level( uSupported );
+}
+
+TEST_CASE("utf8 count invalid text with simd", "[utf8]") {
+   // ## lead bytes without continuation bytes take following bytes, same count for all levels
+   std::string stringMixed = std::string( 40, 'a' ) + "\xC3" "A" + std::string( 40, 'b' ) + "\xE2\x82" "x";
+
+   // ## latin-1 like text with stray lead and continuation bytes
+   std::string stringText;
+   const char* ppbszPart[] = { "SELECT ", "\xE5\xE4\xF6 ", "\xC3\xA5", "\xF0\x9F\x98", "\x80\xBF", "\xE2\x82\xAC", "\xC0\xF5\xFF", "abcdefghijklmnopqrstuvwxyz" };
+   for( unsigned u = 0; u < 2000; u++ ) stringText += ppbszPart[ ( u * 7 + u / 3 ) % 8 ];
+
+   unsigned uSupported = gd::utf8::simd::level_supported();
+   for( unsigned uLevel = gd::utf8::simd::eLevelScalar; uLevel <= uSupported; uLevel++ )
+   {
+      gd::utf8::simd::level( uLevel );
+      auto pubMixed = reinterpret_cast<const uint8_t*>( stringMixed.data() );
+      auto [uCount, pubCountEnd] = gd::utf8::count( pubMixed, pubMixed + stringMixed.length() ); REQUIRE( uCount == 82 );
+                                                                               REQUIRE( pubCountEnd == pubMixed + stringMixed.length() );
+
+      const uint8_t* pubBegin = reinterpret_cast<const uint8_t*>( stringText.data() );
+      for( unsigned uOffset = 0; uOffset < 70; uOffset++ )
+      {
+         for( unsigned uLength = 0; uLength < 300; uLength += 5 )
+         {
+            auto pubFirst = pubBegin + uOffset;
+            auto pubLast = pubFirst + uLength;
+            auto resultCount = gd::utf8::count( pubFirst, pubLast );
+            auto resultScalar = gd::utf8::scalar::count( pubFirst, pubLast );  REQUIRE( resultCount == resultScalar );
+         }
+      }
+      auto pubEnd = pubBegin + stringText.length();                            REQUIRE( gd::utf8::count( pubBegin, pubEnd ) == gd::utf8::scalar::count( pubBegin, pubEnd ) );
+   }
+
+   gd::utf8::simd::level( uSupported );
+}
+
+TEST_CASE("utf8 find text with simd", "[utf8]") {
+   std::string stringText;
+   const char* ppbszPart[] = { "SELECT * FROM t; ", "åäö ", "--", "€😀", "aaaa", "x-" };
+   for( unsigned u = 0; u < 500; u++ ) stringText += ppbszPart[ ( u * 5 + u / 7 ) % 6 ];
+   stringText += "end--";
+
+   const uint8_t* pubBegin = reinterpret_cast<const uint8_t*>( stringText.data() );
+   const uint8_t* pubEnd = pubBegin + stringText.length();
+   std::string_view ppFind[] = { "--", "-", "aaaaa", "😀", "end--", "t; åäö", "zz", "--x-", "" };
+
+   unsigned uSupported = gd::utf8::simd::level_supported();
+   for( unsigned uLevel = gd::utf8::simd::eLevelScalar; uLevel <= uSupported; uLevel++ )
+   {
+      gd::utf8::simd::level( uLevel );
+      for( auto stringFind : ppFind )
+      {
+         gd::utf8::searcher searcherFind( stringFind );
+         auto pubFind = reinterpret_cast<const uint8_t*>( stringFind.data() );
+         uint32_t uFind = static_cast<uint32_t>( stringFind.length() );
+         for( unsigned uOffset = 0; uOffset < 40; uOffset++ )
+         {
+            for( std::size_t uLength = 0; uLength + uOffset <= stringText.length(); uLength += 1 + uLength / 4 )
+            {
+               std::string_view stringIn( stringText.data() + uOffset, uLength );
+               auto uExpect = stringIn.find( stringFind );
+               const uint8_t* pubExpect = uExpect == std::string_view::npos ? nullptr : pubBegin + uOffset + uExpect;
+               auto pubFound = gd::utf8::move::find( pubBegin + uOffset, pubBegin + uOffset + uLength, pubFind, uFind );  REQUIRE( pubFound == pubExpect );
+               pubFound = searcherFind.find( pubBegin + uOffset, pubBegin + uOffset + uLength );                       REQUIRE( pubFound == pubExpect );
+            }
+         }
+      }
+   }
+
+   gd::utf8::simd::level( uSupported );
+
+   // ## last position in text is found
+   gd::utf8::string stringEnd( "select 1 --" );
+   auto itFind = stringEnd.find( "--" );                                       REQUIRE( itFind != stringEnd.end() );
+}
+
+TEST_CASE("utf8 squeeze marker bytes with simd", "[utf8]") {
+   // ## text with markers alone, in runs longer than a block and at block boundaries
+   std::string stringText;
+   const char* ppbszPart[] = { "SELECT * FROM t;", "", "åäö", "€😀", "abcdefghijklmnopqrstuvwxyz" };// part 1 is markers
+   for( unsigned u = 0; u < 400; u++ )
+   {
+      unsigned uPart = ( u * 3 + u / 5 ) % 5;
+      if( uPart == 1 ) stringText.append( ( u % 7 ) * 6 + 1, '\0' );
+      else stringText += ppbszPart[uPart];
+   }
+
+   std::string stringExpect;
+   for( char i : stringText ) { if( i != '\0' ) stringExpect += i; }
+   uint32_t uExpect = gd::utf8::count( stringExpect.c_str() ).first;
+
+   unsigned uSupported = gd::utf8::simd::level_supported();
+   for( unsigned uLevel = gd::utf8::simd::eLevelScalar; uLevel <= uSupported; uLevel++ )
+   {
+      gd::utf8::simd::level( uLevel );
+      for( unsigned uOffset = 0; uOffset < 70; uOffset += 3 )
+      {
+         for( unsigned uLength = 0; uLength < 300; uLength += 7 )
+         {
+            std::string stringSimd = stringText.substr( uOffset, uLength );
+            std::string stringScalar = stringSimd;
+            auto pubSimd = reinterpret_cast<uint8_t*>( stringSimd.data() );
+            auto pubScalar = reinterpret_cast<uint8_t*>( stringScalar.data() );
+            auto [uCount, pubSimdEnd] = gd::utf8::squeeze( pubSimd, pubSimd + stringSimd.length(), 0 );
+            auto [uCountScalar, pubScalarEnd] = gd::utf8::scalar::squeeze( pubScalar, pubScalar + stringScalar.length(), 0 ); REQUIRE( uCount == uCountScalar );
+            REQUIRE( std::string_view( stringSimd.data(), pubSimdEnd - pubSimd ) == std::string_view( stringScalar.data(), pubScalarEnd - pubScalar ) );
+         }
+      }
+
+      gd::utf8::string s1;
+      s1.assign( reinterpret_cast<const uint8_t*>( stringText.data() ), stringText.length() );
+      s1.squeeze();                                                            REQUIRE( s1.size() == stringExpect.length() );
+                                                                               REQUIRE( s1.is_counted() == true );
+                                                                               REQUIRE( s1.count() == uExpect );
+                                                                               REQUIRE( std::memcmp( s1.c_str(), stringExpect.c_str(), s1.size() ) == 0 );
+
+      // ## only markers, and markers removed within part of string
+      std::string stringMarker( 100, '\0' );
+      gd::utf8::string s2;
+      s2.assign( reinterpret_cast<const uint8_t*>( stringMarker.data() ), stringMarker.length() );
+      s2.squeeze();                                                            REQUIRE( s2.empty() == true );
+                                                                               REQUIRE( s2.count() == 0 );
+
+      const char* pbszDash = "åäö-abc---def-åäö";
+      gd::utf8::string s3;
+      s3.assign( reinterpret_cast<const uint8_t*>( pbszDash ), std::strlen( pbszDash ) );REQUIRE( s3.count() == 17 );
+      s3.squeeze( s3.begin() + 3u, s3.begin() + 13u, '-' );                    REQUIRE( s3.is_counted() == true );
+                                                                               REQUIRE( s3.count() == 13 );
+                                                                               REQUIRE( std::string_view( s3.c_str(), s3.size() ) == "åäöabcdef-åäö" );
+
+      gd::utf8::string s4;
+      s4.squeeze();                                                            REQUIRE( s4.empty() == true );
+                                                                               REQUIRE( s4.m_pbuffer->is_common_empty() == true );
+                                                                               REQUIRE( s4.m_pbuffer->get_count() == 0 );
+   }
+
+   gd::utf8::simd::level( uSupported );
+}
+
+TEST_CASE("utf16 and utf32 transcoding with simd", "[utf8]") {
+   // ## text with ascii runs longer than a block, two and three byte characters, surrogate pairs and lone surrogates
+   std::u16string stringText;
+   const char16_t* ppwszPart[] = { u"SELECT * FROM t;", u"åäö", u"€😀", u"abcdefghijklmnopqrstuvwxyz", u"😀😀" };
+   for( unsigned u = 0; u < 300; u++ )
+   {
+      stringText += ppwszPart[( u * 3 + u / 5 ) % 5];
+      if( u % 37 == 0 ) stringText += char16_t( 0xd800 + u );                  // lone high surrogate
+      if( u % 41 == 0 ) stringText += char16_t( 0xdc00 + u );                  // lone low surrogate
+   }
+   std::u32string stringText32;
+   for( unsigned u = 0; u < 300; u++ ) stringText32 += ( u % 11 == 0 ) ? U"€😀å" : U"abcdefghijklmnop";
+   std::string stringUtf8;
+   for( unsigned u = 0; u < 300; u++ ) stringUtf8 += ( u % 7 == 0 ) ? "€😀å" : "abcdefghijklmnopqrstuvwxyz";
+
+   unsigned uSupported = gd::utf8::simd::level_supported();
+   for( unsigned uLevel = gd::utf8::simd::eLevelScalar; uLevel <= uSupported; uLevel++ )
+   {
+      gd::utf8::simd::level( uLevel );
+      for( unsigned uOffset = 0; uOffset < 70; uOffset += 3 )
+      {
+         for( unsigned uLength = 0; uLength < 300; uLength += 7 )
+         {
+            // ## utf16 to utf8
+            std::u16string_view stringPart = std::u16string_view( stringText ).substr( uOffset, uLength );
+            const char16_t* pwszEnd = stringPart.data() + stringPart.length();
+            uint32_t uSize = gd::utf8::size( stringPart.data(), pwszEnd );    REQUIRE( uSize == gd::utf8::scalar::size( stringPart.data(), pwszEnd ) );
+            std::string stringSimd( uSize, '\0' ), stringScalar( uSize, '\0' );
+            auto pubSimd = reinterpret_cast<uint8_t*>( stringSimd.data() );
+            auto pubScalar = reinterpret_cast<uint8_t*>( stringScalar.data() );
+            REQUIRE( gd::utf8::convert( stringPart.data(), pwszEnd, pubSimd ) == pubSimd + uSize );
+            REQUIRE( gd::utf8::scalar::convert( stringPart.data(), pwszEnd, pubScalar ) == pubScalar + uSize );
+            REQUIRE( stringSimd == stringScalar );
+
+            // ## utf32 to utf8
+            std::u32string_view stringPart32 = std::u32string_view( stringText32 ).substr( uOffset, uLength );
+            const char32_t* pwszEnd32 = stringPart32.data() + stringPart32.length();
+            uSize = gd::utf8::size( stringPart32.data(), pwszEnd32 );         REQUIRE( uSize == gd::utf8::scalar::size( stringPart32.data(), pwszEnd32 ) );
+            stringSimd.assign( uSize, '\0' ); stringScalar.assign( uSize, '\0' );
+            pubSimd = reinterpret_cast<uint8_t*>( stringSimd.data() );
+            pubScalar = reinterpret_cast<uint8_t*>( stringScalar.data() );
+            REQUIRE( gd::utf8::convert( stringPart32.data(), pwszEnd32, pubSimd ) == pubSimd + uSize );
+            REQUIRE( gd::utf8::scalar::convert( stringPart32.data(), pwszEnd32, pubScalar ) == pubScalar + uSize );
+            REQUIRE( stringSimd == stringScalar );
+
+            // ## utf8 to utf16, part may cut characters
+            std::string_view stringPart8 = std::string_view( stringUtf8 ).substr( uOffset, uLength );
+            auto pubBegin = reinterpret_cast<const uint8_t*>( stringPart8.data() );
+            auto pubEnd = pubBegin + stringPart8.length();
+            uSize = gd::utf8::size_utf16( pubBegin, pubEnd );                 REQUIRE( uSize == gd::utf8::scalar::size_utf16( pubBegin, pubEnd ) );
+            std::u16string string16Simd( uSize, u'\0' ), string16Scalar( uSize, u'\0' );
+            REQUIRE( gd::utf8::convert( pubBegin, pubEnd, string16Simd.data() ) == string16Simd.data() + uSize );
+            REQUIRE( gd::utf8::scalar::convert( pubBegin, pubEnd, string16Scalar.data() ) == string16Scalar.data() + uSize );
+            REQUIRE( string16Simd == string16Scalar );
+         }
+      }
+
+      // ## known results and round trip
+      std::u16string_view stringKnown = u"abc åäö € 😀 SELECT * FROM table_name;";
+      std::string_view stringKnown8 = "abc åäö € 😀 SELECT * FROM table_name;";
+      std::string stringConvert( gd::utf8::size( stringKnown.data(), stringKnown.data() + stringKnown.length() ), '\0' );
+                                                                               REQUIRE( stringConvert.length() == stringKnown8.length() );
+      gd::utf8::convert( stringKnown.data(), stringKnown.data() + stringKnown.length(), reinterpret_cast<uint8_t*>( stringConvert.data() ) );
+                                                                               REQUIRE( stringConvert == stringKnown8 );
+      auto pubKnown = reinterpret_cast<const uint8_t*>( stringKnown8.data() );
+      std::u16string string16( gd::utf8::size_utf16( pubKnown, pubKnown + stringKnown8.length() ), u'\0' );
+                                                                               REQUIRE( string16.length() == stringKnown.length() );
+      gd::utf8::convert( pubKnown, pubKnown + stringKnown8.length(), string16.data() );
+                                                                               REQUIRE( string16 == stringKnown );
+
+      std::u32string_view stringKnown32 = U"abc åäö € 😀 SELECT * FROM table_name;";
+      stringConvert.assign( gd::utf8::size( stringKnown32.data(), stringKnown32.data() + stringKnown32.length() ), '\0' );
+      gd::utf8::convert( stringKnown32.data(), stringKnown32.data() + stringKnown32.length(), reinterpret_cast<uint8_t*>( stringConvert.data() ) );
+                                                                               REQUIRE( stringConvert == stringKnown8 );
+
+      std::string stringAppend = "log: ";
+      gd::utf8::convert_utf16_to_uft8( reinterpret_cast<const uint16_t*>( stringKnown.data() ), stringAppend );
+                                                                               REQUIRE( stringAppend == "log: " + std::string( stringKnown8 ) );
+   }
+
+   gd::utf8::simd::level( uSupported );
+}
+
+// Compare find loop without simd, simd find and searcher on large text. Run with "[benchmark]" to see numbers.
+TEST_CASE("utf8 find benchmark", "[.][benchmark]") {
+   std::string stringText;
+   while( stringText.length() < 8 * 1024 * 1024 ) stringText += "SELECT a.id, b.name FROM table_a a JOIN table_b b ON a.id = b.id WHERE a.value > 10 - 2;\n";
+   stringText += "-- comment";
+
+   const uint8_t* pubBegin = reinterpret_cast<const uint8_t*>( stringText.data() );
+   const uint8_t* pubEnd = pubBegin + stringText.length();
+   const uint8_t* pubExpect = pubEnd - 10;
+   unsigned uSupported = gd::utf8::simd::level_supported();
+
+   auto measure_ = [&]( const char* pbszName, auto find_ ) {
+      auto timeStart = std::chrono::steady_clock::now();
+      for( unsigned u = 0; u < 20; u++ ) { REQUIRE( find_() == pubExpect ); }
+      auto uMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - timeStart ).count();
+      std::cout << pbszName << ": " << ( double( stringText.length() ) * 20 / uMicroseconds ) << " MB/s\n";
+   };
+
+   gd::utf8::simd::level( gd::utf8::simd::eLevelScalar );
+   measure_( "find (no simd)", [&]() { return gd::utf8::move::find( pubBegin, pubEnd, reinterpret_cast<const uint8_t*>( "--" ), 2 ); } );
+   gd::utf8::searcher searcherComment( "-- comment" );
+   measure_( "searcher (no simd)", [&]() { return searcherComment.find( pubBegin, pubEnd ); } );
+   gd::utf8::simd::level( uSupported );
+   measure_( "find (simd)", [&]() { return gd::utf8::move::find( pubBegin, pubEnd, reinterpret_cast<const uint8_t*>( "--" ), 2 ); } );
+   measure_( "searcher (simd)", [&]() { return searcherComment.find( pubBegin, pubEnd ); } );
+}
+
 TEST_CASE("utf8 convert operations", "[utf8]") {
    {
       uint8_t pBuffer[100] = { 0 };
@@ -213,6 +514,309 @@ TEST_CASE("insert and remove text in string", "[utf8]") {
 
 }
 
+TEST_CASE("count characters when needed", "[utf8]") {
+   const char* pbszText = "abc åäö 123";                                      // 11 characters, 14 bytes
+
+   gd::utf8::string s1;
+   s1.assign( reinterpret_cast<const uint8_t*>( pbszText ), std::strlen( pbszText ) );REQUIRE( s1.is_counted() == false );
+                                                                               REQUIRE( s1.size() == 14 );
+                                                                               REQUIRE( s1.count() == 11 );
+                                                                               REQUIRE( s1.is_counted() == true );
+
+   s1.push_back( (uint32_t)U'Ö' );                                            REQUIRE( s1.is_counted() == true );
+                                                                               REQUIRE( s1.count() == 12 );
+
+   s1.replace( s1.cbegin() + 4u, s1.cbegin() + 7u, "aao" );                   REQUIRE( s1.is_counted() == false );
+                                                                               REQUIRE( s1.size() == 13 );
+                                                                               REQUIRE( s1.count() == 12 );
+   
+   s1.insert( s1.begin(), s1.begin() + 4u, 4, '\0' );
+   s1.squeeze();                                                               REQUIRE( s1.is_counted() == true );
+                                                                               REQUIRE( s1 == "aao 123Ö" );
+                                                                               REQUIRE( s1.count() == 8 );
+
+   gd::utf8::string s2;
+   s2.append( s1 );                                                            REQUIRE( s2.count() == 8 );
+   s1.clear();                                                                 REQUIRE( s1.count() == 0 );
+}
+
+TEST_CASE("short text stored in string object", "[utf8]") {
+   using namespace gd::utf8;
+   const uint8_t* pubShort = reinterpret_cast<const uint8_t*>( "tag_åäö" );
+   uint32_t uInline = string::buffer_inline::capacity;
+
+   string stringShort;
+   stringShort.assign( pubShort, std::strlen( (const char*)pubShort ) );       REQUIRE( stringShort.is_inline() == true );
+                                                                               REQUIRE( stringShort == std::string_view( "tag_åäö" ) );
+                                                                               REQUIRE( stringShort.count() == 7 );
+
+   // ## copy, move and swap keep text in each object
+   string stringCopy( stringShort );                                           REQUIRE( stringCopy.is_inline() == true );
+                                                                               REQUIRE( stringCopy.c_str() != stringShort.c_str() );
+                                                                               REQUIRE( stringCopy == std::string_view( "tag_åäö" ) );
+   string stringMove( std::move( stringCopy ) );                               REQUIRE( stringMove == std::string_view( "tag_åäö" ) );
+                                                                               REQUIRE( stringCopy.empty() == true );
+   string stringLong;
+   stringLong.assign( reinterpret_cast<const uint8_t*>( std::string( 100, 'x' ).c_str() ), std::size_t( 100 ) ); REQUIRE( stringLong.is_inline() == false );
+   stringLong.swap( stringMove );                                              REQUIRE( stringLong == std::string_view( "tag_åäö" ) );
+                                                                               REQUIRE( stringLong.is_inline() == true );
+                                                                               REQUIRE( stringMove.size() == 100 );
+   stringMove = std::move( stringLong );                                       REQUIRE( stringMove == std::string_view( "tag_åäö" ) );
+
+   // ## grows to allocated buffer past inline capacity
+   string stringGrow;
+   std::string stringExpect;
+   for( uint32_t u = 0; u < uInline + 10; u++ )
+   {
+      stringGrow.append( "a" );
+      stringExpect += 'a';
+                                                                               REQUIRE( stringGrow.is_inline() == ( u + 1 < uInline ) );
+                                                                               REQUIRE( stringGrow == std::string_view( stringExpect ) );
+   }
+
+   // ## long text is still reference counted, unique strings stay unique
+   string stringShared( stringGrow );                                          REQUIRE( stringShared.c_str() == stringGrow.c_str() );
+   string stringUnique( string::unique );
+   stringUnique.append( "åäö" );                                               REQUIRE( stringUnique.is_inline() == true );
+   stringUnique.append( stringExpect );                                        REQUIRE( stringUnique.m_pbuffer->is_single() == true );
+   string stringUniqueCopy( stringUnique );                                    REQUIRE( stringUniqueCopy.c_str() != stringUnique.c_str() );
+                                                                               REQUIRE( stringUniqueCopy == stringUnique );
+
+   // ## stack storage is used as before
+   uint8_t pBuffer[100];
+   string stringStack( gd::utf8::buffer{ pBuffer, 100 } );
+   stringStack.append( "0123456789" );                                         REQUIRE( stringStack.c_str() == (const char*)pBuffer + sizeof( string::buffer ) );
+                                                                               REQUIRE( stringStack.is_inline() == false );
+}
+
+TEST_CASE("string with allocator", "[utf8]") {
+   using namespace gd::utf8;
+   /// counts memory taken and returned, memory is taken from arena
+   struct allocator_count : public allocator
+   {
+      void* allocate( std::size_t uSize ) override { m_iCount++; return m_arena.allocate( uSize ); }
+      void deallocate( void* p, std::size_t uSize ) override { m_iCount--; m_arena.deallocate( p, uSize ); }
+      int m_iCount = 0;
+      arena m_arena{ 1024 };
+   };
+
+   allocator_count allocatorCount;
+   std::string stringLong( 100, 'x' );
+   {
+      string stringText( &allocatorCount );
+      stringText.assign( stringLong );                                         REQUIRE( allocatorCount.m_iCount == 1 );
+                                                                               REQUIRE( stringText.m_pbuffer->get_allocator() == &allocatorCount );
+      string stringShared( stringText );                                       REQUIRE( stringShared.c_str() == stringText.c_str() );
+                                                                               REQUIRE( stringShared.get_allocator() == &allocatorCount );
+      stringText.append( stringLong );                                         REQUIRE( stringText.size() == 200 );
+                                                                               REQUIRE( stringShared == std::string_view( stringLong ) );
+                                                                               REQUIRE( stringText.m_pbuffer->get_allocator() == &allocatorCount );
+
+      // ## short text is stored in string object
+      string stringShort( &allocatorCount );
+      stringShort.assign( "abc" );                                             REQUIRE( stringShort.is_inline() == true );
+
+      // ## string without allocator copies text to own buffer
+      string stringCopy;
+      stringCopy.assign( stringText.c_buffer(), std::size_t( stringText.size() ) ); REQUIRE( stringCopy.m_pbuffer->get_allocator() == nullptr );
+
+      // ## allocator is swapped with buffer, both for allocated and short text
+      stringCopy.swap( stringText );                                           REQUIRE( stringCopy.get_allocator() == &allocatorCount );
+                                                                               REQUIRE( stringText.get_allocator() == nullptr );
+      stringCopy.append( stringLong );                                         REQUIRE( stringCopy.m_pbuffer->get_allocator() == &allocatorCount );
+      string stringEmpty;
+      stringEmpty.swap( stringShort );                                         REQUIRE( stringEmpty.get_allocator() == &allocatorCount );
+                                                                               REQUIRE( stringEmpty == std::string_view( "abc" ) );
+                                                                               REQUIRE( stringShort.get_allocator() == nullptr );
+   }
+                                                                               REQUIRE( allocatorCount.m_iCount == 0 );
+
+   // ## arena frees all blocks at once
+   arena arenaText( 1024 );
+   std::vector<string> vectorText;
+   for( int i = 0; i < 100; i++ )
+   {
+      string stringText( &arenaText );
+      stringText.assign( stringLong );
+      vectorText.push_back( std::move( stringText ) );                         
+   }
+                                                                               REQUIRE( vectorText[99] == std::string_view( stringLong ) );
+                                                                               REQUIRE( arenaText.block_count() > 1 );
+                                                                               REQUIRE( arenaText.size() >= 100 * 100 );
+   vectorText.clear();
+   arenaText.release();                                                        REQUIRE( arenaText.block_count() == 0 );
+                                                                               REQUIRE( arenaText.size() == 0 );
+   void* pLarge = arenaText.allocate( 4000 );                                  REQUIRE( pLarge != nullptr );
+                                                                               REQUIRE( arenaText.block_count() == 1 );
+}
+
+TEST_CASE("string with atomic reference counter shared by threads", "[utf8]") {
+   using namespace gd::utf8;
+   std::string stringLong;
+   for( int i = 0; i < 1000; i++ ) stringLong += "åäö-";
+
+   string stringShared( string::atomic_counter );
+   stringShared.assign( reinterpret_cast<const uint8_t*>( stringLong.data() ), stringLong.size() ); REQUIRE( stringShared.m_pbuffer->is_refcount() == true );
+                                                                               REQUIRE( stringShared.m_pbuffer->is_type_atomic() == true );
+                                                                               REQUIRE( stringShared.m_pbuffer->get_reference() == 1 );
+
+   // ## each worker copies and reads shared text, one in four modifies its copy (copy on write)
+   std::vector<std::thread> vectorThread;
+   std::vector<int> vectorError( 8, 0 );
+   for( int iThread = 0; iThread < 8; iThread++ )
+   {
+      vectorThread.emplace_back( [&stringShared, &stringLong, &vectorError, iThread]() {
+         for( int i = 0; i < 2000; i++ )
+         {
+            string stringCopy( stringShared );
+            if( stringCopy.c_str() != stringShared.c_str() ) vectorError[iThread]++;
+            if( stringCopy.count() != 4000 ) vectorError[iThread]++;
+            if( ( i % 4 ) == 0 )
+            {
+               stringCopy.append( "x" );
+               if( stringCopy.c_str() == stringShared.c_str() || stringCopy.size() != stringLong.size() + 1 ) vectorError[iThread]++;
+               if( stringCopy.m_pbuffer->is_type_atomic() == false ) vectorError[iThread]++;
+            }
+         }
+      } );
+   }
+   for( auto& it : vectorThread ) it.join();
+   for( auto it : vectorError )                                                REQUIRE( it == 0 );
+                                                                               REQUIRE( stringShared.m_pbuffer->get_reference() == 1 );
+                                                                               REQUIRE( stringShared == std::string_view( stringLong ) );
+
+   // ## type is kept when short text stored in object grows and when text is moved
+   string stringShort( string::atomic_counter );
+   stringShort.assign( "abc" );                                                REQUIRE( stringShort.is_inline() == true );
+   stringShort.append( std::string( 100, 'x' ) );                              REQUIRE( stringShort.m_pbuffer->is_type_atomic() == true );
+   string stringMove( std::move( stringShort ) );                              REQUIRE( stringShort.m_pbuffer->is_type_atomic() == true );
+                                                                               REQUIRE( stringMove.m_pbuffer->is_refcount() == true );
+}
+
+TEST_CASE("edit on copy with spare capacity keeps shared text", "[utf8]") {
+   using namespace gd::utf8;
+   std::string stringOriginal( 200, 'a' );
+
+   string stringText;
+   stringText.append( stringOriginal );                                        REQUIRE( stringText.m_pbuffer->is_refcount() == true );
+                                                                               REQUIRE( stringText.capacity() > stringText.size() + 10 );// edits below fit in buffer
+
+   auto check_ = [&]( string& stringCopy, std::string_view stringExpect ) {
+                                                                               REQUIRE( stringCopy.c_str() != stringText.c_str() );
+                                                                               REQUIRE( stringCopy == stringExpect );
+                                                                               REQUIRE( stringText == std::string_view( stringOriginal ) );
+                                                                               REQUIRE( stringText.m_pbuffer->get_reference() == 1 );
+   };
+
+   { string stringCopy( stringText ); stringCopy.append( "b" );               check_( stringCopy, stringOriginal + "b" ); }
+   { string stringCopy( stringText ); stringCopy.push_back( uint32_t( 'b' ) ); check_( stringCopy, stringOriginal + "b" ); }
+   { string stringCopy( stringText ); stringCopy.replace( stringCopy.begin(), stringCopy.begin() + 2, "b" ); check_( stringCopy, "b" + stringOriginal.substr( 2 ) ); }
+   { string stringCopy( stringText ); stringCopy.replace( stringCopy.begin(), stringCopy.begin() + 1, "bc" ); check_( stringCopy, "bc" + stringOriginal.substr( 1 ) ); }
+   { string stringCopy( stringText ); stringCopy.insert( stringCopy.begin(), stringCopy.begin() + 1, 3, uint32_t( 'b' ) ); check_( stringCopy, "bbb" + stringOriginal.substr( 1 ) ); }
+   { string stringCopy( stringText ); stringCopy.erase( stringCopy.begin(), stringCopy.begin() + 5, true ); check_( stringCopy, stringOriginal.substr( 5 ) ); }
+   { string stringCopy( stringText ); stringCopy.squeeze( stringCopy.begin(), stringCopy.end(), 'a' ); check_( stringCopy, "" ); }
+}
+
+TEST_CASE("character index for random access", "[utf8]") {
+   using namespace gd::utf8;
+   std::string stringMixed;
+   std::vector<uint32_t> vectorCharacter;
+   for( int i = 0; i < 3000; i++ )
+   {
+      stringMixed += "a\xC3\xA5\xE2\x82\xAC";                                   // a, å, €
+      vectorCharacter.insert( vectorCharacter.end(), { 'a', 0xE5, 0x20AC } );
+   }
+
+   string stringText;
+   stringText.assign( reinterpret_cast<const uint8_t*>( stringMixed.data() ), stringMixed.size() );
+   for( uint32_t u = 0; u < vectorCharacter.size(); u += 7 )
+   {
+      if( stringText.at( u ) != vectorCharacter[u] )                           REQUIRE( stringText.at( u ) == vectorCharacter[u] );
+   }
+                                                                               REQUIRE( stringText.m_pbuffer->get_index() != nullptr );
+                                                                               REQUIRE( stringText.position( vectorCharacter.size() ) == stringText.cend() );
+                                                                               REQUIRE( stringText.position( vectorCharacter.size() - 1 ).value32() == 0x20AC );
+
+   // ## shared buffer shares index, modified text drops index
+   string stringShared( stringText );                                          REQUIRE( stringShared.m_pbuffer->get_index() == stringText.m_pbuffer->get_index() );
+   stringText.append( "x" );                                                   REQUIRE( stringText.m_pbuffer->get_index() == nullptr );
+                                                                               REQUIRE( stringShared.m_pbuffer->get_index() != nullptr );
+                                                                               REQUIRE( stringText.at( vectorCharacter.size() ) == 'x' );
+                                                                               REQUIRE( stringText.at( 4 ) == 0xE5 );
+
+   // ## ascii text is indexed directly
+   string stringAscii( std::string( 5000, 'b' ) + "c" );
+                                                                               REQUIRE( stringAscii.count() == 5001 );
+                                                                               REQUIRE( stringAscii.at( 5000 ) == 'c' );
+                                                                               REQUIRE( stringAscii.m_pbuffer->get_index() == nullptr );
+}
+
+TEST_CASE("ascii flag for text with one byte characters", "[utf8]") {
+   using namespace gd::utf8;
+   std::string stringSql;
+   for( int i = 0; i < 200; i++ ) stringSql += "SELECT name FROM t WHERE id = " + std::to_string( i ) + ";\n";
+
+   // ## flag is set when text is assigned, characters do not need to be counted
+   string stringText;
+   stringText.assign( reinterpret_cast<const uint8_t*>( stringSql.data() ), stringSql.size() ); REQUIRE( stringText.is_ascii() == true );
+                                                                               REQUIRE( stringText.is_counted() == true );
+                                                                               REQUIRE( stringText.count() == stringSql.size() );
+                                                                               REQUIRE( stringText.at( 7 ) == 'n' );
+                                                                               REQUIRE( stringText.m_pbuffer->get_index() == nullptr );
+                                                                               REQUIRE( stringText.find( "WHERE id = 10;" ) != stringText.cend() );
+                                                                               REQUIRE( stringText.find( "åäö" ) == stringText.cend() );
+   string stringPart = stringText.substr( stringText.position( 7 ), stringText.position( 11 ) ); REQUIRE( stringPart == std::string_view( "name" ) );
+                                                                               REQUIRE( stringPart.is_ascii() == true );
+
+   // ## shared buffer keeps flag when copied before edit, ascii edits keep flag
+   string stringShared( stringText );
+   stringText.append( "-- end" );                                              REQUIRE( stringText.is_ascii() == true );
+                                                                               REQUIRE( stringShared.is_ascii() == true );
+   stringText.replace( stringText.position( 0 ), stringText.position( 6 ), "select" ); REQUIRE( stringText.is_ascii() == true );
+   stringText.push_back( uint8_t( 'x' ) );                                     REQUIRE( stringText.is_ascii() == true );
+
+   // ## non ascii clears flag
+   stringText.replace( stringText.position( 7 ), stringText.position( 11 ), "namn_åäö" ); REQUIRE( stringText.is_ascii() == false );
+                                                                               REQUIRE( stringText.count() == stringSql.size() + 6 + 1 + 4 );
+   string stringAppend( "abc" );                                               REQUIRE( stringAppend.is_ascii() == true );
+   stringAppend.append( reinterpret_cast<const uint8_t*>( "\xE2\x82\xAC" ), 3u ); REQUIRE( stringAppend.is_ascii() == false );
+                                                                               REQUIRE( stringAppend.count() == 4 );
+   string stringPush( "abc" );
+   stringPush.push_back( uint32_t( 0x20AC ) );                                 REQUIRE( stringPush.is_ascii() == false );
+   string stringLatin( "\xE5" );                                               REQUIRE( stringLatin.is_ascii() == false );
+
+   // ## text written to buffer is checked when size is set
+   string stringDirect;
+   stringDirect.allocate( 100 );
+   std::memcpy( stringDirect.c_buffer(), "abc", 3 );
+   stringDirect.set_size( 3, string::buffer::npos );                           REQUIRE( stringDirect.is_ascii() == true );
+                                                                               REQUIRE( stringDirect.is_counted() == true );
+   std::memcpy( stringDirect.c_buffer(), "\xC3\xA5" "bc", 4 );
+   stringDirect.set_size( 4, string::buffer::npos );                           REQUIRE( stringDirect.is_ascii() == false );
+                                                                               REQUIRE( stringDirect.count() == 3 );
+
+   // ## ascii text is sorted as bytes
+   string stringSort( "dcba" );
+   stringSort.sort();                                                          REQUIRE( stringSort == std::string_view( "abcd" ) );
+
+   // ## simd check against scalar
+   for( unsigned uLevel = simd::eLevelScalar; uLevel <= simd::level_supported(); uLevel++ )
+   {
+      simd::level( uLevel );
+      for( std::size_t uPosition = 0; uPosition < 300; uPosition += 13 )
+      {
+         std::string stringCheck( 300, 'a' );
+         stringCheck[uPosition] = '\x80';
+         auto pubCheck = reinterpret_cast<const uint8_t*>( stringCheck.data() );
+         for( std::size_t uLength = 0; uLength <= 300; uLength += 17 )
+         {
+            if( is_ascii( pubCheck, pubCheck + uLength ) != ( uPosition >= uLength ) ) REQUIRE( is_ascii( pubCheck, pubCheck + uLength ) == ( uPosition >= uLength ) );
+         }
+      }
+   }
+   simd::level( simd::level_supported() );
+}
+
 TEST_CASE("find text using regex", "[utf8]") {
 
    {